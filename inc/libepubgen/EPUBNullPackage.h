@@ -0,0 +1,73 @@
+/* -*- Mode: C++; tab-width: 2; indent-tabs-mode: nil; c-basic-offset: 2 -*- */
+/*
+ * This file is part of the libepubgen project.
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#ifndef INCLUDED_LIBEPUBGEN_EPUBNULLPACKAGE_H
+#define INCLUDED_LIBEPUBGEN_EPUBNULLPACKAGE_H
+
+#include <librevenge/librevenge.h>
+
+#include "libepubgen-api.h"
+#include "EPUBPackage.h"
+
+namespace libepubgen
+{
+
+/** A package which discards everything written to it.
+  *
+  * It only counts the files and the bytes they would have when
+  * serialized, e.g., to measure the generator without the cost of a
+  * real package. The bytes are estimated like the libepubgen:*-bytes
+  * statistics of the generators.
+  */
+class EPUBGENAPI EPUBNullPackage : public EPUBPackage
+{
+  // disable copying
+  EPUBNullPackage(const EPUBNullPackage &);
+  EPUBNullPackage &operator=(const EPUBNullPackage &);
+
+public:
+  EPUBNullPackage();
+  ~EPUBNullPackage() override;
+
+  void openXMLFile(const char *name) override;
+  void openElement(const char *name, const librevenge::RVNGPropertyList &attributes) override;
+  void closeElement(const char *name) override;
+  void insertCharacters(const librevenge::RVNGString &characters) override;
+  void closeXMLFile() override;
+
+  void openCSSFile(const char *name) override;
+  void insertRule(const librevenge::RVNGString &selector, const librevenge::RVNGPropertyList &properties) override;
+  void closeCSSFile() override;
+
+  void openBinaryFile(const char *name) override;
+  void insertBinaryData(const librevenge::RVNGBinaryData &data) override;
+  void closeBinaryFile() override;
+
+  void openTextFile(const char *name) override;
+  void insertText(const librevenge::RVNGString &characters) override;
+  void insertLineBreak() override;
+  void closeTextFile() override;
+
+  /// Gets the number of files opened.
+  unsigned long getFiles() const;
+  /// Gets the estimated size of all files, in bytes.
+  unsigned long getBytes() const;
+  /// Sets both counts to 0.
+  void reset();
+
+private:
+  unsigned long m_files;
+  unsigned long m_bytes;
+};
+
+}
+
+#endif // INCLUDED_LIBEPUBGEN_EPUBNULLPACKAGE_H
+
+/* vim:set shiftwidth=2 softtabstop=2 expandtab: */
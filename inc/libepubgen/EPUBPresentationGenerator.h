@@ -43,6 +43,43 @@ public:
   void setSplitHeadingLevel(unsigned level);
   void setSplitSize(unsigned size);
 
+  /** Set the maximum size of the HTML files, whatever the split method.
+    *
+    * A page is never split: a section which reaches this size ends with
+    * the current page. This is reported to the diagnostic handler.
+    *
+    * @param[in] size the estimated size, in bytes; 0 means no maximum
+    *
+    * @sa EPUBTextGenerator::setMaxSectionSize
+    */
+  void setMaxSectionSize(unsigned size);
+
+  /** Set how much memory the finished sections and the images may use.
+    *
+    * @param[in] budget the estimated memory, in bytes; 0 means no limit
+    *
+    * @sa EPUBTextGenerator::setMemoryBudget
+    */
+  void setMemoryBudget(unsigned long budget);
+
+  /** Register a handler for diagnostics.
+    *
+    * @sa EPUBTextGenerator::registerDiagnosticHandler
+    */
+  void registerDiagnosticHandler(EPUBDiagnosticHandler diagnosticHandler);
+
+  /** Register a handler for the progress of the generation.
+    *
+    * @sa EPUBTextGenerator::registerProgressHandler
+    */
+  void registerProgressHandler(EPUBProgressHandler progressHandler);
+
+  /** Was the generation cancelled by the progress handler?
+    *
+    * @sa EPUBTextGenerator::isCancelled
+    */
+  bool isCancelled() const;
+
   /** Set an option for the EPUB generator
    * @param[in] key a value from the EPUBGeneratorOption enumeration
    * @param[in] value depends on the value of key
@@ -71,6 +108,22 @@ public:
     */
   void registerEmbeddedObjectHandler(const librevenge::RVNGString &mimeType, EPUBEmbeddedObject objectHandler);
 
+  /** Get statistics of the generation.
+    *
+    * @param[out] statistics the statistics
+    *
+    * @sa EPUBTextGenerator::getStatistics
+    */
+  void getStatistics(librevenge::RVNGPropertyList &statistics) const;
+
+  /** Get the estimated memory used by the generator.
+    *
+    * @param[out] usage the memory usage, in bytes
+    *
+    * @sa EPUBTextGenerator::getMemoryUsage
+    */
+  void getMemoryUsage(librevenge::RVNGPropertyList &usage) const;
+
   void startDocument(const librevenge::RVNGPropertyList &propList) override;
 
   void endDocument() override;
@@ -10,6 +10,8 @@
 #ifndef INCLUDED_LIBEPUBGEN_EPUBTEXTGENERATOR_H
 #define INCLUDED_LIBEPUBGEN_EPUBTEXTGENERATOR_H
 
+#include <cstddef>
+
 #include <librevenge/librevenge.h>
 #include <librevenge-stream/librevenge-stream.h>
 
@@ -41,8 +43,39 @@ public:
   ~EPUBTextGenerator() override;
 
   void setSplitHeadingLevel(unsigned level);
+
+  /** Set the size of the HTML files when splitting by size.
+    *
+    * @param[in] size the estimated size of the XHTML markup and of the
+    *   images it refers to, in bytes
+    */
   void setSplitSize(unsigned size);
 
+  /** Set the maximum size of the HTML files, whatever the split method.
+    *
+    * A section which reaches this size is split at the next point where
+    * it is possible, even inside a table or a list. This is reported to
+    * the diagnostic handler.
+    *
+    * @param[in] size the estimated size of the XHTML markup and of the
+    *   images it refers to, in bytes; 0 means no maximum
+    */
+  void setMaxSectionSize(unsigned size);
+
+  /** Set how much memory the finished sections and the images may use.
+    *
+    * The sections are kept in memory until endDocument() writes the
+    * package. When a section is finished and the estimated memory of the
+    * finished sections and of the images is over the budget, the
+    * finished sections are moved to a temporary file, and read back when
+    * the package is written. The images are always kept in memory.
+    *
+    * @param[in] budget the estimated memory, in bytes; 0 means no limit
+    *
+    * @sa getMemoryUsage
+    */
+  void setMemoryBudget(unsigned long budget);
+
   /** Set an option for the EPUB generator
    *
    * @param[in] key a value from the EPUBGeneratorOption enumeration
@@ -72,6 +105,122 @@ public:
     */
   void registerEmbeddedObjectHandler(const librevenge::RVNGString &mimeType, EPUBEmbeddedObject objectHandler);
 
+  /** Register a handler for diagnostics.
+    *
+    * @param[in] diagnosticHandler a function called when a problem occurs
+    *
+    * @sa EPUBDiagnosticHandler
+    */
+  void registerDiagnosticHandler(EPUBDiagnosticHandler diagnosticHandler);
+
+  /** Register a handler for the progress of the generation.
+    *
+    * If the handler cancels the generation, the buffered sections,
+    * images and fonts are released and all further calls, including
+    * endDocument(), do nothing. If it happens while endDocument() writes
+    * the package, the package is incomplete and has to be discarded.
+    *
+    * @param[in] progressHandler a function called when a section is
+    *   finished and after each phase of writing the package
+    *
+    * @sa EPUBProgressHandler
+    */
+  void registerProgressHandler(EPUBProgressHandler progressHandler);
+
+  /** Was the generation cancelled by the progress handler?
+    *
+    * @sa registerProgressHandler
+    */
+  bool isCancelled() const;
+
+  /** Get how many elements use each CSS class.
+    *
+    * Classes of styles which are defined but never used have 0 uses;
+    * their rules are not written to the stylesheet.
+    *
+    * @param[out] usage the number of uses, keyed by class name
+    */
+  void getStyleUsage(librevenge::RVNGPropertyList &usage) const;
+
+  /** Get a report of the generated sections, after endDocument().
+    *
+    * Each section has:
+    * - libepubgen:path, and libepubgen:title if it has one
+    * - libepubgen:split-reason: start, page-break, heading, size,
+    *   max-size, second-page-span or plan; libepubgen:heading-level for
+    *   heading
+    * - libepubgen:events: the number of XML events (tags and character
+    *   runs) of the file
+    * - libepubgen:text-length: the number of characters of text
+    * - libepubgen:size: the estimated size of the file and of the images
+    *   it refers to, in bytes
+    * - libepubgen:resources: the images it refers to, each with a
+    *   libepubgen:path
+    *
+    * @param[out] report the sections, in spine order
+    */
+  void getSectionReport(librevenge::RVNGPropertyListVector &report) const;
+
+  /** Get statistics of the generation.
+    *
+    * The counters are cheap to collect, so they are always kept. The
+    * counts of what was written and the times of the write phases are
+    * only known after endDocument().
+    *
+    * The counters are doubles, so big counts of bytes do not overflow.
+    * The statistics are:
+    * - libepubgen:sections: the number of HTML files started
+    * - libepubgen:style-cache-hits, libepubgen:style-cache-misses: the
+    *   lookups of CSS classes which found an existing class, and the
+    *   classes created
+    * - libepubgen:images, libepubgen:fonts: the images and fonts
+    *   inserted; libepubgen:images-deduplicated and
+    *   libepubgen:fonts-deduplicated: how many of them were already
+    *   inserted before, so were not written again
+    * - libepubgen:files: the number of files written to the package
+    * - libepubgen:elements, libepubgen:spans: the number of XML elements,
+    *   and of span elements, written
+    * - libepubgen:text-bytes: the bytes of text in XML files
+    * - libepubgen:xml-bytes, libepubgen:css-bytes,
+    *   libepubgen:binary-bytes, libepubgen:text-file-bytes: the bytes
+    *   written to each type of file; estimated for XML and CSS
+    * - libepubgen:generation-time: the seconds from startDocument() to
+    *   endDocument()
+    * - libepubgen:write-container-time, libepubgen:write-root-time,
+    *   libepubgen:write-navigation-time,
+    *   libepubgen:write-stylesheet-time, libepubgen:write-sections-time,
+    *   libepubgen:write-images-time, libepubgen:write-fonts-time: the
+    *   seconds spent in each phase of writing the package in
+    *   endDocument()
+    *
+    * @param[out] statistics the statistics
+    */
+  void getStatistics(librevenge::RVNGPropertyList &statistics) const;
+
+  /** Get the estimated memory used by the generator.
+    *
+    * The memory is estimated from the data the generator keeps, without
+    * tracking the allocations, so it is cheap enough to be always on. It
+    * can be queried during the conversion, e.g., to stop a document which
+    * uses too much.
+    *
+    * For each part, there is libepubgen:<part>-bytes, the current usage,
+    * and libepubgen:<part>-peak-bytes, the highest usage so far. The
+    * peaks are sampled at the end of each section, before the package is
+    * written and when this function is called. The parts are:
+    * - xhtml: the content of the finished sections
+    * - zones: the content of the current section: the text, the notes,
+    *   the comments and the text boxes
+    * - styles: the CSS classes
+    * - images, fonts: the embedded binaries
+    * - recorded: the calls recorded for the headers, the footers, the
+    *   repeated table rows and the split plan
+    * - total: the sum of the above
+    *
+    * @param[out] usage the memory usage, in bytes
+    */
+  void getMemoryUsage(librevenge::RVNGPropertyList &usage) const;
+
   void setDocumentMetaData(const librevenge::RVNGPropertyList &propList) override;
 
   void startDocument(const librevenge::RVNGPropertyList &propList) override;
@@ -111,6 +260,19 @@ public:
   void insertTab() override;
   void insertSpace() override;
   void insertText(const librevenge::RVNGString &text) override;
+  /** Insert text from a UTF-8 buffer.
+    *
+    * The same as insertText(const librevenge::RVNGString &), without the
+    * need to build a librevenge::RVNGString: the text is copied directly
+    * into the current section. Only text in a header, a footer or a
+    * repeated table header row is still copied into a string, as it is
+    * recorded.
+    *
+    * @param[in] text the UTF-8 text; it does not need to be null-terminated,
+    *   but it ends at a null character before length, as a RVNGString does
+    * @param[in] length the length of text, in bytes
+    */
+  void insertText(const char *text, std::size_t length);
   void insertLineBreak() override;
 
   void insertField(const librevenge::RVNGPropertyList &propList) override;
@@ -0,0 +1,157 @@
+/* -*- Mode: C++; tab-width: 2; indent-tabs-mode: nil; c-basic-offset: 2 -*- */
+/*
+ * This file is part of the libepubgen project.
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#ifndef INCLUDED_LIBEPUBGEN_EPUBTEXTTRACE_H
+#define INCLUDED_LIBEPUBGEN_EPUBTEXTTRACE_H
+
+#include <istream>
+#include <ostream>
+
+#include <librevenge/librevenge.h>
+
+#include "libepubgen-api.h"
+
+namespace libepubgen
+{
+
+class EPUBTextElements;
+
+/** Records the calls of a text document into a binary trace.
+  *
+  * The trace can be replayed by EPUBTextTraceReplayer, e.g., to profile
+  * EPUBTextGenerator without the import library which produced the calls.
+  * Binary data, like images, are recorded as their base64 representation.
+  */
+class EPUBGENAPI EPUBTextTraceRecorder : public librevenge::RVNGTextInterface
+{
+  // disable copying
+  EPUBTextTraceRecorder(const EPUBTextTraceRecorder &);
+  EPUBTextTraceRecorder &operator=(const EPUBTextTraceRecorder &);
+
+  struct Impl;
+
+public:
+  /** Constructor.
+    *
+    * @param[in] trace the stream to write the trace to; it must be opened
+    *   in binary mode
+    * @param[in] next an interface which gets the calls after they are
+    *   recorded, e.g., an EPUBTextGenerator; may be null
+    *
+    * The trace is only complete when the recorder is destroyed.
+    */
+  explicit EPUBTextTraceRecorder(std::ostream &trace, librevenge::RVNGTextInterface *next = nullptr);
+  ~EPUBTextTraceRecorder() override;
+
+  void closeComment() override;
+  void closeEndnote() override;
+  void closeFooter() override;
+  void closeFootnote() override;
+  void closeFrame() override;
+  void closeGroup() override;
+  void closeHeader() override;
+  void closeLink() override;
+  void closeListElement() override;
+  void closeOrderedListLevel() override;
+  void closePageSpan() override;
+  void closeParagraph() override;
+  void closeSection() override;
+  void closeSpan() override;
+  void closeTable() override;
+  void closeTableCell() override;
+  void closeTableRow() override;
+  void closeTextBox() override;
+  void closeUnorderedListLevel() override;
+  void defineCharacterStyle(const librevenge::RVNGPropertyList &propList) override;
+  void defineEmbeddedFont(const librevenge::RVNGPropertyList &propList) override;
+  void defineGraphicStyle(const librevenge::RVNGPropertyList &propList) override;
+  void definePageStyle(const librevenge::RVNGPropertyList &propList) override;
+  void defineParagraphStyle(const librevenge::RVNGPropertyList &propList) override;
+  void defineSectionStyle(const librevenge::RVNGPropertyList &propList) override;
+  void drawConnector(const librevenge::RVNGPropertyList &propList) override;
+  void drawEllipse(const librevenge::RVNGPropertyList &propList) override;
+  void drawPath(const librevenge::RVNGPropertyList &propList) override;
+  void drawPolygon(const librevenge::RVNGPropertyList &propList) override;
+  void drawPolyline(const librevenge::RVNGPropertyList &propList) override;
+  void drawRectangle(const librevenge::RVNGPropertyList &propList) override;
+  void endDocument() override;
+  void insertBinaryObject(const librevenge::RVNGPropertyList &propList) override;
+  void insertCoveredTableCell(const librevenge::RVNGPropertyList &propList) override;
+  void insertEquation(const librevenge::RVNGPropertyList &propList) override;
+  void insertField(const librevenge::RVNGPropertyList &propList) override;
+  void insertLineBreak() override;
+  void insertSpace() override;
+  void insertTab() override;
+  void insertText(const librevenge::RVNGString &text) override;
+  void openComment(const librevenge::RVNGPropertyList &propList) override;
+  void openEndnote(const librevenge::RVNGPropertyList &propList) override;
+  void openFooter(const librevenge::RVNGPropertyList &propList) override;
+  void openFootnote(const librevenge::RVNGPropertyList &propList) override;
+  void openFrame(const librevenge::RVNGPropertyList &propList) override;
+  void openGroup(const librevenge::RVNGPropertyList &propList) override;
+  void openHeader(const librevenge::RVNGPropertyList &propList) override;
+  void openLink(const librevenge::RVNGPropertyList &propList) override;
+  void openListElement(const librevenge::RVNGPropertyList &propList) override;
+  void openOrderedListLevel(const librevenge::RVNGPropertyList &propList) override;
+  void openPageSpan(const librevenge::RVNGPropertyList &propList) override;
+  void openParagraph(const librevenge::RVNGPropertyList &propList) override;
+  void openSection(const librevenge::RVNGPropertyList &propList) override;
+  void openSpan(const librevenge::RVNGPropertyList &propList) override;
+  void openTable(const librevenge::RVNGPropertyList &propList) override;
+  void openTableCell(const librevenge::RVNGPropertyList &propList) override;
+  void openTableRow(const librevenge::RVNGPropertyList &propList) override;
+  void openTextBox(const librevenge::RVNGPropertyList &propList) override;
+  void openUnorderedListLevel(const librevenge::RVNGPropertyList &propList) override;
+  void setDocumentMetaData(const librevenge::RVNGPropertyList &propList) override;
+  void startDocument(const librevenge::RVNGPropertyList &propList) override;
+
+private:
+  Impl *const m_impl;
+};
+
+/** Replays a trace written by EPUBTextTraceRecorder.
+  */
+class EPUBGENAPI EPUBTextTraceReplayer
+{
+  // disable copying
+  EPUBTextTraceReplayer(const EPUBTextTraceReplayer &);
+  EPUBTextTraceReplayer &operator=(const EPUBTextTraceReplayer &);
+
+public:
+  EPUBTextTraceReplayer();
+  ~EPUBTextTraceReplayer();
+
+  /** Read a trace.
+    *
+    * The calls are decoded in advance, so replaying them only measures
+    * the interface they are replayed into.
+    *
+    * @param[in] trace the stream to read the trace from
+    * @return false if the trace is not valid; the calls read before the
+    *   error are kept
+    */
+  bool load(std::istream &trace);
+
+  /** Replay the calls of the trace.
+    *
+    * It can be called more than once.
+    *
+    * @param[in] iface the interface to send the calls to
+    */
+  void replay(librevenge::RVNGTextInterface *iface) const;
+
+private:
+  EPUBTextElements *const m_elements;
+};
+
+}
+
+#endif // INCLUDED_LIBEPUBGEN_EPUBTEXTTRACE_H
+
+/* vim:set shiftwidth=2 softtabstop=2 expandtab: */
@@ -0,0 +1,39 @@
+/* -*- Mode: C++; tab-width: 2; indent-tabs-mode: nil; c-basic-offset: 2 -*- */
+/*
+ * This file is part of the libepubgen project.
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#ifndef INCLUDED_LIBEPUBGEN_EPUBTRACEEVENTS_H
+#define INCLUDED_LIBEPUBGEN_EPUBTRACEEVENTS_H
+
+#include <ostream>
+
+#include "libepubgen-api.h"
+
+namespace libepubgen
+{
+
+/** Write timed events of the phases of the generators to a stream.
+  *
+  * The events are written in the JSON format of Chrome's trace event
+  * profiling tool, which can be opened by chrome://tracing or Perfetto.
+  * The events of all generators, in all threads, go to the same stream.
+  *
+  * The events are only recorded if libepubgen was configured with
+  * --enable-trace; otherwise this does nothing.
+  *
+  * @param[in] stream the stream to write the events to, or null to stop
+  *   writing them; the stream which was set before is completed
+  * @return true if events are recorded
+  */
+EPUBGENAPI bool setTraceEventStream(std::ostream *stream);
+
+}
+
+#endif // INCLUDED_LIBEPUBGEN_EPUBTRACEEVENTS_H
+
+/* vim:set shiftwidth=2 softtabstop=2 expandtab: */
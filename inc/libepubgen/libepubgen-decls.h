@@ -33,7 +33,7 @@ enum EPUBSplitMethod
   EPUB_SPLIT_METHOD_HEADING, //< The content will be split on headings.
   EPUB_SPLIT_METHOD_SIZE, //< The content will be split into roughly equal-sized chunks.
   EPUB_SPLIT_METHOD_NONE, //< The whole content will be in a single HTML.
-  EPUB_SPLIT_METHOD_DETECT //< The first method that actually results in splitting will be used.
+  EPUB_SPLIT_METHOD_DETECT //< Split on headings, and on page breaks in sections without headings, if the sections are not too small; on size if a section gets too large.
 };
 
 /** An opaque type used for communication with the parent generator.
@@ -63,6 +63,38 @@ typedef bool (*EPUBEmbeddedImage)(const librevenge::RVNGBinaryData &input, libre
   */
 typedef bool (*EPUBEmbeddedObject)(const librevenge::RVNGBinaryData &data, const EPUBEmbeddingContact &contact);
 
+/** The possible problems reported to EPUBDiagnosticHandler.
+  */
+enum EPUBDiagnostic
+{
+  EPUB_DIAGNOSTIC_SECTION_SIZE_CAP, //< A section reached the maximum section size; unless it was the last one, the content continues in a new section.
+  EPUB_DIAGNOSTIC_SPILL_DAMAGED, //< A file spilled over the memory budget could not be read back; it is missing from the package.
+};
+
+/** Handler for diagnostics.
+  *
+  * @param[in] diagnostic what happened
+  * @param[in] details the details: for EPUB_DIAGNOSTIC_SECTION_SIZE_CAP,
+  *   libepubgen:size is the estimated size of the section and
+  *   libepubgen:max-size the maximum section size, in bytes; for
+  *   EPUB_DIAGNOSTIC_SPILL_DAMAGED, libepubgen:path is the path of the file
+  */
+typedef void (*EPUBDiagnosticHandler)(EPUBDiagnostic diagnostic, const librevenge::RVNGPropertyList &details);
+
+/** Handler for the progress of a generation.
+  *
+  * It is called when a section is finished and after each phase of
+  * writing the package in endDocument().
+  *
+  * @param[in] progress libepubgen:phase is the phase which ended:
+  *   generation for a section, then container, root, navigation,
+  *   stylesheet, sections, images and fonts; libepubgen:sections is the
+  *   number of finished sections and libepubgen:bytes, a double, the
+  *   estimated size of the finished sections
+  * @return false to cancel the generation
+  */
+typedef bool (*EPUBProgressHandler)(const librevenge::RVNGPropertyList &progress);
+
 /** The possible ways to represent styles in CSS/HTML files.
   */
 enum EPUBStylesMethod
@@ -79,13 +111,76 @@ enum EPUBLayoutMethod
   EPUB_LAYOUT_METHOD_FIXED, //< Exactly one page per HTML file.
 };
 
+/** The possible ways to distribute the CSS rules between stylesheets.
+  */
+enum EPUBStylesheetMethod
+{
+  EPUB_STYLESHEET_METHOD_SINGLE, //< All rules are in a single stylesheet, linked from every HTML file.
+  EPUB_STYLESHEET_METHOD_PER_SECTION, //< Each HTML file links a shared stylesheet and a stylesheet with the classes it uses.
+};
+
+/** The possible ways to describe the styles of spans.
+  */
+enum EPUBSpanStylesMethod
+{
+  EPUB_SPAN_STYLES_METHOD_FULL, //< Each span has all of its text properties.
+  EPUB_SPAN_STYLES_METHOD_DELTA, //< Paragraphs have their text properties, spans only what differs; spans adding nothing are omitted.
+};
+
+/** The possible ways to name the CSS classes.
+  */
+enum EPUBClassNamesMethod
+{
+  EPUB_CLASS_NAMES_METHOD_COUNTER, //< Classes are numbered in the order they are first used.
+  EPUB_CLASS_NAMES_METHOD_CONTENT, //< Class names are derived from the properties, so they don't depend on the rest of the document.
+};
+
+/** The possible ways to choose the split points.
+  */
+enum EPUBSplitPlanMethod
+{
+  EPUB_SPLIT_PLAN_METHOD_GREEDY, //< Split as soon as the split method allows it.
+  EPUB_SPLIT_PLAN_METHOD_BALANCED, //< Record the whole document first, then choose the split points giving the most even sections.
+};
+
+/** The possible ways to place footnotes, endnotes and comments.
+  */
+enum EPUBNotesMethod
+{
+  EPUB_NOTES_METHOD_INLINE, //< The notes are at the end of the HTML file referring to them.
+  EPUB_NOTES_METHOD_SEPARATE, //< The notes of each HTML file are in a separate file, out of the reading order.
+};
+
+/** The possible ways to build the table of contents.
+  */
+enum EPUBTocMethod
+{
+  EPUB_TOC_METHOD_SECTIONS, //< One entry for each HTML file.
+  EPUB_TOC_METHOD_OUTLINE, //< One entry for each heading, nested by level, linking to the heading itself.
+};
+
+/** The possible ways to output the HTML files of the sections.
+  */
+enum EPUBOutputMethod
+{
+  EPUB_OUTPUT_METHOD_PACKAGE, //< The sections are written to the package.
+  EPUB_OUTPUT_METHOD_MEASURE, //< The sections are only counted in the statistics, as they are finished, and never written nor kept.
+};
+
 /** The possible options for a generator.
   */
 enum EPUBGeneratorOption
 {
   EPUB_GENERATOR_OPTION_SPLIT, //< EPUBSplitMethod.
   EPUB_GENERATOR_OPTION_STYLES, //< EPUBStylesMethod.
-  EPUB_GENERATOR_OPTION_LAYOUT //< EPUBLayoutMethod.
+  EPUB_GENERATOR_OPTION_LAYOUT, //< EPUBLayoutMethod.
+  EPUB_GENERATOR_OPTION_STYLESHEET, //< EPUBStylesheetMethod.
+  EPUB_GENERATOR_OPTION_SPAN_STYLES, //< EPUBSpanStylesMethod.
+  EPUB_GENERATOR_OPTION_CLASS_NAMES, //< EPUBClassNamesMethod.
+  EPUB_GENERATOR_OPTION_SPLIT_PLAN, //< EPUBSplitPlanMethod.
+  EPUB_GENERATOR_OPTION_NOTES, //< EPUBNotesMethod.
+  EPUB_GENERATOR_OPTION_TOC, //< EPUBTocMethod.
+  EPUB_GENERATOR_OPTION_OUTPUT //< EPUBOutputMethod.
 };
 
 }
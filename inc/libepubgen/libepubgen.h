@@ -11,9 +11,12 @@
 #define INCLUDED_LIBEPUBGEN_LIBEPUBGEN_H
 
 #include "EPUBDrawingGenerator.h"
+#include "EPUBNullPackage.h"
 #include "EPUBPackage.h"
 #include "EPUBPresentationGenerator.h"
 #include "EPUBTextGenerator.h"
+#include "EPUBTextTrace.h"
+#include "EPUBTraceEvents.h"
 
 #endif // INCLUDED_LIBEPUBGEN_LIBEPUBGEN_H
 
@@ -0,0 +1,526 @@
+/* -*- Mode: C++; tab-width: 2; indent-tabs-mode: nil; c-basic-offset: 2 -*- */
+/*
+ * This file is part of the libepubgen project.
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <new>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <sys/resource.h>
+
+#include <librevenge/librevenge.h>
+
+#include <libepubgen/libepubgen.h>
+
+namespace
+{
+
+/// The number of allocations and the allocated bytes since the last reset.
+std::size_t allocationCount = 0;
+std::size_t allocationSize = 0;
+
+void *allocate(std::size_t size)
+{
+  ++allocationCount;
+  allocationSize += size;
+  if (void *const ptr = std::malloc(size ? size : 1))
+    return ptr;
+  throw std::bad_alloc();
+}
+
+}
+
+void *operator new(std::size_t size)
+{
+  return allocate(size);
+}
+
+void *operator new[](std::size_t size)
+{
+  return allocate(size);
+}
+
+void operator delete(void *ptr) noexcept
+{
+  std::free(ptr);
+}
+
+void operator delete[](void *ptr) noexcept
+{
+  std::free(ptr);
+}
+
+namespace
+{
+
+using librevenge::RVNGPropertyList;
+
+enum Generator
+{
+  GENERATOR_TEXT,
+  GENERATOR_PRESENTATION,
+  GENERATOR_DRAWING
+};
+
+/// The parameters of a synthetic document.
+struct Workload
+{
+  Workload();
+
+  Generator m_generator;
+  unsigned m_paragraphs;
+  /// Spans in each paragraph.
+  unsigned m_spans;
+  /// A heading before every that many paragraphs; 0 for none.
+  unsigned m_headingEvery;
+  unsigned m_tables;
+  unsigned m_rows;
+  unsigned m_columns;
+  unsigned m_footnotes;
+  unsigned m_images;
+  /// The size of an image, in bytes.
+  unsigned m_imageSize;
+  libepubgen::EPUBSplitMethod m_split;
+  libepubgen::EPUBStylesMethod m_styles;
+  libepubgen::EPUBSpanStylesMethod m_spanStyles;
+  libepubgen::EPUBStylesheetMethod m_stylesheet;
+  libepubgen::EPUBClassNamesMethod m_classNames;
+  libepubgen::EPUBOutputMethod m_output;
+  unsigned m_repeat;
+};
+
+Workload::Workload()
+  : m_generator(GENERATOR_TEXT)
+  , m_paragraphs(2000)
+  , m_spans(4)
+  , m_headingEvery(50)
+  , m_tables(10)
+  , m_rows(20)
+  , m_columns(5)
+  , m_footnotes(100)
+  , m_images(10)
+  , m_imageSize(16384)
+  , m_split(libepubgen::EPUB_SPLIT_METHOD_PAGE_BREAK)
+  , m_styles(libepubgen::EPUB_STYLES_METHOD_CSS)
+  , m_spanStyles(libepubgen::EPUB_SPAN_STYLES_METHOD_FULL)
+  , m_stylesheet(libepubgen::EPUB_STYLESHEET_METHOD_SINGLE)
+  , m_classNames(libepubgen::EPUB_CLASS_NAMES_METHOD_COUNTER)
+  , m_output(libepubgen::EPUB_OUTPUT_METHOD_PACKAGE)
+  , m_repeat(3)
+{
+}
+
+const char *const TEXT = "Lorem ipsum dolor sit amet, consectetur adipiscing elit, sed do eiusmod tempor.";
+
+const char *const GENERATOR_NAMES[] = {"text", "presentation", "drawing"};
+const char *const SPLIT_NAMES[] = {"page-break", "heading", "size", "none", "detect"};
+const char *const STYLES_NAMES[] = {"css", "inline"};
+const char *const SPAN_STYLES_NAMES[] = {"full", "delta"};
+const char *const STYLESHEET_NAMES[] = {"single", "per-section"};
+const char *const CLASS_NAMES_NAMES[] = {"counter", "content"};
+const char *const OUTPUT_NAMES[] = {"package", "measure"};
+
+/// Is index one of count points spread evenly over total?
+bool isSpread(const unsigned index, const unsigned count, const unsigned total)
+{
+  if ((0 == count) || (0 == total))
+    return false;
+  if (count >= total)
+    return true;
+  return (index * count) / total != ((index + 1) * count) / total;
+}
+
+RVNGPropertyList makeSpanProps(const unsigned index)
+{
+  RVNGPropertyList props;
+  // A few distinct styles, as in a real document.
+  if (index % 3 == 1)
+    props.insert("fo:font-weight", "bold");
+  if (index % 5 == 2)
+    props.insert("fo:font-style", "italic");
+  std::ostringstream size;
+  size << (10 + index % 4) << "pt";
+  props.insert("fo:font-size", size.str().c_str());
+  return props;
+}
+
+RVNGPropertyList makeImageProps(const unsigned index, const unsigned size)
+{
+  std::vector<unsigned char> data(size ? size : 1, static_cast<unsigned char>(index));
+  // Make every image different, so they are not shared.
+  for (std::size_t i = 0; (i < sizeof(index)) && (i < data.size()); ++i)
+    data[i] = static_cast<unsigned char>(index >> (8 * i));
+  RVNGPropertyList props;
+  props.insert("librevenge:mime-type", "image/png");
+  props.insert("office:binary-data", librevenge::RVNGBinaryData(&data[0], data.size()));
+  return props;
+}
+
+template<class Interface>
+void writeSpans(Interface &generator, const Workload &workload, const unsigned paragraph)
+{
+  for (unsigned span = 0; span < workload.m_spans; ++span)
+  {
+    generator.openSpan(makeSpanProps(paragraph + span));
+    generator.insertText(TEXT);
+    generator.closeSpan();
+  }
+}
+
+template<class Interface>
+void writeCells(Interface &generator, const Workload &workload, const unsigned table)
+{
+  for (unsigned row = 0; row < workload.m_rows; ++row)
+  {
+    generator.openTableRow(RVNGPropertyList());
+    for (unsigned column = 0; column < workload.m_columns; ++column)
+    {
+      generator.openTableCell(RVNGPropertyList());
+      generator.openParagraph(RVNGPropertyList());
+      generator.openSpan(makeSpanProps(table + row + column));
+      generator.insertText("cell");
+      generator.closeSpan();
+      generator.closeParagraph();
+      generator.closeTableCell();
+    }
+    generator.closeTableRow();
+  }
+}
+
+void writeText(libepubgen::EPUBTextGenerator &generator, const Workload &workload)
+{
+  generator.startDocument(RVNGPropertyList());
+  generator.openPageSpan(RVNGPropertyList());
+  unsigned table = 0;
+  unsigned image = 0;
+  for (unsigned i = 0; i < workload.m_paragraphs; ++i)
+  {
+    RVNGPropertyList paraProps;
+    if ((0 != workload.m_headingEvery) && (0 == i % workload.m_headingEvery))
+    {
+      paraProps.insert("text:outline-level", 1);
+      if (0 != i)
+        paraProps.insert("fo:break-before", "page");
+    }
+    generator.openParagraph(paraProps);
+    writeSpans(generator, workload, i);
+    if (isSpread(i, workload.m_footnotes, workload.m_paragraphs))
+    {
+      generator.openFootnote(RVNGPropertyList());
+      generator.openParagraph(RVNGPropertyList());
+      generator.insertText(TEXT);
+      generator.closeParagraph();
+      generator.closeFootnote();
+    }
+    if (isSpread(i, workload.m_images, workload.m_paragraphs))
+    {
+      generator.openFrame(RVNGPropertyList());
+      generator.insertBinaryObject(makeImageProps(image++, workload.m_imageSize));
+      generator.closeFrame();
+    }
+    generator.closeParagraph();
+
+    if (isSpread(i, workload.m_tables, workload.m_paragraphs))
+    {
+      generator.openTable(RVNGPropertyList());
+      writeCells(generator, workload, table++);
+      generator.closeTable();
+    }
+  }
+  generator.closePageSpan();
+  generator.endDocument();
+}
+
+/** Writes a presentation or a drawing: startPage and endPage are the only difference.
+  *
+  * A drawing has no notes, so startNotes and endNotes are null for it.
+  */
+template<class Interface>
+void writePaged(Interface &generator, const Workload &workload, void (Interface::*startPage)(const RVNGPropertyList &), void (Interface::*endPage)(),
+                void (Interface::*startNotes)(const RVNGPropertyList &), void (Interface::*endNotes)())
+{
+  const unsigned paragraphsPerPage = 10;
+  const unsigned pages = (workload.m_paragraphs + paragraphsPerPage - 1) / paragraphsPerPage;
+  generator.startDocument(RVNGPropertyList());
+  unsigned table = 0;
+  unsigned image = 0;
+  for (unsigned i = 0; i < workload.m_paragraphs; i += paragraphsPerPage)
+  {
+    const unsigned page = i / paragraphsPerPage;
+    (generator.*startPage)(RVNGPropertyList());
+    generator.startTextObject(RVNGPropertyList());
+    for (unsigned j = i; (j < i + paragraphsPerPage) && (j < workload.m_paragraphs); ++j)
+    {
+      generator.openParagraph(RVNGPropertyList());
+      writeSpans(generator, workload, j);
+      generator.closeParagraph();
+    }
+    generator.endTextObject();
+    if (isSpread(page, workload.m_tables, pages))
+    {
+      generator.startTableObject(RVNGPropertyList());
+      writeCells(generator, workload, table++);
+      generator.endTableObject();
+    }
+    if (isSpread(page, workload.m_images, pages))
+      generator.drawGraphicObject(makeImageProps(image++, workload.m_imageSize));
+    if (startNotes && isSpread(page, workload.m_footnotes, pages))
+    {
+      (generator.*startNotes)(RVNGPropertyList());
+      generator.openParagraph(RVNGPropertyList());
+      generator.insertText(TEXT);
+      generator.closeParagraph();
+      (generator.*endNotes)();
+    }
+    (generator.*endPage)();
+  }
+  generator.endDocument();
+}
+
+/// Runs the workload; the statistics count the sections even if they are only measured.
+void run(const Workload &workload, libepubgen::EPUBNullPackage &package, RVNGPropertyList &statistics)
+{
+  switch (workload.m_generator)
+  {
+  case GENERATOR_TEXT:
+  {
+    libepubgen::EPUBTextGenerator generator(&package);
+    generator.setOption(libepubgen::EPUB_GENERATOR_OPTION_SPLIT, workload.m_split);
+    generator.setOption(libepubgen::EPUB_GENERATOR_OPTION_STYLES, workload.m_styles);
+    generator.setOption(libepubgen::EPUB_GENERATOR_OPTION_SPAN_STYLES, workload.m_spanStyles);
+    generator.setOption(libepubgen::EPUB_GENERATOR_OPTION_STYLESHEET, workload.m_stylesheet);
+    generator.setOption(libepubgen::EPUB_GENERATOR_OPTION_CLASS_NAMES, workload.m_classNames);
+    generator.setOption(libepubgen::EPUB_GENERATOR_OPTION_OUTPUT, workload.m_output);
+    writeText(generator, workload);
+    generator.getStatistics(statistics);
+    break;
+  }
+  case GENERATOR_PRESENTATION:
+  {
+    libepubgen::EPUBPresentationGenerator generator(&package);
+    generator.setOption(libepubgen::EPUB_GENERATOR_OPTION_SPLIT, workload.m_split);
+    generator.setOption(libepubgen::EPUB_GENERATOR_OPTION_OUTPUT, workload.m_output);
+    writePaged(generator, workload, &libepubgen::EPUBPresentationGenerator::startSlide, &libepubgen::EPUBPresentationGenerator::endSlide,
+               &libepubgen::EPUBPresentationGenerator::startNotes, &libepubgen::EPUBPresentationGenerator::endNotes);
+    generator.getStatistics(statistics);
+    break;
+  }
+  case GENERATOR_DRAWING:
+  {
+    libepubgen::EPUBDrawingGenerator generator(&package);
+    generator.setOption(libepubgen::EPUB_GENERATOR_OPTION_SPLIT, workload.m_split);
+    generator.setOption(libepubgen::EPUB_GENERATOR_OPTION_OUTPUT, workload.m_output);
+    writePaged<libepubgen::EPUBDrawingGenerator>(generator, workload, &libepubgen::EPUBDrawingGenerator::startPage, &libepubgen::EPUBDrawingGenerator::endPage, nullptr, nullptr);
+    generator.getStatistics(statistics);
+    break;
+  }
+  }
+}
+
+/// Gets a counter of the statistics, or 0 if it is missing.
+double getCount(const RVNGPropertyList &statistics, const char *const name)
+{
+  const librevenge::RVNGProperty *const count = statistics[name];
+  return count ? count->getDouble() : 0;
+}
+
+/// Gets the peak resident set size of the process, in kB.
+long getPeakRSS()
+{
+  rusage usage;
+  if (0 != getrusage(RUSAGE_SELF, &usage))
+    return 0;
+  return usage.ru_maxrss;
+}
+
+void measure(const Workload &workload)
+{
+  double best = 0;
+  std::size_t allocations = 0;
+  std::size_t allocated = 0;
+  libepubgen::EPUBNullPackage package;
+  RVNGPropertyList statistics;
+  for (unsigned i = 0; i < workload.m_repeat; ++i)
+  {
+    allocationCount = allocationSize = 0;
+    const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    run(workload, package, statistics);
+    const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    allocations = allocationCount;
+    allocated = allocationSize;
+    if ((0 == i) || (seconds < best))
+      best = seconds;
+  }
+  if (0 >= best)
+    best = 1e-9;
+  const double bytes = getCount(statistics, "libepubgen:xml-bytes") + getCount(statistics, "libepubgen:css-bytes")
+                       + getCount(statistics, "libepubgen:binary-bytes") + getCount(statistics, "libepubgen:text-file-bytes");
+  const bool text = GENERATOR_TEXT == workload.m_generator;
+
+  std::cout << std::left << std::setw(13) << GENERATOR_NAMES[workload.m_generator]
+            << " split=" << std::setw(11) << SPLIT_NAMES[workload.m_split]
+            << " styles=" << std::setw(7) << (text ? STYLES_NAMES[workload.m_styles] : "-")
+            << " span-styles=" << std::setw(6) << (text ? SPAN_STYLES_NAMES[workload.m_spanStyles] : "-")
+            << " stylesheet=" << std::setw(12) << (text ? STYLESHEET_NAMES[workload.m_stylesheet] : "-")
+            << " class-names=" << std::setw(8) << (text ? CLASS_NAMES_NAMES[workload.m_classNames] : "-")
+            << " output=" << std::setw(7) << OUTPUT_NAMES[workload.m_output]
+            << std::right << std::fixed << std::setprecision(3)
+            << std::setw(9) << best * 1000 << " ms"
+            << std::setprecision(0)
+            << std::setw(10) << workload.m_paragraphs / best << " para/s"
+            << std::setprecision(2)
+            << std::setw(8) << bytes / best / (1 << 20) << " MB/s"
+            << std::setw(6) << unsigned(getCount(statistics, "libepubgen:files")) << " files"
+            << std::setw(10) << allocations << " allocs"
+            << std::setw(8) << double(allocated) / (1 << 20) << " MB"
+            << std::setw(8) << getPeakRSS() / 1024 << " MB peak RSS"
+            << std::endl;
+}
+
+bool parseName(const std::string &value, const char *const *names, const std::size_t count, int &result)
+{
+  for (std::size_t i = 0; i < count; ++i)
+  {
+    if (value == names[i])
+    {
+      result = int(i);
+      return true;
+    }
+  }
+  return false;
+}
+
+void usage(const char *const program)
+{
+  std::cerr << "Usage: " << program << " [--option=value ...]\n"
+            "  --generator=text|presentation|drawing\n"
+            "  --split=page-break|heading|size|none|detect\n"
+            "  --styles=css|inline\n"
+            "  --span-styles=full|delta --stylesheet=single|per-section\n"
+            "  --class-names=counter|content (text only)\n"
+            "  --output=package|measure (measure drops the sections once they are counted)\n"
+            "  --paragraphs=N --spans=N --heading-every=N\n"
+            "  --tables=N --rows=N --columns=N\n"
+            "  --footnotes=N (notes of the slides for a presentation)\n"
+            "  --images=N --image-size=BYTES --repeat=N\n"
+            "Without --generator, --split or --styles, all of their values are run.\n";
+}
+
+}
+
+int main(int argc, char *argv[])
+{
+  Workload workload;
+  int generator = -1;
+  int split = -1;
+  int styles = -1;
+
+  for (int i = 1; i < argc; ++i)
+  {
+    const std::string arg(argv[i]);
+    const std::string::size_type eq = arg.find('=');
+    if ((0 != arg.compare(0, 2, "--")) || (std::string::npos == eq))
+    {
+      usage(argv[0]);
+      return 1;
+    }
+    const std::string name = arg.substr(2, eq - 2);
+    const std::string value = arg.substr(eq + 1);
+    const unsigned number = unsigned(std::strtoul(value.c_str(), nullptr, 10));
+    bool ok = true;
+    if (name == "generator")
+      ok = parseName(value, GENERATOR_NAMES, 3, generator);
+    else if (name == "split")
+      ok = parseName(value, SPLIT_NAMES, 5, split);
+    else if (name == "styles")
+      ok = parseName(value, STYLES_NAMES, 2, styles);
+    else if (name == "span-styles")
+    {
+      int spanStyles = 0;
+      ok = parseName(value, SPAN_STYLES_NAMES, 2, spanStyles);
+      workload.m_spanStyles = libepubgen::EPUBSpanStylesMethod(spanStyles);
+    }
+    else if (name == "stylesheet")
+    {
+      int stylesheet = 0;
+      ok = parseName(value, STYLESHEET_NAMES, 2, stylesheet);
+      workload.m_stylesheet = libepubgen::EPUBStylesheetMethod(stylesheet);
+    }
+    else if (name == "class-names")
+    {
+      int classNames = 0;
+      ok = parseName(value, CLASS_NAMES_NAMES, 2, classNames);
+      workload.m_classNames = libepubgen::EPUBClassNamesMethod(classNames);
+    }
+    else if (name == "output")
+    {
+      int output = 0;
+      ok = parseName(value, OUTPUT_NAMES, 2, output);
+      workload.m_output = libepubgen::EPUBOutputMethod(output);
+    }
+    else if (name == "paragraphs")
+      workload.m_paragraphs = number;
+    else if (name == "spans")
+      workload.m_spans = number;
+    else if (name == "heading-every")
+      workload.m_headingEvery = number;
+    else if (name == "tables")
+      workload.m_tables = number;
+    else if (name == "rows")
+      workload.m_rows = number;
+    else if (name == "columns")
+      workload.m_columns = number;
+    else if (name == "footnotes")
+      workload.m_footnotes = number;
+    else if (name == "images")
+      workload.m_images = number;
+    else if (name == "image-size")
+      workload.m_imageSize = number;
+    else if (name == "repeat")
+      workload.m_repeat = number ? number : 1;
+    else
+      ok = false;
+    if (!ok)
+    {
+      usage(argv[0]);
+      return 1;
+    }
+  }
+
+  for (int g = 0; g < 3; ++g)
+  {
+    if ((generator >= 0) && (generator != g))
+      continue;
+    workload.m_generator = Generator(g);
+    for (int s = 0; s < 5; ++s)
+    {
+      if ((split >= 0) && (split != s))
+        continue;
+      workload.m_split = libepubgen::EPUBSplitMethod(s);
+      for (int st = 0; st < 2; ++st)
+      {
+        if ((styles >= 0) && (styles != st))
+          continue;
+        // The paged generators have no styles option.
+        if ((GENERATOR_TEXT != g) && (0 != st))
+          continue;
+        workload.m_styles = libepubgen::EPUBStylesMethod(st);
+        measure(workload);
+      }
+    }
+  }
+
+  return 0;
+}
+
+/* vim:set shiftwidth=2 softtabstop=2 expandtab: */
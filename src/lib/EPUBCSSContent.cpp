@@ -9,29 +9,70 @@
 
 #include "EPUBCSSContent.h"
 
-#include <libepubgen/EPUBPackage.h>
+#include "EPUBStatistics.h"
 
 namespace libepubgen
 {
 
 EPUBCSSContent::EPUBCSSContent()
   : m_rules()
+  , m_sizes()
 {
 }
 
 void EPUBCSSContent::insertRule(const librevenge::RVNGString &selector, const librevenge::RVNGPropertyList &properties)
 {
   m_rules.push_back(std::make_pair(selector, properties));
+  // selector { key: value; }
+  m_sizes.push_back(selector.size() + 4 + getSerializedSize(properties));
 }
 
-void EPUBCSSContent::writeTo(EPUBPackage &package, const char *const name)
+void EPUBCSSContent::writeTo(EPUBStatisticsPackage &package, const char *const name)
 {
   package.openCSSFile(name);
 
-  for (Rules_t::const_iterator it = m_rules.begin(); m_rules.end() != it; ++it)
-    package.insertRule(it->first, it->second);
+  std::size_t size = 0;
+  for (Rules_t::size_type i = 0; m_rules.size() != i; ++i)
+  {
+    package.insertRule(m_rules[i].first, m_rules[i].second);
+    size += m_sizes[i];
+  }
 
   package.closeCSSFile();
+  package.addCSSBytes(size);
+}
+
+void EPUBCSSContent::writeSharedTo(EPUBStatisticsPackage &package, const char *const name)
+{
+  package.openCSSFile(name);
+  std::size_t size = 0;
+  for (Rules_t::size_type i = 0; m_rules.size() != i; ++i)
+  {
+    if (m_rules[i].first.cstr()[0] != '.')
+    {
+      package.insertRule(m_rules[i].first, m_rules[i].second);
+      size += m_sizes[i];
+    }
+  }
+  package.closeCSSFile();
+  package.addCSSBytes(size);
+}
+
+void EPUBCSSContent::writeClassesTo(EPUBStatisticsPackage &package, const char *const name, const std::set<std::string> &classes)
+{
+  package.openCSSFile(name);
+  std::size_t size = 0;
+  for (Rules_t::size_type i = 0; m_rules.size() != i; ++i)
+  {
+    const char *const selector = m_rules[i].first.cstr();
+    if (selector[0] == '.' && classes.find(selector + 1) != classes.end())
+    {
+      package.insertRule(m_rules[i].first, m_rules[i].second);
+      size += m_sizes[i];
+    }
+  }
+  package.closeCSSFile();
+  package.addCSSBytes(size);
 }
 
 } // namespace libepubgen
@@ -10,6 +10,9 @@
 #ifndef INCLUDED_EPUBCSSCONTENT_H
 #define INCLUDED_EPUBCSSCONTENT_H
 
+#include <cstddef>
+#include <set>
+#include <string>
 #include <utility>
 #include <vector>
 
@@ -18,7 +21,7 @@
 namespace libepubgen
 {
 
-class EPUBPackage;
+class EPUBStatisticsPackage;
 
 class EPUBCSSContent
 {
@@ -29,10 +32,17 @@ public:
 
   void insertRule(const librevenge::RVNGString &selector, const librevenge::RVNGPropertyList &properties);
 
-  void writeTo(EPUBPackage &package, const char *name);
+  void writeTo(EPUBStatisticsPackage &package, const char *name);
+
+  /// Writes the rules which are not class selectors, e.g. @font-face.
+  void writeSharedTo(EPUBStatisticsPackage &package, const char *name);
+  /// Writes the rules of the given classes.
+  void writeClassesTo(EPUBStatisticsPackage &package, const char *name, const std::set<std::string> &classes);
 
 private:
   Rules_t m_rules;
+  /// The estimated size of each rule, computed once as a rule can be written to several files.
+  std::vector<std::size_t> m_sizes;
 };
 
 }
@@ -0,0 +1,167 @@
+/* -*- Mode: C++; tab-width: 2; indent-tabs-mode: nil; c-basic-offset: 2 -*- */
+/*
+ * This file is part of the libepubgen project.
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#include "EPUBContentNameMap.h"
+
+#include <cstdint>
+#include <iomanip>
+#include <sstream>
+
+#include <librevenge/librevenge.h>
+
+#include "libepubgen_utils.h"
+#include "EPUBCSSContent.h"
+#include "EPUBMemoryUsage.h"
+#include "EPUBStatistics.h"
+
+namespace libepubgen
+{
+
+namespace
+{
+
+// FNV-1a: unlike std::hash, the result is the same on every platform.
+void hashString(const std::string &str, uint64_t &hash)
+{
+  for (const auto c : str)
+  {
+    hash ^= static_cast<unsigned char>(c);
+    hash *= 0x100000001b3ULL;
+  }
+}
+
+uint64_t hashContent(const EPUBCSSProperties &content)
+{
+  uint64_t hash = 0xcbf29ce484222325ULL;
+  for (const auto &property : content)
+  {
+    hashString(property.first, hash);
+    hashString(":", hash);
+    hashString(property.second, hash);
+    hashString(";", hash);
+  }
+  return hash;
+}
+
+}
+
+EPUBContentNameMap::EPUBContentNameMap(const std::string &prefix)
+  : m_prefix(prefix)
+  , m_map()
+  , m_entries()
+  , m_indices()
+  , m_classNamesMethod(EPUB_CLASS_NAMES_METHOD_COUNTER)
+  , m_hits(0)
+  , m_memory(0)
+{
+}
+
+void EPUBContentNameMap::setClassNamesMethod(EPUBClassNamesMethod method)
+{
+  m_classNamesMethod = method;
+}
+
+const std::string &EPUBContentNameMap::getName(const EPUBCSSProperties &content)
+{
+  Entry &entry = findEntry(content);
+  ++entry.m_uses;
+  return entry.m_name;
+}
+
+const std::string &EPUBContentNameMap::defineName(const EPUBCSSProperties &content)
+{
+  return findEntry(content).m_name;
+}
+
+void EPUBContentNameMap::use(const std::string &name)
+{
+  const auto it = m_indices.find(name);
+  if (it == m_indices.end())
+  {
+    EPUBGEN_DEBUG_MSG(("EPUBContentNameMap::use: unknown class %s\n", name.c_str()));
+    return;
+  }
+  ++m_hits;
+  ++m_entries[it->second].m_uses;
+}
+
+void EPUBContentNameMap::getUsage(librevenge::RVNGPropertyList &usage) const
+{
+  for (const auto &entry : m_entries)
+    usage.insert(entry.m_name.c_str(), int(entry.m_uses));
+}
+
+void EPUBContentNameMap::addStatistics(EPUBStatistics &statistics) const
+{
+  statistics.m_styleHits += m_hits;
+  statistics.m_styleMisses += m_entries.size();
+}
+
+void EPUBContentNameMap::addMemoryUsage(EPUBMemoryUsage &usage) const
+{
+  usage.m_current[EPUB_MEMORY_STYLES] += m_memory;
+}
+
+void EPUBContentNameMap::send(EPUBCSSContent &out) const
+{
+  for (const auto &entry : m_entries)
+  {
+    if (!entry.m_uses)
+      continue;
+    librevenge::RVNGPropertyList props;
+    fillPropertyList(*entry.m_content, props);
+    out.insertRule(("." + entry.m_name).c_str(), props);
+  }
+}
+
+EPUBContentNameMap::Entry &EPUBContentNameMap::findEntry(const EPUBCSSProperties &content)
+{
+  MapType_t::const_iterator it = m_map.find(content);
+  if (it != m_map.end())
+  {
+    ++m_hits;
+    return m_entries[it->second];
+  }
+
+  const std::string name = createName(content);
+  it = m_map.insert(MapType_t::value_type(content, m_entries.size())).first;
+  m_indices[name] = it->second;
+  m_entries.push_back(Entry(&it->first, name));
+  m_memory += sizeof(MapType_t::value_type) + estimateMemory(content) + sizeof(Entry) + sizeof(std::pair<const std::string, std::size_t>) + 2 * estimateMemory(name.size());
+  return m_entries.back();
+}
+
+std::string EPUBContentNameMap::createName(const EPUBCSSProperties &content) const
+{
+  std::ostringstream name;
+  name << m_prefix;
+  if (m_classNamesMethod == EPUB_CLASS_NAMES_METHOD_COUNTER)
+  {
+    name << m_map.size();
+    return name.str();
+  }
+
+  const uint64_t hash = hashContent(content);
+  name << std::hex << std::setw(8) << std::setfill('0') << static_cast<uint32_t>(hash ^ (hash >> 32));
+  if (m_indices.find(name.str()) == m_indices.end())
+    return name.str();
+
+  // A collision: only the first content keeps the plain name.
+  for (unsigned i = 1;; ++i)
+  {
+    std::ostringstream suffixed;
+    suffixed << name.str() << '_' << i;
+    if (m_indices.find(suffixed.str()) == m_indices.end())
+      return suffixed.str();
+  }
+}
+
+}
+
+/* vim:set shiftwidth=2 softtabstop=2 expandtab: */
@@ -0,0 +1,99 @@
+/* -*- Mode: C++; tab-width: 2; indent-tabs-mode: nil; c-basic-offset: 2 -*- */
+/*
+ * This file is part of the libepubgen project.
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#ifndef INCLUDED_EPUBCONTENTNAMEMAP_H
+#define INCLUDED_EPUBCONTENTNAMEMAP_H
+
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <boost/functional/hash.hpp>
+
+#include <librevenge/librevenge.h>
+
+#include <libepubgen/libepubgen-decls.h>
+
+#include "EPUBCSSProperties.h"
+
+namespace libepubgen
+{
+
+class EPUBCSSContent;
+struct EPUBMemoryUsage;
+struct EPUBStatistics;
+
+/** Maps CSS property sets to class names.
+  *
+  * The classes are sent in the order they were created, so the output
+  * doesn't depend on the hash table layout. Classes which are never used
+  * by an element are not sent.
+  */
+class EPUBContentNameMap
+{
+  // disable copying
+  EPUBContentNameMap(const EPUBContentNameMap &);
+  EPUBContentNameMap &operator=(const EPUBContentNameMap &);
+
+  struct Entry
+  {
+    Entry(const EPUBCSSProperties *content, const std::string &name) : m_content(content), m_name(name), m_uses(0) {}
+
+    const EPUBCSSProperties *m_content;
+    std::string m_name;
+    unsigned m_uses;
+  };
+
+  typedef std::unordered_map<EPUBCSSProperties, std::size_t, boost::hash<EPUBCSSProperties>> MapType_t;
+
+public:
+  explicit EPUBContentNameMap(const std::string &prefix);
+
+  void setClassNamesMethod(EPUBClassNamesMethod method);
+
+  //! returns the class name corresponding to a CSS property map, creating it if needed, and counts a use
+  const std::string &getName(const EPUBCSSProperties &content);
+  //! returns the class name corresponding to a CSS property map, creating it if needed, for a named style
+  const std::string &defineName(const EPUBCSSProperties &content);
+  //! counts a use of a class returned by defineName() or getName()
+  void use(const std::string &name);
+
+  //! add the number of uses of each class to usage
+  void getUsage(librevenge::RVNGPropertyList &usage) const;
+  //! add the lookups which found an existing class and the created classes to statistics
+  void addStatistics(EPUBStatistics &statistics) const;
+  //! add the estimated memory of the classes to usage
+  void addMemoryUsage(EPUBMemoryUsage &usage) const;
+
+  //! send the used rules to the sink, in creation order
+  void send(EPUBCSSContent &out) const;
+
+private:
+  Entry &findEntry(const EPUBCSSProperties &content);
+  std::string createName(const EPUBCSSProperties &content) const;
+
+  const std::string m_prefix;
+  //! a map content -> index in m_entries
+  MapType_t m_map;
+  //! the classes, in creation order
+  std::vector<Entry> m_entries;
+  //! a map name -> index in m_entries
+  std::unordered_map<std::string, std::size_t> m_indices;
+  EPUBClassNamesMethod m_classNamesMethod;
+  //! the number of lookups which found an existing class
+  unsigned long m_hits;
+  //! the estimated memory of the classes
+  std::size_t m_memory;
+};
+
+}
+
+#endif // INCLUDED_EPUBCONTENTNAMEMAP_H
+
+/* vim:set shiftwidth=2 softtabstop=2 expandtab: */
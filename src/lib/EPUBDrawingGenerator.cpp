@@ -61,6 +61,12 @@ void EPUBDrawingGenerator::setOption(int key, int value)
   case EPUB_GENERATOR_OPTION_SPLIT:
     m_impl->setSplitMethod(static_cast<EPUBSplitMethod>(value));
     break;
+  case EPUB_GENERATOR_OPTION_LAYOUT:
+    m_impl->setLayoutMethod(static_cast<EPUBLayoutMethod>(value));
+    break;
+  case EPUB_GENERATOR_OPTION_OUTPUT:
+    m_impl->setOutputMethod(static_cast<EPUBOutputMethod>(value));
+    break;
   }
 }
 
@@ -69,6 +75,31 @@ void EPUBDrawingGenerator::setSplitSize(const unsigned size)
   m_impl->setSplitSize(size);
 }
 
+void EPUBDrawingGenerator::setMaxSectionSize(const unsigned size)
+{
+  m_impl->setMaxSectionSize(size);
+}
+
+void EPUBDrawingGenerator::setMemoryBudget(const unsigned long budget)
+{
+  m_impl->setMemoryBudget(budget);
+}
+
+void EPUBDrawingGenerator::registerDiagnosticHandler(EPUBDiagnosticHandler diagnosticHandler)
+{
+  m_impl->setDiagnosticHandler(diagnosticHandler);
+}
+
+void EPUBDrawingGenerator::registerProgressHandler(EPUBProgressHandler progressHandler)
+{
+  m_impl->setProgressHandler(progressHandler);
+}
+
+bool EPUBDrawingGenerator::isCancelled() const
+{
+  return m_impl->isCancelled();
+}
+
 void EPUBDrawingGenerator::registerEmbeddedImageHandler(const librevenge::RVNGString &mimeType, EPUBEmbeddedImage imageHandler)
 {
   // TODO: implement me
@@ -83,6 +114,16 @@ void EPUBDrawingGenerator::registerEmbeddedObjectHandler(const librevenge::RVNGS
   (void) objectHandler;
 }
 
+void EPUBDrawingGenerator::getStatistics(librevenge::RVNGPropertyList &statistics) const
+{
+  m_impl->getStatistics(statistics);
+}
+
+void EPUBDrawingGenerator::getMemoryUsage(librevenge::RVNGPropertyList &usage) const
+{
+  m_impl->getMemoryUsage(usage);
+}
+
 void EPUBDrawingGenerator::startDocument(const RVNGPropertyList &propList)
 {
   m_impl->startDocument(propList);
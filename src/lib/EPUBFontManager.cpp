@@ -20,6 +20,9 @@
 #include "EPUBCSSContent.h"
 #include "EPUBManifest.h"
 #include "EPUBPath.h"
+#include "EPUBMemoryUsage.h"
+#include "EPUBStatistics.h"
+#include "EPUBTraceScope.h"
 
 namespace libepubgen
 {
@@ -68,15 +71,22 @@ bool EPUBFontManager::BinaryDataEqual::operator()(const librevenge::RVNGBinaryDa
 EPUBFontManager::EPUBFontManager(EPUBManifest &manifest)
   : m_manifest(manifest)
   , m_map()
+  , m_mapEntries()
   , m_number()
+  , m_insertions(0)
+  , m_mapMemory(0)
   , m_set()
+  , m_setEntries()
+  , m_setMemory(0)
 {
 }
 
 void EPUBFontManager::insert(const librevenge::RVNGPropertyList &propertyList, const EPUBPath &base)
 {
+  EPUBGEN_TRACE_SCOPE("EPUBFontManager::insert");
   librevenge::RVNGBinaryData data(propertyList["office:binary-data"]->getStr());
   librevenge::RVNGString mimetype(propertyList["librevenge:mime-type"]->getStr());
+  ++m_insertions;
   if (mimetype == "truetype")
     // librevenge's truetype is EPUB's opentype.
     mimetype = "application/vnd.ms-opentype";
@@ -96,6 +106,8 @@ void EPUBFontManager::insert(const librevenge::RVNGPropertyList &propertyList, c
 
     m_manifest.insert(path, mime, id, "");
     it = m_map.insert(MapType_t::value_type(data, path)).first;
+    m_mapEntries.push_back(&*it);
+    m_mapMemory += sizeof(MapType_t::value_type) + data.size();
   }
 
   assert(m_map.end() != it); // the font must be present at this point
@@ -108,11 +120,12 @@ void EPUBFontManager::insert(const librevenge::RVNGPropertyList &propertyList, c
   ss << it->second.relativeTo(base).str();
   ss << ")";
   content["src"] = ss.str();
-  SetType_t::const_iterator contentIt = m_set.find(content);
-  if (contentIt != m_set.end())
-    return;
-
-  m_set.insert(content);
+  const std::pair<SetType_t::const_iterator, bool> inserted = m_set.insert(content);
+  if (inserted.second)
+  {
+    m_setEntries.push_back(&*inserted.first);
+    m_setMemory += estimateMemory(*inserted.first);
+  }
 }
 
 void EPUBFontManager::extractFontProperties(librevenge::RVNGPropertyList const &pList, EPUBCSSProperties &cssProps) const
@@ -131,22 +144,42 @@ void EPUBFontManager::extractFontProperties(librevenge::RVNGPropertyList const &
     cssProps["font-weight"] = pList["librevenge:font-weight"]->getStr().cstr();
 }
 
+void EPUBFontManager::addStatistics(EPUBStatistics &statistics) const
+{
+  statistics.m_fonts += m_insertions;
+  statistics.m_duplicateFonts += m_insertions - m_mapEntries.size();
+}
+
+void EPUBFontManager::addMemoryUsage(EPUBMemoryUsage &usage) const
+{
+  usage.m_current[EPUB_MEMORY_FONTS] += m_mapMemory + m_setMemory;
+}
+
+void EPUBFontManager::release()
+{
+  m_mapEntries.clear();
+  m_map.clear();
+  m_insertions = 0;
+  m_mapMemory = 0;
+}
+
 void EPUBFontManager::writeTo(EPUBPackage &package)
 {
-  for (MapType_t::const_iterator it = m_map.begin(); m_map.end() != it; ++it)
+  EPUBGEN_TRACE_SCOPE("EPUBFontManager::writeTo");
+  for (const auto &entry : m_mapEntries)
   {
     EPUBBinaryContent font;
-    font.insertBinaryData(it->first);
-    font.writeTo(package, it->second.str().c_str());
+    font.insertBinaryData(entry->first);
+    font.writeTo(package, entry->second.str().c_str());
   }
 }
 
 void EPUBFontManager::send(EPUBCSSContent &out)
 {
-  for (const auto &fontProperties : m_set)
+  for (const auto &fontProperties : m_setEntries)
   {
     librevenge::RVNGPropertyList props;
-    fillPropertyList(fontProperties, props);
+    fillPropertyList(*fontProperties, props);
     out.insertRule("@font-face", props);
   }
 }
@@ -10,8 +10,10 @@
 #ifndef INCLUDED_EPUBFONTMANAGER_H
 #define INCLUDED_EPUBFONTMANAGER_H
 
+#include <cstddef>
 #include <unordered_map>
 #include <unordered_set>
+#include <vector>
 
 #include <boost/functional/hash.hpp>
 
@@ -27,6 +29,8 @@ namespace libepubgen
 class EPUBManifest;
 class EPUBPackage;
 class EPUBCSSContent;
+struct EPUBMemoryUsage;
+struct EPUBStatistics;
 
 /// Manages embedded fonts.
 class EPUBFontManager
@@ -57,6 +61,12 @@ public:
 
   //! send the data to the sink
   void send(EPUBCSSContent &out);
+  //! add the font counters to statistics
+  void addStatistics(EPUBStatistics &statistics) const;
+  //! add the estimated memory of the fonts to usage
+  void addMemoryUsage(EPUBMemoryUsage &usage) const;
+  //! forget the fonts, e.g., when the generation is cancelled
+  void release();
 
 private:
   //! convert a property list into a CSS property map
@@ -65,9 +75,19 @@ private:
   EPUBManifest &m_manifest;
   /// Font filename -> content map.
   MapType_t m_map;
+  /// Entries of m_map, in insertion order.
+  std::vector<const MapType_t::value_type *> m_mapEntries;
   EPUBCounter m_number;
+  /// The number of calls of insert().
+  unsigned long m_insertions;
+  /// The estimated memory of the entries of m_map.
+  std::size_t m_mapMemory;
   /// Set of font properties.
   SetType_t m_set;
+  /// Entries of m_set, in insertion order.
+  std::vector<const EPUBCSSProperties *> m_setEntries;
+  /// The estimated memory of the entries of m_set.
+  std::size_t m_setMemory;
 };
 
 }
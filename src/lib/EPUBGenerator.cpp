@@ -20,8 +20,10 @@
 #include <boost/uuid/uuid_generators.hpp>
 #include <boost/uuid/uuid_io.hpp>
 
+#include "libepubgen_utils.h"
 #include "EPUBCSSContent.h"
 #include "EPUBHTMLGenerator.h"
+#include "EPUBTraceScope.h"
 #include "EPUBXMLContent.h"
 
 namespace libepubgen
@@ -31,8 +33,28 @@ using librevenge::RVNGPropertyFactory;
 using librevenge::RVNGPropertyList;
 using librevenge::RVNGString;
 
+namespace
+{
+
+const char *const PHASE_NAMES[EPUB_STATISTICS_PHASE_COUNT] =
+{
+  "generation",
+  "container",
+  "root",
+  "navigation",
+  "stylesheet",
+  "sections",
+  "images",
+  "fonts"
+};
+
+}
+
 EPUBGenerator::EPUBGenerator(EPUBPackage *const package, int version)
-  : m_package(package)
+  : m_statistics()
+  , m_package(package, m_statistics)
+  , m_nullPackage()
+  , m_measurePackage(&m_nullPackage, m_statistics)
   , m_manifest()
   , m_htmlManager(m_manifest)
   , m_imageManager(m_manifest)
@@ -49,7 +71,21 @@ EPUBGenerator::EPUBGenerator(EPUBPackage *const package, int version)
   , m_splitGuard(EPUB_SPLIT_METHOD_PAGE_BREAK,true)
   , m_version(version)
   , m_stylesMethod(EPUB_STYLES_METHOD_CSS)
+  , m_stylesheetMethod(EPUB_STYLESHEET_METHOD_SINGLE)
+  , m_spanStylesMethod(EPUB_SPAN_STYLES_METHOD_FULL)
   , m_layoutMethod(EPUB_LAYOUT_METHOD_REFLOWABLE)
+  , m_notesMethod(EPUB_NOTES_METHOD_INLINE)
+  , m_tocMethod(EPUB_TOC_METHOD_SECTIONS)
+  , m_diagnosticHandler(nullptr)
+  , m_progressHandler(nullptr)
+  , m_splitReason(EPUB_SPLIT_REASON_START)
+  , m_splitHeadingLevel(0)
+  , m_startTime()
+  , m_memoryUsage()
+  , m_documentEnded(false)
+  , m_memoryBudget(0)
+  , m_outputMethod(EPUB_OUTPUT_METHOD_PACKAGE)
+  , m_cancelled(false)
 {
 }
 
@@ -59,9 +95,12 @@ EPUBGenerator::~EPUBGenerator()
 
 void EPUBGenerator::startDocument(const RVNGPropertyList &props)
 {
+  m_startTime = EPUBStatistics::Clock::now();
+  m_documentEnded = false;
+  m_cancelled = false;
   m_documentProps = props;
 
-  startNewHtmlFile();
+  startNewHtmlFile(EPUB_SPLIT_REASON_START);
 
   if (m_version >= 30)
     m_manifest.insert(EPUBPath("OEBPS/toc.xhtml"), "application/xhtml+xml", "toc.xhtml", "nav");
@@ -71,19 +110,50 @@ void EPUBGenerator::startDocument(const RVNGPropertyList &props)
 
 void EPUBGenerator::endDocument()
 {
+  EPUBGEN_TRACE_SCOPE("EPUBGenerator::endDocument");
+  if (m_cancelled)
+    return;
+
   if (bool(m_currentHtml))
   {
+    sampleMemoryUsage();
     endHtmlFile();
     m_currentHtml->endDocument();
+    m_htmlManager.finishSection();
+    updateSplitSize();
+    checkSectionSize();
+    reportSection();
+    measureSections();
   }
+  m_documentEnded = true;
+  sampleMemoryUsage();
 
+  // A cancelled package is incomplete; the caller has to discard it.
+  EPUBStatistics::Clock::time_point start = m_startTime;
+  if (!endPhase(EPUB_STATISTICS_PHASE_GENERATION, start))
+    return;
   writeContainer();
+  if (!endPhase(EPUB_STATISTICS_PHASE_CONTAINER, start))
+    return;
   writeRoot();
+  if (!endPhase(EPUB_STATISTICS_PHASE_ROOT, start))
+    return;
   writeNavigation();
+  if (!endPhase(EPUB_STATISTICS_PHASE_NAVIGATION, start))
+    return;
   writeStylesheet();
-  m_htmlManager.writeTo(*m_package);
-  m_imageManager.writeTo(*m_package);
-  m_fontManager.writeTo(*m_package);
+  if (!endPhase(EPUB_STATISTICS_PHASE_STYLESHEET, start))
+    return;
+  std::vector<std::string> damaged;
+  m_htmlManager.writeTo(m_package, damaged);
+  reportDamagedFiles(damaged);
+  if (!endPhase(EPUB_STATISTICS_PHASE_SECTIONS, start))
+    return;
+  m_imageManager.writeTo(m_package);
+  if (!endPhase(EPUB_STATISTICS_PHASE_IMAGES, start))
+    return;
+  m_fontManager.writeTo(m_package);
+  endPhase(EPUB_STATISTICS_PHASE_FONTS, start);
 }
 
 void EPUBGenerator::setDocumentMetaData(const RVNGPropertyList &props)
@@ -109,20 +179,34 @@ void EPUBGenerator::setDocumentMetaData(const RVNGPropertyList &props)
   }
 }
 
-void EPUBGenerator::startNewHtmlFile()
+void EPUBGenerator::startNewHtmlFile(EPUBSplitReason reason, const unsigned headingLevel)
 {
+  EPUBGEN_TRACE_SCOPE("EPUBGenerator::startNewHtmlFile");
   // close the current HTML file
   librevenge::RVNGPropertyList pageProperties;
   if (bool(m_currentHtml))
   {
+    sampleMemoryUsage();
     endHtmlFile();
     m_currentHtml->endDocument();
+    m_htmlManager.finishSection();
     m_currentHtml->getPageProperties(pageProperties);
+    checkSectionSize();
+    reportSection();
+    measureSections();
+    checkMemoryBudget();
+    // The new file is still created, so the current call can finish.
+    reportProgress(EPUB_STATISTICS_PHASE_GENERATION);
   }
 
+  if ((reason == EPUB_SPLIT_REASON_SIZE) && m_splitGuard.isOverMaxSize())
+    reason = EPUB_SPLIT_REASON_MAX_SIZE;
+  m_splitReason = reason;
+  m_splitHeadingLevel = headingLevel;
   m_splitGuard.onSplit();
+  ++m_statistics.m_sections;
 
-  m_currentHtml = m_htmlManager.create(m_imageManager, m_fontManager, m_listStyleManager, m_paragraphStyleManager, m_spanStyleManager, m_bodyStyleManager, m_tableStyleManager, m_stylesheetPath, m_stylesMethod, m_layoutMethod, m_version);
+  m_currentHtml = m_htmlManager.create(m_imageManager, m_fontManager, m_listStyleManager, m_paragraphStyleManager, m_spanStyleManager, m_bodyStyleManager, m_tableStyleManager, m_stylesheetPath, m_stylesMethod, m_stylesheetMethod, m_spanStylesMethod, m_layoutMethod, m_notesMethod, m_version);
 
   // Splitted html file should keep the same page property.
   m_currentHtml->setPageProperties(pageProperties);
@@ -139,6 +223,11 @@ const std::shared_ptr<EPUBHTMLGenerator> &EPUBGenerator::getHtml() const
   return m_currentHtml;
 }
 
+void EPUBGenerator::updateSplitSize()
+{
+  m_splitGuard.setCurrentSize(unsigned(m_currentHtml->getSize()));
+}
+
 EPUBHTMLManager &EPUBGenerator::getHtmlManager()
 {
   return m_htmlManager;
@@ -169,6 +258,112 @@ void EPUBGenerator::setStylesMethod(EPUBStylesMethod styles)
   m_stylesMethod = styles;
 }
 
+void EPUBGenerator::setStylesheetMethod(EPUBStylesheetMethod stylesheet)
+{
+  m_stylesheetMethod = stylesheet;
+}
+
+void EPUBGenerator::setSpanStylesMethod(EPUBSpanStylesMethod spanStyles)
+{
+  m_spanStylesMethod = spanStyles;
+}
+
+void EPUBGenerator::setClassNamesMethod(EPUBClassNamesMethod classNames)
+{
+  m_imageManager.setClassNamesMethod(classNames);
+  m_listStyleManager.setClassNamesMethod(classNames);
+  m_paragraphStyleManager.setClassNamesMethod(classNames);
+  m_spanStyleManager.setClassNamesMethod(classNames);
+  m_bodyStyleManager.setClassNamesMethod(classNames);
+  m_tableStyleManager.setClassNamesMethod(classNames);
+}
+
+void EPUBGenerator::getStyleUsage(RVNGPropertyList &usage) const
+{
+  m_imageManager.getUsage(usage);
+  m_listStyleManager.getUsage(usage);
+  m_paragraphStyleManager.getUsage(usage);
+  m_spanStyleManager.getUsage(usage);
+  m_bodyStyleManager.getUsage(usage);
+  m_tableStyleManager.getUsage(usage);
+}
+
+void EPUBGenerator::getStatistics(RVNGPropertyList &statistics) const
+{
+  EPUBStatistics total(m_statistics);
+  m_imageManager.addStatistics(total);
+  m_fontManager.addStatistics(total);
+  m_listStyleManager.addStatistics(total);
+  m_paragraphStyleManager.addStatistics(total);
+  m_spanStyleManager.addStatistics(total);
+  m_bodyStyleManager.addStatistics(total);
+  m_tableStyleManager.addStatistics(total);
+  total.writeTo(statistics);
+}
+
+void EPUBGenerator::getMemoryUsage(RVNGPropertyList &usage) const
+{
+  sampleMemoryUsage();
+  m_memoryUsage.writeTo(usage);
+}
+
+void EPUBGenerator::setMemoryBudget(const unsigned long budget)
+{
+  m_memoryBudget = budget;
+}
+
+void EPUBGenerator::checkMemoryBudget()
+{
+  if (0 == m_memoryBudget)
+    return;
+
+  // Not a sample: the zones of the closed section are in the HTML manager already.
+  EPUBMemoryUsage usage;
+  m_htmlManager.addMemoryUsage(usage);
+  m_imageManager.addMemoryUsage(usage);
+  if (usage.m_current[EPUB_MEMORY_XHTML] + usage.m_current[EPUB_MEMORY_IMAGES] <= m_memoryBudget)
+    return;
+
+  EPUBGEN_DEBUG_MSG(("EPUBGenerator::checkMemoryBudget: spilling %lu bytes of sections\n", static_cast<unsigned long>(usage.m_current[EPUB_MEMORY_XHTML])));
+  m_htmlManager.spill();
+}
+
+void EPUBGenerator::setOutputMethod(const EPUBOutputMethod outputMethod)
+{
+  m_outputMethod = outputMethod;
+}
+
+void EPUBGenerator::measureSections()
+{
+  if (m_outputMethod != EPUB_OUTPUT_METHOD_MEASURE)
+    return;
+  std::vector<std::string> damaged;
+  m_htmlManager.writeFinishedTo(m_measurePackage, damaged);
+  reportDamagedFiles(damaged);
+}
+
+void EPUBGenerator::addMemoryUsage(EPUBMemoryUsage &) const
+{
+}
+
+void EPUBGenerator::sampleMemoryUsage() const
+{
+  m_memoryUsage.reset();
+  m_htmlManager.addMemoryUsage(m_memoryUsage);
+  // The content of a finished section is in the HTML manager already.
+  if (bool(m_currentHtml) && !m_documentEnded)
+    m_memoryUsage.m_current[EPUB_MEMORY_ZONES] += m_currentHtml->getMemory();
+  m_imageManager.addMemoryUsage(m_memoryUsage);
+  m_fontManager.addMemoryUsage(m_memoryUsage);
+  m_listStyleManager.addMemoryUsage(m_memoryUsage);
+  m_paragraphStyleManager.addMemoryUsage(m_memoryUsage);
+  m_spanStyleManager.addMemoryUsage(m_memoryUsage);
+  m_bodyStyleManager.addMemoryUsage(m_memoryUsage);
+  m_tableStyleManager.addMemoryUsage(m_memoryUsage);
+  addMemoryUsage(m_memoryUsage);
+  m_memoryUsage.updatePeaks();
+}
+
 void EPUBGenerator::setLayoutMethod(EPUBLayoutMethod layout)
 {
   m_layoutMethod = layout;
@@ -179,8 +374,126 @@ void EPUBGenerator::setLayoutMethod(EPUBLayoutMethod layout)
   m_splitGuard.setSplitOnSecondPageSpan(m_layoutMethod == EPUB_LAYOUT_METHOD_REFLOWABLE);
 }
 
+void EPUBGenerator::setDiagnosticHandler(EPUBDiagnosticHandler handler)
+{
+  m_diagnosticHandler = handler;
+}
+
+void EPUBGenerator::setProgressHandler(EPUBProgressHandler handler)
+{
+  m_progressHandler = handler;
+}
+
+bool EPUBGenerator::isCancelled() const
+{
+  return m_cancelled;
+}
+
+bool EPUBGenerator::endPhase(const EPUBStatisticsPhase phase, EPUBStatistics::Clock::time_point &start)
+{
+  start = m_statistics.endPhase(phase, start);
+  return reportProgress(phase);
+}
+
+bool EPUBGenerator::reportProgress(const EPUBStatisticsPhase phase)
+{
+  if (!m_progressHandler || m_cancelled)
+    return !m_cancelled;
+
+  RVNGPropertyList progress;
+  progress.insert("libepubgen:phase", PHASE_NAMES[phase]);
+  progress.insert("libepubgen:sections", int(m_statistics.m_sections));
+  // The package is only written in endDocument(), so the size of the sections is what grows.
+  progress.insert("libepubgen:bytes", double(m_htmlManager.getFinishedSize()), librevenge::RVNG_GENERIC);
+  if (m_progressHandler(progress))
+    return true;
+
+  EPUBGEN_DEBUG_MSG(("EPUBGenerator::reportProgress: cancelled after %s\n", PHASE_NAMES[phase]));
+  m_cancelled = true;
+  m_htmlManager.release();
+  m_imageManager.release();
+  m_fontManager.release();
+  return false;
+}
+
+void EPUBGenerator::checkSectionSize()
+{
+  if (!m_splitGuard.isOverMaxSize())
+    return;
+
+  EPUBGEN_DEBUG_MSG(("EPUBGenerator::checkSectionSize: section of %u bytes\n", m_splitGuard.getCurrentSize()));
+  if (!m_diagnosticHandler)
+    return;
+  RVNGPropertyList details;
+  details.insert("libepubgen:size", int(m_splitGuard.getCurrentSize()));
+  details.insert("libepubgen:max-size", int(m_splitGuard.getMaxSize()));
+  m_diagnosticHandler(EPUB_DIAGNOSTIC_SECTION_SIZE_CAP, details);
+}
+
+void EPUBGenerator::reportDamagedFiles(const std::vector<std::string> &paths)
+{
+  for (const auto &path : paths)
+  {
+    EPUBGEN_DEBUG_MSG(("EPUBGenerator::reportDamagedFiles: %s could not be read back\n", path.c_str()));
+    if (!m_diagnosticHandler)
+      continue;
+    RVNGPropertyList details;
+    details.insert("libepubgen:path", path.c_str());
+    m_diagnosticHandler(EPUB_DIAGNOSTIC_SPILL_DAMAGED, details);
+  }
+}
+
+void EPUBGenerator::getSectionReport(librevenge::RVNGPropertyListVector &report) const
+{
+  m_htmlManager.getReport(report);
+}
+
+void EPUBGenerator::reportSection()
+{
+  static const char *const REASONS[] =
+  {
+    "start",
+    "page-break",
+    "heading",
+    "size",
+    "max-size",
+    "second-page-span",
+    "plan",
+    "page"
+  };
+
+  RVNGPropertyList section;
+  section.insert("libepubgen:split-reason", REASONS[m_splitReason]);
+  if (m_splitReason == EPUB_SPLIT_REASON_HEADING)
+    section.insert("libepubgen:heading-level", int(m_splitHeadingLevel));
+  m_currentHtml->getReport(section);
+  m_htmlManager.setReport(section);
+}
+
+EPUBLayoutMethod EPUBGenerator::getLayoutMethod() const
+{
+  return m_layoutMethod;
+}
+
+void EPUBGenerator::setNotesMethod(EPUBNotesMethod notesMethod)
+{
+  m_notesMethod = notesMethod;
+}
+
+void EPUBGenerator::setTocMethod(EPUBTocMethod tocMethod)
+{
+  m_tocMethod = tocMethod;
+}
+
+bool EPUBGenerator::hasOutlineToc() const
+{
+  // Fixed layout has its own table of contents: pages or chapter names.
+  return (m_tocMethod == EPUB_TOC_METHOD_OUTLINE) && (m_layoutMethod == EPUB_LAYOUT_METHOD_REFLOWABLE);
+}
+
 void EPUBGenerator::writeContainer()
 {
+  EPUBGEN_TRACE_SCOPE("EPUBGenerator::writeContainer");
   EPUBXMLContent xml;
 
   RVNGPropertyList containerAttrs;
@@ -199,11 +512,12 @@ void EPUBGenerator::writeContainer()
   xml.closeElement("rootfiles");
   xml.closeElement("container");
 
-  xml.writeTo(*m_package, "META-INF/container.xml");
+  xml.writeTo(m_package, "META-INF/container.xml");
 }
 
 void EPUBGenerator::writeNavigation()
 {
+  EPUBGEN_TRACE_SCOPE("EPUBGenerator::writeNavigation");
   if (m_version >= 30)
   {
     EPUBXMLContent xml;
@@ -223,14 +537,14 @@ void EPUBGenerator::writeNavigation()
     xml.openElement("nav", navAttrs);
 
     xml.openElement("ol");
-    m_htmlManager.writeTocTo(xml, path, m_version, m_layoutMethod);
+    m_htmlManager.writeTocTo(xml, path, m_version, m_layoutMethod, hasOutlineToc());
     xml.closeElement("ol");
 
     xml.closeElement("nav");
     xml.closeElement("body");
     xml.closeElement("html");
 
-    xml.writeTo(*m_package, path.str().c_str());
+    xml.writeTo(m_package, path.str().c_str());
   }
 
   EPUBXMLContent xml;
@@ -257,16 +571,17 @@ void EPUBGenerator::writeNavigation()
   xml.openElement("navMap");
   // In case of EPUB3 the (deprecated, but valid) EPUB2 markup is wanted, so
   // the version is unconditional here.
-  m_htmlManager.writeTocTo(xml, path, /*version=*/20, m_layoutMethod);
+  m_htmlManager.writeTocTo(xml, path, /*version=*/20, m_layoutMethod, hasOutlineToc());
   xml.closeElement("navMap");
 
   xml.closeElement("ncx");
 
-  xml.writeTo(*m_package, path.str().c_str());
+  xml.writeTo(m_package, path.str().c_str());
 }
 
 void EPUBGenerator::writeStylesheet()
 {
+  EPUBGEN_TRACE_SCOPE("EPUBGenerator::writeStylesheet");
   EPUBCSSContent stylesheet;
 
   m_fontManager.send(stylesheet);
@@ -277,11 +592,20 @@ void EPUBGenerator::writeStylesheet()
   m_tableStyleManager.send(stylesheet);
   m_imageManager.send(stylesheet);
 
-  stylesheet.writeTo(*m_package, m_stylesheetPath.str().c_str());
+  if (m_stylesheetMethod == EPUB_STYLESHEET_METHOD_PER_SECTION)
+  {
+    // Rules not tied to a class go to the shared stylesheet, the rest is
+    // distributed to the sections which actually use them.
+    stylesheet.writeSharedTo(m_package, m_stylesheetPath.str().c_str());
+    m_htmlManager.writeStylesheetsTo(m_package, stylesheet);
+  }
+  else
+    stylesheet.writeTo(m_package, m_stylesheetPath.str().c_str());
 }
 
 void EPUBGenerator::writeRoot()
 {
+  EPUBGEN_TRACE_SCOPE("EPUBGenerator::writeRoot");
   EPUBXMLContent sink;
 
   const RVNGString uniqueId("unique-identifier");
@@ -412,7 +736,7 @@ void EPUBGenerator::writeRoot()
 
   sink.closeElement("package");
 
-  sink.writeTo(*m_package, "OEBPS/content.opf");
+  sink.writeTo(m_package, "OEBPS/content.opf");
 }
 
 }
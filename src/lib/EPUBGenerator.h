@@ -11,17 +11,23 @@
 #define INCLUDED_EPUBGENERATOR_H
 
 #include <memory>
+#include <string>
+#include <vector>
+
+#include <libepubgen/EPUBNullPackage.h>
 
 #include "EPUBFontManager.h"
 #include "EPUBHTMLManager.h"
 #include "EPUBImageManager.h"
 #include "EPUBListStyleManager.h"
 #include "EPUBManifest.h"
+#include "EPUBMemoryUsage.h"
 #include "EPUBParagraphStyleManager.h"
 #include "EPUBPath.h"
 #include "EPUBSpanStyleManager.h"
 #include "EPUBBodyStyleManager.h"
 #include "EPUBSplitGuard.h"
+#include "EPUBStatistics.h"
 #include "EPUBTableStyleManager.h"
 
 namespace libepubgen
@@ -45,7 +51,12 @@ public:
 
   void setDocumentMetaData(const librevenge::RVNGPropertyList &props);
 
-  void startNewHtmlFile();
+  /** Closes the current HTML file and starts a new one.
+    *
+    * @param[in] reason why, for the section report
+    * @param[in] headingLevel the level of the heading, if splitting on one
+    */
+  void startNewHtmlFile(EPUBSplitReason reason, unsigned headingLevel = 0);
 
   const std::shared_ptr<EPUBHTMLGenerator> &getHtml() const;
 
@@ -53,26 +64,89 @@ public:
 
   const EPUBSplitGuard &getSplitGuard() const;
   EPUBSplitGuard &getSplitGuard();
+  /// Passes the size of the current HTML file to the split guard.
+  void updateSplitSize();
   int getVersion() const;
 
   void setSplitMethod(EPUBSplitMethod splitMethod);
 
   void setStylesMethod(EPUBStylesMethod stylesMethod);
 
+  void setStylesheetMethod(EPUBStylesheetMethod stylesheetMethod);
+
+  void setSpanStylesMethod(EPUBSpanStylesMethod spanStylesMethod);
+
+  void setClassNamesMethod(EPUBClassNamesMethod classNamesMethod);
+
   void setLayoutMethod(EPUBLayoutMethod layoutMethod);
+  EPUBLayoutMethod getLayoutMethod() const;
+
+  void setNotesMethod(EPUBNotesMethod notesMethod);
+
+  void setTocMethod(EPUBTocMethod tocMethod);
+  /// Does the table of contents link to the headings?
+  bool hasOutlineToc() const;
+
+  void getStyleUsage(librevenge::RVNGPropertyList &usage) const;
+
+  void setDiagnosticHandler(EPUBDiagnosticHandler handler);
+
+  void setProgressHandler(EPUBProgressHandler handler);
+  /// Whether the progress handler cancelled the generation; then all calls are ignored.
+  bool isCancelled() const;
+
+  /// Gets the reports of the sections, after endDocument().
+  void getSectionReport(librevenge::RVNGPropertyListVector &report) const;
+
+  void getStatistics(librevenge::RVNGPropertyList &statistics) const;
+
+  /// Gets the current and the peak memory usage, updating the peaks.
+  void getMemoryUsage(librevenge::RVNGPropertyList &usage) const;
+
+  /// Sets the memory of the finished sections and the images over which the sections are spilled; 0 means no limit.
+  void setMemoryBudget(unsigned long budget);
+
+  void setOutputMethod(EPUBOutputMethod outputMethod);
 
 private:
   virtual void startHtmlFile() = 0;
   virtual void endHtmlFile() = 0;
+  /// Adds the estimated memory of what the derived generator records.
+  virtual void addMemoryUsage(EPUBMemoryUsage &usage) const;
 
 private:
+  /// Reports the current section if it reached the maximum size.
+  void checkSectionSize();
+  /// Reports the spilled files which could not be read back.
+  void reportDamagedFiles(const std::vector<std::string> &paths);
+  /// Passes the report of the current section to the HTML manager.
+  void reportSection();
+  /// Measures the current memory usage and updates the peaks.
+  void sampleMemoryUsage() const;
+  /// Spills the finished sections if they and the images are over the memory budget.
+  void checkMemoryBudget();
+  /// Counts and drops the finished sections, if they are only measured.
+  void measureSections();
+  /** Ends a phase and reports the progress.
+    *
+    * @param[in,out] start the start of the phase; set to the start of the next one
+    * @return false if the generation is cancelled
+    */
+  bool endPhase(EPUBStatisticsPhase phase, EPUBStatistics::Clock::time_point &start);
+  /// Calls the progress handler; cancels the generation if it says so.
+  bool reportProgress(EPUBStatisticsPhase phase);
   void writeContainer();
   void writeNavigation();
   void writeStylesheet();
   void writeRoot();
 
 private:
-  EPUBPackage *m_package;
+  EPUBStatistics m_statistics;
+  /// Counts what is written into the package of the caller.
+  EPUBStatisticsPackage m_package;
+  EPUBNullPackage m_nullPackage;
+  /// Counts the sections which are only measured.
+  EPUBStatisticsPackage m_measurePackage;
   EPUBManifest m_manifest;
   EPUBHTMLManager m_htmlManager;
   EPUBImageManager m_imageManager;
@@ -93,7 +167,24 @@ private:
 
   int m_version;
   EPUBStylesMethod m_stylesMethod;
+  EPUBStylesheetMethod m_stylesheetMethod;
+  EPUBSpanStylesMethod m_spanStylesMethod;
   EPUBLayoutMethod m_layoutMethod;
+  EPUBNotesMethod m_notesMethod;
+  EPUBTocMethod m_tocMethod;
+  EPUBDiagnosticHandler m_diagnosticHandler;
+  EPUBProgressHandler m_progressHandler;
+  /// Why the current HTML file was started.
+  EPUBSplitReason m_splitReason;
+  unsigned m_splitHeadingLevel;
+  EPUBStatistics::Clock::time_point m_startTime;
+  /// Sampled at section boundaries and on request, hence mutable.
+  mutable EPUBMemoryUsage m_memoryUsage;
+  /// Whether the last section is closed, i.e., its zones are in the document.
+  bool m_documentEnded;
+  unsigned long m_memoryBudget;
+  EPUBOutputMethod m_outputMethod;
+  bool m_cancelled;
 };
 
 }
@@ -11,6 +11,7 @@
 
 #include <algorithm>
 #include <cmath>
+#include <initializer_list>
 #include <sstream>
 #include <stack>
 #include <string>
@@ -18,6 +19,7 @@
 
 #include <boost/algorithm/string/replace.hpp>
 
+#include "EPUBCSSProperties.h"
 #include "EPUBFontManager.h"
 #include "EPUBImageManager.h"
 #include "EPUBListStyleManager.h"
@@ -25,6 +27,7 @@
 #include "EPUBPath.h"
 #include "EPUBSpanStyleManager.h"
 #include "EPUBTableStyleManager.h"
+#include "EPUBTraceScope.h"
 #include "EPUBXMLContent.h"
 
 #include "libepubgen_utils.h"
@@ -132,7 +135,7 @@ struct EPUBHTMLTextZone
   //! the different zone
   enum Type { Z_Comment=0, Z_EndNote, Z_FootNote, Z_Main, Z_MetaData, Z_TextBox, Z_Unknown, Z_NumZones= Z_Unknown+1};
   //! constructor for basic stream
-  EPUBHTMLTextZone(Type tp=Z_Unknown) : m_type(tp), m_actualId(0), m_zoneSinks(), m_version(20)
+  EPUBHTMLTextZone(Type tp=Z_Unknown) : m_type(tp), m_actualId(0), m_zoneSinks(), m_version(20), m_mainHref(), m_notesHref()
   {
   }
   //! the type
@@ -153,6 +156,17 @@ struct EPUBHTMLTextZone
   {
     return m_version;
   }
+  //! puts the zone into a separate file: mainHref and notesHref are the two files, relative to each other
+  void setSeparate(const std::string &mainHref, const std::string &notesHref)
+  {
+    m_mainHref = mainHref;
+    m_notesHref = notesHref;
+  }
+  //! returns true if the zone is in a separate file
+  bool isSeparate() const
+  {
+    return !m_notesHref.empty();
+  }
   //! returns a new sink corresponding to this zone
   std::unique_ptr<TextZoneSink> getNewSink();
   //! returns true if there is no data
@@ -163,6 +177,14 @@ struct EPUBHTMLTextZone
         return false;
     return true;
   }
+  //! returns the estimated memory used by the data, in bytes
+  std::size_t getMemory() const
+  {
+    std::size_t memory = 0;
+    for (const auto &zoneSink : m_zoneSinks)
+      memory += zoneSink.get().getMemory();
+    return memory;
+  }
   //! send the zone data
   void send(EPUBXMLContent &out) const
   {
@@ -216,6 +238,10 @@ protected:
   //! the list of data string
   std::vector<ZoneSinkImpl> m_zoneSinks;
   int m_version;
+  //! the file of the calls, when the zone is in a separate file
+  std::string m_mainHref;
+  //! the file of the zone, when it is in a separate file
+  std::string m_notesHref;
 private:
   EPUBHTMLTextZone(EPUBHTMLTextZone const &orig);
   EPUBHTMLTextZone operator=(EPUBHTMLTextZone const &orig);
@@ -244,8 +270,14 @@ struct TextZoneSink
     if (!lbl.length())
       return;
     int version = 30;
+    std::string mainHref;
+    std::string notesHref;
     if (m_zone)
+    {
       version = m_zone->getVersion();
+      mainHref = m_zone->m_mainHref;
+      notesHref = m_zone->m_notesHref;
+    }
     {
       RVNGPropertyList supAttrs;
       supAttrs.insert("id", ("called" + lbl).c_str());
@@ -254,7 +286,7 @@ struct TextZoneSink
       RVNGPropertyList aAttrs;
       if (version >= 30)
         aAttrs.insert("epub:type", "noteref");
-      aAttrs.insert("href", ("#data" + lbl).c_str());
+      aAttrs.insert("href", (notesHref + "#data" + lbl).c_str());
       output.openElement("a", aAttrs);
       if (closeAnchor)
       {
@@ -278,7 +310,7 @@ struct TextZoneSink
     {
       m_delayedLabel.openElement("sup", supAttrs);
       RVNGPropertyList aAttrs;
-      aAttrs.insert("href", ("#called" + lbl).c_str());
+      aAttrs.insert("href", (mainHref + "#called" + lbl).c_str());
       m_delayedLabel.openElement("a", aAttrs);
       m_delayedLabel.insertCharacters(uiLabel.c_str());
       m_delayedLabel.closeElement("a");
@@ -296,6 +328,21 @@ struct TextZoneSink
   {
     return m_sink.get();
   }
+  //! returns the estimated size of the data, in bytes
+  std::size_t size() const
+  {
+    return m_sink.get().size() + m_delayedLabel.get().size();
+  }
+  //! returns the estimated memory used by the data, in bytes
+  std::size_t getMemory() const
+  {
+    return m_sink.get().getMemory() + m_delayedLabel.get().getMemory();
+  }
+  //! returns true if the data will be part of the body
+  bool isBodyContent() const
+  {
+    return m_zone && m_zone->type() != EPUBHTMLTextZone::Z_MetaData && m_zone->type() != EPUBHTMLTextZone::Z_Unknown && !m_zone->isSeparate();
+  }
   //! send the data to the zone
   void send()
   {
@@ -375,13 +422,25 @@ std::string EPUBHTMLTextZone::label(int id) const
   return s.str();
 }
 
+/// Counts the characters of UTF-8 text, like RVNGString::len().
+std::size_t getCharacterCount(const char *const text, const std::size_t length)
+{
+  std::size_t count = 0;
+  for (std::size_t i = 0; i < length; ++i)
+  {
+    if ((text[i] & 0xc0) != 0x80)
+      ++count;
+  }
+  return count;
+}
+
 }
 
 //! the internal state of a html document generator
 struct EPUBHTMLGeneratorImpl
 {
   //! constructor
-  EPUBHTMLGeneratorImpl(EPUBXMLContent &document, EPUBImageManager &imageManager, EPUBFontManager &fontManager, EPUBListStyleManager &listStyleManager, EPUBParagraphStyleManager &paragraphStyleManager, EPUBSpanStyleManager &spanStyleManager, EPUBSpanStyleManager &bodyStyleManager, EPUBTableStyleManager &tableStyleManager, const EPUBPath &path, const EPUBPath &stylesheetPath, EPUBStylesMethod stylesMethod, EPUBLayoutMethod layoutMethod, int version)
+  EPUBHTMLGeneratorImpl(EPUBXMLContent &document, EPUBImageManager &imageManager, EPUBFontManager &fontManager, EPUBListStyleManager &listStyleManager, EPUBParagraphStyleManager &paragraphStyleManager, EPUBSpanStyleManager &spanStyleManager, EPUBSpanStyleManager &bodyStyleManager, EPUBTableStyleManager &tableStyleManager, const EPUBPath &path, const EPUBPath &stylesheetPath, const EPUBPath &sectionStylesheetPath, std::set<std::string> &usedClasses, EPUBStylesMethod stylesMethod, EPUBStylesheetMethod stylesheetMethod, EPUBSpanStylesMethod spanStylesMethod, EPUBLayoutMethod layoutMethod, int version)
     : m_document(document)
     , m_imageManager(imageManager)
     , m_fontManager(fontManager)
@@ -392,6 +451,8 @@ struct EPUBHTMLGeneratorImpl
     , m_tableManager(tableStyleManager)
     , m_path(path)
     , m_stylesheetPath(stylesheetPath)
+    , m_sectionStylesheetPath(sectionStylesheetPath)
+    , m_usedClasses(usedClasses)
     , m_actualPage(0)
     , m_actualPageProperties()
     , m_ignore(false)
@@ -402,11 +463,22 @@ struct EPUBHTMLGeneratorImpl
     , m_linkPropertiesStack()
     , m_paragraphAttributesStack()
     , m_spanAttributesStack()
+    , m_inheritedPropertiesStack()
     , m_rubyText()
     , m_stylesMethod(stylesMethod)
+    , m_stylesheetMethod(stylesheetMethod)
+    , m_spanStylesMethod(spanStylesMethod)
     , m_layoutMethod(layoutMethod)
+    , m_imageSize(0)
+    , m_textLength(0)
+    , m_resources()
+    , m_notes(nullptr)
+    , m_paragraphId()
     , m_actualSink()
     , m_sinkStack()
+    , m_sentSize(0)
+    , m_stackedSize(0)
+    , m_stackedMemory(0)
   {
     for (int i = 0; i < EPUBHTMLTextZone::Z_NumZones; ++i)
     {
@@ -434,6 +506,8 @@ struct EPUBHTMLGeneratorImpl
   }
   void push(EPUBHTMLTextZone::Type type)
   {
+    m_stackedSize += m_actualSink->size();
+    m_stackedMemory += m_actualSink->getMemory();
     m_sinkStack.push(std::move(m_actualSink));
     if (type==EPUBHTMLTextZone::Z_Main || type==EPUBHTMLTextZone::Z_NumZones)
     {
@@ -451,11 +525,43 @@ struct EPUBHTMLGeneratorImpl
     }
     if (m_actualSink)
     {
+      if (m_actualSink->isBodyContent())
+        m_sentSize += m_actualSink->size();
       m_actualSink->send();
       m_actualSink.reset();
     }
     m_actualSink = std::move(m_sinkStack.top());
     m_sinkStack.pop();
+    m_stackedSize -= m_actualSink->size();
+    m_stackedMemory -= m_actualSink->getMemory();
+  }
+  //! returns the estimated size of the body and of the images it refers to, in bytes
+  std::size_t getSize() const
+  {
+    return m_sentSize + m_stackedSize + (m_actualSink ? m_actualSink->size() : 0) + m_imageSize;
+  }
+  //! returns the estimated memory used by the sinks and the zones, in bytes
+  std::size_t getMemory() const
+  {
+    std::size_t memory = m_stackedMemory + (m_actualSink ? m_actualSink->getMemory() : 0);
+    for (const auto &zone : m_zones)
+      memory += zone.getMemory();
+    return memory;
+  }
+  //! registers a class used by this file, returns its name
+  const std::string &useClass(const std::string &name)
+  {
+    if (m_stylesheetMethod == EPUB_STYLESHEET_METHOD_PER_SECTION)
+      m_usedClasses.insert(name);
+    return name;
+  }
+  //! returns the text properties a span inherits from its paragraph
+  const EPUBCSSProperties &getInheritedProperties() const
+  {
+    static EPUBCSSProperties dummy;
+    if (m_inheritedPropertiesStack.empty())
+      return dummy;
+    return m_inheritedPropertiesStack.top();
   }
   void sendMetaData(EPUBXMLContent &out)
   {
@@ -476,10 +582,37 @@ struct EPUBHTMLGeneratorImpl
     }
     else
       m_actualSink->sendMain(out);
-    m_zones[EPUBHTMLTextZone::Z_Comment].send(out);
-    m_zones[EPUBHTMLTextZone::Z_FootNote].send(out);
-    m_zones[EPUBHTMLTextZone::Z_EndNote].send(out);
-    m_zones[EPUBHTMLTextZone::Z_TextBox].send(out);
+    for (const auto type : {EPUBHTMLTextZone::Z_Comment, EPUBHTMLTextZone::Z_FootNote, EPUBHTMLTextZone::Z_EndNote, EPUBHTMLTextZone::Z_TextBox})
+    {
+      if (!m_zones[type].isSeparate())
+        m_zones[type].send(out);
+    }
+  }
+  //! moves the notes and comments to a separate file
+  void setSeparateNotes(const std::string &mainHref, const std::string &notesHref)
+  {
+    // Text boxes have no links to them, so they stay in the main file.
+    for (const auto type : {EPUBHTMLTextZone::Z_Comment, EPUBHTMLTextZone::Z_FootNote, EPUBHTMLTextZone::Z_EndNote})
+      m_zones[type].setSeparate(mainHref, notesHref);
+  }
+  //! returns true if some zone of the separate file has data
+  bool hasSeparateNotes() const
+  {
+    for (const auto &zone : m_zones)
+    {
+      if (zone.isSeparate() && !zone.isEmpty())
+        return true;
+    }
+    return false;
+  }
+  //! sends the zones of the separate file
+  void sendSeparateNotes(EPUBXMLContent &out)
+  {
+    for (const auto type : {EPUBHTMLTextZone::Z_Comment, EPUBHTMLTextZone::Z_FootNote, EPUBHTMLTextZone::Z_EndNote})
+    {
+      if (m_zones[type].isSeparate())
+        m_zones[type].send(out);
+    }
   }
 
   EPUBXMLContent &m_document;
@@ -492,6 +625,9 @@ struct EPUBHTMLGeneratorImpl
   EPUBTableStyleManager &m_tableManager;
   const EPUBPath m_path;
   const EPUBPath m_stylesheetPath;
+  const EPUBPath m_sectionStylesheetPath;
+  /// Classes referenced from this file.
+  std::set<std::string> &m_usedClasses;
 
   int m_actualPage;
   RVNGPropertyList m_actualPageProperties;
@@ -505,17 +641,39 @@ struct EPUBHTMLGeneratorImpl
   /// This is used for links which don't have a href.
   std::stack<RVNGPropertyList> m_linkPropertiesStack;
   std::stack<RVNGPropertyList> m_paragraphAttributesStack;
+  /// Empty attributes mean that the span has no element.
   std::stack<RVNGPropertyList> m_spanAttributesStack;
+  /// Text properties the paragraphs provide to their spans.
+  std::stack<EPUBCSSProperties> m_inheritedPropertiesStack;
 
   /// This is set when the span has ruby text and should be wrapped in <ruby></ruby>.
   std::string m_rubyText;
 
   EPUBStylesMethod m_stylesMethod;
+  EPUBStylesheetMethod m_stylesheetMethod;
+  EPUBSpanStylesMethod m_spanStylesMethod;
   EPUBLayoutMethod m_layoutMethod;
 
+  /// Size of the images inserted into this file.
+  std::size_t m_imageSize;
+  /// Length of the inserted text, in characters.
+  std::size_t m_textLength;
+  /// Paths of the images inserted into this file.
+  std::vector<std::string> m_resources;
+  /// The separate file of the notes, if there is one.
+  EPUBXMLContent *m_notes;
+  /// The id of the next paragraph.
+  std::string m_paragraphId;
+
 protected:
   std::unique_ptr<TextZoneSink> m_actualSink;
   std::stack<std::unique_ptr<TextZoneSink>> m_sinkStack;
+  /// Size of the notes, comments, etc. already sent to their zone.
+  std::size_t m_sentSize;
+  /// Size of the sinks in m_sinkStack.
+  std::size_t m_stackedSize;
+  /// Memory of the sinks in m_sinkStack.
+  std::size_t m_stackedMemory;
 
   EPUBHTMLTextZone m_zones[EPUBHTMLTextZone::Z_NumZones];
 private:
@@ -523,8 +681,8 @@ private:
   EPUBHTMLGeneratorImpl operator=(EPUBHTMLGeneratorImpl const &orig);
 };
 
-EPUBHTMLGenerator::EPUBHTMLGenerator(EPUBXMLContent &document, EPUBImageManager &imageManager, EPUBFontManager &fontManager, EPUBListStyleManager &listStyleManager, EPUBParagraphStyleManager &paragraphStyleManager, EPUBSpanStyleManager &spanStyleManager, EPUBSpanStyleManager &bodyStyleManager, EPUBTableStyleManager &tableStyleManager, const EPUBPath &path, const EPUBPath &stylesheetPath, EPUBStylesMethod stylesMethod, EPUBLayoutMethod layoutMethod, int version)
-  : m_impl(new EPUBHTMLGeneratorImpl(document, imageManager, fontManager, listStyleManager, paragraphStyleManager, spanStyleManager, bodyStyleManager, tableStyleManager, path, stylesheetPath, stylesMethod, layoutMethod, version))
+EPUBHTMLGenerator::EPUBHTMLGenerator(EPUBXMLContent &document, EPUBImageManager &imageManager, EPUBFontManager &fontManager, EPUBListStyleManager &listStyleManager, EPUBParagraphStyleManager &paragraphStyleManager, EPUBSpanStyleManager &spanStyleManager, EPUBSpanStyleManager &bodyStyleManager, EPUBTableStyleManager &tableStyleManager, const EPUBPath &path, const EPUBPath &stylesheetPath, const EPUBPath &sectionStylesheetPath, std::set<std::string> &usedClasses, EPUBStylesMethod stylesMethod, EPUBStylesheetMethod stylesheetMethod, EPUBSpanStylesMethod spanStylesMethod, EPUBLayoutMethod layoutMethod, int version)
+  : m_impl(new EPUBHTMLGeneratorImpl(document, imageManager, fontManager, listStyleManager, paragraphStyleManager, spanStyleManager, bodyStyleManager, tableStyleManager, path, stylesheetPath, sectionStylesheetPath, usedClasses, stylesMethod, stylesheetMethod, spanStylesMethod, layoutMethod, version))
 {
 }
 
@@ -568,22 +726,39 @@ void EPUBHTMLGenerator::startDocument(const RVNGPropertyList &)
 }
 
 void EPUBHTMLGenerator::endDocument()
+{
+  EPUBGEN_TRACE_SCOPE("EPUBHTMLGenerator::endDocument");
+  openHtml(m_impl->m_document);
+  m_impl->flushUnsent(m_impl->m_document);
+  m_impl->m_document.closeElement("body");
+  m_impl->m_document.closeElement("html");
+
+  if (m_impl->m_notes && m_impl->hasSeparateNotes())
+  {
+    openHtml(*m_impl->m_notes);
+    m_impl->sendSeparateNotes(*m_impl->m_notes);
+    m_impl->m_notes->closeElement("body");
+    m_impl->m_notes->closeElement("html");
+  }
+}
+
+void EPUBHTMLGenerator::openHtml(EPUBXMLContent &document)
 {
   RVNGPropertyList htmlAttrs;
   // TODO: set lang and xml:lang from metadata
   htmlAttrs.insert("xmlns", "http://www.w3.org/1999/xhtml");
-  m_impl->m_document.openElement("html", htmlAttrs);
-  m_impl->m_document.openElement("head", RVNGPropertyList());
+  document.openElement("html", htmlAttrs);
+  document.openElement("head", RVNGPropertyList());
   if (m_impl->m_version < 30)
   {
-    m_impl->m_document.openElement("title", RVNGPropertyList());
-    m_impl->m_document.closeElement("title");
+    document.openElement("title", RVNGPropertyList());
+    document.closeElement("title");
   }
   RVNGPropertyList metaAttrs;
   metaAttrs.insert("http-equiv", "content-type");
   metaAttrs.insert("content", "text/html; charset=UTF-8");
-  m_impl->m_document.openElement("meta", metaAttrs);
-  m_impl->m_document.closeElement("meta");
+  document.openElement("meta", metaAttrs);
+  document.closeElement("meta");
   if (m_impl->m_version >= 30 && m_impl->m_layoutMethod == EPUB_LAYOUT_METHOD_FIXED)
   {
     metaAttrs.clear();
@@ -600,17 +775,22 @@ void EPUBHTMLGenerator::endDocument()
       content << inchToCSSPixel(pageHeight);
     }
     metaAttrs.insert("content", content.str().c_str());
-    m_impl->m_document.openElement("meta", metaAttrs);
-    m_impl->m_document.closeElement("meta");
+    document.openElement("meta", metaAttrs);
+    document.closeElement("meta");
   }
   if (m_impl->m_version < 30)
-    m_impl->sendMetaData(m_impl->m_document);
+    m_impl->sendMetaData(document);
   RVNGPropertyList linkAttrs;
   linkAttrs.insert("href", m_impl->m_stylesheetPath.relativeTo(m_impl->m_path).str().c_str());
   linkAttrs.insert("type", "text/css");
   linkAttrs.insert("rel", "stylesheet");
-  m_impl->m_document.insertEmptyElement("link", linkAttrs);
-  m_impl->m_document.closeElement("head");
+  document.insertEmptyElement("link", linkAttrs);
+  if (m_impl->m_stylesheetMethod == EPUB_STYLESHEET_METHOD_PER_SECTION)
+  {
+    linkAttrs.insert("href", m_impl->m_sectionStylesheetPath.relativeTo(m_impl->m_path).str().c_str());
+    document.insertEmptyElement("link", linkAttrs);
+  }
+  document.closeElement("head");
   RVNGPropertyList bodyAttrs;
   if (m_impl->m_version >= 30)
     bodyAttrs.insert("xmlns:epub", "http://www.idpf.org/2007/ops");
@@ -620,7 +800,7 @@ void EPUBHTMLGenerator::endDocument()
     switch (m_impl->m_stylesMethod)
     {
     case EPUB_STYLES_METHOD_CSS:
-      bodyAttrs.insert("class", m_impl->m_bodyManager.getClass(m_impl->m_actualPageProperties).c_str());
+      bodyAttrs.insert("class", m_impl->useClass(m_impl->m_bodyManager.getClass(m_impl->m_actualPageProperties)).c_str());
       break;
     case EPUB_STYLES_METHOD_INLINE:
       bodyAttrs.insert("style", m_impl->m_bodyManager.getStyle(m_impl->m_actualPageProperties).c_str());
@@ -628,10 +808,7 @@ void EPUBHTMLGenerator::endDocument()
     }
   }
 
-  m_impl->m_document.openElement("body", bodyAttrs);
-  m_impl->flushUnsent(m_impl->m_document);
-  m_impl->m_document.closeElement("body");
-  m_impl->m_document.closeElement("html");
+  document.openElement("body", bodyAttrs);
 }
 
 void EPUBHTMLGenerator::defineEmbeddedFont(const RVNGPropertyList &propList)
@@ -696,36 +873,52 @@ void EPUBHTMLGenerator::defineParagraphStyle(const RVNGPropertyList &propList)
 
 void EPUBHTMLGenerator::openParagraph(const RVNGPropertyList &propList)
 {
+  EPUBGEN_TRACE_SCOPE("EPUBHTMLGenerator::openParagraph");
   if (m_impl->m_ignore)
     return;
 
+  EPUBCSSProperties textProps;
+  if (m_impl->m_spanStylesMethod == EPUB_SPAN_STYLES_METHOD_DELTA)
+    m_impl->m_spanManager.extractInheritedProperties(propList, textProps);
+
   RVNGPropertyList attrs;
   switch (m_impl->m_stylesMethod)
   {
   case EPUB_STYLES_METHOD_CSS:
-    attrs.insert("class", m_impl->m_paragraphManager.getClass(propList).c_str());
+    attrs.insert("class", m_impl->useClass(m_impl->m_paragraphManager.getClass(propList, textProps)).c_str());
     break;
   case EPUB_STYLES_METHOD_INLINE:
-    attrs.insert("style", m_impl->m_paragraphManager.getStyle(propList).c_str());
+    attrs.insert("style", m_impl->m_paragraphManager.getStyle(propList, textProps).c_str());
     break;
   }
-  m_impl->output(false).openElement("p", attrs);
-  m_impl->m_hasText = false;
-
+  // The paragraph may be reopened with these, e.g. after a text box: not with the id.
   librevenge::RVNGPropertyList::Iter i(attrs);
   RVNGPropertyList paragraphAttributes;
   for (i.rewind(); i.next();)
     paragraphAttributes.insert(i.key(), i()->clone());
   m_impl->m_paragraphAttributesStack.push(paragraphAttributes);
+
+  if (!m_impl->m_paragraphId.empty())
+  {
+    attrs.insert("id", m_impl->m_paragraphId.c_str());
+    m_impl->m_paragraphId.clear();
+  }
+  m_impl->output(false).openElement("p", attrs);
+  m_impl->m_hasText = false;
+  if (m_impl->m_spanStylesMethod == EPUB_SPAN_STYLES_METHOD_DELTA)
+    m_impl->m_inheritedPropertiesStack.push(textProps);
 }
 
 void EPUBHTMLGenerator::closeParagraph()
 {
+  EPUBGEN_TRACE_SCOPE("EPUBHTMLGenerator::closeParagraph");
   if (m_impl->m_ignore)
     return;
 
   if (!m_impl->m_paragraphAttributesStack.empty())
     m_impl->m_paragraphAttributesStack.pop();
+  if (!m_impl->m_inheritedPropertiesStack.empty())
+    m_impl->m_inheritedPropertiesStack.pop();
 
   if (!m_impl->m_hasText)
     insertSpace();
@@ -740,18 +933,43 @@ void EPUBHTMLGenerator::defineCharacterStyle(const RVNGPropertyList &propList)
 
 void EPUBHTMLGenerator::openSpan(const RVNGPropertyList &propList)
 {
+  EPUBGEN_TRACE_SCOPE("EPUBHTMLGenerator::openSpan");
   if (m_impl->m_ignore)
     return;
 
   RVNGPropertyList attrs;
-  switch (m_impl->m_stylesMethod)
+  if (m_impl->m_spanStylesMethod == EPUB_SPAN_STYLES_METHOD_DELTA)
   {
-  case EPUB_STYLES_METHOD_CSS:
-    attrs.insert("class", m_impl->m_spanManager.getClass(propList).c_str());
-    break;
-  case EPUB_STYLES_METHOD_INLINE:
-    attrs.insert("style", m_impl->m_spanManager.getStyle(propList).c_str());
-    break;
+    // Only write what the paragraph doesn't provide already.
+    switch (m_impl->m_stylesMethod)
+    {
+    case EPUB_STYLES_METHOD_CSS:
+    {
+      const std::string className = m_impl->m_spanManager.getDeltaClass(propList, m_impl->getInheritedProperties());
+      if (!className.empty())
+        attrs.insert("class", m_impl->useClass(className).c_str());
+      break;
+    }
+    case EPUB_STYLES_METHOD_INLINE:
+    {
+      const std::string style = m_impl->m_spanManager.getDeltaStyle(propList, m_impl->getInheritedProperties());
+      if (!style.empty())
+        attrs.insert("style", style.c_str());
+      break;
+    }
+    }
+  }
+  else
+  {
+    switch (m_impl->m_stylesMethod)
+    {
+    case EPUB_STYLES_METHOD_CSS:
+      attrs.insert("class", m_impl->useClass(m_impl->m_spanManager.getClass(propList)).c_str());
+      break;
+    case EPUB_STYLES_METHOD_INLINE:
+      attrs.insert("style", m_impl->m_spanManager.getStyle(propList).c_str());
+      break;
+    }
   }
 
   const librevenge::RVNGProperty *rubyText = propList["text:ruby-text"];
@@ -761,7 +979,9 @@ void EPUBHTMLGenerator::openSpan(const RVNGPropertyList &propList)
     m_impl->output(false).openElement("ruby", attrs);
   }
 
-  m_impl->output(false).openElement("span", attrs);
+  // A span without attributes would add nothing.
+  if (!attrs.empty())
+    m_impl->output(false).openElement("span", attrs);
 
   librevenge::RVNGPropertyList::Iter i(attrs);
   RVNGPropertyList spanAttributes;
@@ -772,13 +992,19 @@ void EPUBHTMLGenerator::openSpan(const RVNGPropertyList &propList)
 
 void EPUBHTMLGenerator::closeSpan()
 {
+  EPUBGEN_TRACE_SCOPE("EPUBHTMLGenerator::closeSpan");
   if (m_impl->m_ignore)
     return;
 
+  bool hasElement = true;
   if (!m_impl->m_spanAttributesStack.empty())
+  {
+    hasElement = !m_impl->m_spanAttributesStack.top().empty();
     m_impl->m_spanAttributesStack.pop();
+  }
 
-  m_impl->output().closeElement("span");
+  if (hasElement)
+    m_impl->output().closeElement("span");
 
   if (m_impl->m_rubyText.length())
   {
@@ -793,6 +1019,7 @@ void EPUBHTMLGenerator::closeSpan()
 
 void EPUBHTMLGenerator::openLink(const RVNGPropertyList &propList)
 {
+  EPUBGEN_TRACE_SCOPE("EPUBHTMLGenerator::openLink");
   if (m_impl->m_ignore)
     return;
 
@@ -868,12 +1095,19 @@ void EPUBHTMLGenerator::insertField(const RVNGPropertyList & /* propList */)
 
 void EPUBHTMLGenerator::insertText(const RVNGString &text)
 {
+  insertText(text.cstr(), text.size());
+}
+
+void EPUBHTMLGenerator::insertText(const char *const text, const std::size_t length)
+{
+  EPUBGEN_TRACE_SCOPE("EPUBHTMLGenerator::insertText");
   if (m_impl->m_ignore)
     return;
   EPUBXMLContent &output = openPopup();
-  output.insertCharacters(text);
+  output.insertCharacters(text, length);
   closePopup(output);
   m_impl->m_hasText = true;
+  m_impl->m_textLength += getCharacterCount(text, length);
 }
 
 void EPUBHTMLGenerator::insertSpace()
@@ -886,11 +1120,15 @@ void EPUBHTMLGenerator::insertSpace()
 
 void EPUBHTMLGenerator::openOrderedListLevel(const RVNGPropertyList &propList)
 {
+  EPUBGEN_TRACE_SCOPE("EPUBHTMLGenerator::openOrderedListLevel");
   if (m_impl->m_ignore)
     return;
   m_impl->m_listManager.defineLevel(propList, true);
   RVNGPropertyList attrs;
-  attrs.insert("class", m_impl->m_listManager.openLevel(propList, true).c_str());
+  attrs.insert("class", m_impl->useClass(m_impl->m_listManager.openLevel(propList, true)).c_str());
+  // XHTML 1.1 has no start attribute.
+  if (m_impl->m_version >= 30 && propList["text:start-value"] && propList["text:start-value"]->getInt() != 1)
+    attrs.insert("start", propList["text:start-value"]->getInt());
   // fixme: if level is > 1, we must first insert a div here
   m_impl->output(false).openElement("ol", attrs);
 }
@@ -905,11 +1143,12 @@ void EPUBHTMLGenerator::closeOrderedListLevel()
 
 void EPUBHTMLGenerator::openUnorderedListLevel(const RVNGPropertyList &propList)
 {
+  EPUBGEN_TRACE_SCOPE("EPUBHTMLGenerator::openUnorderedListLevel");
   if (m_impl->m_ignore)
     return;
   m_impl->m_listManager.defineLevel(propList, false);
   RVNGPropertyList attrs;
-  attrs.insert("class", m_impl->m_listManager.openLevel(propList, false).c_str());
+  attrs.insert("class", m_impl->useClass(m_impl->m_listManager.openLevel(propList, false)).c_str());
   // fixme: if level is > 1, we must first insert a div here
   m_impl->output(false).openElement("ul", attrs);
 }
@@ -925,22 +1164,29 @@ void EPUBHTMLGenerator::closeUnorderedListLevel()
 
 void EPUBHTMLGenerator::openListElement(const RVNGPropertyList &propList)
 {
+  EPUBGEN_TRACE_SCOPE("EPUBHTMLGenerator::openListElement");
   if (m_impl->m_ignore)
     return;
   RVNGPropertyList attrs;
-  attrs.insert("class", m_impl->m_listManager.getClass(propList).c_str());
+  attrs.insert("class", m_impl->useClass(m_impl->m_listManager.getClass(propList)).c_str());
   m_impl->output(false).openElement("li", attrs);
+  // List elements have no text properties to inherit.
+  if (m_impl->m_spanStylesMethod == EPUB_SPAN_STYLES_METHOD_DELTA)
+    m_impl->m_inheritedPropertiesStack.push(EPUBCSSProperties());
 }
 
 void EPUBHTMLGenerator::closeListElement()
 {
   if (m_impl->m_ignore)
     return;
+  if (!m_impl->m_inheritedPropertiesStack.empty())
+    m_impl->m_inheritedPropertiesStack.pop();
   m_impl->output().closeElement("li");
 }
 
 void EPUBHTMLGenerator::openFootnote(const RVNGPropertyList &propList)
 {
+  EPUBGEN_TRACE_SCOPE("EPUBHTMLGenerator::openFootnote");
   if (m_impl->m_ignore)
     return;
   EPUBXMLContent &output = m_impl->output();
@@ -963,6 +1209,7 @@ void EPUBHTMLGenerator::closeFootnote()
 
 void EPUBHTMLGenerator::openEndnote(const RVNGPropertyList &)
 {
+  EPUBGEN_TRACE_SCOPE("EPUBHTMLGenerator::openEndnote");
   if (m_impl->m_ignore)
     return;
   EPUBXMLContent &output = m_impl->output();
@@ -979,6 +1226,7 @@ void EPUBHTMLGenerator::closeEndnote()
 
 void EPUBHTMLGenerator::openComment(const RVNGPropertyList & /*propList*/)
 {
+  EPUBGEN_TRACE_SCOPE("EPUBHTMLGenerator::openComment");
   if (m_impl->m_ignore)
     return;
   EPUBXMLContent &output = m_impl->output();
@@ -995,10 +1243,11 @@ void EPUBHTMLGenerator::closeComment()
 
 void EPUBHTMLGenerator::openTextBox(const RVNGPropertyList & /*propList*/)
 {
+  EPUBGEN_TRACE_SCOPE("EPUBHTMLGenerator::openTextBox");
   if (m_impl->m_ignore)
     return;
 
-  if (!m_impl->m_spanAttributesStack.empty())
+  if (!m_impl->m_spanAttributesStack.empty() && !m_impl->m_spanAttributesStack.top().empty())
     m_impl->output().closeElement("span");
   if (!m_impl->m_paragraphAttributesStack.empty())
     m_impl->output().closeElement("p");
@@ -1011,7 +1260,7 @@ void EPUBHTMLGenerator::openTextBox(const RVNGPropertyList & /*propList*/)
     switch (m_impl->m_stylesMethod)
     {
     case EPUB_STYLES_METHOD_CSS:
-      attrs.insert("class", m_impl->m_imageManager.getFrameClass(frameProperties).c_str());
+      attrs.insert("class", m_impl->useClass(m_impl->m_imageManager.getFrameClass(frameProperties)).c_str());
       break;
     case EPUB_STYLES_METHOD_INLINE:
       attrs.insert("style", m_impl->m_imageManager.getFrameStyle(frameProperties).c_str());
@@ -1043,12 +1292,13 @@ void EPUBHTMLGenerator::closeTextBox()
 
   if (!m_impl->m_paragraphAttributesStack.empty())
     m_impl->output(false).openElement("p", m_impl->m_paragraphAttributesStack.top());
-  if (!m_impl->m_spanAttributesStack.empty())
+  if (!m_impl->m_spanAttributesStack.empty() && !m_impl->m_spanAttributesStack.top().empty())
     m_impl->output(false).openElement("span", m_impl->m_spanAttributesStack.top());
 }
 
 void EPUBHTMLGenerator::openTable(const RVNGPropertyList &propList)
 {
+  EPUBGEN_TRACE_SCOPE("EPUBHTMLGenerator::openTable");
   if (m_impl->m_ignore)
     return;
 
@@ -1057,7 +1307,7 @@ void EPUBHTMLGenerator::openTable(const RVNGPropertyList &propList)
   switch (m_impl->m_stylesMethod)
   {
   case EPUB_STYLES_METHOD_CSS:
-    attrs.insert("class", m_impl->m_tableManager.getTableClass(propList).c_str());
+    attrs.insert("class", m_impl->useClass(m_impl->m_tableManager.getTableClass(propList)).c_str());
     break;
   case EPUB_STYLES_METHOD_INLINE:
     attrs.insert("style", m_impl->m_tableManager.getTableStyle(propList).c_str());
@@ -1069,13 +1319,14 @@ void EPUBHTMLGenerator::openTable(const RVNGPropertyList &propList)
 
 void EPUBHTMLGenerator::openTableRow(const RVNGPropertyList &propList)
 {
+  EPUBGEN_TRACE_SCOPE("EPUBHTMLGenerator::openTableRow");
   if (m_impl->m_ignore)
     return;
   RVNGPropertyList attrs;
   switch (m_impl->m_stylesMethod)
   {
   case EPUB_STYLES_METHOD_CSS:
-    attrs.insert("class", m_impl->m_tableManager.getRowClass(propList).c_str());
+    attrs.insert("class", m_impl->useClass(m_impl->m_tableManager.getRowClass(propList)).c_str());
     break;
   case EPUB_STYLES_METHOD_INLINE:
     attrs.insert("style", m_impl->m_tableManager.getRowStyle(propList).c_str());
@@ -1093,13 +1344,14 @@ void EPUBHTMLGenerator::closeTableRow()
 
 void EPUBHTMLGenerator::openTableCell(const RVNGPropertyList &propList)
 {
+  EPUBGEN_TRACE_SCOPE("EPUBHTMLGenerator::openTableCell");
   if (m_impl->m_ignore)
     return;
   RVNGPropertyList attrs;
   switch (m_impl->m_stylesMethod)
   {
   case EPUB_STYLES_METHOD_CSS:
-    attrs.insert("class", m_impl->m_tableManager.getCellClass(propList).c_str());
+    attrs.insert("class", m_impl->useClass(m_impl->m_tableManager.getCellClass(propList)).c_str());
     break;
   case EPUB_STYLES_METHOD_INLINE:
     attrs.insert("style", m_impl->m_tableManager.getCellStyle(propList).c_str());
@@ -1124,6 +1376,7 @@ void EPUBHTMLGenerator::insertCoveredTableCell(const RVNGPropertyList & /* propL
 
 void EPUBHTMLGenerator::closeTable()
 {
+  EPUBGEN_TRACE_SCOPE("EPUBHTMLGenerator::closeTable");
   if (m_impl->m_ignore)
     return;
   m_impl->output().closeElement("tbody");
@@ -1133,6 +1386,7 @@ void EPUBHTMLGenerator::closeTable()
 
 void EPUBHTMLGenerator::openFrame(const RVNGPropertyList &propList)
 {
+  EPUBGEN_TRACE_SCOPE("EPUBHTMLGenerator::openFrame");
   librevenge::RVNGPropertyList::Iter i(propList);
   std::string anchorType;
   RVNGPropertyList frameProperties;
@@ -1180,9 +1434,12 @@ void EPUBHTMLGenerator::drawConnector(const librevenge::RVNGPropertyList & /* pr
 
 void EPUBHTMLGenerator::insertBinaryObject(const RVNGPropertyList &propList)
 {
-  const EPUBPath &path = m_impl->m_imageManager.insert(
-                           RVNGBinaryData(propList["office:binary-data"]->getStr()),
-                           propList["librevenge:mime-type"]->getStr());
+  EPUBGEN_TRACE_SCOPE("EPUBHTMLGenerator::insertBinaryObject");
+  const RVNGBinaryData data(propList["office:binary-data"]->getStr());
+  const EPUBPath &path = m_impl->m_imageManager.insert(data, propList["librevenge:mime-type"]->getStr());
+  m_impl->m_imageSize += data.size();
+  if (std::find(m_impl->m_resources.begin(), m_impl->m_resources.end(), path.str()) == m_impl->m_resources.end())
+    m_impl->m_resources.push_back(path.str());
 
   RVNGPropertyList attrs;
   RVNGString wrapStyle;
@@ -1193,7 +1450,7 @@ void EPUBHTMLGenerator::insertBinaryObject(const RVNGPropertyList &propList)
     switch (m_impl->m_stylesMethod)
     {
     case EPUB_STYLES_METHOD_CSS:
-      attrs.insert("class", m_impl->m_imageManager.getFrameClass(frameProperties).c_str());
+      attrs.insert("class", m_impl->useClass(m_impl->m_imageManager.getFrameClass(frameProperties)).c_str());
       break;
     case EPUB_STYLES_METHOD_INLINE:
       attrs.insert("style", m_impl->m_imageManager.getFrameStyle(frameProperties).c_str());
@@ -1250,6 +1507,43 @@ void EPUBHTMLGenerator::closePopup(EPUBXMLContent &main)
 
 void EPUBHTMLGenerator::insertEquation(const RVNGPropertyList & /* propList */) {}
 
+void EPUBHTMLGenerator::setParagraphId(const std::string &id)
+{
+  m_impl->m_paragraphId = id;
+}
+
+void EPUBHTMLGenerator::setNotes(EPUBXMLContent &notes, const EPUBPath &notesPath)
+{
+  m_impl->m_notes = &notes;
+  m_impl->setSeparateNotes(m_impl->m_path.relativeTo(notesPath).str(), notesPath.relativeTo(m_impl->m_path).str());
+}
+
+std::size_t EPUBHTMLGenerator::getSize() const
+{
+  return m_impl->getSize();
+}
+
+std::size_t EPUBHTMLGenerator::getMemory() const
+{
+  return m_impl->getMemory();
+}
+
+void EPUBHTMLGenerator::getReport(librevenge::RVNGPropertyList &report) const
+{
+  report.insert("libepubgen:events", int(m_impl->m_document.getEventCount()));
+  report.insert("libepubgen:text-length", int(m_impl->m_textLength));
+  report.insert("libepubgen:size", int(m_impl->getSize()));
+  librevenge::RVNGPropertyListVector resources;
+  for (const auto &resource : m_impl->m_resources)
+  {
+    RVNGPropertyList resourceProps;
+    resourceProps.insert("libepubgen:path", resource.c_str());
+    resources.append(resourceProps);
+  }
+  if (resources.count())
+    report.insert("libepubgen:resources", resources);
+}
+
 void EPUBHTMLGenerator::getPageProperties(librevenge::RVNGPropertyList &propList) const
 {
   propList.clear();
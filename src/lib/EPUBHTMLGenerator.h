@@ -10,7 +10,10 @@
 #ifndef INCLUDED_EPUBHTMLGENERATOR_H
 #define INCLUDED_EPUBHTMLGENERATOR_H
 
+#include <cstddef>
 #include <memory>
+#include <set>
+#include <string>
 
 #include <librevenge/librevenge.h>
 
@@ -32,7 +35,7 @@ class EPUBXMLContent;
 class EPUBHTMLGenerator : public librevenge::RVNGTextInterface
 {
 public:
-  EPUBHTMLGenerator(EPUBXMLContent &document, EPUBImageManager &imageManager, EPUBFontManager &fontManager, EPUBListStyleManager &listStyleManager, EPUBParagraphStyleManager &paragraphStyleManager, EPUBSpanStyleManager &spanStyleManager, EPUBSpanStyleManager &bodyStyleManager, EPUBTableStyleManager &tableStyleManager, const EPUBPath &path, const EPUBPath &stylesheetPath, EPUBStylesMethod stylesMethod, EPUBLayoutMethod layoutMethod, int version);
+  EPUBHTMLGenerator(EPUBXMLContent &document, EPUBImageManager &imageManager, EPUBFontManager &fontManager, EPUBListStyleManager &listStyleManager, EPUBParagraphStyleManager &paragraphStyleManager, EPUBSpanStyleManager &spanStyleManager, EPUBSpanStyleManager &bodyStyleManager, EPUBTableStyleManager &tableStyleManager, const EPUBPath &path, const EPUBPath &stylesheetPath, const EPUBPath &sectionStylesheetPath, std::set<std::string> &usedClasses, EPUBStylesMethod stylesMethod, EPUBStylesheetMethod stylesheetMethod, EPUBSpanStylesMethod spanStylesMethod, EPUBLayoutMethod layoutMethod, int version);
   ~EPUBHTMLGenerator() override;
 
   void setDocumentMetaData(const librevenge::RVNGPropertyList &propList) override;
@@ -67,6 +70,8 @@ public:
 
   void insertTab() override;
   void insertText(const librevenge::RVNGString &text) override;
+  /// Inserts length bytes of UTF-8 text, without building a string.
+  void insertText(const char *text, std::size_t length);
   void insertSpace() override;
   void insertLineBreak() override;
   void insertField(const librevenge::RVNGPropertyList &propList) override;
@@ -112,12 +117,31 @@ public:
   void insertBinaryObject(const librevenge::RVNGPropertyList &propList) override;
   void insertEquation(const librevenge::RVNGPropertyList &propList) override;
 
+  /// Sets the id of the next paragraph, e.g. to link to a heading.
+  void setParagraphId(const std::string &id);
+
+  /// Gets the estimated size of the file and of the images it refers to, in bytes.
+  std::size_t getSize() const;
+  /// Gets the estimated memory used by the content which is not in the document yet, in bytes.
+  std::size_t getMemory() const;
+  /// Adds the statistics of the file to report.
+  void getReport(librevenge::RVNGPropertyList &report) const;
+
+  /** Moves the footnotes, endnotes and comments to a separate file.
+    *
+    * @param[in] notes the content of the notes file
+    * @param[in] notesPath the path of the notes file
+    */
+  void setNotes(EPUBXMLContent &notes, const EPUBPath &notesPath);
+
   /// Gets the actual page properties into propList.
   void getPageProperties(librevenge::RVNGPropertyList &propList) const;
   /// Sets the actual page properties from propList.
   void setPageProperties(const librevenge::RVNGPropertyList &propList);
 
 private:
+  /// Writes the head of an HTML file and opens its body.
+  void openHtml(EPUBXMLContent &document);
   EPUBXMLContent &openPopup();
   void closePopup(EPUBXMLContent &main);
 
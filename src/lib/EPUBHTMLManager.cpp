@@ -14,8 +14,13 @@
 #include <iomanip>
 #include <sstream>
 
+#include "EPUBCSSContent.h"
 #include "EPUBHTMLGenerator.h"
 #include "EPUBManifest.h"
+#include "EPUBMemoryUsage.h"
+#include "EPUBSpillFile.h"
+#include "EPUBStatistics.h"
+#include "EPUBTraceScope.h"
 
 namespace libepubgen
 {
@@ -23,10 +28,13 @@ namespace libepubgen
 namespace
 {
 
+/// The spill record of a file which is in memory.
+const std::size_t NOT_SPILLED = std::size_t(-1);
+
 /// Extracts a title string from a path and provides a fallback if it would be empty.
-void getPathTitle(std::ostringstream &label, const EPUBPath &path, EPUBLayoutMethod layout, std::vector<EPUBPath>::size_type index)
+void getPathTitle(std::ostringstream &label, const std::string &title, EPUBLayoutMethod layout, std::vector<EPUBPath>::size_type index)
 {
-  if (path.getTitle().empty())
+  if (title.empty())
   {
     if (layout == EPUB_LAYOUT_METHOD_FIXED)
       label << "Page ";
@@ -35,7 +43,7 @@ void getPathTitle(std::ostringstream &label, const EPUBPath &path, EPUBLayoutMet
     label << (index + 1);
   }
   else
-    label << path.getTitle();
+    label << title;
 }
 
 }
@@ -45,11 +53,29 @@ EPUBHTMLManager::EPUBHTMLManager(EPUBManifest &manifest)
   , m_paths()
   , m_contents()
   , m_ids()
+  , m_stylesheetPaths()
+  , m_classes()
+  , m_reports()
+  , m_notesIds()
+  , m_notesPaths()
+  , m_notesContents()
+  , m_hasNotes()
   , m_number()
+  , m_outline()
+  , m_spillFile()
+  , m_spillRecords()
+  , m_notesSpillRecords()
+  , m_written()
+  , m_finishedSize(0)
+  , m_finishedMemory(0)
+{
+}
+
+EPUBHTMLManager::~EPUBHTMLManager()
 {
 }
 
-const std::shared_ptr<EPUBHTMLGenerator> EPUBHTMLManager::create(EPUBImageManager &imageManager, EPUBFontManager &fontManager, EPUBListStyleManager &listStyleManager, EPUBParagraphStyleManager &paragraphStyleManager, EPUBSpanStyleManager &spanStyleManager, EPUBSpanStyleManager &bodyStyleManager, EPUBTableStyleManager &tableStyleManager, const EPUBPath &stylesheetPath, EPUBStylesMethod stylesMethod, EPUBLayoutMethod layoutMethod, int version)
+const std::shared_ptr<EPUBHTMLGenerator> EPUBHTMLManager::create(EPUBImageManager &imageManager, EPUBFontManager &fontManager, EPUBListStyleManager &listStyleManager, EPUBParagraphStyleManager &paragraphStyleManager, EPUBSpanStyleManager &spanStyleManager, EPUBSpanStyleManager &bodyStyleManager, EPUBTableStyleManager &tableStyleManager, const EPUBPath &stylesheetPath, EPUBStylesMethod stylesMethod, EPUBStylesheetMethod stylesheetMethod, EPUBSpanStylesMethod spanStylesMethod, EPUBLayoutMethod layoutMethod, EPUBNotesMethod notesMethod, int version)
 {
   std::ostringstream nameBuf;
   nameBuf << "section" << std::setw(4) << std::setfill('0') << m_number.next();
@@ -61,36 +87,296 @@ const std::shared_ptr<EPUBHTMLGenerator> EPUBHTMLManager::create(EPUBImageManage
   m_manifest.insert(m_paths.back(), "application/xhtml+xml", m_ids.back(), "");
 
   m_contents.push_back(EPUBXMLContent());
+  m_spillRecords.push_back(NOT_SPILLED);
+
+  m_stylesheetPaths.push_back(EPUBPath("OEBPS/styles") / (m_ids.back() + ".css"));
+  if (stylesheetMethod == EPUB_STYLESHEET_METHOD_PER_SECTION)
+    m_manifest.insert(m_stylesheetPaths.back(), "text/css", m_ids.back() + ".css", "");
+  m_classes.push_back(std::set<std::string>());
+  m_reports.push_back(librevenge::RVNGPropertyList());
+  m_outline.startSection();
+
+  // The notes file has the same number as its section.
+  std::ostringstream notesNameBuf;
+  notesNameBuf << "notes-" << std::setw(4) << std::setfill('0') << m_number.current();
+  m_notesIds.push_back(notesNameBuf.str());
+  m_notesPaths.push_back(EPUBPath("OEBPS/sections") / (m_notesIds.back() + ".xhtml"));
+  m_notesContents.push_back(EPUBXMLContent());
+  m_notesSpillRecords.push_back(NOT_SPILLED);
+  m_hasNotes.push_back(false);
+  m_written.push_back(false);
 
   const std::shared_ptr<EPUBHTMLGenerator> gen(
-    new EPUBHTMLGenerator(m_contents.back(), imageManager, fontManager, listStyleManager, paragraphStyleManager, spanStyleManager, bodyStyleManager, tableStyleManager, m_paths.back(), stylesheetPath, stylesMethod, layoutMethod, version));
+    new EPUBHTMLGenerator(m_contents.back(), imageManager, fontManager, listStyleManager, paragraphStyleManager, spanStyleManager, bodyStyleManager, tableStyleManager, m_paths.back(), stylesheetPath, m_stylesheetPaths.back(), m_classes.back(), stylesMethod, stylesheetMethod, spanStylesMethod, layoutMethod, version));
+  if (notesMethod == EPUB_NOTES_METHOD_SEPARATE)
+    gen->setNotes(m_notesContents.back(), m_notesPaths.back());
 
   return gen;
 }
 
-void EPUBHTMLManager::writeTo(EPUBPackage &package)
+void EPUBHTMLManager::writeOutlineTo(EPUBXMLContent &xml, const EPUBPath &tocPath, int version, EPUBLayoutMethod layout)
 {
+  struct Entry
+  {
+    unsigned m_level;
+    bool m_hasChildren;
+  };
+  // The entries which are still open, the innermost last.
+  std::vector<Entry> open;
+  int playOrder = 0;
+
+  // Closes the entries of at least level.
+  const auto closeEntries = [&](unsigned level)
+  {
+    for (; !open.empty() && (open.back().m_level >= level); open.pop_back())
+    {
+      if (version >= 30)
+      {
+        if (open.back().m_hasChildren)
+          xml.closeElement("ol");
+        xml.closeElement("li");
+      }
+      else
+        xml.closeElement("navPoint");
+    }
+  };
+  const auto openEntry = [&](unsigned level, const std::string &label, const std::string &href)
+  {
+    closeEntries(level);
+    if (!open.empty() && !open.back().m_hasChildren)
+    {
+      open.back().m_hasChildren = true;
+      if (version >= 30)
+        xml.openElement("ol");
+    }
+    open.push_back(Entry {level, false});
+    ++playOrder;
+
+    if (version >= 30)
+    {
+      xml.openElement("li");
+      librevenge::RVNGPropertyList anchorAttrs;
+      anchorAttrs.insert("href", href.c_str());
+      xml.openElement("a", anchorAttrs);
+      xml.insertCharacters(label.c_str());
+      xml.closeElement("a");
+      return;
+    }
+
+    std::ostringstream id;
+    id << "navPoint" << playOrder;
+    librevenge::RVNGPropertyList navPointAttrs;
+    navPointAttrs.insert("id", id.str().c_str());
+    navPointAttrs.insert("class", "document");
+    std::ostringstream order;
+    order << playOrder;
+    navPointAttrs.insert("playOrder", order.str().c_str());
+    xml.openElement("navPoint", navPointAttrs);
+    xml.openElement("navLabel");
+    xml.openElement("text");
+    xml.insertCharacters(label.c_str());
+    xml.closeElement("text");
+    xml.closeElement("navLabel");
+    librevenge::RVNGPropertyList contentAttrs;
+    contentAttrs.insert("src", href.c_str());
+    xml.insertEmptyElement("content", contentAttrs);
+  };
+
+  const std::vector<EPUBOutline::Heading> &headings = m_outline.getHeadings();
+  std::vector<EPUBOutline::Heading>::size_type heading = 0;
+  for (std::vector<EPUBPath>::size_type i = 0; m_paths.size() != i; ++i)
+  {
+    const std::string path = m_paths[i].relativeTo(tocPath).str();
+    bool hasEntry = false;
+    for (; (headings.size() != heading) && (headings[heading].m_section == i); ++heading)
+    {
+      if (headings[heading].m_title.empty())
+        continue;
+      openEntry(headings[heading].m_level, headings[heading].m_title, path + "#" + EPUBOutline::getAnchor(heading));
+      hasEntry = true;
+    }
+    if (!hasEntry)
+    {
+      // Continue the current level: the section is most likely a part of
+      // the content of the last heading.
+      std::ostringstream label;
+      getPathTitle(label, std::string(), layout, i);
+      openEntry(open.empty() ? 1 : open.back().m_level, label.str(), path);
+    }
+  }
+  closeEntries(0);
+}
+
+void EPUBHTMLManager::finishSection()
+{
+  if (m_contents.empty())
+    return;
+
+  m_finishedSize += m_contents.back().size();
+  m_finishedMemory += m_contents.back().getMemory();
+  if (m_notesContents.back().empty())
+    return;
+
+  m_finishedSize += m_notesContents.back().size();
+  m_finishedMemory += m_notesContents.back().getMemory();
+  m_manifest.insert(m_notesPaths.back(), "application/xhtml+xml", m_notesIds.back(), "");
+  m_hasNotes.back() = true;
+}
+
+std::size_t EPUBHTMLManager::getFinishedSize() const
+{
+  return m_finishedSize;
+}
+
+void EPUBHTMLManager::setReport(const librevenge::RVNGPropertyList &report)
+{
+  if (m_reports.empty())
+    return;
+  m_reports.back() = report;
+}
+
+void EPUBHTMLManager::getReport(librevenge::RVNGPropertyListVector &report) const
+{
+  assert(m_reports.size() == m_paths.size());
+  for (std::vector<EPUBPath>::size_type i = 0; m_paths.size() != i; ++i)
+  {
+    librevenge::RVNGPropertyList section(m_reports[i]);
+    section.insert("libepubgen:path", m_paths[i].str().c_str());
+    const std::string &title = m_outline.getSectionTitle(i);
+    if (!title.empty())
+      section.insert("libepubgen:title", title.c_str());
+    report.append(section);
+  }
+}
+
+void EPUBHTMLManager::addMemoryUsage(EPUBMemoryUsage &usage) const
+{
+  usage.m_current[EPUB_MEMORY_XHTML] += m_finishedMemory;
+}
+
+void EPUBHTMLManager::writeTo(EPUBStatisticsPackage &package, std::vector<std::string> &damaged)
+{
+  EPUBGEN_TRACE_SCOPE("EPUBHTMLManager::writeTo");
   assert(m_contents.size() == m_paths.size());
 
   std::vector<EPUBPath>::const_iterator pathIt = m_paths.begin();
   auto contentIt = m_contents.begin();
 
-  for (; (m_paths.end() != pathIt) && (m_contents.end() != contentIt); ++pathIt, ++contentIt)
-    contentIt->writeTo(package, pathIt->str().c_str());
+  auto recordIt = m_spillRecords.begin();
+  auto writtenIt = m_written.begin();
+  for (; (m_paths.end() != pathIt) && (m_contents.end() != contentIt); ++pathIt, ++contentIt, ++recordIt, ++writtenIt)
+  {
+    if (!*writtenIt)
+      writeFileTo(package, *contentIt, *pathIt, *recordIt, damaged);
+  }
+
+  assert(m_notesContents.size() == m_notesPaths.size());
+  for (std::vector<EPUBPath>::size_type i = 0; m_notesPaths.size() != i; ++i)
+  {
+    if (m_hasNotes[i] && !m_written[i])
+      writeFileTo(package, m_notesContents[i], m_notesPaths[i], m_notesSpillRecords[i], damaged);
+  }
+}
+
+void EPUBHTMLManager::spill()
+{
+  EPUBGEN_TRACE_SCOPE("EPUBHTMLManager::spill");
+  if (!m_spillFile)
+    m_spillFile.reset(new EPUBSpillFile());
+
+  // The content of a section is only set when it is finished.
+  for (std::vector<EPUBPath>::size_type i = 0; m_contents.size() != i; ++i)
+  {
+    if (!m_contents[i].empty() && m_spillFile->spill(m_contents[i], m_paths[i].str().c_str(), m_spillRecords[i]))
+    {
+      m_finishedMemory -= m_contents[i].getMemory();
+      m_contents[i] = EPUBXMLContent();
+    }
+  }
+  for (std::vector<EPUBPath>::size_type i = 0; m_notesContents.size() != i; ++i)
+  {
+    if (m_hasNotes[i] && !m_notesContents[i].empty() && m_spillFile->spill(m_notesContents[i], m_notesPaths[i].str().c_str(), m_notesSpillRecords[i]))
+    {
+      m_finishedMemory -= m_notesContents[i].getMemory();
+      m_notesContents[i] = EPUBXMLContent();
+    }
+  }
+}
+
+void EPUBHTMLManager::writeFinishedTo(EPUBStatisticsPackage &package, std::vector<std::string> &damaged)
+{
+  EPUBGEN_TRACE_SCOPE("EPUBHTMLManager::writeFinishedTo");
+  for (std::vector<EPUBPath>::size_type i = 0; m_contents.size() != i; ++i)
+  {
+    if (m_written[i])
+      continue;
+
+    writeFileTo(package, m_contents[i], m_paths[i], m_spillRecords[i], damaged);
+    m_finishedMemory -= m_contents[i].getMemory();
+    m_contents[i] = EPUBXMLContent();
+
+    if (m_hasNotes[i])
+    {
+      writeFileTo(package, m_notesContents[i], m_notesPaths[i], m_notesSpillRecords[i], damaged);
+      m_finishedMemory -= m_notesContents[i].getMemory();
+      m_notesContents[i] = EPUBXMLContent();
+    }
+
+    m_written[i] = true;
+  }
+}
+
+void EPUBHTMLManager::release()
+{
+  // Emptied in place, as the generator of the current section still refers to its content.
+  std::fill(m_contents.begin(), m_contents.end(), EPUBXMLContent());
+  std::fill(m_notesContents.begin(), m_notesContents.end(), EPUBXMLContent());
+  m_finishedMemory = 0;
+  m_spillFile.reset();
+  std::fill(m_spillRecords.begin(), m_spillRecords.end(), NOT_SPILLED);
+  std::fill(m_notesSpillRecords.begin(), m_notesSpillRecords.end(), NOT_SPILLED);
+}
+
+void EPUBHTMLManager::writeFileTo(EPUBStatisticsPackage &package, EPUBXMLContent &content, const EPUBPath &path, const std::size_t record, std::vector<std::string> &damaged)
+{
+  if (NOT_SPILLED == record)
+    content.writeTo(package, path.str().c_str());
+  else if (!m_spillFile->replay(record, package))
+    damaged.push_back(path.str());
+}
+
+void EPUBHTMLManager::writeStylesheetsTo(EPUBStatisticsPackage &package, EPUBCSSContent &stylesheet)
+{
+  assert(m_classes.size() == m_stylesheetPaths.size());
+  for (std::vector<EPUBPath>::size_type i = 0; m_stylesheetPaths.size() != i; ++i)
+    stylesheet.writeClassesTo(package, m_stylesheetPaths[i].str().c_str(), m_classes[i]);
 }
 
 void EPUBHTMLManager::writeSpineTo(EPUBXMLContent &xml)
 {
-  for (std::vector<std::string>::const_iterator it = m_ids.begin(); m_ids.end() != it; ++it)
+  for (std::vector<std::string>::size_type i = 0; m_ids.size() != i; ++i)
   {
     librevenge::RVNGPropertyList itemrefAttrs;
-    itemrefAttrs.insert("idref", it->c_str());
+    itemrefAttrs.insert("idref", m_ids[i].c_str());
     xml.insertEmptyElement("itemref", itemrefAttrs);
+    if (m_hasNotes[i])
+    {
+      // The notes are only reached through the links to them.
+      itemrefAttrs.insert("idref", m_notesIds[i].c_str());
+      itemrefAttrs.insert("linear", "no");
+      xml.insertEmptyElement("itemref", itemrefAttrs);
+    }
   }
 }
 
-void EPUBHTMLManager::writeTocTo(EPUBXMLContent &xml, const EPUBPath &tocPath, int version, EPUBLayoutMethod layout)
+void EPUBHTMLManager::writeTocTo(EPUBXMLContent &xml, const EPUBPath &tocPath, int version, EPUBLayoutMethod layout, bool outline)
 {
+  if (outline)
+  {
+    writeOutlineTo(xml, tocPath, version, layout);
+    return;
+  }
+
   if (version >= 30)
   {
     bool hasChapterNames = std::find_if(m_paths.begin(), m_paths.end(), [](const EPUBPath &path)
@@ -121,7 +407,7 @@ void EPUBHTMLManager::writeTocTo(EPUBXMLContent &xml, const EPUBPath &tocPath, i
       anchorAttrs.insert("href", m_paths[i].relativeTo(tocPath).str().c_str());
       xml.openElement("a", anchorAttrs);
       std::ostringstream label;
-      getPathTitle(label, m_paths[i], layout, i);
+      getPathTitle(label, m_outline.getSectionTitle(i), layout, i);
       xml.insertCharacters(label.str().c_str());
       xml.closeElement("a");
       xml.closeElement("li");
@@ -144,7 +430,7 @@ void EPUBHTMLManager::writeTocTo(EPUBXMLContent &xml, const EPUBPath &tocPath, i
     xml.openElement("navLabel");
     xml.openElement("text");
     std::ostringstream label;
-    getPathTitle(label, m_paths[i], layout, i);
+    getPathTitle(label, m_outline.getSectionTitle(i), layout, i);
     xml.insertCharacters(label.str().c_str());
     xml.closeElement("text");
     xml.closeElement("navLabel");
@@ -155,12 +441,9 @@ void EPUBHTMLManager::writeTocTo(EPUBXMLContent &xml, const EPUBPath &tocPath, i
   }
 }
 
-void EPUBHTMLManager::insertHeadingText(const std::string &text)
+EPUBOutline &EPUBHTMLManager::getOutline()
 {
-  if (m_paths.empty())
-    return;
-
-  m_paths.back().appendTitle(text);
+  return m_outline;
 }
 
 void EPUBHTMLManager::addChapterName(const std::string &text)
@@ -171,14 +454,6 @@ void EPUBHTMLManager::addChapterName(const std::string &text)
   m_paths.back().addChapter(text);
 }
 
-bool EPUBHTMLManager::hasHeadingText() const
-{
-  if (m_paths.empty())
-    return false;
-
-  return !m_paths.back().getTitle().empty();
-}
-
 }
 
 /* vim:set shiftwidth=2 softtabstop=2 expandtab: */
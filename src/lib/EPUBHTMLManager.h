@@ -10,7 +10,10 @@
 #ifndef INCLUDED_EPUBHTMLMANAGER_H
 #define INCLUDED_EPUBHTMLMANAGER_H
 
+#include <cstddef>
+#include <deque>
 #include <memory>
+#include <set>
 #include <string>
 #include <vector>
 
@@ -19,12 +22,14 @@
 #include <libepubgen/libepubgen-decls.h>
 
 #include "EPUBCounter.h"
+#include "EPUBOutline.h"
 #include "EPUBPath.h"
 #include "EPUBXMLContent.h"
 
 namespace libepubgen
 {
 
+class EPUBCSSContent;
 class EPUBFontManager;
 class EPUBHTMLGenerator;
 class EPUBImageManager;
@@ -33,7 +38,9 @@ class EPUBParagraphStyleManager;
 class EPUBSpanStyleManager;
 class EPUBTableStyleManager;
 class EPUBManifest;
-class EPUBPackage;
+struct EPUBMemoryUsage;
+class EPUBSpillFile;
+class EPUBStatisticsPackage;
 
 class EPUBHTMLManager
 {
@@ -43,29 +50,102 @@ class EPUBHTMLManager
 
 public:
   explicit EPUBHTMLManager(EPUBManifest &manifest);
+  ~EPUBHTMLManager();
 
-  const std::shared_ptr<EPUBHTMLGenerator> create(EPUBImageManager &imageManager, EPUBFontManager &fontManager, EPUBListStyleManager &listStyleManager, EPUBParagraphStyleManager &paragraphStyleManager, EPUBSpanStyleManager &spanStyleManager, EPUBSpanStyleManager &bodyStyleManager, EPUBTableStyleManager &tableStyleManager, const EPUBPath &stylesheetPath, EPUBStylesMethod stylesMethod, EPUBLayoutMethod layoutMethod, int version);
+  const std::shared_ptr<EPUBHTMLGenerator> create(EPUBImageManager &imageManager, EPUBFontManager &fontManager, EPUBListStyleManager &listStyleManager, EPUBParagraphStyleManager &paragraphStyleManager, EPUBSpanStyleManager &spanStyleManager, EPUBSpanStyleManager &bodyStyleManager, EPUBTableStyleManager &tableStyleManager, const EPUBPath &stylesheetPath, EPUBStylesMethod stylesMethod, EPUBStylesheetMethod stylesheetMethod, EPUBSpanStylesMethod spanStylesMethod, EPUBLayoutMethod layoutMethod, EPUBNotesMethod notesMethod, int version);
 
-  void writeTo(EPUBPackage &package);
+  /** Writes the sections which writeFinishedTo() did not, with their notes.
+    *
+    * @param[out] damaged the paths of the spilled files which could not be
+    *   read back, and are missing from the package
+    */
+  void writeTo(EPUBStatisticsPackage &package, std::vector<std::string> &damaged);
+
+  /// Writes the per-section stylesheets, each with the classes used by its section.
+  void writeStylesheetsTo(EPUBStatisticsPackage &package, EPUBCSSContent &stylesheet);
 
   void writeSpineTo(EPUBXMLContent &xml);
-  void writeTocTo(EPUBXMLContent &xml, const EPUBPath &tocPath, int version, EPUBLayoutMethod layout);
+  /** Writes the entries of a table of contents.
+    *
+    * @param[in] outline if there is an entry for each heading, instead of one for each section.
+    */
+  void writeTocTo(EPUBXMLContent &xml, const EPUBPath &tocPath, int version, EPUBLayoutMethod layout, bool outline);
 
-  /// Appends text to the title of the current heading.
-  void insertHeadingText(const std::string &text);
+  /// Gets the headings of the document, which give the titles of the sections.
+  EPUBOutline &getOutline();
 
   /// Registers a chapter name for the current page (fixed layout case).
   void addChapterName(const std::string &text);
 
-  /// If the current heading has a title.
-  bool hasHeadingText() const;
+  /** Finishes the current section.
+    *
+    * Adds its notes file to the manifest, if it has notes, and counts its
+    * estimated size and memory.
+    */
+  void finishSection();
+
+  /// Gets the estimated size of the finished sections, with their notes.
+  std::size_t getFinishedSize() const;
+
+  /// Sets the report of the current section.
+  void setReport(const librevenge::RVNGPropertyList &report);
+  /// Gets the reports of all sections, with their paths and titles.
+  void getReport(librevenge::RVNGPropertyListVector &report) const;
+
+  /// Adds the estimated memory of the finished sections to usage.
+  void addMemoryUsage(EPUBMemoryUsage &usage) const;
+
+  /** Moves the content of the finished sections to a temporary file.
+    *
+    * It is read back by writeTo(). A section which cannot be written to
+    * the file stays in memory.
+    */
+  void spill();
+
+  /** Writes the finished sections, with their notes, and drops their content.
+    *
+    * writeTo() skips them. It must only be called between sections.
+    *
+    * @param[out] damaged as for writeTo()
+    */
+  void writeFinishedTo(EPUBStatisticsPackage &package, std::vector<std::string> &damaged);
+
+  /// Drops the content of all sections, e.g., when the generation is cancelled.
+  void release();
+
+private:
+  void writeOutlineTo(EPUBXMLContent &xml, const EPUBPath &tocPath, int version, EPUBLayoutMethod layout);
+  /// Writes a section or a notes file, from memory or from m_spillFile.
+  void writeFileTo(EPUBStatisticsPackage &package, EPUBXMLContent &content, const EPUBPath &path, std::size_t record, std::vector<std::string> &damaged);
 
 private:
   EPUBManifest &m_manifest;
   std::vector<EPUBPath> m_paths;
-  std::vector<EPUBXMLContent> m_contents;
+  /// The generators keep references to the content and the classes, so they are in deques, which do not move them.
+  std::deque<EPUBXMLContent> m_contents;
   std::vector<std::string> m_ids;
+  std::vector<EPUBPath> m_stylesheetPaths;
+  /// Classes used by each section.
+  std::deque<std::set<std::string>> m_classes;
+  std::vector<librevenge::RVNGPropertyList> m_reports;
+  /// The notes of each section, if they are in a separate file.
+  std::vector<std::string> m_notesIds;
+  std::vector<EPUBPath> m_notesPaths;
+  std::deque<EPUBXMLContent> m_notesContents;
+  std::vector<bool> m_hasNotes;
   EPUBCounter m_number;
+  EPUBOutline m_outline;
+  /// Created when the first section is spilled.
+  std::unique_ptr<EPUBSpillFile> m_spillFile;
+  /// The record of each section in m_spillFile, or NOT_SPILLED if it is in m_contents.
+  std::vector<std::size_t> m_spillRecords;
+  std::vector<std::size_t> m_notesSpillRecords;
+  /// Whether each section, with its notes, was written by writeFinishedTo() already.
+  std::vector<bool> m_written;
+  /// The estimated size of the finished sections, with their notes.
+  std::size_t m_finishedSize;
+  /// The estimated memory of the finished sections which are in memory, with their notes.
+  std::size_t m_finishedMemory;
 };
 
 }
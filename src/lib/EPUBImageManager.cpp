@@ -20,6 +20,9 @@
 #include "EPUBCSSContent.h"
 #include "EPUBManifest.h"
 #include "EPUBPath.h"
+#include "EPUBMemoryUsage.h"
+#include "EPUBStatistics.h"
+#include "EPUBTraceScope.h"
 
 namespace libepubgen
 {
@@ -71,13 +74,18 @@ bool EPUBImageManager::BinaryDataEqual::operator()(const librevenge::RVNGBinaryD
 EPUBImageManager::EPUBImageManager(EPUBManifest &manifest)
   : m_manifest(manifest)
   , m_map()
+  , m_mapEntries()
   , m_number()
-  , m_imageContentNameMap()
+  , m_insertions(0)
+  , m_memory(0)
+  , m_imageContentNameMap("frame")
 {
 }
 
 const EPUBPath &EPUBImageManager::insert(const librevenge::RVNGBinaryData &data, const librevenge::RVNGString &mimetype, const librevenge::RVNGString &properties)
 {
+  EPUBGEN_TRACE_SCOPE("EPUBImageManager::insert");
+  ++m_insertions;
   MapType_t::const_iterator it = m_map.find(data);
   if (m_map.end() == it)
   {
@@ -93,6 +101,8 @@ const EPUBPath &EPUBImageManager::insert(const librevenge::RVNGBinaryData &data,
 
     m_manifest.insert(path, mime, id, properties.cstr());
     it = m_map.insert(MapType_t::value_type(data, path)).first;
+    m_mapEntries.push_back(&*it);
+    m_memory += sizeof(MapType_t::value_type) + data.size();
   }
 
   assert(m_map.end() != it); // the image must be present at this point
@@ -102,11 +112,12 @@ const EPUBPath &EPUBImageManager::insert(const librevenge::RVNGBinaryData &data,
 
 void EPUBImageManager::writeTo(EPUBPackage &package)
 {
-  for (MapType_t::const_iterator it = m_map.begin(); m_map.end() != it; ++it)
+  EPUBGEN_TRACE_SCOPE("EPUBImageManager::writeTo");
+  for (const auto &entry : m_mapEntries)
   {
     EPUBBinaryContent image;
-    image.insertBinaryData(it->first);
-    image.writeTo(package, it->second.str().c_str());
+    image.insertBinaryData(entry->first);
+    image.writeTo(package, entry->second.str().c_str());
   }
 }
 
@@ -114,13 +125,7 @@ std::string EPUBImageManager::getFrameClass(librevenge::RVNGPropertyList const &
 {
   EPUBCSSProperties content;
   extractImageProperties(pList, content);
-  ContentNameMap_t::const_iterator it=m_imageContentNameMap.find(content);
-  if (it != m_imageContentNameMap.end())
-    return it->second;
-  std::stringstream s;
-  s << "frame" << m_imageContentNameMap.size();
-  m_imageContentNameMap[content]=s.str();
-  return s.str();
+  return m_imageContentNameMap.getName(content);
 }
 
 std::string EPUBImageManager::getFrameStyle(librevenge::RVNGPropertyList const &pList)
@@ -200,14 +205,40 @@ std::string EPUBImageManager::getWrapStyle(librevenge::RVNGPropertyList const &p
   return ret;
 }
 
+void EPUBImageManager::setClassNamesMethod(EPUBClassNamesMethod method)
+{
+  m_imageContentNameMap.setClassNamesMethod(method);
+}
+
+void EPUBImageManager::getUsage(librevenge::RVNGPropertyList &usage) const
+{
+  m_imageContentNameMap.getUsage(usage);
+}
+
+void EPUBImageManager::addStatistics(EPUBStatistics &statistics) const
+{
+  statistics.m_images += m_insertions;
+  statistics.m_duplicateImages += m_insertions - m_mapEntries.size();
+  m_imageContentNameMap.addStatistics(statistics);
+}
+
+void EPUBImageManager::addMemoryUsage(EPUBMemoryUsage &usage) const
+{
+  usage.m_current[EPUB_MEMORY_IMAGES] += m_memory;
+  m_imageContentNameMap.addMemoryUsage(usage);
+}
+
+void EPUBImageManager::release()
+{
+  m_mapEntries.clear();
+  m_map.clear();
+  m_insertions = 0;
+  m_memory = 0;
+}
+
 void EPUBImageManager::send(EPUBCSSContent &out)
 {
-  for (auto it = m_imageContentNameMap.begin(); m_imageContentNameMap.end() != it; ++it)
-  {
-    librevenge::RVNGPropertyList props;
-    fillPropertyList(it->first, props);
-    out.insertRule(("." + it->second).c_str(), props);
-  }
+  m_imageContentNameMap.send(out);
 }
 
 }
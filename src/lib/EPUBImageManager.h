@@ -10,15 +10,18 @@
 #ifndef INCLUDED_EPUBIMAGEMANAGER_H
 #define INCLUDED_EPUBIMAGEMANAGER_H
 
+#include <cstddef>
 #include <string>
 #include <unordered_map>
 #include <unordered_set>
+#include <vector>
 
 #include <boost/functional/hash.hpp>
 
 #include <librevenge/librevenge.h>
 
 #include "EPUBCSSProperties.h"
+#include "EPUBContentNameMap.h"
 #include "EPUBCounter.h"
 #include "EPUBPath.h"
 
@@ -28,6 +31,8 @@ namespace libepubgen
 class EPUBManifest;
 class EPUBPackage;
 class EPUBCSSContent;
+struct EPUBMemoryUsage;
+struct EPUBStatistics;
 
 class EPUBImageManager
 {
@@ -46,7 +51,6 @@ class EPUBImageManager
   };
 
   typedef std::unordered_map<librevenge::RVNGBinaryData, EPUBPath, BinaryDataHash, BinaryDataEqual> MapType_t;
-  typedef std::unordered_map<EPUBCSSProperties, std::string, boost::hash<EPUBCSSProperties>> ContentNameMap_t;
 
 public:
   explicit EPUBImageManager(EPUBManifest &manifest);
@@ -61,6 +65,16 @@ public:
   std::string getFrameStyle(librevenge::RVNGPropertyList const &pList);
   //! returns the style for a follow-up <br> element, based on wrapping properties.
   static std::string getWrapStyle(librevenge::RVNGPropertyList const &pList);
+  //! set how the classes are named
+  void setClassNamesMethod(EPUBClassNamesMethod method);
+  //! add the number of uses of each class to usage
+  void getUsage(librevenge::RVNGPropertyList &usage) const;
+  //! add the image and style cache counters to statistics
+  void addStatistics(EPUBStatistics &statistics) const;
+  //! add the estimated memory of the images and of their classes to usage
+  void addMemoryUsage(EPUBMemoryUsage &usage) const;
+  //! forget the images, e.g., when the generation is cancelled
+  void release();
   //! send the data to the sink
   void send(EPUBCSSContent &out);
 
@@ -70,9 +84,15 @@ private:
 
   EPUBManifest &m_manifest;
   MapType_t m_map;
+  //! the entries of m_map, in insertion order
+  std::vector<const MapType_t::value_type *> m_mapEntries;
   EPUBCounter m_number;
+  //! the number of calls of insert()
+  unsigned long m_insertions;
+  //! the estimated memory of the entries of m_map
+  std::size_t m_memory;
   //! a map image content -> name
-  ContentNameMap_t m_imageContentNameMap;
+  EPUBContentNameMap m_imageContentNameMap;
 };
 
 }
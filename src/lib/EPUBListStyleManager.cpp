@@ -16,6 +16,9 @@
 
 #include "libepubgen_utils.h"
 #include "EPUBCSSContent.h"
+#include "EPUBMemoryUsage.h"
+#include "EPUBStatistics.h"
+#include "EPUBTraceScope.h"
 
 namespace libepubgen
 {
@@ -75,29 +78,42 @@ const EPUBCSSProperties &EPUBListStyleManager::List::getCurrentProperties() cons
   return m_contentsList[size_t(m_level)];
 }
 
+void EPUBListStyleManager::setClassNamesMethod(EPUBClassNamesMethod method)
+{
+  EPUBParagraphStyleManager::setClassNamesMethod(method);
+  m_levelNameMap.setClassNamesMethod(method);
+}
+
+void EPUBListStyleManager::getUsage(RVNGPropertyList &usage) const
+{
+  EPUBParagraphStyleManager::getUsage(usage);
+  m_levelNameMap.getUsage(usage);
+}
+
+void EPUBListStyleManager::addStatistics(EPUBStatistics &statistics) const
+{
+  EPUBParagraphStyleManager::addStatistics(statistics);
+  m_levelNameMap.addStatistics(statistics);
+}
+
+void EPUBListStyleManager::addMemoryUsage(EPUBMemoryUsage &usage) const
+{
+  EPUBParagraphStyleManager::addMemoryUsage(usage);
+  m_levelNameMap.addMemoryUsage(usage);
+}
+
 void EPUBListStyleManager::send(EPUBCSSContent &out)
 {
   EPUBParagraphStyleManager::send(out);
-
-  for (List::ContentNameMap_t::const_iterator it=m_levelNameMap.begin(); m_levelNameMap.end() != it; ++it)
-  {
-    RVNGPropertyList props;
-    fillPropertyList(it->first, props);
-    out.insertRule(("." + it->second).c_str(), props);
-  }
+  m_levelNameMap.send(out);
 }
 
 std::string EPUBListStyleManager::getClass(RVNGPropertyList const &pList)
 {
+  EPUBGEN_TRACE_SCOPE("EPUBListStyleManager::getClass");
   EPUBCSSProperties content;
   extractProperties(pList, true, content);
-  List::ContentNameMap_t::const_iterator it = m_contentNameMap.find(content);
-  if (it != m_contentNameMap.end())
-    return it->second;
-  std::stringstream s;
-  s << "listElt" << m_contentNameMap.size();
-  m_contentNameMap[content]=s.str();
-  return s.str();
+  return m_contentNameMap.getName(content);
 }
 
 void EPUBListStyleManager::defineLevel(RVNGPropertyList const &pList, bool ordered)
@@ -132,14 +148,7 @@ std::string EPUBListStyleManager::openLevel(RVNGPropertyList const &pList, bool
     const EPUBCSSProperties &levelProps = m_idListMap.find(id)->second.getCurrentProperties();
     content.insert(levelProps.begin(), levelProps.end());
   }
-  List::ContentNameMap_t::const_iterator it = m_levelNameMap.find(content);
-  if (it != m_levelNameMap.end())
-    return it->second;
-  std::stringstream s;
-  s << "listLevel" << m_levelNameMap.size();
-  m_levelNameMap[content]=s.str();
-
-  return s.str();
+  return m_levelNameMap.getName(content);
 }
 
 void EPUBListStyleManager::closeLevel()
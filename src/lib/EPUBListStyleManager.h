@@ -12,20 +12,20 @@
 
 #include <string>
 #include <map>
-#include <unordered_map>
 #include <vector>
 
-#include <boost/functional/hash.hpp>
-
 #include <librevenge/librevenge.h>
 
 #include "EPUBCSSProperties.h"
+#include "EPUBContentNameMap.h"
 #include "EPUBParagraphStyleManager.h"
 
 namespace libepubgen
 {
 
 class EPUBCSSContent;
+struct EPUBMemoryUsage;
+struct EPUBStatistics;
 
 /** Small class to manage the list style */
 class EPUBListStyleManager : public EPUBParagraphStyleManager
@@ -33,8 +33,6 @@ class EPUBListStyleManager : public EPUBParagraphStyleManager
 public:
   struct List
   {
-    typedef std::unordered_map<EPUBCSSProperties, std::string, boost::hash<EPUBCSSProperties>> ContentNameMap_t;
-
     //! constructor
     List() : m_contentsList(), m_level(0)
     {
@@ -68,7 +66,7 @@ public:
     mutable int m_level;
   };
   //! constructor
-  EPUBListStyleManager() : EPUBParagraphStyleManager(), m_levelNameMap(),
+  EPUBListStyleManager() : EPUBParagraphStyleManager("listElt"), m_levelNameMap("listLevel"),
     m_idListMap(), m_actualIdStack()
   {
   }
@@ -85,11 +83,19 @@ public:
   //! returns the classname corresponding to a list element
   std::string getClass(librevenge::RVNGPropertyList const &pList);
 
+  //! set how the classes are named
+  void setClassNamesMethod(EPUBClassNamesMethod method);
+  //! add the number of uses of each class to usage
+  void getUsage(librevenge::RVNGPropertyList &usage) const;
+  //! add the style cache hits and misses to statistics
+  void addStatistics(EPUBStatistics &statistics) const;
+  //! add the estimated memory of the classes to usage
+  void addMemoryUsage(EPUBMemoryUsage &usage) const;
   //! send the data to the sink
   void send(EPUBCSSContent &out);
 protected:
   //! a map content -> list level name
-  List::ContentNameMap_t m_levelNameMap;
+  EPUBContentNameMap m_levelNameMap;
   //! a map listId -> list
   std::map<int, List> m_idListMap;
   //! the actual list id
@@ -19,26 +19,30 @@ namespace libepubgen
 
 EPUBManifest::EPUBManifest()
   : m_map()
+  , m_entries()
 {
 }
 
 void EPUBManifest::insert(const EPUBPath &path, const std::string &mimetype, const std::string &id, const std::string &properties)
 {
-  if (!m_map.insert(MapType_t::value_type(path.relativeTo(EPUBPath("OEBPS/content.opf")).str(), ValueType_t(mimetype, id, properties))).second)
+  const std::pair<MapType_t::const_iterator, bool> inserted = m_map.insert(MapType_t::value_type(path.relativeTo(EPUBPath("OEBPS/content.opf")).str(), ValueType_t(mimetype, id, properties)));
+  if (!inserted.second)
   {
     assert(!"duplicate entry!");
+    return;
   }
+  m_entries.push_back(&*inserted.first);
 }
 
 void EPUBManifest::writeTo(EPUBXMLContent &xml)
 {
-  for (MapType_t::const_iterator it = m_map.begin(); m_map.end() != it; ++it)
+  for (const auto &entry : m_entries)
   {
     librevenge::RVNGPropertyList attrs;
-    attrs.insert("href", it->first.c_str());
-    attrs.insert("media-type", std::get<0>(it->second).c_str());
-    attrs.insert("id", std::get<1>(it->second).c_str());
-    const std::string &properties = std::get<2>(it->second);
+    attrs.insert("href", entry->first.c_str());
+    attrs.insert("media-type", std::get<0>(entry->second).c_str());
+    attrs.insert("id", std::get<1>(entry->second).c_str());
+    const std::string &properties = std::get<2>(entry->second);
     if (!properties.empty())
       attrs.insert("properties", properties.c_str());
     xml.insertEmptyElement("item", attrs);
@@ -13,6 +13,7 @@
 #include <string>
 #include <tuple>
 #include <unordered_map>
+#include <vector>
 
 namespace libepubgen
 {
@@ -39,6 +40,8 @@ public:
 
 private:
   MapType_t m_map;
+  /// Entries of m_map, in insertion order.
+  std::vector<const MapType_t::value_type *> m_entries;
 };
 
 }
@@ -0,0 +1,113 @@
+/* -*- Mode: C++; tab-width: 2; indent-tabs-mode: nil; c-basic-offset: 2 -*- */
+/*
+ * This file is part of the libepubgen project.
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#include "EPUBMemoryUsage.h"
+
+#include <algorithm>
+#include <cstring>
+#include <string>
+
+namespace libepubgen
+{
+
+namespace
+{
+
+const char *const SUBSYSTEM_NAMES[EPUB_MEMORY_COUNT] =
+{
+  "xhtml",
+  "zones",
+  "styles",
+  "images",
+  "fonts",
+  "recorded"
+};
+
+/// The overhead of a heap block, of a map node or of a list entry.
+const std::size_t NODE_OVERHEAD = 4 * sizeof(void *);
+
+void insertUsage(librevenge::RVNGPropertyList &usage, const std::string &name, const std::size_t current, const std::size_t peak)
+{
+  usage.insert(("libepubgen:" + name + "-bytes").c_str(), double(current), librevenge::RVNG_GENERIC);
+  usage.insert(("libepubgen:" + name + "-peak-bytes").c_str(), double(peak), librevenge::RVNG_GENERIC);
+}
+
+}
+
+EPUBMemoryUsage::EPUBMemoryUsage()
+  : m_current()
+  , m_peaks()
+  , m_totalPeak(0)
+{
+}
+
+void EPUBMemoryUsage::reset()
+{
+  std::fill(m_current, m_current + EPUB_MEMORY_COUNT, 0);
+}
+
+void EPUBMemoryUsage::updatePeaks()
+{
+  for (int i = 0; i < EPUB_MEMORY_COUNT; ++i)
+    m_peaks[i] = std::max(m_peaks[i], m_current[i]);
+  m_totalPeak = std::max(m_totalPeak, getTotal());
+}
+
+std::size_t EPUBMemoryUsage::getTotal() const
+{
+  std::size_t total = 0;
+  for (const auto current : m_current)
+    total += current;
+  return total;
+}
+
+void EPUBMemoryUsage::writeTo(librevenge::RVNGPropertyList &usage) const
+{
+  for (int i = 0; i < EPUB_MEMORY_COUNT; ++i)
+    insertUsage(usage, SUBSYSTEM_NAMES[i], m_current[i], m_peaks[i]);
+  insertUsage(usage, "total", getTotal(), m_totalPeak);
+}
+
+std::size_t estimateMemory(const std::size_t length)
+{
+  // Short strings are stored in the string object itself.
+  return length < 16 ? 0 : length + 1;
+}
+
+std::size_t estimateMemory(const librevenge::RVNGPropertyList &properties)
+{
+  std::size_t memory = 0;
+  librevenge::RVNGPropertyList::Iter i(properties);
+  for (i.rewind(); i.next();)
+  {
+    memory += NODE_OVERHEAD + std::strlen(i.key()) + 1;
+    if (i.child())
+    {
+      for (unsigned long j = 0; j < i.child()->count(); ++j)
+        memory += NODE_OVERHEAD + estimateMemory((*i.child())[j]);
+    }
+    else if (i())
+    {
+      memory += NODE_OVERHEAD + i()->getStr().size() + 1;
+    }
+  }
+  return memory;
+}
+
+std::size_t estimateMemory(const EPUBCSSProperties &properties)
+{
+  std::size_t memory = 0;
+  for (const auto &property : properties)
+    memory += NODE_OVERHEAD + sizeof(property) + estimateMemory(property.first.size()) + estimateMemory(property.second.size());
+  return memory;
+}
+
+}
+
+/* vim:set shiftwidth=2 softtabstop=2 expandtab: */
@@ -0,0 +1,70 @@
+/* -*- Mode: C++; tab-width: 2; indent-tabs-mode: nil; c-basic-offset: 2 -*- */
+/*
+ * This file is part of the libepubgen project.
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#ifndef INCLUDED_EPUBMEMORYUSAGE_H
+#define INCLUDED_EPUBMEMORYUSAGE_H
+
+#include <cstddef>
+
+#include <librevenge/librevenge.h>
+
+#include "EPUBCSSProperties.h"
+
+namespace libepubgen
+{
+
+/// The parts of the generator whose memory is accounted.
+enum EPUBMemorySubsystem
+{
+  EPUB_MEMORY_XHTML, //< The content of the finished sections.
+  EPUB_MEMORY_ZONES, //< The content of the current section: main text, notes, comments, text boxes.
+  EPUB_MEMORY_STYLES,
+  EPUB_MEMORY_IMAGES,
+  EPUB_MEMORY_FONTS,
+  EPUB_MEMORY_RECORDED, //< Recorded calls: headers, footers and the split plan.
+  EPUB_MEMORY_COUNT
+};
+
+/** The estimated memory used by the generator, in bytes.
+  *
+  * The parts add their current usage on request. The peaks are only
+  * updated when a sample is taken, i.e., at section boundaries, before
+  * the package is written and when the usage is queried.
+  */
+struct EPUBMemoryUsage
+{
+  EPUBMemoryUsage();
+
+  /// Sets the current usage to 0, before the parts add theirs.
+  void reset();
+  /// Updates the peaks from the current usage.
+  void updatePeaks();
+
+  std::size_t getTotal() const;
+
+  void writeTo(librevenge::RVNGPropertyList &usage) const;
+
+  std::size_t m_current[EPUB_MEMORY_COUNT];
+  std::size_t m_peaks[EPUB_MEMORY_COUNT];
+  /// The peak of the total, which is not the sum of the peaks.
+  std::size_t m_totalPeak;
+};
+
+/// Estimates the heap memory used by a string of the given length.
+std::size_t estimateMemory(std::size_t length);
+/// Estimates the heap memory used by a property list, including the nested ones.
+std::size_t estimateMemory(const librevenge::RVNGPropertyList &properties);
+/// Estimates the heap memory used by CSS properties.
+std::size_t estimateMemory(const EPUBCSSProperties &properties);
+
+}
+
+#endif // INCLUDED_EPUBMEMORYUSAGE_H
+
+/* vim:set shiftwidth=2 softtabstop=2 expandtab: */
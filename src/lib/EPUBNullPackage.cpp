@@ -0,0 +1,121 @@
+/* -*- Mode: C++; tab-width: 2; indent-tabs-mode: nil; c-basic-offset: 2 -*- */
+/*
+ * This file is part of the libepubgen project.
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#include <libepubgen/EPUBNullPackage.h>
+
+#include <cstring>
+
+#include "EPUBStatistics.h"
+#include "EPUBXMLContent.h"
+
+namespace libepubgen
+{
+
+EPUBNullPackage::EPUBNullPackage()
+  : m_files(0)
+  , m_bytes(0)
+{
+}
+
+EPUBNullPackage::~EPUBNullPackage()
+{
+}
+
+void EPUBNullPackage::openXMLFile(const char *)
+{
+  ++m_files;
+}
+
+void EPUBNullPackage::openElement(const char *const name, const librevenge::RVNGPropertyList &attributes)
+{
+  // <name key="value">
+  m_bytes += std::strlen(name) + 2 + getSerializedAttributesSize(attributes);
+}
+
+void EPUBNullPackage::closeElement(const char *const name)
+{
+  m_bytes += std::strlen(name) + 3;
+}
+
+void EPUBNullPackage::insertCharacters(const librevenge::RVNGString &characters)
+{
+  m_bytes += getEscapedSize(characters.cstr(), characters.size(), false);
+}
+
+void EPUBNullPackage::closeXMLFile()
+{
+}
+
+void EPUBNullPackage::openCSSFile(const char *)
+{
+  ++m_files;
+}
+
+void EPUBNullPackage::insertRule(const librevenge::RVNGString &selector, const librevenge::RVNGPropertyList &properties)
+{
+  // selector { key: value; }
+  m_bytes += selector.size() + 4 + getSerializedSize(properties);
+}
+
+void EPUBNullPackage::closeCSSFile()
+{
+}
+
+void EPUBNullPackage::openBinaryFile(const char *)
+{
+  ++m_files;
+}
+
+void EPUBNullPackage::insertBinaryData(const librevenge::RVNGBinaryData &data)
+{
+  m_bytes += data.size();
+}
+
+void EPUBNullPackage::closeBinaryFile()
+{
+}
+
+void EPUBNullPackage::openTextFile(const char *)
+{
+  ++m_files;
+}
+
+void EPUBNullPackage::insertText(const librevenge::RVNGString &characters)
+{
+  m_bytes += characters.size();
+}
+
+void EPUBNullPackage::insertLineBreak()
+{
+  ++m_bytes;
+}
+
+void EPUBNullPackage::closeTextFile()
+{
+}
+
+unsigned long EPUBNullPackage::getFiles() const
+{
+  return m_files;
+}
+
+unsigned long EPUBNullPackage::getBytes() const
+{
+  return m_bytes;
+}
+
+void EPUBNullPackage::reset()
+{
+  m_files = 0;
+  m_bytes = 0;
+}
+
+}
+
+/* vim:set shiftwidth=2 softtabstop=2 expandtab: */
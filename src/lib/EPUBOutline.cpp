@@ -0,0 +1,106 @@
+/* -*- Mode: C++; tab-width: 2; indent-tabs-mode: nil; c-basic-offset: 2 -*- */
+/*
+ * This file is part of the libepubgen project.
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#include "EPUBOutline.h"
+
+#include <sstream>
+
+#include "libepubgen_utils.h"
+
+namespace libepubgen
+{
+
+namespace
+{
+
+const std::size_t NO_TITLE = std::size_t(-1);
+
+}
+
+EPUBOutline::Heading::Heading(const unsigned level, const std::size_t section)
+  : m_level(level)
+  , m_section(section)
+  , m_title()
+{
+}
+
+EPUBOutline::EPUBOutline()
+  : m_headings()
+  , m_titles()
+  , m_paragraphs()
+{
+}
+
+void EPUBOutline::startSection()
+{
+  m_titles.push_back(NO_TITLE);
+}
+
+bool EPUBOutline::openParagraph(const unsigned level)
+{
+  if (m_titles.empty())
+  {
+    EPUBGEN_DEBUG_MSG(("EPUBOutline::openParagraph: no section\n"));
+    startSection();
+  }
+
+  // A heading inside a heading, e.g. in a footnote, is not in the outline.
+  const bool heading = (0 != level) && (m_paragraphs.empty() || !m_paragraphs.back());
+  if (heading)
+    m_headings.push_back(Heading(level, m_titles.size() - 1));
+  m_paragraphs.push_back(heading);
+  return heading;
+}
+
+void EPUBOutline::closeParagraph()
+{
+  if (m_paragraphs.empty())
+  {
+    EPUBGEN_DEBUG_MSG(("EPUBOutline::closeParagraph: no paragraph is open\n"));
+    return;
+  }
+
+  if (m_paragraphs.back())
+  {
+    const Heading &heading = m_headings.back();
+    if ((NO_TITLE == m_titles[heading.m_section]) && !heading.m_title.empty())
+      m_titles[heading.m_section] = m_headings.size() - 1;
+  }
+  m_paragraphs.pop_back();
+}
+
+void EPUBOutline::insertText(const char *const text, const std::size_t length)
+{
+  if (!m_paragraphs.empty() && m_paragraphs.back())
+    m_headings.back().m_title.append(text, length);
+}
+
+const std::vector<EPUBOutline::Heading> &EPUBOutline::getHeadings() const
+{
+  return m_headings;
+}
+
+std::string EPUBOutline::getAnchor(const std::size_t heading)
+{
+  std::ostringstream anchor;
+  anchor << "heading" << (heading + 1);
+  return anchor.str();
+}
+
+const std::string &EPUBOutline::getSectionTitle(const std::size_t section) const
+{
+  static const std::string noTitle;
+  if ((m_titles.size() <= section) || (NO_TITLE == m_titles[section]))
+    return noTitle;
+  return m_headings[m_titles[section]].m_title;
+}
+
+}
+
+/* vim:set shiftwidth=2 softtabstop=2 expandtab: */
@@ -0,0 +1,74 @@
+/* -*- Mode: C++; tab-width: 2; indent-tabs-mode: nil; c-basic-offset: 2 -*- */
+/*
+ * This file is part of the libepubgen project.
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#ifndef INCLUDED_EPUBOUTLINE_H
+#define INCLUDED_EPUBOUTLINE_H
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+namespace libepubgen
+{
+
+/** Collects the headings of the document as it is written.
+  *
+  * The titles of the sections and the table of contents are taken from it.
+  */
+class EPUBOutline
+{
+  // disable copying
+  EPUBOutline(const EPUBOutline &);
+  EPUBOutline &operator=(const EPUBOutline &);
+
+public:
+  struct Heading
+  {
+    Heading(unsigned level, std::size_t section);
+
+    unsigned m_level;
+    /// The index of the section the heading is in.
+    std::size_t m_section;
+    std::string m_title;
+  };
+
+  EPUBOutline();
+
+  /// Starts collecting the headings of the next section.
+  void startSection();
+
+  /** Opens a paragraph, which is a heading if level is not 0.
+    *
+    * @return true if the paragraph is a heading of the outline.
+    */
+  bool openParagraph(unsigned level);
+  void closeParagraph();
+  /// Appends text to the title of the current heading, if in one.
+  void insertText(const char *text, std::size_t length);
+
+  /// Gets the headings, in document order.
+  const std::vector<Heading> &getHeadings() const;
+  /// Gets the id of the anchor of a heading.
+  static std::string getAnchor(std::size_t heading);
+  /// Gets the title of a section: the title of its first heading which has one.
+  const std::string &getSectionTitle(std::size_t section) const;
+
+private:
+  std::vector<Heading> m_headings;
+  /// For each section, the index of the heading giving its title.
+  std::vector<std::size_t> m_titles;
+  /// For each open paragraph, if it is a heading.
+  std::vector<bool> m_paragraphs;
+};
+
+}
+
+#endif // INCLUDED_EPUBOUTLINE_H
+
+/* vim:set shiftwidth=2 softtabstop=2 expandtab: */
@@ -30,6 +30,13 @@ class EPUBPagedGenerator::Impl : public EPUBGenerator
 public:
   Impl(EPUBPackage *const package, int version);
 
+  /** Decides if a new page goes to a new HTML file.
+    *
+    * @return the reason of the split, or EPUB_SPLIT_REASON_START if the
+    *   page goes to the current file.
+    */
+  EPUBSplitReason splitOnPage();
+
 private:
   void startHtmlFile() override;
   void endHtmlFile() override;
@@ -44,6 +51,35 @@ EPUBPagedGenerator::Impl::Impl(EPUBPackage *const package, int version)
 {
 }
 
+EPUBSplitReason EPUBPagedGenerator::Impl::splitOnPage()
+{
+  // Fixed layout has exactly one page per file.
+  if (getLayoutMethod() == EPUB_LAYOUT_METHOD_FIXED)
+    return EPUB_SPLIT_REASON_PAGE;
+
+  EPUBSplitGuard &splitGuard = getSplitGuard();
+  updateSplitSize();
+  switch (splitGuard.getSplitMethod())
+  {
+  case EPUB_SPLIT_METHOD_PAGE_BREAK:
+  case EPUB_SPLIT_METHOD_HEADING:
+    // Pages have no headings: the start of a page is the nearest thing.
+    return EPUB_SPLIT_REASON_PAGE;
+  case EPUB_SPLIT_METHOD_NONE:
+    // The maximum size applies on top of any method.
+    return splitGuard.isOverMaxSize() ? EPUB_SPLIT_REASON_MAX_SIZE : EPUB_SPLIT_REASON_START;
+  default:
+    break;
+  }
+
+  // Group the pages into files up to the split size.
+  if (splitGuard.splitOnSize())
+    return splitGuard.isOverMaxSize() ? EPUB_SPLIT_REASON_MAX_SIZE : EPUB_SPLIT_REASON_SIZE;
+  if (splitGuard.splitOnPageBreak())
+    return EPUB_SPLIT_REASON_PAGE;
+  return EPUB_SPLIT_REASON_START;
+}
+
 void EPUBPagedGenerator::setSplitMethod(EPUBSplitMethod split)
 {
   m_impl->setSplitMethod(split);
@@ -59,6 +95,51 @@ void EPUBPagedGenerator::setSplitSize(const unsigned size)
   m_impl->getSplitGuard().setSplitSize(size);
 }
 
+void EPUBPagedGenerator::setMaxSectionSize(const unsigned size)
+{
+  m_impl->getSplitGuard().setMaxSize(size);
+}
+
+void EPUBPagedGenerator::setMemoryBudget(const unsigned long budget)
+{
+  m_impl->setMemoryBudget(budget);
+}
+
+void EPUBPagedGenerator::setOutputMethod(const EPUBOutputMethod outputMethod)
+{
+  m_impl->setOutputMethod(outputMethod);
+}
+
+void EPUBPagedGenerator::setDiagnosticHandler(const EPUBDiagnosticHandler handler)
+{
+  m_impl->setDiagnosticHandler(handler);
+}
+
+void EPUBPagedGenerator::setProgressHandler(const EPUBProgressHandler handler)
+{
+  m_impl->setProgressHandler(handler);
+}
+
+bool EPUBPagedGenerator::isCancelled() const
+{
+  return m_impl->isCancelled();
+}
+
+void EPUBPagedGenerator::setLayoutMethod(EPUBLayoutMethod layout)
+{
+  m_impl->setLayoutMethod(layout);
+}
+
+void EPUBPagedGenerator::getStatistics(librevenge::RVNGPropertyList &statistics) const
+{
+  m_impl->getStatistics(statistics);
+}
+
+void EPUBPagedGenerator::getMemoryUsage(librevenge::RVNGPropertyList &usage) const
+{
+  m_impl->getMemoryUsage(usage);
+}
+
 void EPUBPagedGenerator::Impl::startHtmlFile()
 {
 }
@@ -84,6 +165,9 @@ void EPUBPagedGenerator::endDocument()
 
 void EPUBPagedGenerator::setDocumentMetaData(const RVNGPropertyList &propList)
 {
+  if (m_impl->isCancelled())
+    return;
+
   m_impl->setDocumentMetaData(propList);
 
   m_impl->getHtml()->setDocumentMetaData(propList);
@@ -96,8 +180,15 @@ void EPUBPagedGenerator::defineEmbeddedFont(const RVNGPropertyList &propList)
 
 void EPUBPagedGenerator::startSlide(const RVNGPropertyList &/*propList*/)
 {
+  if (m_impl->isCancelled())
+    return;
+
   if (!m_impl->m_firstPage)
-    m_impl->startNewHtmlFile();
+  {
+    const EPUBSplitReason reason = m_impl->splitOnPage();
+    if (reason != EPUB_SPLIT_REASON_START)
+      m_impl->startNewHtmlFile(reason);
+  }
   m_impl->m_firstPage = false;
 }
 
@@ -188,41 +279,65 @@ void EPUBPagedGenerator::drawConnector(const RVNGPropertyList &propList)
 
 void EPUBPagedGenerator::startTextObject(const RVNGPropertyList &/*propList*/)
 {
+  if (m_impl->isCancelled())
+    return;
+
   m_impl->getSplitGuard().openLevel();
 }
 
 void EPUBPagedGenerator::endTextObject()
 {
+  if (m_impl->isCancelled())
+    return;
+
   m_impl->getSplitGuard().closeLevel();
 }
 
 void EPUBPagedGenerator::insertTab()
 {
+  if (m_impl->isCancelled())
+    return;
+
   m_impl->getHtml()->insertTab();
 }
 
 void EPUBPagedGenerator::insertSpace()
 {
+  if (m_impl->isCancelled())
+    return;
+
   m_impl->getHtml()->insertSpace();
 }
 
 void EPUBPagedGenerator::insertText(const RVNGString &text)
 {
+  if (m_impl->isCancelled())
+    return;
+
   m_impl->getHtml()->insertText(text);
 }
 
 void EPUBPagedGenerator::insertLineBreak()
 {
+  if (m_impl->isCancelled())
+    return;
+
   m_impl->getHtml()->insertLineBreak();
 }
 
 void EPUBPagedGenerator::insertField(const RVNGPropertyList &propList)
 {
+  if (m_impl->isCancelled())
+    return;
+
   m_impl->getHtml()->insertField(propList);
 }
 
 void EPUBPagedGenerator::openOrderedListLevel(const RVNGPropertyList &propList)
 {
+  if (m_impl->isCancelled())
+    return;
+
   m_impl->getSplitGuard().openLevel();
 
   m_impl->getHtml()->openOrderedListLevel(propList);
@@ -230,6 +345,9 @@ void EPUBPagedGenerator::openOrderedListLevel(const RVNGPropertyList &propList)
 
 void EPUBPagedGenerator::openUnorderedListLevel(const RVNGPropertyList &propList)
 {
+  if (m_impl->isCancelled())
+    return;
+
   m_impl->getSplitGuard().openLevel();
 
   m_impl->getHtml()->openUnorderedListLevel(propList);
@@ -237,6 +355,9 @@ void EPUBPagedGenerator::openUnorderedListLevel(const RVNGPropertyList &propList
 
 void EPUBPagedGenerator::closeOrderedListLevel()
 {
+  if (m_impl->isCancelled())
+    return;
+
   m_impl->getSplitGuard().closeLevel();
 
   m_impl->getHtml()->closeOrderedListLevel();
@@ -244,6 +365,9 @@ void EPUBPagedGenerator::closeOrderedListLevel()
 
 void EPUBPagedGenerator::closeUnorderedListLevel()
 {
+  if (m_impl->isCancelled())
+    return;
+
   m_impl->getSplitGuard().closeLevel();
 
   m_impl->getHtml()->closeUnorderedListLevel();
@@ -251,6 +375,9 @@ void EPUBPagedGenerator::closeUnorderedListLevel()
 
 void EPUBPagedGenerator::openListElement(const RVNGPropertyList &propList)
 {
+  if (m_impl->isCancelled())
+    return;
+
   m_impl->getSplitGuard().openLevel();
 
   m_impl->getHtml()->openListElement(propList);
@@ -258,6 +385,9 @@ void EPUBPagedGenerator::openListElement(const RVNGPropertyList &propList)
 
 void EPUBPagedGenerator::closeListElement()
 {
+  if (m_impl->isCancelled())
+    return;
+
   m_impl->getSplitGuard().closeLevel();
 
   m_impl->getHtml()->closeListElement();
@@ -265,11 +395,17 @@ void EPUBPagedGenerator::closeListElement()
 
 void EPUBPagedGenerator::defineParagraphStyle(const RVNGPropertyList &propList)
 {
+  if (m_impl->isCancelled())
+    return;
+
   m_impl->getHtml()->defineParagraphStyle(propList);
 }
 
 void EPUBPagedGenerator::openParagraph(const RVNGPropertyList &propList)
 {
+  if (m_impl->isCancelled())
+    return;
+
   m_impl->getSplitGuard().openLevel();
 
   m_impl->getHtml()->openParagraph(propList);
@@ -277,6 +413,9 @@ void EPUBPagedGenerator::openParagraph(const RVNGPropertyList &propList)
 
 void EPUBPagedGenerator::closeParagraph()
 {
+  if (m_impl->isCancelled())
+    return;
+
   m_impl->getSplitGuard().closeLevel();
 
   m_impl->getHtml()->closeParagraph();
@@ -284,31 +423,49 @@ void EPUBPagedGenerator::closeParagraph()
 
 void EPUBPagedGenerator::defineCharacterStyle(const RVNGPropertyList &propList)
 {
+  if (m_impl->isCancelled())
+    return;
+
   m_impl->getHtml()->defineCharacterStyle(propList);
 }
 
 void EPUBPagedGenerator::openSpan(const RVNGPropertyList &propList)
 {
+  if (m_impl->isCancelled())
+    return;
+
   m_impl->getHtml()->openSpan(propList);
 }
 
 void EPUBPagedGenerator::closeSpan()
 {
+  if (m_impl->isCancelled())
+    return;
+
   m_impl->getHtml()->closeSpan();
 }
 
 void EPUBPagedGenerator::openLink(const RVNGPropertyList &propList)
 {
+  if (m_impl->isCancelled())
+    return;
+
   m_impl->getHtml()->openLink(propList);
 }
 
 void EPUBPagedGenerator::closeLink()
 {
+  if (m_impl->isCancelled())
+    return;
+
   m_impl->getHtml()->closeSpan();
 }
 
 void EPUBPagedGenerator::startTableObject(const RVNGPropertyList &propList)
 {
+  if (m_impl->isCancelled())
+    return;
+
   m_impl->getSplitGuard().openLevel();
 
   m_impl->getHtml()->openTable(propList);
@@ -316,31 +473,49 @@ void EPUBPagedGenerator::startTableObject(const RVNGPropertyList &propList)
 
 void EPUBPagedGenerator::openTableRow(const RVNGPropertyList &propList)
 {
+  if (m_impl->isCancelled())
+    return;
+
   m_impl->getHtml()->openTableRow(propList);
 }
 
 void EPUBPagedGenerator::closeTableRow()
 {
+  if (m_impl->isCancelled())
+    return;
+
   m_impl->getHtml()->closeTableRow();
 }
 
 void EPUBPagedGenerator::openTableCell(const RVNGPropertyList &propList)
 {
+  if (m_impl->isCancelled())
+    return;
+
   m_impl->getHtml()->openTableCell(propList);
 }
 
 void EPUBPagedGenerator::closeTableCell()
 {
+  if (m_impl->isCancelled())
+    return;
+
   m_impl->getHtml()->closeTableCell();
 }
 
 void EPUBPagedGenerator::insertCoveredTableCell(const RVNGPropertyList &propList)
 {
+  if (m_impl->isCancelled())
+    return;
+
   m_impl->getHtml()->insertCoveredTableCell(propList);
 }
 
 void EPUBPagedGenerator::endTableObject()
 {
+  if (m_impl->isCancelled())
+    return;
+
   m_impl->getHtml()->closeTable();
 }
 
@@ -32,6 +32,15 @@ public:
   void setSplitMethod(EPUBSplitMethod split);
   void setSplitHeadingLevel(unsigned level);
   void setSplitSize(unsigned size);
+  void setMaxSectionSize(unsigned size);
+  void setMemoryBudget(unsigned long budget);
+  void setOutputMethod(EPUBOutputMethod outputMethod);
+  void setDiagnosticHandler(EPUBDiagnosticHandler handler);
+  void setProgressHandler(EPUBProgressHandler handler);
+  bool isCancelled() const;
+  void setLayoutMethod(EPUBLayoutMethod layout);
+  void getStatistics(librevenge::RVNGPropertyList &statistics) const;
+  void getMemoryUsage(librevenge::RVNGPropertyList &usage) const;
 
   void startDocument(const librevenge::RVNGPropertyList &propList) override;
 
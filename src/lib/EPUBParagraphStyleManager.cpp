@@ -15,6 +15,9 @@
 
 #include "libepubgen_utils.h"
 #include "EPUBCSSContent.h"
+#include "EPUBMemoryUsage.h"
+#include "EPUBStatistics.h"
+#include "EPUBTraceScope.h"
 
 namespace libepubgen
 {
@@ -24,27 +27,40 @@ using librevenge::RVNGString;
 
 std::string EPUBParagraphStyleManager::getClass(RVNGPropertyList const &pList)
 {
-  if (pList["librevenge:paragraph-id"])
+  return getClass(pList, EPUBCSSProperties());
+}
+
+std::string EPUBParagraphStyleManager::getClass(RVNGPropertyList const &pList, EPUBCSSProperties const &textProps)
+{
+  EPUBGEN_TRACE_SCOPE("EPUBParagraphStyleManager::getClass");
+  // A named style has no text properties, so it is only usable if the
+  // content doesn't rely on them.
+  if (pList["librevenge:paragraph-id"] && textProps.empty())
   {
     int id=pList["librevenge:paragraph-id"]->getInt();
-    if (m_idNameMap.find(id)!=m_idNameMap.end())
-      return m_idNameMap.find(id)->second;
+    const auto it = m_idNameMap.find(id);
+    if (it != m_idNameMap.end())
+    {
+      m_contentNameMap.use(it->second);
+      return it->second;
+    }
   }
   EPUBCSSProperties content;
   extractProperties(pList, false, content);
-  ContentNameMap_t::const_iterator it=m_contentNameMap.find(content);
-  if (it != m_contentNameMap.end())
-    return it->second;
-  std::stringstream s;
-  s << "para" << m_contentNameMap.size();
-  m_contentNameMap[content]=s.str();
-  return s.str();
+  content.insert(textProps.begin(), textProps.end());
+  return m_contentNameMap.getName(content);
 }
 
 std::string EPUBParagraphStyleManager::getStyle(RVNGPropertyList const &pList)
+{
+  return getStyle(pList, EPUBCSSProperties());
+}
+
+std::string EPUBParagraphStyleManager::getStyle(RVNGPropertyList const &pList, EPUBCSSProperties const &textProps)
 {
   EPUBCSSProperties content;
   extractProperties(pList, false, content);
+  content.insert(textProps.begin(), textProps.end());
 
   std::stringstream s;
   for (const auto &property : content)
@@ -60,19 +76,35 @@ void EPUBParagraphStyleManager::defineParagraph(RVNGPropertyList const &propList
     return;
   }
   int id=propList["librevenge:paragraph-id"]->getInt();
-  RVNGPropertyList pList(propList);
-  pList.remove("librevenge:paragraph-id");
-  m_idNameMap[id]=getClass(pList);
+  EPUBCSSProperties content;
+  extractProperties(propList, false, content);
+  // The rule is only written if a paragraph uses it.
+  m_idNameMap[id]=m_contentNameMap.defineName(content);
+}
+
+void EPUBParagraphStyleManager::setClassNamesMethod(EPUBClassNamesMethod method)
+{
+  m_contentNameMap.setClassNamesMethod(method);
+}
+
+void EPUBParagraphStyleManager::getUsage(RVNGPropertyList &usage) const
+{
+  m_contentNameMap.getUsage(usage);
+}
+
+void EPUBParagraphStyleManager::addStatistics(EPUBStatistics &statistics) const
+{
+  m_contentNameMap.addStatistics(statistics);
+}
+
+void EPUBParagraphStyleManager::addMemoryUsage(EPUBMemoryUsage &usage) const
+{
+  m_contentNameMap.addMemoryUsage(usage);
 }
 
 void EPUBParagraphStyleManager::send(EPUBCSSContent &out)
 {
-  for (ContentNameMap_t::const_iterator it=m_contentNameMap.begin(); m_contentNameMap.end() != it; ++it)
-  {
-    RVNGPropertyList props;
-    fillPropertyList(it->first, props);
-    out.insertRule(("." + it->second).c_str(), props);
-  }
+  m_contentNameMap.send(out);
 }
 
 void EPUBParagraphStyleManager::extractProperties(RVNGPropertyList const &pList, bool isList, EPUBCSSProperties &cssProps) const
@@ -12,27 +12,25 @@
 
 #include <string>
 #include <map>
-#include <unordered_map>
-
-#include <boost/functional/hash.hpp>
 
 #include <librevenge/librevenge.h>
 
 #include "EPUBCSSProperties.h"
+#include "EPUBContentNameMap.h"
 
 namespace libepubgen
 {
 
 class EPUBCSSContent;
+struct EPUBMemoryUsage;
+struct EPUBStatistics;
 
 /** Small class to manage the paragraph style */
 class EPUBParagraphStyleManager
 {
-  typedef std::unordered_map<EPUBCSSProperties, std::string, boost::hash<EPUBCSSProperties>> ContentNameMap_t;
-
 public:
   //! constructor
-  EPUBParagraphStyleManager() : m_contentNameMap(), m_idNameMap()
+  EPUBParagraphStyleManager() : m_contentNameMap("para"), m_idNameMap()
   {
   }
   //! destructor
@@ -45,13 +43,29 @@ public:
   std::string getClass(librevenge::RVNGPropertyList const &pList);
   //! returns the style string corresponding to a propertylist
   std::string getStyle(librevenge::RVNGPropertyList const &pList);
+  //! returns the class name corresponding to a propertylist and the text properties inherited by its content
+  std::string getClass(librevenge::RVNGPropertyList const &pList, EPUBCSSProperties const &textProps);
+  //! returns the style string corresponding to a propertylist and the text properties inherited by its content
+  std::string getStyle(librevenge::RVNGPropertyList const &pList, EPUBCSSProperties const &textProps);
+  //! set how the classes are named
+  void setClassNamesMethod(EPUBClassNamesMethod method);
+  //! add the number of uses of each class to usage
+  void getUsage(librevenge::RVNGPropertyList &usage) const;
+  //! add the style cache hits and misses to statistics
+  void addStatistics(EPUBStatistics &statistics) const;
+  //! add the estimated memory of the classes to usage
+  void addMemoryUsage(EPUBMemoryUsage &usage) const;
   //! send the data to the sink
   void send(EPUBCSSContent &out);
 protected:
+  //! constructor for the derived managers, which name their classes differently
+  explicit EPUBParagraphStyleManager(const std::string &classNamePrefix) : m_contentNameMap(classNamePrefix), m_idNameMap()
+  {
+  }
   //! convert a property list into a CSS property map
   void extractProperties(librevenge::RVNGPropertyList const &pList, bool isList, EPUBCSSProperties &cssProps) const;
   //! a map content -> name
-  ContentNameMap_t m_contentNameMap;
+  EPUBContentNameMap m_contentNameMap;
   //! a map id -> name
   std::map<int, std::string> m_idNameMap;
   //! add data corresponding to the border
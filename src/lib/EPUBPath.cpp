@@ -54,7 +54,6 @@ EPUBPath::Relative::Relative(const std::vector<std::string> &components)
 
 EPUBPath::EPUBPath(const std::string &path)
   : m_components()
-  , m_title()
   , m_chapters()
 {
   const std::string trimmed(algorithm::trim_left_copy_if(path, algorithm::is_any_of("/")));
@@ -113,11 +112,6 @@ const EPUBPath::Relative EPUBPath::relativeTo(const EPUBPath &base) const
   return Relative(components);
 }
 
-void EPUBPath::appendTitle(const std::string &title)
-{
-  m_title += title;
-}
-
 void EPUBPath::addChapter(const std::string &chapter)
 {
   m_chapters.push_back(chapter);
@@ -128,11 +122,6 @@ const std::vector<std::string> &EPUBPath::getChapters() const
   return m_chapters;
 }
 
-std::string EPUBPath::getTitle() const
-{
-  return m_title;
-}
-
 bool operator==(const EPUBPath &left, const EPUBPath &right)
 {
   return left.m_components == right.m_components;
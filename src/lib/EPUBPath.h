@@ -48,15 +48,11 @@ public:
 
   const Relative relativeTo(const EPUBPath &base) const;
 
-  void appendTitle(const std::string &title);
-  std::string getTitle() const;
-
   /// Adds chapter name (fixed layout).
   void addChapter(const std::string &chapter);
   const std::vector<std::string> &getChapters() const;
 private:
   std::vector<std::string> m_components;
-  std::string m_title;
   std::vector<std::string> m_chapters;
 };
 
@@ -56,6 +56,12 @@ void EPUBPresentationGenerator::setOption(int key, int value)
   case EPUB_GENERATOR_OPTION_SPLIT:
     m_impl->setSplitMethod(static_cast<EPUBSplitMethod>(value));
     break;
+  case EPUB_GENERATOR_OPTION_LAYOUT:
+    m_impl->setLayoutMethod(static_cast<EPUBLayoutMethod>(value));
+    break;
+  case EPUB_GENERATOR_OPTION_OUTPUT:
+    m_impl->setOutputMethod(static_cast<EPUBOutputMethod>(value));
+    break;
   }
 }
 
@@ -69,6 +75,31 @@ void EPUBPresentationGenerator::setSplitSize(const unsigned size)
   m_impl->setSplitSize(size);
 }
 
+void EPUBPresentationGenerator::setMaxSectionSize(const unsigned size)
+{
+  m_impl->setMaxSectionSize(size);
+}
+
+void EPUBPresentationGenerator::setMemoryBudget(const unsigned long budget)
+{
+  m_impl->setMemoryBudget(budget);
+}
+
+void EPUBPresentationGenerator::registerDiagnosticHandler(EPUBDiagnosticHandler diagnosticHandler)
+{
+  m_impl->setDiagnosticHandler(diagnosticHandler);
+}
+
+void EPUBPresentationGenerator::registerProgressHandler(EPUBProgressHandler progressHandler)
+{
+  m_impl->setProgressHandler(progressHandler);
+}
+
+bool EPUBPresentationGenerator::isCancelled() const
+{
+  return m_impl->isCancelled();
+}
+
 void EPUBPresentationGenerator::registerEmbeddedImageHandler(const librevenge::RVNGString &mimeType, EPUBEmbeddedImage imageHandler)
 {
   // TODO: implement me
@@ -83,6 +114,16 @@ void EPUBPresentationGenerator::registerEmbeddedObjectHandler(const librevenge::
   (void) objectHandler;
 }
 
+void EPUBPresentationGenerator::getStatistics(librevenge::RVNGPropertyList &statistics) const
+{
+  m_impl->getStatistics(statistics);
+}
+
+void EPUBPresentationGenerator::getMemoryUsage(librevenge::RVNGPropertyList &usage) const
+{
+  m_impl->getMemoryUsage(usage);
+}
+
 void EPUBPresentationGenerator::startDocument(const RVNGPropertyList &propList)
 {
   m_impl->startDocument(propList);
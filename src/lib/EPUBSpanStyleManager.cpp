@@ -16,6 +16,9 @@
 
 #include "libepubgen_utils.h"
 #include "EPUBCSSContent.h"
+#include "EPUBMemoryUsage.h"
+#include "EPUBStatistics.h"
+#include "EPUBTraceScope.h"
 
 namespace libepubgen
 {
@@ -24,32 +27,69 @@ using librevenge::RVNGPropertyList;
 
 std::string EPUBSpanStyleManager::getClass(RVNGPropertyList const &pList)
 {
+  EPUBGEN_TRACE_SCOPE("EPUBSpanStyleManager::getClass");
   if (pList["librevenge:span-id"])
   {
     int id=pList["librevenge:span-id"]->getInt();
-    if (m_idNameMap.find(id)!=m_idNameMap.end())
-      return m_idNameMap.find(id)->second;
+    const auto it = m_idNameMap.find(id);
+    if (it != m_idNameMap.end())
+    {
+      m_contentNameMap.use(it->second);
+      return it->second;
+    }
   }
 
   EPUBCSSProperties content;
 
   extractProperties(pList, content);
 
-  ContentNameMap_t::const_iterator it = m_contentNameMap.find(content);
-  if (it != m_contentNameMap.end())
-    return it->second;
+  return getContentClass(content);
+}
 
-  std::stringstream s;
-  s << m_classNamePrefix << m_contentNameMap.size();
+std::string EPUBSpanStyleManager::getContentClass(EPUBCSSProperties const &content)
+{
+  return m_contentNameMap.getName(content);
+}
 
-  m_contentNameMap[content]=s.str();
+std::string EPUBSpanStyleManager::getStyle(RVNGPropertyList const &pList)
+{
+  EPUBCSSProperties content;
+  extractProperties(pList, content);
+
+  std::stringstream s;
+  for (const auto &property : content)
+    s << property.first << ": " << property.second << "; ";
   return s.str();
 }
 
-std::string EPUBSpanStyleManager::getStyle(RVNGPropertyList const &pList)
+std::string EPUBSpanStyleManager::getDeltaClass(RVNGPropertyList const &pList, EPUBCSSProperties const &inherited)
 {
+  // A named style is complete, it is correct whatever is inherited.
+  if (pList["librevenge:span-id"])
+  {
+    int id=pList["librevenge:span-id"]->getInt();
+    const auto it = m_idNameMap.find(id);
+    if (it != m_idNameMap.end())
+    {
+      m_contentNameMap.use(it->second);
+      return it->second;
+    }
+  }
+
   EPUBCSSProperties content;
   extractProperties(pList, content);
+  removeInherited(content, inherited);
+  if (content.empty())
+    return std::string();
+
+  return getContentClass(content);
+}
+
+std::string EPUBSpanStyleManager::getDeltaStyle(RVNGPropertyList const &pList, EPUBCSSProperties const &inherited)
+{
+  EPUBCSSProperties content;
+  extractProperties(pList, content);
+  removeInherited(content, inherited);
 
   std::stringstream s;
   for (const auto &property : content)
@@ -57,6 +97,36 @@ std::string EPUBSpanStyleManager::getStyle(RVNGPropertyList const &pList)
   return s.str();
 }
 
+void EPUBSpanStyleManager::extractInheritedProperties(RVNGPropertyList const &pList, EPUBCSSProperties &cssProps) const
+{
+  // Only properties which CSS inherits: e.g. a span can't cancel a
+  // text-decoration of its paragraph.
+  static char const *inheritedNames[] =
+  {
+    "color", "font-family", "font-size", "font-stretch", "font-style", "font-variant",
+    "font-weight", "letter-spacing", "text-shadow", "text-transform"
+  };
+
+  EPUBCSSProperties content;
+  extractProperties(pList, content);
+  for (const auto &name : inheritedNames)
+  {
+    EPUBCSSProperties::const_iterator it = content.find(name);
+    if (it != content.end())
+      cssProps[it->first] = it->second;
+  }
+}
+
+void EPUBSpanStyleManager::removeInherited(EPUBCSSProperties &cssProps, EPUBCSSProperties const &inherited) const
+{
+  for (const auto &property : inherited)
+  {
+    EPUBCSSProperties::iterator it = cssProps.find(property.first);
+    if (it != cssProps.end() && it->second == property.second)
+      cssProps.erase(it);
+  }
+}
+
 void EPUBSpanStyleManager::defineSpan(RVNGPropertyList const &propList)
 {
   if (!propList["librevenge:span-id"])
@@ -67,19 +137,35 @@ void EPUBSpanStyleManager::defineSpan(RVNGPropertyList const &propList)
   }
   int id=propList["librevenge:span-id"]->getInt();
 
-  RVNGPropertyList pList(propList);
-  pList.remove("librevenge:span-id");
-  m_idNameMap[id]=getClass(pList);
+  EPUBCSSProperties content;
+  extractProperties(propList, content);
+  // The rule is only written if a span uses it.
+  m_idNameMap[id]=m_contentNameMap.defineName(content);
+}
+
+void EPUBSpanStyleManager::setClassNamesMethod(EPUBClassNamesMethod method)
+{
+  m_contentNameMap.setClassNamesMethod(method);
+}
+
+void EPUBSpanStyleManager::getUsage(RVNGPropertyList &usage) const
+{
+  m_contentNameMap.getUsage(usage);
+}
+
+void EPUBSpanStyleManager::addStatistics(EPUBStatistics &statistics) const
+{
+  m_contentNameMap.addStatistics(statistics);
+}
+
+void EPUBSpanStyleManager::addMemoryUsage(EPUBMemoryUsage &usage) const
+{
+  m_contentNameMap.addMemoryUsage(usage);
 }
 
 void EPUBSpanStyleManager::send(EPUBCSSContent &out)
 {
-  for (ContentNameMap_t::const_iterator it=m_contentNameMap.begin(); m_contentNameMap.end() != it; ++it)
-  {
-    RVNGPropertyList props;
-    fillPropertyList(it->first, props);
-    out.insertRule(("." + it->second).c_str(), props);
-  }
+  m_contentNameMap.send(out);
 }
 
 void EPUBSpanStyleManager::extractProperties(RVNGPropertyList const &pList, EPUBCSSProperties &cssProps) const
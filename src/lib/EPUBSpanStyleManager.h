@@ -12,28 +12,26 @@
 
 #include <map>
 #include <string>
-#include <unordered_map>
-
-#include <boost/functional/hash.hpp>
 
 #include <librevenge/librevenge.h>
 
 #include "EPUBCSSProperties.h"
+#include "EPUBContentNameMap.h"
 #include "EPUBCounter.h"
 
 namespace libepubgen
 {
 
 class EPUBCSSContent;
+struct EPUBMemoryUsage;
+struct EPUBStatistics;
 
 /** Small class to manage the span style */
 class EPUBSpanStyleManager
 {
-  typedef std::unordered_map<EPUBCSSProperties, std::string, boost::hash<EPUBCSSProperties>> ContentNameMap_t;
-
 public:
   //! constructor
-  EPUBSpanStyleManager(std::string classNamePrefix) : m_contentNameMap(), m_idNameMap(), m_classNamePrefix(classNamePrefix)
+  EPUBSpanStyleManager(std::string classNamePrefix) : m_contentNameMap(classNamePrefix), m_idNameMap()
   {
   }
   //! destructor
@@ -46,6 +44,20 @@ public:
   std::string getClass(librevenge::RVNGPropertyList const &pList);
   //! returns the style string corresponding to a propertylist
   std::string getStyle(librevenge::RVNGPropertyList const &pList);
+  //! returns the class name of the properties which differ from the inherited ones, or an empty string if there are none
+  std::string getDeltaClass(librevenge::RVNGPropertyList const &pList, EPUBCSSProperties const &inherited);
+  //! returns the style string of the properties which differ from the inherited ones
+  std::string getDeltaStyle(librevenge::RVNGPropertyList const &pList, EPUBCSSProperties const &inherited);
+  //! extracts the properties of a paragraph which are inherited by its spans
+  void extractInheritedProperties(librevenge::RVNGPropertyList const &pList, EPUBCSSProperties &cssProps) const;
+  //! set how the classes are named
+  void setClassNamesMethod(EPUBClassNamesMethod method);
+  //! add the number of uses of each class to usage
+  void getUsage(librevenge::RVNGPropertyList &usage) const;
+  //! add the style cache hits and misses to statistics
+  void addStatistics(EPUBStatistics &statistics) const;
+  //! add the estimated memory of the classes to usage
+  void addMemoryUsage(EPUBMemoryUsage &usage) const;
   //! send the data to the sink
   void send(EPUBCSSContent &out);
 protected:
@@ -53,18 +65,20 @@ protected:
   virtual void extractProperties(librevenge::RVNGPropertyList const &pList, EPUBCSSProperties &cssProps) const;
 
 private:
+  //! returns the class name corresponding to a CSS property map
+  std::string getContentClass(EPUBCSSProperties const &content);
+  //! remove the properties which have the same value in inherited
+  void removeInherited(EPUBCSSProperties &cssProps, EPUBCSSProperties const &inherited) const;
   //! add data corresponding to a text position into the map
   void extractTextPosition(char const *value, EPUBCSSProperties &cssProps) const;
   //! add data corresponding to the line decoration into the map
   void extractDecorations(librevenge::RVNGPropertyList const &pList, EPUBCSSProperties &cssProps) const;
 protected:
   //! a map content -> name
-  ContentNameMap_t m_contentNameMap;
+  EPUBContentNameMap m_contentNameMap;
   //! a map id -> name
   std::map<int, std::string> m_idNameMap;
 
-  std::string m_classNamePrefix;
-
 private:
   EPUBSpanStyleManager(EPUBSpanStyleManager const &orig);
   EPUBSpanStyleManager operator=(EPUBSpanStyleManager const &orig);
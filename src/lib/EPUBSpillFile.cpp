@@ -0,0 +1,380 @@
+/* -*- Mode: C++; tab-width: 2; indent-tabs-mode: nil; c-basic-offset: 2 -*- */
+/*
+ * This file is part of the libepubgen project.
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#include "EPUBSpillFile.h"
+
+#include <cstring>
+#include <string>
+
+#include "libepubgen_utils.h"
+#include "EPUBStatistics.h"
+#include "EPUBTraceScope.h"
+#include "EPUBXMLContent.h"
+
+namespace libepubgen
+{
+
+using librevenge::RVNGPropertyList;
+using librevenge::RVNGString;
+
+namespace
+{
+
+/* A spilled XML file is its estimated size, followed by a sequence of
+ * SpillCall, each followed by its arguments: a name, attributes or
+ * characters. Numbers are written as
+ * variable-length unsigned integers, 7 bits per byte, the least
+ * significant first. A string is its length, followed by its bytes.
+ * Attributes are their number, followed by the name and the string value
+ * of each.
+ */
+
+enum SpillCall
+{
+  SPILL_OPEN_FILE = 0,
+  SPILL_OPEN_ELEMENT,
+  SPILL_CLOSE_ELEMENT,
+  SPILL_INSERT_CHARACTERS,
+  SPILL_CLOSE_FILE
+};
+
+void writeNumber(std::FILE *const file, unsigned long number)
+{
+  while (number >= 0x80)
+  {
+    std::fputc(int((number & 0x7f) | 0x80), file);
+    number >>= 7;
+  }
+  std::fputc(int(number), file);
+}
+
+void writeString(std::FILE *const file, const char *const str)
+{
+  const std::size_t length = std::strlen(str);
+  writeNumber(file, length);
+  std::fwrite(str, 1, length, file);
+}
+
+bool readNumber(std::FILE *const file, unsigned long &number)
+{
+  number = 0;
+  for (unsigned shift = 0; shift < 8 * sizeof(number); shift += 7)
+  {
+    const int c = std::fgetc(file);
+    if (EOF == c)
+      return false;
+    number |= (static_cast<unsigned long>(c) & 0x7f) << shift;
+    if (!(c & 0x80))
+      return true;
+  }
+  return false;
+}
+
+bool readString(std::FILE *const file, std::string &str)
+{
+  unsigned long length = 0;
+  if (!readNumber(file, length))
+    return false;
+  str.clear();
+  // Read in pieces, so a broken length does not allocate too much.
+  char buffer[4096];
+  while (length > 0)
+  {
+    const std::size_t size = length < sizeof(buffer) ? std::size_t(length) : sizeof(buffer);
+    if (std::fread(buffer, 1, size, file) != size)
+      return false;
+    str.append(buffer, size);
+    length -= size;
+  }
+  return true;
+}
+
+bool readAttributes(std::FILE *const file, RVNGPropertyList &attributes)
+{
+  unsigned long count = 0;
+  if (!readNumber(file, count))
+    return false;
+  std::string name;
+  std::string value;
+  for (unsigned long i = 0; i < count; ++i)
+  {
+    if (!readString(file, name) || !readString(file, value))
+      return false;
+    attributes.insert(name.c_str(), value.c_str());
+  }
+  return true;
+}
+
+/** Reads the calls of an XML file, following its size.
+  *
+  * They are passed to package, unless it is null, which just checks them.
+  *
+  * @return false if the file is damaged
+  */
+bool readFile(std::FILE *const file, EPUBStatisticsPackage *const package)
+{
+  unsigned long size = 0;
+  if (!readNumber(file, size))
+    return false;
+
+  std::string name;
+  std::string text;
+  bool open = false;
+  for (;;)
+  {
+    const int call = std::fgetc(file);
+    bool ok = true;
+    switch (call)
+    {
+    case SPILL_OPEN_FILE:
+      ok = readString(file, name);
+      if (ok && package)
+      {
+        package->openXMLFile(name.c_str());
+        open = true;
+      }
+      break;
+    case SPILL_OPEN_ELEMENT:
+    {
+      RVNGPropertyList attributes;
+      ok = readString(file, name) && readAttributes(file, attributes);
+      if (ok && package)
+        package->openElement(name.c_str(), attributes);
+      break;
+    }
+    case SPILL_CLOSE_ELEMENT:
+      ok = readString(file, name);
+      if (ok && package)
+        package->closeElement(name.c_str());
+      break;
+    case SPILL_INSERT_CHARACTERS:
+      ok = readString(file, text);
+      if (ok && package)
+        package->insertCharacters(text.c_str());
+      break;
+    case SPILL_CLOSE_FILE:
+      if (package)
+      {
+        package->closeXMLFile();
+        package->addXMLBytes(size);
+      }
+      return true;
+    default:
+      ok = false;
+    }
+
+    if (!ok)
+    {
+      // Keep the calls to the package balanced.
+      if (open)
+        package->closeXMLFile();
+      return false;
+    }
+  }
+}
+
+/// A package which writes the calls of an XML file to the spill file.
+class SpillPackage : public EPUBPackage
+{
+  // disable copying
+  SpillPackage(const SpillPackage &);
+  SpillPackage &operator=(const SpillPackage &);
+
+public:
+  explicit SpillPackage(std::FILE *file);
+  ~SpillPackage() override;
+
+  void openXMLFile(const char *name) override;
+  void openElement(const char *name, const RVNGPropertyList &attributes) override;
+  void closeElement(const char *name) override;
+  void insertCharacters(const RVNGString &characters) override;
+  void closeXMLFile() override;
+
+  void openCSSFile(const char *name) override;
+  void insertRule(const RVNGString &selector, const RVNGPropertyList &properties) override;
+  void closeCSSFile() override;
+
+  void openBinaryFile(const char *name) override;
+  void insertBinaryData(const librevenge::RVNGBinaryData &data) override;
+  void closeBinaryFile() override;
+
+  void openTextFile(const char *name) override;
+  void insertText(const RVNGString &characters) override;
+  void insertLineBreak() override;
+  void closeTextFile() override;
+
+private:
+  std::FILE *const m_file;
+};
+
+SpillPackage::SpillPackage(std::FILE *const file)
+  : m_file(file)
+{
+}
+
+SpillPackage::~SpillPackage()
+{
+}
+
+void SpillPackage::openXMLFile(const char *const name)
+{
+  std::fputc(SPILL_OPEN_FILE, m_file);
+  writeString(m_file, name);
+}
+
+void SpillPackage::openElement(const char *const name, const RVNGPropertyList &attributes)
+{
+  std::fputc(SPILL_OPEN_ELEMENT, m_file);
+  writeString(m_file, name);
+  unsigned long count = 0;
+  RVNGPropertyList::Iter i(attributes);
+  for (i.rewind(); i.next();)
+  {
+    if (i())
+      ++count;
+  }
+  writeNumber(m_file, count);
+  for (i.rewind(); i.next();)
+  {
+    if (!i())
+      continue;
+    writeString(m_file, i.key());
+    writeString(m_file, i()->getStr().cstr());
+  }
+}
+
+void SpillPackage::closeElement(const char *const name)
+{
+  std::fputc(SPILL_CLOSE_ELEMENT, m_file);
+  writeString(m_file, name);
+}
+
+void SpillPackage::insertCharacters(const RVNGString &characters)
+{
+  std::fputc(SPILL_INSERT_CHARACTERS, m_file);
+  writeString(m_file, characters.cstr());
+}
+
+void SpillPackage::closeXMLFile()
+{
+  std::fputc(SPILL_CLOSE_FILE, m_file);
+}
+
+void SpillPackage::openCSSFile(const char *)
+{
+  EPUBGEN_DEBUG_MSG(("SpillPackage::openCSSFile: only XML files are spilled\n"));
+}
+
+void SpillPackage::insertRule(const RVNGString &, const RVNGPropertyList &)
+{
+}
+
+void SpillPackage::closeCSSFile()
+{
+}
+
+void SpillPackage::openBinaryFile(const char *)
+{
+  EPUBGEN_DEBUG_MSG(("SpillPackage::openBinaryFile: only XML files are spilled\n"));
+}
+
+void SpillPackage::insertBinaryData(const librevenge::RVNGBinaryData &)
+{
+}
+
+void SpillPackage::closeBinaryFile()
+{
+}
+
+void SpillPackage::openTextFile(const char *)
+{
+  EPUBGEN_DEBUG_MSG(("SpillPackage::openTextFile: only XML files are spilled\n"));
+}
+
+void SpillPackage::insertText(const RVNGString &)
+{
+}
+
+void SpillPackage::insertLineBreak()
+{
+}
+
+void SpillPackage::closeTextFile()
+{
+}
+
+}
+
+EPUBSpillFile::EPUBSpillFile()
+  : m_file(std::tmpfile())
+  , m_positions()
+{
+  if (!m_file)
+  {
+    EPUBGEN_DEBUG_MSG(("EPUBSpillFile::EPUBSpillFile: cannot create a temporary file\n"));
+  }
+}
+
+EPUBSpillFile::EPUBSpillFile(std::FILE *const file)
+  : m_file(file)
+  , m_positions()
+{
+}
+
+EPUBSpillFile::~EPUBSpillFile()
+{
+  if (m_file)
+    std::fclose(m_file);
+}
+
+bool EPUBSpillFile::spill(EPUBXMLContent &content, const char *const name, std::size_t &record)
+{
+  EPUBGEN_TRACE_SCOPE("EPUBSpillFile::spill");
+  std::fpos_t start;
+  if (!m_file || (0 != std::fseek(m_file, 0, SEEK_END)) || (0 != std::fgetpos(m_file, &start)))
+    return false;
+
+  writeNumber(m_file, content.size());
+  SpillPackage package(m_file);
+  content.writeTo(package, name);
+  if (0 == std::fflush(m_file) && !std::ferror(m_file))
+  {
+    record = m_positions.size();
+    m_positions.push_back(start);
+    return true;
+  }
+
+  EPUBGEN_DEBUG_MSG(("EPUBSpillFile::spill: cannot write %s\n", name));
+  // What was written is never read, the content is kept in memory.
+  std::clearerr(m_file);
+  return false;
+}
+
+bool EPUBSpillFile::replay(const std::size_t record, EPUBStatisticsPackage &package)
+{
+  EPUBGEN_TRACE_SCOPE("EPUBSpillFile::replay");
+  if (!m_file || (m_positions.size() <= record) || (0 != std::fsetpos(m_file, &m_positions[record])))
+  {
+    EPUBGEN_DEBUG_MSG(("EPUBSpillFile::replay: cannot seek to record %lu\n", static_cast<unsigned long>(record)));
+    return false;
+  }
+
+  // Read twice, so nothing is written for a damaged record.
+  if (!readFile(m_file, nullptr) || (0 != std::fsetpos(m_file, &m_positions[record])) || !readFile(m_file, &package))
+  {
+    EPUBGEN_DEBUG_MSG(("EPUBSpillFile::replay: record %lu is damaged\n", static_cast<unsigned long>(record)));
+    std::clearerr(m_file);
+    return false;
+  }
+  return true;
+}
+
+}
+
+/* vim:set shiftwidth=2 softtabstop=2 expandtab: */
@@ -0,0 +1,72 @@
+/* -*- Mode: C++; tab-width: 2; indent-tabs-mode: nil; c-basic-offset: 2 -*- */
+/*
+ * This file is part of the libepubgen project.
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#ifndef INCLUDED_EPUBSPILLFILE_H
+#define INCLUDED_EPUBSPILLFILE_H
+
+#include <cstddef>
+#include <cstdio>
+#include <vector>
+
+#include <libepubgen/EPUBPackage.h>
+
+namespace libepubgen
+{
+
+class EPUBStatisticsPackage;
+class EPUBXMLContent;
+
+/** A temporary file which keeps finished XML files out of memory.
+  *
+  * A file is written to it as the calls of the package it would be
+  * written to, and these calls are replayed when the package is written.
+  * The temporary file is removed when the object is destroyed.
+  *
+  * The records are found by their positions, so the file is not limited
+  * to what a long offset can address.
+  */
+class EPUBSpillFile
+{
+  // disable copying
+  EPUBSpillFile(const EPUBSpillFile &);
+  EPUBSpillFile &operator=(const EPUBSpillFile &);
+
+public:
+  EPUBSpillFile();
+  /// Uses file, which is closed when the object is destroyed.
+  explicit EPUBSpillFile(std::FILE *file);
+  ~EPUBSpillFile();
+
+  /** Writes content to the file.
+    *
+    * @param[out] record the number of the record of the content
+    * @return false if the content could not be written, and must be kept
+    */
+  bool spill(EPUBXMLContent &content, const char *name, std::size_t &record);
+
+  /** Writes the XML file spilled as record to package.
+    *
+    * The record is checked before anything is written, so a damaged
+    * record gives no file at all rather than a truncated one.
+    *
+    * @return false if the record could not be read back
+    */
+  bool replay(std::size_t record, EPUBStatisticsPackage &package);
+
+private:
+  std::FILE *m_file;
+  /// Where each record starts in m_file.
+  std::vector<std::fpos_t> m_positions;
+};
+
+}
+
+#endif // INCLUDED_EPUBSPILLFILE_H
+
+/* vim:set shiftwidth=2 softtabstop=2 expandtab: */
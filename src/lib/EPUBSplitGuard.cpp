@@ -20,10 +20,14 @@ EPUBSplitGuard::EPUBSplitGuard(const EPUBSplitMethod method,bool needSplitOnSeco
   , m_splitOnSecondPageSpan(needSplitOnSecondPageSpan)
   , m_htmlEverInPageSpan(false)
   , m_headingLevel(DEFAULT_SPLIT_HEADING_LEVEL)
-  , m_currentHeadingLevel(0)
   , m_size(DEFAULT_SPLIT_SIZE)
+  , m_maxSize(0)
   , m_currentSize(0)
   , m_nestingLevel(0)
+  , m_headingSeen(false)
+  , m_planned(false)
+  , m_plan()
+  , m_planPoint(0)
 {
 }
 
@@ -39,7 +43,8 @@ void EPUBSplitGuard::setSplitHeadingLevel(const unsigned level)
 
 void EPUBSplitGuard::setCurrentHeadingLevel(const unsigned level)
 {
-  m_currentHeadingLevel = level;
+  if (level && m_headingLevel >= level)
+    m_headingSeen = true;
 }
 
 void EPUBSplitGuard::setSplitSize(const unsigned size)
@@ -47,6 +52,11 @@ void EPUBSplitGuard::setSplitSize(const unsigned size)
   m_size = size;
 }
 
+void EPUBSplitGuard::setMaxSize(const unsigned size)
+{
+  m_maxSize = size;
+}
+
 void EPUBSplitGuard::setSplitMethod(EPUBSplitMethod method)
 {
   m_method = method;
@@ -57,6 +67,38 @@ void EPUBSplitGuard::setSplitOnSecondPageSpan(bool value)
   m_splitOnSecondPageSpan = value;
 }
 
+void EPUBSplitGuard::setPlan(const std::vector<bool> &plan)
+{
+  m_planned = true;
+  m_plan = plan;
+  m_planPoint = 0;
+}
+
+EPUBSplitMethod EPUBSplitGuard::getSplitMethod() const
+{
+  return m_method;
+}
+
+unsigned EPUBSplitGuard::getSplitHeadingLevel() const
+{
+  return m_headingLevel;
+}
+
+unsigned EPUBSplitGuard::getSplitSize() const
+{
+  return m_size;
+}
+
+unsigned EPUBSplitGuard::getMaxSize() const
+{
+  return m_maxSize;
+}
+
+unsigned EPUBSplitGuard::getCurrentSize() const
+{
+  return m_currentSize;
+}
+
 void EPUBSplitGuard::openLevel()
 {
   ++m_nestingLevel;
@@ -67,9 +109,14 @@ void EPUBSplitGuard::closeLevel()
   --m_nestingLevel;
 }
 
-void EPUBSplitGuard::incrementSize(const unsigned size)
+unsigned EPUBSplitGuard::getNestingLevel() const
 {
-  m_currentSize += size;
+  return m_nestingLevel;
+}
+
+void EPUBSplitGuard::setCurrentSize(const unsigned size)
+{
+  m_currentSize = size;
 }
 
 bool EPUBSplitGuard::splitOnPageBreak() const
@@ -87,30 +134,75 @@ bool EPUBSplitGuard::splitOnSecondPageSpan() const
   return m_splitOnSecondPageSpan && m_htmlEverInPageSpan;
 }
 
-bool EPUBSplitGuard::inHeading(bool any) const
+bool EPUBSplitGuard::splitOnSize() const
 {
-  if (!m_currentHeadingLevel)
-    return false;
-
-  if (any)
+  // The maximum size applies on top of any method, including a plan.
+  if ((0 == m_nestingLevel) && isOverMaxSize())
     return true;
+  return canSplit(EPUB_SPLIT_METHOD_SIZE) && (m_size <= m_currentSize);
+}
 
-  return m_headingLevel >= m_currentHeadingLevel;
+bool EPUBSplitGuard::isOverMaxSize() const
+{
+  return (0 != m_maxSize) && (m_maxSize <= m_currentSize);
 }
 
-bool EPUBSplitGuard::splitOnSize() const
+bool EPUBSplitGuard::splitInStructure() const
 {
-  return canSplit(EPUB_SPLIT_METHOD_SIZE) && (m_size <= m_currentSize);
+  // Only the rows or elements of the structure itself, not those of a
+  // table or list nested in it, are split points.
+  if (1 != m_nestingLevel)
+    return false;
+  return isOverMaxSize() || (allowsSplit(EPUB_SPLIT_METHOD_SIZE) && (m_size <= m_currentSize));
+}
+
+bool EPUBSplitGuard::splitOnPlan()
+{
+  if (!m_planned || (0 != m_nestingLevel))
+    return false;
+  const std::size_t point = m_planPoint++;
+  return (point < m_plan.size()) && m_plan[point] && (0 != m_currentSize);
 }
 
 void EPUBSplitGuard::onSplit()
 {
   m_currentSize = 0;
+  m_headingSeen = false;
 }
 
 bool EPUBSplitGuard::canSplit(const EPUBSplitMethod method) const
 {
-  return (method == m_method) && (0 == m_nestingLevel) && (0 != m_currentSize);
+  return (0 == m_nestingLevel) && allowsSplit(method);
+}
+
+bool EPUBSplitGuard::allowsSplit(const EPUBSplitMethod method) const
+{
+  if (m_planned || (0 == m_currentSize))
+    return false;
+  if (m_method == EPUB_SPLIT_METHOD_DETECT)
+    return detectSplit(method);
+  return method == m_method;
+}
+
+bool EPUBSplitGuard::detectSplit(const EPUBSplitMethod method) const
+{
+  switch (method)
+  {
+  case EPUB_SPLIT_METHOD_HEADING:
+    // The best split points: the sections also get their titles from them.
+    // But not if they become tiny: e.g. a title before the first chapter.
+    return m_currentSize >= m_size / 4;
+  case EPUB_SPLIT_METHOD_PAGE_BREAK:
+    // Only useful in a section without headings, and only if it doesn't
+    // become tiny: e.g. a document with a page break after each page.
+    return !m_headingSeen && (m_currentSize >= m_size / 4);
+  case EPUB_SPLIT_METHOD_SIZE:
+    // The fallback if neither gives a split before the size limit.
+    return true;
+  default:
+    break;
+  }
+  return false;
 }
 
 }
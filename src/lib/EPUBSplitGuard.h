@@ -10,11 +10,26 @@
 #ifndef INCLUDED_EPUBSPLITGUARD_H
 #define INCLUDED_EPUBSPLITGUARD_H
 
+#include <vector>
+
 #include <libepubgen/libepubgen-decls.h>
 
 namespace libepubgen
 {
 
+/// Why a new HTML file was started.
+enum EPUBSplitReason
+{
+  EPUB_SPLIT_REASON_START, //< The first file.
+  EPUB_SPLIT_REASON_PAGE_BREAK,
+  EPUB_SPLIT_REASON_HEADING,
+  EPUB_SPLIT_REASON_SIZE,
+  EPUB_SPLIT_REASON_MAX_SIZE,
+  EPUB_SPLIT_REASON_SECOND_PAGE_SPAN,
+  EPUB_SPLIT_REASON_PLAN,
+  EPUB_SPLIT_REASON_PAGE //< A new page of a paged document.
+};
+
 class EPUBSplitGuard
 {
 public:
@@ -23,35 +38,65 @@ public:
   void setSplitHeadingLevel(unsigned level);
   void setCurrentHeadingLevel(unsigned level);
   void setSplitSize(unsigned size);
+  /// Sets the size at which a section is split whatever the method; 0 means no maximum.
+  void setMaxSize(unsigned size);
   void setHtmlEverInPageSpan(bool value);
   /// Allows overwriting the value given in the constructor.
   void setSplitMethod(EPUBSplitMethod method);
   void setSplitOnSecondPageSpan(bool value);
+  /** Replaces the split methods with a plan made by EPUBSplitPlanner.
+    *
+    * @param[in] plan for each point where splitOnPlan() is asked, if the
+    *   content is split there.
+    */
+  void setPlan(const std::vector<bool> &plan);
+
+  EPUBSplitMethod getSplitMethod() const;
+  unsigned getSplitHeadingLevel() const;
+  unsigned getSplitSize() const;
+  unsigned getMaxSize() const;
+  unsigned getCurrentSize() const;
 
   void openLevel();
   void closeLevel();
-  void incrementSize(unsigned size);
+  unsigned getNestingLevel() const;
+  /// Sets the estimated size of the current file, in bytes.
+  void setCurrentSize(unsigned size);
 
   bool splitOnPageBreak() const;
   bool splitOnHeading(unsigned level) const;
   bool splitOnSecondPageSpan() const;
-  bool inHeading(bool any) const;
   bool splitOnSize() const;
+  /// Has the current section reached the maximum size?
+  bool isOverMaxSize() const;
+  /// Can the outermost table or list be split before its next row or element?
+  bool splitInStructure() const;
+  /// Moves to the next point of the plan; true if the content is split there.
+  bool splitOnPlan();
 
   void onSplit();
 
 private:
   bool canSplit(EPUBSplitMethod method) const;
+  bool allowsSplit(EPUBSplitMethod method) const;
+  /// Decides if EPUB_SPLIT_METHOD_DETECT splits on method.
+  bool detectSplit(EPUBSplitMethod method) const;
 
 private:
   EPUBSplitMethod m_method;
   bool m_splitOnSecondPageSpan;
   bool m_htmlEverInPageSpan;
   unsigned m_headingLevel;
-  unsigned m_currentHeadingLevel;
   unsigned m_size;
+  unsigned m_maxSize;
   unsigned m_currentSize;
   unsigned m_nestingLevel;
+  /// Was there a heading of the split level in the current section?
+  bool m_headingSeen;
+  bool m_planned;
+  std::vector<bool> m_plan;
+  /// The index of the next point of the plan.
+  std::size_t m_planPoint;
 };
 
 }
@@ -0,0 +1,482 @@
+/* -*- Mode: C++; tab-width: 2; indent-tabs-mode: nil; c-basic-offset: 2 -*- */
+/*
+ * This file is part of the libepubgen project.
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#include "EPUBSplitPlanner.h"
+
+#include <limits>
+
+#include "libepubgen_utils.h"
+
+namespace libepubgen
+{
+
+using librevenge::RVNGBinaryData;
+using librevenge::RVNGProperty;
+using librevenge::RVNGPropertyList;
+using librevenge::RVNGString;
+
+namespace
+{
+
+/// Estimated size of an element's tags and attributes.
+const std::size_t ELEMENT_SIZE = 32;
+
+/// The cost of a section larger than the split size, which dwarfs the cost of any other.
+const double OVERSIZE_COST = 1000;
+
+bool isPageBreak(const RVNGProperty *const property)
+{
+  if (!property)
+    return false;
+
+  const RVNGString str = property->getStr();
+  return str != "column" && str != "auto";
+}
+
+}
+
+EPUBSplitPlanner::Candidate::Candidate(const std::size_t position, const unsigned headingLevel, const bool pageBreak, const bool forced)
+  : m_position(position)
+  , m_headingLevel(headingLevel)
+  , m_pageBreak(pageBreak)
+  , m_forced(forced)
+{
+}
+
+EPUBSplitPlanner::EPUBSplitPlanner(const EPUBSplitMethod method, const unsigned headingLevel, const unsigned size)
+  : m_method(method)
+  , m_headingLevel(headingLevel)
+  , m_size(size ? size : 1)
+  , m_candidates()
+  , m_position(0)
+  , m_nestingLevel(0)
+  , m_inHeaderOrFooter(false)
+  , m_pageSpanSeen(false)
+  , m_breakAfterPara(false)
+{
+}
+
+EPUBSplitPlanner::~EPUBSplitPlanner()
+{
+}
+
+std::vector<bool> EPUBSplitPlanner::getPlan() const
+{
+  std::vector<bool> split(m_candidates.size(), false);
+  if (m_method != EPUB_SPLIT_METHOD_NONE)
+  {
+    std::size_t first = 0;
+    std::size_t start = 0;
+    for (std::size_t i = 0; i != m_candidates.size(); ++i)
+    {
+      if (!m_candidates[i].m_forced)
+        continue;
+      planRange(first, i, start, m_candidates[i].m_position, split);
+      first = i + 1;
+      start = m_candidates[i].m_position;
+    }
+    planRange(first, m_candidates.size(), start, m_position, split);
+  }
+
+  std::vector<bool> plan;
+  plan.reserve(m_candidates.size());
+  for (std::size_t i = 0; i != m_candidates.size(); ++i)
+  {
+    if (!m_candidates[i].m_forced)
+      plan.push_back(split[i]);
+  }
+  return plan;
+}
+
+void EPUBSplitPlanner::setDocumentMetaData(const RVNGPropertyList &) {}
+
+void EPUBSplitPlanner::startDocument(const RVNGPropertyList &) {}
+
+void EPUBSplitPlanner::endDocument() {}
+
+void EPUBSplitPlanner::defineEmbeddedFont(const RVNGPropertyList &) {}
+
+void EPUBSplitPlanner::definePageStyle(const RVNGPropertyList &) {}
+
+void EPUBSplitPlanner::openPageSpan(const RVNGPropertyList &)
+{
+  // The generator starts a new file on the second page span. That only
+  // holds if no planned split happened since the first one, but page
+  // spans are rare enough to not care.
+  if (m_pageSpanSeen)
+    m_candidates.push_back(Candidate(m_position, 0, false, true));
+  m_pageSpanSeen = true;
+}
+
+void EPUBSplitPlanner::closePageSpan() {}
+
+void EPUBSplitPlanner::openHeader(const RVNGPropertyList &)
+{
+  m_inHeaderOrFooter = true;
+}
+
+void EPUBSplitPlanner::closeHeader()
+{
+  m_inHeaderOrFooter = false;
+}
+
+void EPUBSplitPlanner::openFooter(const RVNGPropertyList &)
+{
+  m_inHeaderOrFooter = true;
+}
+
+void EPUBSplitPlanner::closeFooter()
+{
+  m_inHeaderOrFooter = false;
+}
+
+void EPUBSplitPlanner::defineSectionStyle(const RVNGPropertyList &) {}
+
+void EPUBSplitPlanner::openSection(const RVNGPropertyList &) {}
+
+void EPUBSplitPlanner::closeSection() {}
+
+void EPUBSplitPlanner::defineParagraphStyle(const RVNGPropertyList &) {}
+
+void EPUBSplitPlanner::openParagraph(const RVNGPropertyList &propList)
+{
+  addCandidate(propList);
+  if (!m_inHeaderOrFooter && (0 == m_nestingLevel))
+    m_breakAfterPara = isPageBreak(propList["fo:break-after"]);
+  openLevel();
+  addSize(ELEMENT_SIZE);
+}
+
+void EPUBSplitPlanner::closeParagraph()
+{
+  closeLevel();
+}
+
+void EPUBSplitPlanner::defineCharacterStyle(const RVNGPropertyList &) {}
+
+void EPUBSplitPlanner::openSpan(const RVNGPropertyList &)
+{
+  addSize(ELEMENT_SIZE);
+}
+
+void EPUBSplitPlanner::closeSpan() {}
+
+void EPUBSplitPlanner::openLink(const RVNGPropertyList &)
+{
+  addSize(ELEMENT_SIZE);
+}
+
+void EPUBSplitPlanner::closeLink() {}
+
+void EPUBSplitPlanner::insertTab()
+{
+  addSize(2);
+}
+
+void EPUBSplitPlanner::insertText(const RVNGString &text)
+{
+  addSize(text.size());
+}
+
+void EPUBSplitPlanner::insertSpace()
+{
+  addSize(2);
+}
+
+void EPUBSplitPlanner::insertLineBreak()
+{
+  addSize(6);
+}
+
+void EPUBSplitPlanner::insertField(const RVNGPropertyList &)
+{
+  addSize(ELEMENT_SIZE);
+}
+
+void EPUBSplitPlanner::openOrderedListLevel(const RVNGPropertyList &propList)
+{
+  addCandidate(propList);
+  openLevel();
+  addSize(ELEMENT_SIZE);
+}
+
+void EPUBSplitPlanner::openUnorderedListLevel(const RVNGPropertyList &propList)
+{
+  addCandidate(propList);
+  openLevel();
+  addSize(ELEMENT_SIZE);
+}
+
+void EPUBSplitPlanner::closeOrderedListLevel()
+{
+  closeLevel();
+}
+
+void EPUBSplitPlanner::closeUnorderedListLevel()
+{
+  closeLevel();
+}
+
+void EPUBSplitPlanner::openListElement(const RVNGPropertyList &)
+{
+  addSize(ELEMENT_SIZE);
+}
+
+void EPUBSplitPlanner::closeListElement() {}
+
+void EPUBSplitPlanner::openFootnote(const RVNGPropertyList &)
+{
+  addSize(ELEMENT_SIZE);
+}
+
+void EPUBSplitPlanner::closeFootnote() {}
+
+void EPUBSplitPlanner::openEndnote(const RVNGPropertyList &)
+{
+  addSize(ELEMENT_SIZE);
+}
+
+void EPUBSplitPlanner::closeEndnote() {}
+
+void EPUBSplitPlanner::openComment(const RVNGPropertyList &)
+{
+  addSize(ELEMENT_SIZE);
+}
+
+void EPUBSplitPlanner::closeComment() {}
+
+void EPUBSplitPlanner::openTextBox(const RVNGPropertyList &)
+{
+  openLevel();
+  addSize(ELEMENT_SIZE);
+}
+
+void EPUBSplitPlanner::closeTextBox()
+{
+  closeLevel();
+}
+
+void EPUBSplitPlanner::openTable(const RVNGPropertyList &propList)
+{
+  addCandidate(propList);
+  openLevel();
+  addSize(ELEMENT_SIZE);
+}
+
+void EPUBSplitPlanner::openTableRow(const RVNGPropertyList &)
+{
+  addSize(ELEMENT_SIZE);
+}
+
+void EPUBSplitPlanner::closeTableRow() {}
+
+void EPUBSplitPlanner::openTableCell(const RVNGPropertyList &)
+{
+  addSize(ELEMENT_SIZE);
+}
+
+void EPUBSplitPlanner::closeTableCell() {}
+
+void EPUBSplitPlanner::insertCoveredTableCell(const RVNGPropertyList &) {}
+
+void EPUBSplitPlanner::closeTable()
+{
+  closeLevel();
+}
+
+void EPUBSplitPlanner::openFrame(const RVNGPropertyList &)
+{
+  openLevel();
+  addSize(ELEMENT_SIZE);
+}
+
+void EPUBSplitPlanner::closeFrame()
+{
+  closeLevel();
+}
+
+void EPUBSplitPlanner::openGroup(const RVNGPropertyList &)
+{
+  openLevel();
+}
+
+void EPUBSplitPlanner::closeGroup()
+{
+  closeLevel();
+}
+
+void EPUBSplitPlanner::defineGraphicStyle(const RVNGPropertyList &) {}
+
+void EPUBSplitPlanner::drawRectangle(const RVNGPropertyList &)
+{
+  addSize(ELEMENT_SIZE);
+}
+
+void EPUBSplitPlanner::drawEllipse(const RVNGPropertyList &)
+{
+  addSize(ELEMENT_SIZE);
+}
+
+void EPUBSplitPlanner::drawPolygon(const RVNGPropertyList &)
+{
+  addSize(ELEMENT_SIZE);
+}
+
+void EPUBSplitPlanner::drawPolyline(const RVNGPropertyList &)
+{
+  addSize(ELEMENT_SIZE);
+}
+
+void EPUBSplitPlanner::drawPath(const RVNGPropertyList &)
+{
+  addSize(ELEMENT_SIZE);
+}
+
+void EPUBSplitPlanner::drawConnector(const RVNGPropertyList &)
+{
+  addSize(ELEMENT_SIZE);
+}
+
+void EPUBSplitPlanner::insertBinaryObject(const RVNGPropertyList &propList)
+{
+  addSize(ELEMENT_SIZE);
+  // Images count in the split size too.
+  if (const RVNGProperty *const data = propList["office:binary-data"])
+    addSize(RVNGBinaryData(data->getStr()).size());
+}
+
+void EPUBSplitPlanner::insertEquation(const RVNGPropertyList &)
+{
+  addSize(ELEMENT_SIZE);
+}
+
+void EPUBSplitPlanner::addCandidate(const RVNGPropertyList &propList)
+{
+  if (m_inHeaderOrFooter || (0 != m_nestingLevel))
+    return;
+
+  const RVNGProperty *const outlineLevel = propList["text:outline-level"];
+  const bool pageBreak = m_breakAfterPara || isPageBreak(propList["fo:break-before"]);
+  m_candidates.push_back(Candidate(m_position, outlineLevel ? unsigned(outlineLevel->getInt()) : 0, pageBreak, false));
+  m_breakAfterPara = false;
+}
+
+void EPUBSplitPlanner::openLevel()
+{
+  ++m_nestingLevel;
+}
+
+void EPUBSplitPlanner::closeLevel()
+{
+  if (0 == m_nestingLevel)
+  {
+    EPUBGEN_DEBUG_MSG(("EPUBSplitPlanner::closeLevel: no open level\n"));
+    return;
+  }
+  --m_nestingLevel;
+}
+
+void EPUBSplitPlanner::addSize(const std::size_t size)
+{
+  // Headers and footers are repeated in every file, they don't make any of them larger.
+  if (!m_inHeaderOrFooter)
+    m_position += size;
+}
+
+bool EPUBSplitPlanner::isAllowed(const Candidate &candidate) const
+{
+  switch (m_method)
+  {
+  case EPUB_SPLIT_METHOD_PAGE_BREAK:
+    return candidate.m_pageBreak;
+  case EPUB_SPLIT_METHOD_HEADING:
+    return (0 != candidate.m_headingLevel) && (candidate.m_headingLevel <= m_headingLevel);
+  case EPUB_SPLIT_METHOD_SIZE:
+  case EPUB_SPLIT_METHOD_DETECT:
+    return true;
+  default:
+    break;
+  }
+  return false;
+}
+
+double EPUBSplitPlanner::getPenalty(const Candidate &candidate) const
+{
+  if (m_method != EPUB_SPLIT_METHOD_DETECT)
+    return 0;
+  if ((0 != candidate.m_headingLevel) && (candidate.m_headingLevel <= m_headingLevel))
+    return 0;
+  if (candidate.m_pageBreak)
+    return 0.1;
+  if (0 != candidate.m_headingLevel)
+    return 0.2;
+  return 0.5;
+}
+
+double EPUBSplitPlanner::getSectionCost(const std::size_t size) const
+{
+  // The square of the unused part of the split size: this prefers few
+  // sections of even size to many small or some tiny ones.
+  const double ratio = double(size) / m_size;
+  if (ratio <= 1)
+    return (1 - ratio) * (1 - ratio);
+  return OVERSIZE_COST * (1 + (ratio - 1) * (ratio - 1));
+}
+
+void EPUBSplitPlanner::planRange(const std::size_t first, const std::size_t last, const std::size_t start, const std::size_t end, std::vector<bool> &split) const
+{
+  // The nodes are the start, the allowed candidates and the end.
+  std::vector<std::size_t> nodes;
+  for (std::size_t i = first; i != last; ++i)
+  {
+    if (isAllowed(m_candidates[i]))
+      nodes.push_back(i);
+  }
+
+  const std::size_t count = nodes.size() + 2;
+  const auto position = [&](const std::size_t node)
+  {
+    if (0 == node)
+      return start;
+    if (count - 1 == node)
+      return end;
+    return m_candidates[nodes[node - 1]].m_position;
+  };
+
+  std::vector<double> cost(count, std::numeric_limits<double>::infinity());
+  std::vector<std::size_t> previous(count, 0);
+  cost[0] = 0;
+  for (std::size_t k = 1; k != count; ++k)
+  {
+    const double penalty = (count - 1 == k) ? 0 : getPenalty(m_candidates[nodes[k - 1]]);
+    for (std::size_t j = k; j-- != 0;)
+    {
+      const std::size_t size = position(k) - position(j);
+      // Empty sections are not possible, except if the whole range is empty.
+      if ((0 == size) && ((0 != j) || (count - 1 != k)))
+        continue;
+      const double total = cost[j] + getSectionCost(size) + penalty;
+      if (total < cost[k])
+      {
+        cost[k] = total;
+        previous[k] = j;
+      }
+      // Longer sections only cost more.
+      if (size > m_size)
+        break;
+    }
+  }
+
+  for (std::size_t node = previous[count - 1]; 0 != node; node = previous[node])
+    split[nodes[node - 1]] = true;
+}
+
+}
+
+/* vim:set shiftwidth=2 softtabstop=2 expandtab: */
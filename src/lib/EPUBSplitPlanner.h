@@ -0,0 +1,164 @@
+/* -*- Mode: C++; tab-width: 2; indent-tabs-mode: nil; c-basic-offset: 2 -*- */
+/*
+ * This file is part of the libepubgen project.
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#ifndef INCLUDED_EPUBSPLITPLANNER_H
+#define INCLUDED_EPUBSPLITPLANNER_H
+
+#include <cstddef>
+#include <vector>
+
+#include <librevenge/librevenge.h>
+
+#include <libepubgen/libepubgen-decls.h>
+
+namespace libepubgen
+{
+
+/** Chooses the split points of a recorded document.
+  *
+  * The document is written into the planner, which collects the points
+  * where EPUBSplitGuard::splitOnPlan() is asked, together with the
+  * estimated size of the content before them. getPlan() then picks the
+  * set of points which gives the most balanced sections not larger than
+  * the split size, preferring headings and page breaks as the split method
+  * asks.
+  */
+class EPUBSplitPlanner : public librevenge::RVNGTextInterface
+{
+  // disable copying
+  EPUBSplitPlanner(const EPUBSplitPlanner &);
+  EPUBSplitPlanner &operator=(const EPUBSplitPlanner &);
+
+  struct Candidate
+  {
+    Candidate(std::size_t position, unsigned headingLevel, bool pageBreak, bool forced);
+
+    /// Estimated size of the content before the point.
+    std::size_t m_position;
+    unsigned m_headingLevel;
+    bool m_pageBreak;
+    /// The generator splits here anyway: not a point of the plan.
+    bool m_forced;
+  };
+
+public:
+  EPUBSplitPlanner(EPUBSplitMethod method, unsigned headingLevel, unsigned size);
+  ~EPUBSplitPlanner() override;
+
+  /// Returns, for each point of the plan, if the content is split there.
+  std::vector<bool> getPlan() const;
+
+  void setDocumentMetaData(const librevenge::RVNGPropertyList &propList) override;
+
+  void startDocument(const librevenge::RVNGPropertyList &propList) override;
+  void endDocument() override;
+
+  void defineEmbeddedFont(const librevenge::RVNGPropertyList &propList) override;
+
+  void definePageStyle(const librevenge::RVNGPropertyList &propList) override;
+  void openPageSpan(const librevenge::RVNGPropertyList &propList) override;
+  void closePageSpan() override;
+  void openHeader(const librevenge::RVNGPropertyList &propList) override;
+  void closeHeader() override;
+  void openFooter(const librevenge::RVNGPropertyList &propList) override;
+  void closeFooter() override;
+
+  void defineSectionStyle(const librevenge::RVNGPropertyList &propList) override;
+  void openSection(const librevenge::RVNGPropertyList &propList) override;
+  void closeSection() override;
+
+  void defineParagraphStyle(const librevenge::RVNGPropertyList &propList) override;
+  void openParagraph(const librevenge::RVNGPropertyList &propList) override;
+  void closeParagraph() override;
+
+  void defineCharacterStyle(const librevenge::RVNGPropertyList &propList) override;
+  void openSpan(const librevenge::RVNGPropertyList &propList) override;
+  void closeSpan() override;
+
+  void openLink(const librevenge::RVNGPropertyList &propList) override;
+  void closeLink() override;
+
+  void insertTab() override;
+  void insertText(const librevenge::RVNGString &text) override;
+  void insertSpace() override;
+  void insertLineBreak() override;
+  void insertField(const librevenge::RVNGPropertyList &propList) override;
+
+  void openOrderedListLevel(const librevenge::RVNGPropertyList &propList) override;
+  void openUnorderedListLevel(const librevenge::RVNGPropertyList &propList) override;
+  void closeOrderedListLevel() override;
+  void closeUnorderedListLevel() override;
+  void openListElement(const librevenge::RVNGPropertyList &propList) override;
+  void closeListElement() override;
+
+  void openFootnote(const librevenge::RVNGPropertyList &propList) override;
+  void closeFootnote() override;
+  void openEndnote(const librevenge::RVNGPropertyList &propList) override;
+  void closeEndnote() override;
+  void openComment(const librevenge::RVNGPropertyList &propList) override;
+  void closeComment() override;
+  void openTextBox(const librevenge::RVNGPropertyList &propList) override;
+  void closeTextBox() override;
+
+  void openTable(const librevenge::RVNGPropertyList &propList) override;
+  void openTableRow(const librevenge::RVNGPropertyList &propList) override;
+  void closeTableRow() override;
+  void openTableCell(const librevenge::RVNGPropertyList &propList) override;
+  void closeTableCell() override;
+  void insertCoveredTableCell(const librevenge::RVNGPropertyList &propList) override;
+  void closeTable() override;
+
+  void openFrame(const librevenge::RVNGPropertyList &propList) override;
+  void closeFrame() override;
+
+  void openGroup(const librevenge::RVNGPropertyList &propList) override;
+  void closeGroup() override;
+
+  void defineGraphicStyle(const librevenge::RVNGPropertyList &propList) override;
+  void drawRectangle(const librevenge::RVNGPropertyList &propList) override;
+  void drawEllipse(const librevenge::RVNGPropertyList &propList) override;
+  void drawPolygon(const librevenge::RVNGPropertyList &propList) override;
+  void drawPolyline(const librevenge::RVNGPropertyList &propList) override;
+  void drawPath(const librevenge::RVNGPropertyList &propList) override;
+  void drawConnector(const librevenge::RVNGPropertyList &propList) override;
+
+  void insertBinaryObject(const librevenge::RVNGPropertyList &propList) override;
+  void insertEquation(const librevenge::RVNGPropertyList &propList) override;
+
+private:
+  /// Adds a point of the plan, if the content is at the top level.
+  void addCandidate(const librevenge::RVNGPropertyList &propList);
+  void openLevel();
+  void closeLevel();
+  void addSize(std::size_t size);
+
+  bool isAllowed(const Candidate &candidate) const;
+  /// The cost of splitting at candidate, relative to the cost of a maximal section.
+  double getPenalty(const Candidate &candidate) const;
+  double getSectionCost(std::size_t size) const;
+  /// Plans the candidates in [first, last), between the forced splits at start and end.
+  void planRange(std::size_t first, std::size_t last, std::size_t start, std::size_t end, std::vector<bool> &split) const;
+
+  const EPUBSplitMethod m_method;
+  const unsigned m_headingLevel;
+  const unsigned m_size;
+
+  std::vector<Candidate> m_candidates;
+  std::size_t m_position;
+  unsigned m_nestingLevel;
+  bool m_inHeaderOrFooter;
+  bool m_pageSpanSeen;
+  bool m_breakAfterPara;
+};
+
+}
+
+#endif // INCLUDED_EPUBSPLITPLANNER_H
+
+/* vim:set shiftwidth=2 softtabstop=2 expandtab: */
@@ -0,0 +1,208 @@
+/* -*- Mode: C++; tab-width: 2; indent-tabs-mode: nil; c-basic-offset: 2 -*- */
+/*
+ * This file is part of the libepubgen project.
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#include "EPUBStatistics.h"
+
+#include <cstring>
+
+namespace libepubgen
+{
+
+namespace
+{
+
+const char *const PHASE_NAMES[EPUB_STATISTICS_PHASE_COUNT] =
+{
+  "libepubgen:generation-time",
+  "libepubgen:write-container-time",
+  "libepubgen:write-root-time",
+  "libepubgen:write-navigation-time",
+  "libepubgen:write-stylesheet-time",
+  "libepubgen:write-sections-time",
+  "libepubgen:write-images-time",
+  "libepubgen:write-fonts-time"
+};
+
+void insertCount(librevenge::RVNGPropertyList &statistics, const char *const name, const unsigned long count)
+{
+  statistics.insert(name, double(count), librevenge::RVNG_GENERIC);
+}
+
+}
+
+std::size_t getSerializedSize(const librevenge::RVNGPropertyList &properties)
+{
+  std::size_t size = 0;
+  librevenge::RVNGPropertyList::Iter i(properties);
+  for (i.rewind(); i.next();)
+  {
+    if (i())
+      size += std::strlen(i.key()) + i()->getStr().size() + 4;
+  }
+  return size;
+}
+
+EPUBStatistics::EPUBStatistics()
+  : m_sections(0)
+  , m_styleHits(0)
+  , m_styleMisses(0)
+  , m_images(0)
+  , m_duplicateImages(0)
+  , m_fonts(0)
+  , m_duplicateFonts(0)
+  , m_files(0)
+  , m_elements(0)
+  , m_spans(0)
+  , m_textBytes(0)
+  , m_xmlBytes(0)
+  , m_cssBytes(0)
+  , m_binaryBytes(0)
+  , m_textFileBytes(0)
+  , m_times()
+{
+}
+
+EPUBStatistics::Clock::time_point EPUBStatistics::endPhase(const EPUBStatisticsPhase phase, const Clock::time_point start)
+{
+  const Clock::time_point end = Clock::now();
+  m_times[phase] = std::chrono::duration<double>(end - start).count();
+  return end;
+}
+
+void EPUBStatistics::writeTo(librevenge::RVNGPropertyList &statistics) const
+{
+  // Doubles, as the counts of bytes can be too big for an int.
+  insertCount(statistics, "libepubgen:sections", m_sections);
+  insertCount(statistics, "libepubgen:style-cache-hits", m_styleHits);
+  insertCount(statistics, "libepubgen:style-cache-misses", m_styleMisses);
+  insertCount(statistics, "libepubgen:images", m_images);
+  insertCount(statistics, "libepubgen:images-deduplicated", m_duplicateImages);
+  insertCount(statistics, "libepubgen:fonts", m_fonts);
+  insertCount(statistics, "libepubgen:fonts-deduplicated", m_duplicateFonts);
+  insertCount(statistics, "libepubgen:files", m_files);
+  insertCount(statistics, "libepubgen:elements", m_elements);
+  insertCount(statistics, "libepubgen:spans", m_spans);
+  insertCount(statistics, "libepubgen:text-bytes", m_textBytes);
+  insertCount(statistics, "libepubgen:xml-bytes", m_xmlBytes);
+  insertCount(statistics, "libepubgen:css-bytes", m_cssBytes);
+  insertCount(statistics, "libepubgen:binary-bytes", m_binaryBytes);
+  insertCount(statistics, "libepubgen:text-file-bytes", m_textFileBytes);
+  for (int i = 0; i < EPUB_STATISTICS_PHASE_COUNT; ++i)
+    statistics.insert(PHASE_NAMES[i], m_times[i], librevenge::RVNG_GENERIC);
+}
+
+EPUBStatisticsPackage::EPUBStatisticsPackage(EPUBPackage *const package, EPUBStatistics &statistics)
+  : m_package(package)
+  , m_statistics(statistics)
+{
+}
+
+EPUBStatisticsPackage::~EPUBStatisticsPackage()
+{
+}
+
+void EPUBStatisticsPackage::openXMLFile(const char *const name)
+{
+  ++m_statistics.m_files;
+  m_package->openXMLFile(name);
+}
+
+void EPUBStatisticsPackage::openElement(const char *const name, const librevenge::RVNGPropertyList &attributes)
+{
+  ++m_statistics.m_elements;
+  if (0 == std::strcmp(name, "span"))
+    ++m_statistics.m_spans;
+  m_package->openElement(name, attributes);
+}
+
+void EPUBStatisticsPackage::closeElement(const char *const name)
+{
+  m_package->closeElement(name);
+}
+
+void EPUBStatisticsPackage::insertCharacters(const librevenge::RVNGString &characters)
+{
+  m_statistics.m_textBytes += characters.size();
+  m_package->insertCharacters(characters);
+}
+
+void EPUBStatisticsPackage::closeXMLFile()
+{
+  m_package->closeXMLFile();
+}
+
+void EPUBStatisticsPackage::openCSSFile(const char *const name)
+{
+  ++m_statistics.m_files;
+  m_package->openCSSFile(name);
+}
+
+void EPUBStatisticsPackage::insertRule(const librevenge::RVNGString &selector, const librevenge::RVNGPropertyList &properties)
+{
+  m_package->insertRule(selector, properties);
+}
+
+void EPUBStatisticsPackage::closeCSSFile()
+{
+  m_package->closeCSSFile();
+}
+
+void EPUBStatisticsPackage::openBinaryFile(const char *const name)
+{
+  ++m_statistics.m_files;
+  m_package->openBinaryFile(name);
+}
+
+void EPUBStatisticsPackage::insertBinaryData(const librevenge::RVNGBinaryData &data)
+{
+  m_statistics.m_binaryBytes += data.size();
+  m_package->insertBinaryData(data);
+}
+
+void EPUBStatisticsPackage::closeBinaryFile()
+{
+  m_package->closeBinaryFile();
+}
+
+void EPUBStatisticsPackage::openTextFile(const char *const name)
+{
+  ++m_statistics.m_files;
+  m_package->openTextFile(name);
+}
+
+void EPUBStatisticsPackage::insertText(const librevenge::RVNGString &characters)
+{
+  m_statistics.m_textFileBytes += characters.size();
+  m_package->insertText(characters);
+}
+
+void EPUBStatisticsPackage::insertLineBreak()
+{
+  ++m_statistics.m_textFileBytes;
+  m_package->insertLineBreak();
+}
+
+void EPUBStatisticsPackage::closeTextFile()
+{
+  m_package->closeTextFile();
+}
+
+void EPUBStatisticsPackage::addXMLBytes(const std::size_t bytes)
+{
+  m_statistics.m_xmlBytes += bytes;
+}
+
+void EPUBStatisticsPackage::addCSSBytes(const std::size_t bytes)
+{
+  m_statistics.m_cssBytes += bytes;
+}
+
+}
+
+/* vim:set shiftwidth=2 softtabstop=2 expandtab: */
@@ -0,0 +1,131 @@
+/* -*- Mode: C++; tab-width: 2; indent-tabs-mode: nil; c-basic-offset: 2 -*- */
+/*
+ * This file is part of the libepubgen project.
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#ifndef INCLUDED_EPUBSTATISTICS_H
+#define INCLUDED_EPUBSTATISTICS_H
+
+#include <chrono>
+#include <cstddef>
+
+#include <librevenge/librevenge.h>
+
+#include <libepubgen/EPUBPackage.h>
+
+namespace libepubgen
+{
+
+/// The phases of the generation which are timed.
+enum EPUBStatisticsPhase
+{
+  EPUB_STATISTICS_PHASE_GENERATION, //< From startDocument() to endDocument().
+  EPUB_STATISTICS_PHASE_CONTAINER,
+  EPUB_STATISTICS_PHASE_ROOT,
+  EPUB_STATISTICS_PHASE_NAVIGATION,
+  EPUB_STATISTICS_PHASE_STYLESHEET,
+  EPUB_STATISTICS_PHASE_SECTIONS,
+  EPUB_STATISTICS_PHASE_IMAGES,
+  EPUB_STATISTICS_PHASE_FONTS,
+  EPUB_STATISTICS_PHASE_COUNT
+};
+
+/// Counters of what the generator did; collected from its parts on request.
+struct EPUBStatistics
+{
+  typedef std::chrono::steady_clock Clock;
+
+  EPUBStatistics();
+
+  /** Sets the time of a phase which started at start.
+    *
+    * @return the end of the phase, i.e., the start of the next one.
+    */
+  Clock::time_point endPhase(EPUBStatisticsPhase phase, Clock::time_point start);
+
+  void writeTo(librevenge::RVNGPropertyList &statistics) const;
+
+  unsigned long m_sections;
+  unsigned long m_styleHits;
+  unsigned long m_styleMisses;
+  /// Images inserted, including the repeated ones.
+  unsigned long m_images;
+  /// Images which were already inserted.
+  unsigned long m_duplicateImages;
+  unsigned long m_fonts;
+  unsigned long m_duplicateFonts;
+
+  // What was written to the package.
+  unsigned long m_files;
+  unsigned long m_elements;
+  unsigned long m_spans;
+  unsigned long m_textBytes;
+  unsigned long m_xmlBytes;
+  unsigned long m_cssBytes;
+  unsigned long m_binaryBytes;
+  unsigned long m_textFileBytes;
+
+  /// The time of each phase, in seconds.
+  double m_times[EPUB_STATISTICS_PHASE_COUNT];
+};
+
+/** Estimates the size of serialized CSS properties.
+  *
+  * Each property counts as `key: value; `.
+  */
+std::size_t getSerializedSize(const librevenge::RVNGPropertyList &properties);
+
+/// A package which counts what is written to another one.
+class EPUBStatisticsPackage : public EPUBPackage
+{
+  // disable copying
+  EPUBStatisticsPackage(const EPUBStatisticsPackage &);
+  EPUBStatisticsPackage &operator=(const EPUBStatisticsPackage &);
+
+public:
+  EPUBStatisticsPackage(EPUBPackage *package, EPUBStatistics &statistics);
+  ~EPUBStatisticsPackage() override;
+
+  void openXMLFile(const char *name) override;
+  void openElement(const char *name, const librevenge::RVNGPropertyList &attributes) override;
+  void closeElement(const char *name) override;
+  void insertCharacters(const librevenge::RVNGString &characters) override;
+  void closeXMLFile() override;
+
+  void openCSSFile(const char *name) override;
+  void insertRule(const librevenge::RVNGString &selector, const librevenge::RVNGPropertyList &properties) override;
+  void closeCSSFile() override;
+
+  void openBinaryFile(const char *name) override;
+  void insertBinaryData(const librevenge::RVNGBinaryData &data) override;
+  void closeBinaryFile() override;
+
+  void openTextFile(const char *name) override;
+  void insertText(const librevenge::RVNGString &characters) override;
+  void insertLineBreak() override;
+  void closeTextFile() override;
+
+  /** Adds the estimated size of an XML file which is written.
+    *
+    * The sizes of XML and CSS files are estimated by their contents when
+    * they are built, so the attributes are not serialized again for every
+    * call here.
+    */
+  void addXMLBytes(std::size_t bytes);
+  /// Adds the estimated size of a CSS file which is written.
+  void addCSSBytes(std::size_t bytes);
+
+private:
+  EPUBPackage *const m_package;
+  EPUBStatistics &m_statistics;
+};
+
+}
+
+#endif // INCLUDED_EPUBSTATISTICS_H
+
+/* vim:set shiftwidth=2 softtabstop=2 expandtab: */
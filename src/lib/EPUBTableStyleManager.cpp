@@ -16,6 +16,9 @@
 
 #include "libepubgen_utils.h"
 #include "EPUBCSSContent.h"
+#include "EPUBMemoryUsage.h"
+#include "EPUBStatistics.h"
+#include "EPUBTraceScope.h"
 
 namespace libepubgen
 {
@@ -55,6 +58,7 @@ void EPUBTableStyleManager::openTable(RVNGPropertyList const &propList)
     }
     m_columnWidthsStack.push_back(colWidths);
     m_relColumnWidthsStack.push_back(relColWidths);
+    m_cellTemplatesStack.push_back(CellTemplateMap_t());
   }
 }
 
@@ -66,6 +70,8 @@ void EPUBTableStyleManager::closeTable()
     return;
   }
   m_columnWidthsStack.pop_back();
+  m_relColumnWidthsStack.pop_back();
+  m_cellTemplatesStack.pop_back();
 }
 
 namespace
@@ -119,41 +125,73 @@ bool EPUBTableStyleManager::getRelColumnsWidth(int col, int numSpanned, double &
   return extractColumnsWidth(m_relColumnWidthsStack, col, numSpanned, true, w);
 }
 
+EPUBTableStyleManager::CellTemplate *EPUBTableStyleManager::findCellTemplate(RVNGPropertyList const &pList)
+{
+  // The cell properties only depend on the column widths of the actual
+  // table and on these properties.
+  static char const *keyNames[] =
+  {
+    "librevenge:column", "table:number-columns-spanned", "fo:text-align", "style:vertical-align", "fo:background-color",
+    "fo:border", "fo:border-left", "fo:border-top", "fo:border-right", "fo:border-bottom"
+  };
+
+  if (m_cellTemplatesStack.empty() || !pList["librevenge:column"])
+    return nullptr;
+
+  m_cellKey.clear();
+  for (const auto &name : keyNames)
+  {
+    if (const librevenge::RVNGProperty *prop = pList[name])
+    {
+      m_cellKey += '+';
+      m_cellKey += prop->getStr().cstr();
+    }
+    m_cellKey += '\n';
+  }
+  return &m_cellTemplatesStack.back()[m_cellKey];
+}
+
 std::string EPUBTableStyleManager::getCellClass(RVNGPropertyList const &pList)
 {
+  EPUBGEN_TRACE_SCOPE("EPUBTableStyleManager::getCellClass");
+  CellTemplate *const cell = findCellTemplate(pList);
+  if (cell && !cell->m_class.empty())
+  {
+    m_cellContentNameMap.use(cell->m_class);
+    return cell->m_class;
+  }
+
   EPUBCSSProperties content;
   extractCellProperties(pList, content);
-  ContentNameMap_t::const_iterator it=m_cellContentNameMap.find(content);
-  if (it != m_cellContentNameMap.end())
-    return it->second;
-  std::stringstream s;
-  s << "cellTable" << m_cellContentNameMap.size();
-  m_cellContentNameMap[content]=s.str();
-  return s.str();
+  const std::string &name = m_cellContentNameMap.getName(content);
+  if (cell)
+    cell->m_class = name;
+  return name;
 }
 
 std::string EPUBTableStyleManager::getCellStyle(RVNGPropertyList const &pList)
 {
+  CellTemplate *const cell = findCellTemplate(pList);
+  if (cell && !cell->m_style.empty())
+    return cell->m_style;
+
   EPUBCSSProperties content;
   extractCellProperties(pList, content);
 
   std::stringstream s;
   for (const auto &property : content)
     s << property.first << ": " << property.second << "; ";
+  if (cell)
+    cell->m_style = s.str();
   return s.str();
 }
 
 std::string EPUBTableStyleManager::getRowClass(RVNGPropertyList const &pList)
 {
+  EPUBGEN_TRACE_SCOPE("EPUBTableStyleManager::getRowClass");
   EPUBCSSProperties content;
   extractRowProperties(pList, content);
-  ContentNameMap_t::const_iterator it=m_rowContentNameMap.find(content);
-  if (it != m_rowContentNameMap.end())
-    return it->second;
-  std::stringstream s;
-  s << "rowTable" << m_rowContentNameMap.size();
-  m_rowContentNameMap[content]=s.str();
-  return s.str();
+  return m_rowContentNameMap.getName(content);
 }
 
 std::string EPUBTableStyleManager::getRowStyle(RVNGPropertyList const &pList)
@@ -169,15 +207,10 @@ std::string EPUBTableStyleManager::getRowStyle(RVNGPropertyList const &pList)
 
 std::string EPUBTableStyleManager::getTableClass(RVNGPropertyList const &pList)
 {
+  EPUBGEN_TRACE_SCOPE("EPUBTableStyleManager::getTableClass");
   EPUBCSSProperties content;
   extractTableProperties(pList, content);
-  ContentNameMap_t::const_iterator it=m_tableContentNameMap.find(content);
-  if (it != m_tableContentNameMap.end())
-    return it->second;
-  std::stringstream s;
-  s << "table" << m_tableContentNameMap.size();
-  m_tableContentNameMap[content]=s.str();
-  return s.str();
+  return m_tableContentNameMap.getName(content);
 }
 
 std::string EPUBTableStyleManager::getTableStyle(RVNGPropertyList const &pList)
@@ -191,28 +224,39 @@ std::string EPUBTableStyleManager::getTableStyle(RVNGPropertyList const &pList)
   return s.str();
 }
 
-void EPUBTableStyleManager::send(EPUBCSSContent &out)
+void EPUBTableStyleManager::setClassNamesMethod(EPUBClassNamesMethod method)
 {
-  for (ContentNameMap_t::const_iterator it=m_cellContentNameMap.begin(); m_cellContentNameMap.end() != it; ++it)
-  {
-    RVNGPropertyList props;
-    fillPropertyList(it->first, props);
-    out.insertRule(("." + it->second).c_str(), props);
-  }
+  m_cellContentNameMap.setClassNamesMethod(method);
+  m_rowContentNameMap.setClassNamesMethod(method);
+  m_tableContentNameMap.setClassNamesMethod(method);
+}
 
-  for (ContentNameMap_t::const_iterator it=m_rowContentNameMap.begin(); m_rowContentNameMap.end() != it; ++it)
-  {
-    RVNGPropertyList props;
-    fillPropertyList(it->first, props);
-    out.insertRule(("." + it->second).c_str(), props);
-  }
+void EPUBTableStyleManager::getUsage(RVNGPropertyList &usage) const
+{
+  m_cellContentNameMap.getUsage(usage);
+  m_rowContentNameMap.getUsage(usage);
+  m_tableContentNameMap.getUsage(usage);
+}
 
-  for (ContentNameMap_t::const_iterator it=m_tableContentNameMap.begin(); m_tableContentNameMap.end() != it; ++it)
-  {
-    RVNGPropertyList props;
-    fillPropertyList(it->first, props);
-    out.insertRule(("." + it->second).c_str(), props);
-  }
+void EPUBTableStyleManager::addStatistics(EPUBStatistics &statistics) const
+{
+  m_cellContentNameMap.addStatistics(statistics);
+  m_rowContentNameMap.addStatistics(statistics);
+  m_tableContentNameMap.addStatistics(statistics);
+}
+
+void EPUBTableStyleManager::addMemoryUsage(EPUBMemoryUsage &usage) const
+{
+  m_cellContentNameMap.addMemoryUsage(usage);
+  m_rowContentNameMap.addMemoryUsage(usage);
+  m_tableContentNameMap.addMemoryUsage(usage);
+}
+
+void EPUBTableStyleManager::send(EPUBCSSContent &out)
+{
+  m_cellContentNameMap.send(out);
+  m_rowContentNameMap.send(out);
+  m_tableContentNameMap.send(out);
 }
 
 void EPUBTableStyleManager::extractCellProperties(RVNGPropertyList const &pList, EPUBCSSProperties &cssProps) const
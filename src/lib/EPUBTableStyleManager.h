@@ -16,23 +16,33 @@
 #include <unordered_map>
 #include <vector>
 
-#include <boost/functional/hash.hpp>
-
 #include "EPUBCSSProperties.h"
+#include "EPUBContentNameMap.h"
 
 namespace libepubgen
 {
 
 class EPUBCSSContent;
+struct EPUBMemoryUsage;
+struct EPUBStatistics;
 
 /** Small class to manage the tables style */
 class EPUBTableStyleManager
 {
-  typedef std::unordered_map<EPUBCSSProperties, std::string, boost::hash<EPUBCSSProperties>> ContentNameMap_t;
+  //! the resolved class and style of a cell, empty until they are needed
+  struct CellTemplate
+  {
+    CellTemplate() : m_class(), m_style() {}
+
+    std::string m_class;
+    std::string m_style;
+  };
+
+  typedef std::unordered_map<std::string, CellTemplate> CellTemplateMap_t;
 
 public:
   //! constructor
-  EPUBTableStyleManager() : m_cellContentNameMap(), m_rowContentNameMap(), m_tableContentNameMap(), m_columnWidthsStack(), m_relColumnWidthsStack()
+  EPUBTableStyleManager() : m_cellContentNameMap("cellTable"), m_rowContentNameMap("rowTable"), m_tableContentNameMap("table"), m_columnWidthsStack(), m_relColumnWidthsStack(), m_cellTemplatesStack(), m_cellKey()
   {
   }
   //! destructor
@@ -55,6 +65,14 @@ public:
   std::string getTableClass(librevenge::RVNGPropertyList const &pList);
   //! returns the style string corresponding to a propertylist
   std::string getTableStyle(librevenge::RVNGPropertyList const &pList);
+  //! set how the classes are named
+  void setClassNamesMethod(EPUBClassNamesMethod method);
+  //! add the number of uses of each class to usage
+  void getUsage(librevenge::RVNGPropertyList &usage) const;
+  //! add the style cache hits and misses to statistics
+  void addStatistics(EPUBStatistics &statistics) const;
+  //! add the estimated memory of the classes to usage
+  void addMemoryUsage(EPUBMemoryUsage &usage) const;
   //! send the data to the sink
   void send(EPUBCSSContent &out);
 private:
@@ -68,16 +86,22 @@ private:
   bool getColumnsWidth(int i, int numSpanned, double &w) const;
   //! try to return the relative col width
   bool getRelColumnsWidth(int i, int numSpanned, double &w) const;
+  //! returns the cached cell of the actual table with the same column and properties, or 0 if the cell can't be cached
+  CellTemplate *findCellTemplate(librevenge::RVNGPropertyList const &pList);
   //! a map cell content -> name
-  ContentNameMap_t m_cellContentNameMap;
+  EPUBContentNameMap m_cellContentNameMap;
   //! a map row content -> name
-  ContentNameMap_t m_rowContentNameMap;
+  EPUBContentNameMap m_rowContentNameMap;
   //! a map table content -> name
-  ContentNameMap_t m_tableContentNameMap;
+  EPUBContentNameMap m_tableContentNameMap;
   //! a stack of column width (in inches )
   std::vector<std::vector<double> > m_columnWidthsStack;
   //! a stack of relative column width (in percents )
   std::vector<std::vector<double> > m_relColumnWidthsStack;
+  //! a stack of resolved cells, one map per table: rows of large tables mostly repeat the same cells
+  std::vector<CellTemplateMap_t> m_cellTemplatesStack;
+  //! buffer for the key of a cell, reused to avoid allocations
+  std::string m_cellKey;
 
   EPUBTableStyleManager(EPUBTableStyleManager const &orig);
   EPUBTableStyleManager operator=(EPUBTableStyleManager const &orig);
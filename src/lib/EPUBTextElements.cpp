@@ -10,6 +10,7 @@
 #include "EPUBTextElements.h"
 
 #include "libepubgen_utils.h"
+#include "EPUBMemoryUsage.h"
 
 namespace libepubgen
 {
@@ -65,6 +66,14 @@ public:
   void write(librevenge::RVNGTextInterface *iface) const override;
 };
 
+class CloseGroupElement : public EPUBTextElement
+{
+public:
+  CloseGroupElement() {}
+  ~CloseGroupElement() override {}
+  void write(librevenge::RVNGTextInterface *iface) const override;
+};
+
 class CloseHeaderElement : public EPUBTextElement
 {
 public:
@@ -109,6 +118,14 @@ public:
   }
 };
 
+class ClosePageSpanElement : public EPUBTextElement
+{
+public:
+  ClosePageSpanElement() {}
+  ~ClosePageSpanElement() override {}
+  void write(librevenge::RVNGTextInterface *iface) const override;
+};
+
 class CloseParagraphElement : public EPUBTextElement
 {
 public:
@@ -121,6 +138,14 @@ public:
   }
 };
 
+class CloseSectionElement : public EPUBTextElement
+{
+public:
+  CloseSectionElement() {}
+  ~CloseSectionElement() override {}
+  void write(librevenge::RVNGTextInterface *iface) const override;
+};
+
 class CloseSpanElement : public EPUBTextElement
 {
 public:
@@ -169,6 +194,14 @@ public:
   }
 };
 
+class CloseTextBoxElement : public EPUBTextElement
+{
+public:
+  CloseTextBoxElement() {}
+  ~CloseTextBoxElement() override {}
+  void write(librevenge::RVNGTextInterface *iface) const override;
+};
+
 class CloseUnorderedListLevelElement : public EPUBTextElement
 {
 public:
@@ -181,6 +214,146 @@ public:
   }
 };
 
+class DefineCharacterStyleElement : public EPUBTextElement
+{
+public:
+  DefineCharacterStyleElement(const librevenge::RVNGPropertyList &propList) :
+    m_propList(propList) {}
+  ~DefineCharacterStyleElement() override {}
+  void write(librevenge::RVNGTextInterface *iface) const override;
+private:
+  librevenge::RVNGPropertyList m_propList;
+};
+
+class DefineEmbeddedFontElement : public EPUBTextElement
+{
+public:
+  DefineEmbeddedFontElement(const librevenge::RVNGPropertyList &propList) :
+    m_propList(propList) {}
+  ~DefineEmbeddedFontElement() override {}
+  void write(librevenge::RVNGTextInterface *iface) const override;
+private:
+  librevenge::RVNGPropertyList m_propList;
+};
+
+class DefineGraphicStyleElement : public EPUBTextElement
+{
+public:
+  DefineGraphicStyleElement(const librevenge::RVNGPropertyList &propList) :
+    m_propList(propList) {}
+  ~DefineGraphicStyleElement() override {}
+  void write(librevenge::RVNGTextInterface *iface) const override;
+private:
+  librevenge::RVNGPropertyList m_propList;
+};
+
+class DefinePageStyleElement : public EPUBTextElement
+{
+public:
+  DefinePageStyleElement(const librevenge::RVNGPropertyList &propList) :
+    m_propList(propList) {}
+  ~DefinePageStyleElement() override {}
+  void write(librevenge::RVNGTextInterface *iface) const override;
+private:
+  librevenge::RVNGPropertyList m_propList;
+};
+
+class DefineParagraphStyleElement : public EPUBTextElement
+{
+public:
+  DefineParagraphStyleElement(const librevenge::RVNGPropertyList &propList) :
+    m_propList(propList) {}
+  ~DefineParagraphStyleElement() override {}
+  void write(librevenge::RVNGTextInterface *iface) const override;
+private:
+  librevenge::RVNGPropertyList m_propList;
+};
+
+class DefineSectionStyleElement : public EPUBTextElement
+{
+public:
+  DefineSectionStyleElement(const librevenge::RVNGPropertyList &propList) :
+    m_propList(propList) {}
+  ~DefineSectionStyleElement() override {}
+  void write(librevenge::RVNGTextInterface *iface) const override;
+private:
+  librevenge::RVNGPropertyList m_propList;
+};
+
+class DrawConnectorElement : public EPUBTextElement
+{
+public:
+  DrawConnectorElement(const librevenge::RVNGPropertyList &propList) :
+    m_propList(propList) {}
+  ~DrawConnectorElement() override {}
+  void write(librevenge::RVNGTextInterface *iface) const override;
+private:
+  librevenge::RVNGPropertyList m_propList;
+};
+
+class DrawEllipseElement : public EPUBTextElement
+{
+public:
+  DrawEllipseElement(const librevenge::RVNGPropertyList &propList) :
+    m_propList(propList) {}
+  ~DrawEllipseElement() override {}
+  void write(librevenge::RVNGTextInterface *iface) const override;
+private:
+  librevenge::RVNGPropertyList m_propList;
+};
+
+class DrawPathElement : public EPUBTextElement
+{
+public:
+  DrawPathElement(const librevenge::RVNGPropertyList &propList) :
+    m_propList(propList) {}
+  ~DrawPathElement() override {}
+  void write(librevenge::RVNGTextInterface *iface) const override;
+private:
+  librevenge::RVNGPropertyList m_propList;
+};
+
+class DrawPolygonElement : public EPUBTextElement
+{
+public:
+  DrawPolygonElement(const librevenge::RVNGPropertyList &propList) :
+    m_propList(propList) {}
+  ~DrawPolygonElement() override {}
+  void write(librevenge::RVNGTextInterface *iface) const override;
+private:
+  librevenge::RVNGPropertyList m_propList;
+};
+
+class DrawPolylineElement : public EPUBTextElement
+{
+public:
+  DrawPolylineElement(const librevenge::RVNGPropertyList &propList) :
+    m_propList(propList) {}
+  ~DrawPolylineElement() override {}
+  void write(librevenge::RVNGTextInterface *iface) const override;
+private:
+  librevenge::RVNGPropertyList m_propList;
+};
+
+class DrawRectangleElement : public EPUBTextElement
+{
+public:
+  DrawRectangleElement(const librevenge::RVNGPropertyList &propList) :
+    m_propList(propList) {}
+  ~DrawRectangleElement() override {}
+  void write(librevenge::RVNGTextInterface *iface) const override;
+private:
+  librevenge::RVNGPropertyList m_propList;
+};
+
+class EndDocumentElement : public EPUBTextElement
+{
+public:
+  EndDocumentElement() {}
+  ~EndDocumentElement() override {}
+  void write(librevenge::RVNGTextInterface *iface) const override;
+};
+
 class InsertBinaryObjectElement : public EPUBTextElement
 {
 public:
@@ -367,6 +540,17 @@ private:
   librevenge::RVNGPropertyList m_propList;
 };
 
+class OpenGroupElement : public EPUBTextElement
+{
+public:
+  OpenGroupElement(const librevenge::RVNGPropertyList &propList) :
+    m_propList(propList) {}
+  ~OpenGroupElement() override {}
+  void write(librevenge::RVNGTextInterface *iface) const override;
+private:
+  librevenge::RVNGPropertyList m_propList;
+};
+
 class OpenHeaderElement : public EPUBTextElement
 {
 public:
@@ -415,6 +599,17 @@ private:
   librevenge::RVNGPropertyList m_propList;
 };
 
+class OpenPageSpanElement : public EPUBTextElement
+{
+public:
+  OpenPageSpanElement(const librevenge::RVNGPropertyList &propList) :
+    m_propList(propList) {}
+  ~OpenPageSpanElement() override {}
+  void write(librevenge::RVNGTextInterface *iface) const override;
+private:
+  librevenge::RVNGPropertyList m_propList;
+};
+
 class OpenParagraphElement : public EPUBTextElement
 {
 public:
@@ -426,6 +621,17 @@ private:
   librevenge::RVNGPropertyList m_propList;
 };
 
+class OpenSectionElement : public EPUBTextElement
+{
+public:
+  OpenSectionElement(const librevenge::RVNGPropertyList &propList) :
+    m_propList(propList) {}
+  ~OpenSectionElement() override {}
+  void write(librevenge::RVNGTextInterface *iface) const override;
+private:
+  librevenge::RVNGPropertyList m_propList;
+};
+
 class OpenSpanElement : public EPUBTextElement
 {
 public:
@@ -470,6 +676,17 @@ private:
   librevenge::RVNGPropertyList m_propList;
 };
 
+class OpenTextBoxElement : public EPUBTextElement
+{
+public:
+  OpenTextBoxElement(const librevenge::RVNGPropertyList &propList) :
+    m_propList(propList) {}
+  ~OpenTextBoxElement() override {}
+  void write(librevenge::RVNGTextInterface *iface) const override;
+private:
+  librevenge::RVNGPropertyList m_propList;
+};
+
 class OpenUnorderedListLevelElement : public EPUBTextElement
 {
 public:
@@ -481,6 +698,28 @@ private:
   librevenge::RVNGPropertyList m_propList;
 };
 
+class SetDocumentMetaDataElement : public EPUBTextElement
+{
+public:
+  SetDocumentMetaDataElement(const librevenge::RVNGPropertyList &propList) :
+    m_propList(propList) {}
+  ~SetDocumentMetaDataElement() override {}
+  void write(librevenge::RVNGTextInterface *iface) const override;
+private:
+  librevenge::RVNGPropertyList m_propList;
+};
+
+class StartDocumentElement : public EPUBTextElement
+{
+public:
+  StartDocumentElement(const librevenge::RVNGPropertyList &propList) :
+    m_propList(propList) {}
+  ~StartDocumentElement() override {}
+  void write(librevenge::RVNGTextInterface *iface) const override;
+private:
+  librevenge::RVNGPropertyList m_propList;
+};
+
 void CloseCommentElement::write(librevenge::RVNGTextInterface *iface) const
 {
   if (iface)
@@ -512,6 +751,12 @@ void CloseFrameElement::write(librevenge::RVNGTextInterface *iface) const
 }
 
 
+void CloseGroupElement::write(librevenge::RVNGTextInterface *iface) const
+{
+  if (iface)
+    iface->closeGroup();
+}
+
 void CloseHeaderElement::write(librevenge::RVNGTextInterface *iface) const
 {
   if (iface)
@@ -536,12 +781,24 @@ void CloseOrderedListLevelElement::write(librevenge::RVNGTextInterface *iface) c
     iface->closeOrderedListLevel();
 }
 
+void ClosePageSpanElement::write(librevenge::RVNGTextInterface *iface) const
+{
+  if (iface)
+    iface->closePageSpan();
+}
+
 void CloseParagraphElement::write(librevenge::RVNGTextInterface *iface) const
 {
   if (iface)
     iface->closeParagraph();
 }
 
+void CloseSectionElement::write(librevenge::RVNGTextInterface *iface) const
+{
+  if (iface)
+    iface->closeSection();
+}
+
 void CloseSpanElement::write(librevenge::RVNGTextInterface *iface) const
 {
   if (iface)
@@ -566,12 +823,96 @@ void CloseTableRowElement::write(librevenge::RVNGTextInterface *iface) const
     iface->closeTableRow();
 }
 
+void CloseTextBoxElement::write(librevenge::RVNGTextInterface *iface) const
+{
+  if (iface)
+    iface->closeTextBox();
+}
+
 void CloseUnorderedListLevelElement::write(librevenge::RVNGTextInterface *iface) const
 {
   if (iface)
     iface->closeUnorderedListLevel();
 }
 
+void DefineCharacterStyleElement::write(librevenge::RVNGTextInterface *iface) const
+{
+  if (iface)
+    iface->defineCharacterStyle(m_propList);
+}
+
+void DefineEmbeddedFontElement::write(librevenge::RVNGTextInterface *iface) const
+{
+  if (iface)
+    iface->defineEmbeddedFont(m_propList);
+}
+
+void DefineGraphicStyleElement::write(librevenge::RVNGTextInterface *iface) const
+{
+  if (iface)
+    iface->defineGraphicStyle(m_propList);
+}
+
+void DefinePageStyleElement::write(librevenge::RVNGTextInterface *iface) const
+{
+  if (iface)
+    iface->definePageStyle(m_propList);
+}
+
+void DefineParagraphStyleElement::write(librevenge::RVNGTextInterface *iface) const
+{
+  if (iface)
+    iface->defineParagraphStyle(m_propList);
+}
+
+void DefineSectionStyleElement::write(librevenge::RVNGTextInterface *iface) const
+{
+  if (iface)
+    iface->defineSectionStyle(m_propList);
+}
+
+void DrawConnectorElement::write(librevenge::RVNGTextInterface *iface) const
+{
+  if (iface)
+    iface->drawConnector(m_propList);
+}
+
+void DrawEllipseElement::write(librevenge::RVNGTextInterface *iface) const
+{
+  if (iface)
+    iface->drawEllipse(m_propList);
+}
+
+void DrawPathElement::write(librevenge::RVNGTextInterface *iface) const
+{
+  if (iface)
+    iface->drawPath(m_propList);
+}
+
+void DrawPolygonElement::write(librevenge::RVNGTextInterface *iface) const
+{
+  if (iface)
+    iface->drawPolygon(m_propList);
+}
+
+void DrawPolylineElement::write(librevenge::RVNGTextInterface *iface) const
+{
+  if (iface)
+    iface->drawPolyline(m_propList);
+}
+
+void DrawRectangleElement::write(librevenge::RVNGTextInterface *iface) const
+{
+  if (iface)
+    iface->drawRectangle(m_propList);
+}
+
+void EndDocumentElement::write(librevenge::RVNGTextInterface *iface) const
+{
+  if (iface)
+    iface->endDocument();
+}
+
 void InsertBinaryObjectElement::write(librevenge::RVNGTextInterface *iface) const
 {
   if (iface)
@@ -650,6 +991,12 @@ void OpenFrameElement::write(librevenge::RVNGTextInterface *iface) const
     iface->openFrame(m_propList);
 }
 
+void OpenGroupElement::write(librevenge::RVNGTextInterface *iface) const
+{
+  if (iface)
+    iface->openGroup(m_propList);
+}
+
 void OpenHeaderElement::write(librevenge::RVNGTextInterface *iface) const
 {
   if (iface)
@@ -674,12 +1021,24 @@ void OpenOrderedListLevelElement::write(librevenge::RVNGTextInterface *iface) co
     iface->openOrderedListLevel(m_propList);
 }
 
+void OpenPageSpanElement::write(librevenge::RVNGTextInterface *iface) const
+{
+  if (iface)
+    iface->openPageSpan(m_propList);
+}
+
 void OpenParagraphElement::write(librevenge::RVNGTextInterface *iface) const
 {
   if (iface)
     iface->openParagraph(m_propList);
 }
 
+void OpenSectionElement::write(librevenge::RVNGTextInterface *iface) const
+{
+  if (iface)
+    iface->openSection(m_propList);
+}
+
 void OpenSpanElement::write(librevenge::RVNGTextInterface *iface) const
 {
   if (iface)
@@ -704,16 +1063,35 @@ void OpenTableRowElement::write(librevenge::RVNGTextInterface *iface) const
     iface->openTableRow(m_propList);
 }
 
+void OpenTextBoxElement::write(librevenge::RVNGTextInterface *iface) const
+{
+  if (iface)
+    iface->openTextBox(m_propList);
+}
+
 void OpenUnorderedListLevelElement::write(librevenge::RVNGTextInterface *iface) const
 {
   if (iface)
     iface->openUnorderedListLevel(m_propList);
 }
 
+void SetDocumentMetaDataElement::write(librevenge::RVNGTextInterface *iface) const
+{
+  if (iface)
+    iface->setDocumentMetaData(m_propList);
+}
+
+void StartDocumentElement::write(librevenge::RVNGTextInterface *iface) const
+{
+  if (iface)
+    iface->startDocument(m_propList);
+}
+
 }
 
 EPUBTextElements::EPUBTextElements()
   : m_elements()
+  , m_memory(0)
 {
 }
 
@@ -727,194 +1105,321 @@ void EPUBTextElements::write(librevenge::RVNGTextInterface *iface) const
     element->write(iface);
 }
 
+std::size_t EPUBTextElements::getMemory() const
+{
+  return m_memory;
+}
+
+template<class T>
+void EPUBTextElements::add(std::unique_ptr<T> element, const std::size_t dataMemory)
+{
+  m_elements.push_back(std::move(element));
+  m_memory += sizeof(T) + sizeof(std::unique_ptr<EPUBTextElement>) + dataMemory;
+}
+
 void EPUBTextElements::addCloseComment()
 {
-  m_elements.push_back(make_unique<CloseCommentElement>());
+  add(make_unique<CloseCommentElement>());
 }
 
 void EPUBTextElements::addCloseEndnote()
 {
-  m_elements.push_back(make_unique<CloseEndnoteElement>());
+  add(make_unique<CloseEndnoteElement>());
 }
 
 void EPUBTextElements::addCloseFooter()
 {
-  m_elements.push_back(make_unique<CloseFooterElement>());
+  add(make_unique<CloseFooterElement>());
 }
 
 void EPUBTextElements::addCloseFootnote()
 {
-  m_elements.push_back(make_unique<CloseFootnoteElement>());
+  add(make_unique<CloseFootnoteElement>());
 }
 
 void EPUBTextElements::addCloseFrame()
 {
-  m_elements.push_back(make_unique<CloseFrameElement>());
+  add(make_unique<CloseFrameElement>());
+}
+
+void EPUBTextElements::addCloseGroup()
+{
+  add(make_unique<CloseGroupElement>());
 }
 
 void EPUBTextElements::addCloseHeader()
 {
-  m_elements.push_back(make_unique<CloseHeaderElement>());
+  add(make_unique<CloseHeaderElement>());
 }
 
 void EPUBTextElements::addCloseLink()
 {
-  m_elements.push_back(make_unique<CloseLinkElement>());
+  add(make_unique<CloseLinkElement>());
 }
 
 void EPUBTextElements::addCloseListElement()
 {
-  m_elements.push_back(make_unique<CloseListElementElement>());
+  add(make_unique<CloseListElementElement>());
 }
 
 void EPUBTextElements::addCloseOrderedListLevel()
 {
-  m_elements.push_back(make_unique<CloseOrderedListLevelElement>());
+  add(make_unique<CloseOrderedListLevelElement>());
+}
+
+void EPUBTextElements::addClosePageSpan()
+{
+  add(make_unique<ClosePageSpanElement>());
 }
 
 void EPUBTextElements::addCloseParagraph()
 {
-  m_elements.push_back(make_unique<CloseParagraphElement>());
+  add(make_unique<CloseParagraphElement>());
+}
+
+void EPUBTextElements::addCloseSection()
+{
+  add(make_unique<CloseSectionElement>());
 }
 
 void EPUBTextElements::addCloseSpan()
 {
-  m_elements.push_back(make_unique<CloseSpanElement>());
+  add(make_unique<CloseSpanElement>());
 }
 
 void EPUBTextElements::addCloseTable()
 {
-  m_elements.push_back(make_unique<CloseTableElement>());
+  add(make_unique<CloseTableElement>());
 }
 
 void EPUBTextElements::addCloseTableCell()
 {
-  m_elements.push_back(make_unique<CloseTableCellElement>());
+  add(make_unique<CloseTableCellElement>());
 }
 
 void EPUBTextElements::addCloseTableRow()
 {
-  m_elements.push_back(make_unique<CloseTableRowElement>());
+  add(make_unique<CloseTableRowElement>());
+}
+
+void EPUBTextElements::addCloseTextBox()
+{
+  add(make_unique<CloseTextBoxElement>());
 }
 
 void EPUBTextElements::addCloseUnorderedListLevel()
 {
-  m_elements.push_back(make_unique<CloseUnorderedListLevelElement>());
+  add(make_unique<CloseUnorderedListLevelElement>());
+}
+
+void EPUBTextElements::addDefineCharacterStyle(const librevenge::RVNGPropertyList &propList)
+{
+  add(make_unique<DefineCharacterStyleElement>(propList), estimateMemory(propList));
+}
+
+void EPUBTextElements::addDefineEmbeddedFont(const librevenge::RVNGPropertyList &propList)
+{
+  add(make_unique<DefineEmbeddedFontElement>(propList), estimateMemory(propList));
+}
+
+void EPUBTextElements::addDefineGraphicStyle(const librevenge::RVNGPropertyList &propList)
+{
+  add(make_unique<DefineGraphicStyleElement>(propList), estimateMemory(propList));
+}
+
+void EPUBTextElements::addDefinePageStyle(const librevenge::RVNGPropertyList &propList)
+{
+  add(make_unique<DefinePageStyleElement>(propList), estimateMemory(propList));
+}
+
+void EPUBTextElements::addDefineParagraphStyle(const librevenge::RVNGPropertyList &propList)
+{
+  add(make_unique<DefineParagraphStyleElement>(propList), estimateMemory(propList));
+}
+
+void EPUBTextElements::addDefineSectionStyle(const librevenge::RVNGPropertyList &propList)
+{
+  add(make_unique<DefineSectionStyleElement>(propList), estimateMemory(propList));
+}
+
+void EPUBTextElements::addDrawConnector(const librevenge::RVNGPropertyList &propList)
+{
+  add(make_unique<DrawConnectorElement>(propList), estimateMemory(propList));
+}
+
+void EPUBTextElements::addDrawEllipse(const librevenge::RVNGPropertyList &propList)
+{
+  add(make_unique<DrawEllipseElement>(propList), estimateMemory(propList));
+}
+
+void EPUBTextElements::addDrawPath(const librevenge::RVNGPropertyList &propList)
+{
+  add(make_unique<DrawPathElement>(propList), estimateMemory(propList));
+}
+
+void EPUBTextElements::addDrawPolygon(const librevenge::RVNGPropertyList &propList)
+{
+  add(make_unique<DrawPolygonElement>(propList), estimateMemory(propList));
+}
+
+void EPUBTextElements::addDrawPolyline(const librevenge::RVNGPropertyList &propList)
+{
+  add(make_unique<DrawPolylineElement>(propList), estimateMemory(propList));
+}
+
+void EPUBTextElements::addDrawRectangle(const librevenge::RVNGPropertyList &propList)
+{
+  add(make_unique<DrawRectangleElement>(propList), estimateMemory(propList));
+}
+
+void EPUBTextElements::addEndDocument()
+{
+  add(make_unique<EndDocumentElement>());
 }
 
 void EPUBTextElements::addInsertBinaryObject(const librevenge::RVNGPropertyList &propList)
 {
-  m_elements.push_back(make_unique<InsertBinaryObjectElement>(propList));
+  add(make_unique<InsertBinaryObjectElement>(propList), estimateMemory(propList));
 }
 
 void EPUBTextElements::addInsertCoveredTableCell(const librevenge::RVNGPropertyList &propList)
 {
-  m_elements.push_back(make_unique<InsertCoveredTableCellElement>(propList));
+  add(make_unique<InsertCoveredTableCellElement>(propList), estimateMemory(propList));
 }
 
 void EPUBTextElements::addInsertEquation(const librevenge::RVNGPropertyList &propList)
 {
-  m_elements.push_back(make_unique<InsertEquationElement>(propList));
+  add(make_unique<InsertEquationElement>(propList), estimateMemory(propList));
 }
 
 void EPUBTextElements::addInsertField(const librevenge::RVNGPropertyList &propList)
 {
-  m_elements.push_back(make_unique<InsertFieldElement>(propList));
+  add(make_unique<InsertFieldElement>(propList), estimateMemory(propList));
 }
 
 void EPUBTextElements::addInsertLineBreak()
 {
-  m_elements.push_back(make_unique<InsertLineBreakElement>());
+  add(make_unique<InsertLineBreakElement>());
 }
 
 void EPUBTextElements::addInsertSpace()
 {
-  m_elements.push_back(make_unique<InsertSpaceElement>());
+  add(make_unique<InsertSpaceElement>());
 }
 
 void EPUBTextElements::addInsertTab()
 {
-  m_elements.push_back(make_unique<InsertTabElement>());
+  add(make_unique<InsertTabElement>());
 }
 
 void EPUBTextElements::addInsertText(const librevenge::RVNGString &text)
 {
-  m_elements.push_back(make_unique<InsertTextElement>(text));
+  add(make_unique<InsertTextElement>(text), sizeof(std::string) + estimateMemory(text.size()));
 }
 
 void EPUBTextElements::addOpenComment(const librevenge::RVNGPropertyList &propList)
 {
-  m_elements.push_back(make_unique<OpenCommentElement>(propList));
+  add(make_unique<OpenCommentElement>(propList), estimateMemory(propList));
 }
 
 void EPUBTextElements::addOpenEndnote(const librevenge::RVNGPropertyList &propList)
 {
-  m_elements.push_back(make_unique<OpenEndnoteElement>(propList));
+  add(make_unique<OpenEndnoteElement>(propList), estimateMemory(propList));
 }
 
 void EPUBTextElements::addOpenFooter(const librevenge::RVNGPropertyList &propList)
 {
-  m_elements.push_back(make_unique<OpenFooterElement>(propList));
+  add(make_unique<OpenFooterElement>(propList), estimateMemory(propList));
 }
 
 void EPUBTextElements::addOpenFootnote(const librevenge::RVNGPropertyList &propList)
 {
-  m_elements.push_back(make_unique<OpenFootnoteElement>(propList));
+  add(make_unique<OpenFootnoteElement>(propList), estimateMemory(propList));
+}
+
+void EPUBTextElements::addOpenGroup(const librevenge::RVNGPropertyList &propList)
+{
+  add(make_unique<OpenGroupElement>(propList), estimateMemory(propList));
 }
 
 void EPUBTextElements::addOpenHeader(const librevenge::RVNGPropertyList &propList)
 {
-  m_elements.push_back(make_unique<OpenHeaderElement>(propList));
+  add(make_unique<OpenHeaderElement>(propList), estimateMemory(propList));
 }
 
 void EPUBTextElements::addOpenFrame(const librevenge::RVNGPropertyList &propList)
 {
-  m_elements.push_back(make_unique<OpenFrameElement>(propList));
+  add(make_unique<OpenFrameElement>(propList), estimateMemory(propList));
 }
 
 void EPUBTextElements::addOpenLink(const librevenge::RVNGPropertyList &propList)
 {
-  m_elements.push_back(make_unique<OpenLinkElement>(propList));
+  add(make_unique<OpenLinkElement>(propList), estimateMemory(propList));
 }
 
 void EPUBTextElements::addOpenListElement(const librevenge::RVNGPropertyList &propList)
 {
-  m_elements.push_back(make_unique<OpenListElementElement>(propList));
+  add(make_unique<OpenListElementElement>(propList), estimateMemory(propList));
 }
 
 void EPUBTextElements::addOpenOrderedListLevel(const librevenge::RVNGPropertyList &propList)
 {
-  m_elements.push_back(make_unique<OpenOrderedListLevelElement>(propList));
+  add(make_unique<OpenOrderedListLevelElement>(propList), estimateMemory(propList));
+}
+
+void EPUBTextElements::addOpenPageSpan(const librevenge::RVNGPropertyList &propList)
+{
+  add(make_unique<OpenPageSpanElement>(propList), estimateMemory(propList));
 }
 
 void EPUBTextElements::addOpenParagraph(const librevenge::RVNGPropertyList &propList)
 {
-  m_elements.push_back(make_unique<OpenParagraphElement>(propList));
+  add(make_unique<OpenParagraphElement>(propList), estimateMemory(propList));
+}
+
+void EPUBTextElements::addOpenSection(const librevenge::RVNGPropertyList &propList)
+{
+  add(make_unique<OpenSectionElement>(propList), estimateMemory(propList));
 }
 
 void EPUBTextElements::addOpenSpan(const librevenge::RVNGPropertyList &propList)
 {
-  m_elements.push_back(make_unique<OpenSpanElement>(propList));
+  add(make_unique<OpenSpanElement>(propList), estimateMemory(propList));
 }
 
 void EPUBTextElements::addOpenTable(const librevenge::RVNGPropertyList &propList)
 {
-  m_elements.push_back(make_unique<OpenTableElement>(propList));
+  add(make_unique<OpenTableElement>(propList), estimateMemory(propList));
 }
 
 void EPUBTextElements::addOpenTableCell(const librevenge::RVNGPropertyList &propList)
 {
-  m_elements.push_back(make_unique<OpenTableCellElement>(propList));
+  add(make_unique<OpenTableCellElement>(propList), estimateMemory(propList));
 }
 
 void EPUBTextElements::addOpenTableRow(const librevenge::RVNGPropertyList &propList)
 {
-  m_elements.push_back(make_unique<OpenTableRowElement>(propList));
+  add(make_unique<OpenTableRowElement>(propList), estimateMemory(propList));
+}
+
+void EPUBTextElements::addOpenTextBox(const librevenge::RVNGPropertyList &propList)
+{
+  add(make_unique<OpenTextBoxElement>(propList), estimateMemory(propList));
 }
 
 void EPUBTextElements::addOpenUnorderedListLevel(const librevenge::RVNGPropertyList &propList)
 {
-  m_elements.push_back(make_unique<OpenUnorderedListLevelElement>(propList));
+  add(make_unique<OpenUnorderedListLevelElement>(propList), estimateMemory(propList));
+}
+
+void EPUBTextElements::addSetDocumentMetaData(const librevenge::RVNGPropertyList &propList)
+{
+  add(make_unique<SetDocumentMetaDataElement>(propList), estimateMemory(propList));
+}
+
+void EPUBTextElements::addStartDocument(const librevenge::RVNGPropertyList &propList)
+{
+  add(make_unique<StartDocumentElement>(propList), estimateMemory(propList));
 }
 
 }
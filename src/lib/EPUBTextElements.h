@@ -10,6 +10,7 @@
 #ifndef INCLUDED_EPUBTEXTELEMENTS_H
 #define INCLUDED_EPUBTEXTELEMENTS_H
 
+#include <cstddef>
 #include <deque>
 #include <memory>
 
@@ -39,16 +40,33 @@ public:
   void addCloseFooter();
   void addCloseFootnote();
   void addCloseFrame();
+  void addCloseGroup();
   void addCloseHeader();
   void addCloseLink();
   void addCloseListElement();
   void addCloseOrderedListLevel();
+  void addClosePageSpan();
   void addCloseParagraph();
+  void addCloseSection();
   void addCloseSpan();
   void addCloseTable();
   void addCloseTableCell();
   void addCloseTableRow();
+  void addCloseTextBox();
   void addCloseUnorderedListLevel();
+  void addDefineCharacterStyle(const librevenge::RVNGPropertyList &propList);
+  void addDefineEmbeddedFont(const librevenge::RVNGPropertyList &propList);
+  void addDefineGraphicStyle(const librevenge::RVNGPropertyList &propList);
+  void addDefinePageStyle(const librevenge::RVNGPropertyList &propList);
+  void addDefineParagraphStyle(const librevenge::RVNGPropertyList &propList);
+  void addDefineSectionStyle(const librevenge::RVNGPropertyList &propList);
+  void addDrawConnector(const librevenge::RVNGPropertyList &propList);
+  void addDrawEllipse(const librevenge::RVNGPropertyList &propList);
+  void addDrawPath(const librevenge::RVNGPropertyList &propList);
+  void addDrawPolygon(const librevenge::RVNGPropertyList &propList);
+  void addDrawPolyline(const librevenge::RVNGPropertyList &propList);
+  void addDrawRectangle(const librevenge::RVNGPropertyList &propList);
+  void addEndDocument();
   void addInsertBinaryObject(const librevenge::RVNGPropertyList &propList);
   void addInsertCoveredTableCell(const librevenge::RVNGPropertyList &propList);
   void addInsertEquation(const librevenge::RVNGPropertyList &propList);
@@ -62,24 +80,39 @@ public:
   void addOpenFooter(const librevenge::RVNGPropertyList &propList);
   void addOpenFootnote(const librevenge::RVNGPropertyList &propList);
   void addOpenFrame(const librevenge::RVNGPropertyList &propList);
+  void addOpenGroup(const librevenge::RVNGPropertyList &propList);
   void addOpenHeader(const librevenge::RVNGPropertyList &propList);
   void addOpenLink(const librevenge::RVNGPropertyList &propList);
   void addOpenListElement(const librevenge::RVNGPropertyList &propList);
   void addOpenOrderedListLevel(const librevenge::RVNGPropertyList &propList);
+  void addOpenPageSpan(const librevenge::RVNGPropertyList &propList);
   void addOpenParagraph(const librevenge::RVNGPropertyList &propList);
+  void addOpenSection(const librevenge::RVNGPropertyList &propList);
   void addOpenSpan(const librevenge::RVNGPropertyList &propList);
   void addOpenTable(const librevenge::RVNGPropertyList &propList);
   void addOpenTableCell(const librevenge::RVNGPropertyList &propList);
   void addOpenTableRow(const librevenge::RVNGPropertyList &propList);
+  void addOpenTextBox(const librevenge::RVNGPropertyList &propList);
   void addOpenUnorderedListLevel(const librevenge::RVNGPropertyList &propList);
+  void addSetDocumentMetaData(const librevenge::RVNGPropertyList &propList);
+  void addStartDocument(const librevenge::RVNGPropertyList &propList);
 
   bool empty() const
   {
     return m_elements.empty();
   }
 
+  /// Estimated heap memory used by the elements, in bytes.
+  std::size_t getMemory() const;
+
+private:
+  /// Adds an element, with the estimated memory of its data.
+  template<class T>
+  void add(std::unique_ptr<T> element, std::size_t dataMemory = 0);
+
 private:
   std::deque<std::unique_ptr<EPUBTextElement>> m_elements;
+  std::size_t m_memory;
 };
 
 }
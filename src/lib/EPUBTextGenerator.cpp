@@ -9,6 +9,7 @@
 
 #include <libepubgen/EPUBTextGenerator.h>
 
+#include <algorithm>
 #include <cassert>
 #include <memory>
 #include <string>
@@ -20,7 +21,9 @@
 #include "EPUBHTMLGenerator.h"
 #include "EPUBHTMLManager.h"
 #include "EPUBSplitGuard.h"
+#include "EPUBSplitPlanner.h"
 #include "EPUBTextElements.h"
+#include "EPUBXMLContent.h"
 
 using std::shared_ptr;
 
@@ -41,6 +44,15 @@ namespace
 
 typedef std::unordered_map<std::string, EPUBEmbeddedImage> ImageHandlerMap_t;
 
+/// Tables and lists which can be split when they get too large.
+enum
+{
+  STRUCTURE_NONE,
+  STRUCTURE_TABLE,
+  STRUCTURE_ORDERED_LIST,
+  STRUCTURE_UNORDERED_LIST
+};
+
 const char *CORE_MEDIA_TYPES[] =
 {
   "image/gif",
@@ -68,8 +80,47 @@ struct EPUBTextGenerator::Impl : public EPUBGenerator
 private:
   void startHtmlFile() override;
   void endHtmlFile() override;
+  void addMemoryUsage(EPUBMemoryUsage &usage) const override;
 
 public:
+  /// Returns the list the current call must be recorded into, if any.
+  EPUBTextElements *getRecorder() const;
+
+  /** Starts a call of the generator.
+    *
+    * While the split plan is made, the call is only recorded by add.
+    *
+    * @return false if the call is not to be generated: the generation
+    *   is cancelled or the call is recorded for the split plan
+    */
+  template<typename... Params, typename... Args>
+  bool startCall(void (EPUBTextElements::*add)(Params...), const Args &... args)
+  {
+    if (isCancelled())
+      return false;
+    if (!m_planRecording)
+      return true;
+    (m_planRecording.get()->*add)(args...);
+    return false;
+  }
+
+  /// Records the current call by add, if it is in a header, a footer or a header row.
+  template<typename... Params, typename... Args>
+  void record(void (EPUBTextElements::*add)(Params...), const Args &... args)
+  {
+    if (EPUBTextElements *const recorder = getRecorder())
+      (recorder->*add)(args...);
+  }
+
+  /// Registers a table or list opened at the top level.
+  void openStructure(int type, const RVNGPropertyList &propList);
+  /// Closes the outermost table or list, moves to a new file and reopens it.
+  void splitStructure();
+  /// Moves to the next point of the split plan; true if the content is split there.
+  bool splitOnPlan();
+  /// Inserts text which is already recorded, if it had to be.
+  void insertText(const char *text, std::size_t length);
+
   bool m_inPageSpan;
   bool m_inHeader;
   bool m_inFooter;
@@ -83,6 +134,20 @@ public:
 
   bool m_breakAfterPara;
 
+  /// The type of the outermost open table or list.
+  int m_structureType;
+  RVNGPropertyList m_structureProps;
+  /// The number of elements of the outermost list so far.
+  int m_structureElements;
+  shared_ptr<EPUBTextElements> m_headerRows;
+  bool m_inHeaderRow;
+
+  EPUBSplitPlanMethod m_splitPlanMethod;
+  /// The document is recorded here until the split plan is made.
+  std::unique_ptr<EPUBTextElements> m_planRecording;
+  /// The recording, while it is replayed.
+  std::unique_ptr<EPUBTextElements> m_planReplay;
+
 private:
   // disable copying
   Impl(const Impl &);
@@ -100,6 +165,14 @@ EPUBTextGenerator::Impl::Impl(EPUBPackage *const package, int version)
   , m_currentHeaderOrFooter()
   , m_imageHandlers()
   , m_breakAfterPara(false)
+  , m_structureType(STRUCTURE_NONE)
+  , m_structureProps()
+  , m_structureElements(0)
+  , m_headerRows()
+  , m_inHeaderRow(false)
+  , m_splitPlanMethod(EPUB_SPLIT_PLAN_METHOD_GREEDY)
+  , m_planRecording()
+  , m_planReplay()
 {
 }
 
@@ -120,6 +193,85 @@ void EPUBTextGenerator::Impl::endHtmlFile()
     m_currentFooter->write(getHtml().get());
 }
 
+void EPUBTextGenerator::Impl::addMemoryUsage(EPUBMemoryUsage &usage) const
+{
+  for (const auto &recording : {m_currentHeader, m_currentFooter, m_headerRows})
+  {
+    if (bool(recording))
+      usage.m_current[EPUB_MEMORY_RECORDED] += recording->getMemory();
+  }
+  if (m_planRecording)
+    usage.m_current[EPUB_MEMORY_RECORDED] += m_planRecording->getMemory();
+  if (m_planReplay)
+    usage.m_current[EPUB_MEMORY_RECORDED] += m_planReplay->getMemory();
+}
+
+EPUBTextElements *EPUBTextGenerator::Impl::getRecorder() const
+{
+  if (m_inHeader || m_inFooter)
+    return m_currentHeaderOrFooter.get();
+  if (m_inHeaderRow)
+    return m_headerRows.get();
+  return nullptr;
+}
+
+void EPUBTextGenerator::Impl::insertText(const char *const text, const std::size_t length)
+{
+  getHtmlManager().getOutline().insertText(text, length);
+
+  getHtml()->insertText(text, length);
+  updateSplitSize();
+}
+
+void EPUBTextGenerator::Impl::openStructure(const int type, const RVNGPropertyList &propList)
+{
+  // Headers and footers are repeated in every file, they are never split.
+  if (m_inHeader || m_inFooter || (0 != getSplitGuard().getNestingLevel()))
+    return;
+  m_structureType = type;
+  m_structureProps = propList;
+  m_structureElements = 0;
+  m_headerRows.reset();
+}
+
+bool EPUBTextGenerator::Impl::splitOnPlan()
+{
+  // The planner doesn't see split points in headers and footers either.
+  return !m_inHeader && !m_inFooter && getSplitGuard().splitOnPlan();
+}
+
+void EPUBTextGenerator::Impl::splitStructure()
+{
+  switch (m_structureType)
+  {
+  case STRUCTURE_TABLE:
+    getHtml()->closeTable();
+    startNewHtmlFile(EPUB_SPLIT_REASON_SIZE);
+    getHtml()->openTable(m_structureProps);
+    if (bool(m_headerRows))
+      m_headerRows->write(getHtml().get());
+    break;
+  case STRUCTURE_ORDERED_LIST:
+  {
+    getHtml()->closeOrderedListLevel();
+    startNewHtmlFile(EPUB_SPLIT_REASON_SIZE);
+    // Continue the numbering.
+    RVNGPropertyList propList(m_structureProps);
+    const RVNGProperty *const startValue = m_structureProps["text:start-value"];
+    propList.insert("text:start-value", (startValue ? startValue->getInt() : 1) + m_structureElements);
+    getHtml()->openOrderedListLevel(propList);
+    break;
+  }
+  case STRUCTURE_UNORDERED_LIST:
+    getHtml()->closeUnorderedListLevel();
+    startNewHtmlFile(EPUB_SPLIT_REASON_SIZE);
+    getHtml()->openUnorderedListLevel(m_structureProps);
+    break;
+  default:
+    break;
+  }
+}
+
 EPUBTextGenerator::EPUBTextGenerator(EPUBPackage *const package, int version)
   : m_impl(new Impl(package, version))
 {
@@ -148,6 +300,16 @@ void EPUBTextGenerator::setSplitSize(const unsigned size)
   m_impl->getSplitGuard().setSplitSize(size);
 }
 
+void EPUBTextGenerator::setMaxSectionSize(const unsigned size)
+{
+  m_impl->getSplitGuard().setMaxSize(size);
+}
+
+void EPUBTextGenerator::setMemoryBudget(const unsigned long budget)
+{
+  m_impl->setMemoryBudget(budget);
+}
+
 void EPUBTextGenerator::setOption(int key, int value)
 {
   switch (key)
@@ -161,6 +323,27 @@ void EPUBTextGenerator::setOption(int key, int value)
   case EPUB_GENERATOR_OPTION_LAYOUT:
     m_impl->setLayoutMethod(static_cast<EPUBLayoutMethod>(value));
     break;
+  case EPUB_GENERATOR_OPTION_STYLESHEET:
+    m_impl->setStylesheetMethod(static_cast<EPUBStylesheetMethod>(value));
+    break;
+  case EPUB_GENERATOR_OPTION_SPAN_STYLES:
+    m_impl->setSpanStylesMethod(static_cast<EPUBSpanStylesMethod>(value));
+    break;
+  case EPUB_GENERATOR_OPTION_CLASS_NAMES:
+    m_impl->setClassNamesMethod(static_cast<EPUBClassNamesMethod>(value));
+    break;
+  case EPUB_GENERATOR_OPTION_SPLIT_PLAN:
+    m_impl->m_splitPlanMethod = static_cast<EPUBSplitPlanMethod>(value);
+    break;
+  case EPUB_GENERATOR_OPTION_NOTES:
+    m_impl->setNotesMethod(static_cast<EPUBNotesMethod>(value));
+    break;
+  case EPUB_GENERATOR_OPTION_TOC:
+    m_impl->setTocMethod(static_cast<EPUBTocMethod>(value));
+    break;
+  case EPUB_GENERATOR_OPTION_OUTPUT:
+    m_impl->setOutputMethod(static_cast<EPUBOutputMethod>(value));
+    break;
   }
 }
 
@@ -177,8 +360,46 @@ void EPUBTextGenerator::registerEmbeddedObjectHandler(const librevenge::RVNGStri
   (void) objectHandler;
 }
 
+void EPUBTextGenerator::registerDiagnosticHandler(EPUBDiagnosticHandler diagnosticHandler)
+{
+  m_impl->setDiagnosticHandler(diagnosticHandler);
+}
+
+void EPUBTextGenerator::registerProgressHandler(EPUBProgressHandler progressHandler)
+{
+  m_impl->setProgressHandler(progressHandler);
+}
+
+bool EPUBTextGenerator::isCancelled() const
+{
+  return m_impl->isCancelled();
+}
+
+void EPUBTextGenerator::getStyleUsage(librevenge::RVNGPropertyList &usage) const
+{
+  m_impl->getStyleUsage(usage);
+}
+
+void EPUBTextGenerator::getSectionReport(librevenge::RVNGPropertyListVector &report) const
+{
+  m_impl->getSectionReport(report);
+}
+
+void EPUBTextGenerator::getStatistics(librevenge::RVNGPropertyList &statistics) const
+{
+  m_impl->getStatistics(statistics);
+}
+
+void EPUBTextGenerator::getMemoryUsage(librevenge::RVNGPropertyList &usage) const
+{
+  m_impl->getMemoryUsage(usage);
+}
+
 void EPUBTextGenerator::setDocumentMetaData(const librevenge::RVNGPropertyList &propList)
 {
+  if (!m_impl->startCall(&EPUBTextElements::addSetDocumentMetaData, propList))
+    return;
+
   m_impl->setDocumentMetaData(propList);
 
   m_impl->getHtml()->setDocumentMetaData(propList);
@@ -187,29 +408,54 @@ void EPUBTextGenerator::setDocumentMetaData(const librevenge::RVNGPropertyList &
 void EPUBTextGenerator::startDocument(const librevenge::RVNGPropertyList &propList)
 {
   m_impl->startDocument(propList);
+
+  // A fixed layout has a file per page, there is nothing to plan.
+  if ((m_impl->m_splitPlanMethod == EPUB_SPLIT_PLAN_METHOD_BALANCED) && (m_impl->getLayoutMethod() == EPUB_LAYOUT_METHOD_REFLOWABLE))
+    m_impl->m_planRecording.reset(new EPUBTextElements());
 }
 
 void EPUBTextGenerator::endDocument()
 {
+  if (m_impl->m_planRecording)
+  {
+    // Kept until the end, so the memory usage includes it.
+    m_impl->m_planReplay = std::move(m_impl->m_planRecording);
+    EPUBSplitGuard &splitGuard = m_impl->getSplitGuard();
+    EPUBSplitPlanner planner(splitGuard.getSplitMethod(), splitGuard.getSplitHeadingLevel(), splitGuard.getSplitSize());
+    m_impl->m_planReplay->write(&planner);
+    splitGuard.setPlan(planner.getPlan());
+    m_impl->m_planReplay->write(this);
+  }
+
   m_impl->endDocument();
+  m_impl->m_planReplay.reset();
 }
 
 void EPUBTextGenerator::definePageStyle(const librevenge::RVNGPropertyList &propList)
 {
+  if (!m_impl->startCall(&EPUBTextElements::addDefinePageStyle, propList))
+    return;
+
   m_impl->getHtml()->definePageStyle(propList);
 }
 
 void EPUBTextGenerator::defineEmbeddedFont(const librevenge::RVNGPropertyList &propList)
 {
+  if (!m_impl->startCall(&EPUBTextElements::addDefineEmbeddedFont, propList))
+    return;
+
   m_impl->getHtml()->defineEmbeddedFont(propList);
 }
 
 void EPUBTextGenerator::openPageSpan(const librevenge::RVNGPropertyList &propList)
 {
+  if (!m_impl->startCall(&EPUBTextElements::addOpenPageSpan, propList))
+    return;
+
   assert(!m_impl->m_inPageSpan);
 
   if (m_impl->getSplitGuard().splitOnSecondPageSpan())
-    m_impl->startNewHtmlFile();
+    m_impl->startNewHtmlFile(EPUB_SPLIT_REASON_SECOND_PAGE_SPAN);
 
   m_impl->m_inPageSpan = true;
   m_impl->m_pageSpanProps = propList;
@@ -220,6 +466,9 @@ void EPUBTextGenerator::openPageSpan(const librevenge::RVNGPropertyList &propLis
 
 void EPUBTextGenerator::closePageSpan()
 {
+  if (!m_impl->startCall(&EPUBTextElements::addClosePageSpan))
+    return;
+
   assert(m_impl->m_inPageSpan);
 
   m_impl->m_inPageSpan = false;
@@ -230,6 +479,9 @@ void EPUBTextGenerator::closePageSpan()
 
 void EPUBTextGenerator::openHeader(const librevenge::RVNGPropertyList &propList)
 {
+  if (!m_impl->startCall(&EPUBTextElements::addOpenHeader, propList))
+    return;
+
   m_impl->m_inHeader = true;
   m_impl->m_currentHeader.reset(new EPUBTextElements());
   m_impl->m_currentHeaderOrFooter = m_impl->m_currentHeader;
@@ -240,6 +492,9 @@ void EPUBTextGenerator::openHeader(const librevenge::RVNGPropertyList &propList)
 
 void EPUBTextGenerator::closeHeader()
 {
+  if (!m_impl->startCall(&EPUBTextElements::addCloseHeader))
+    return;
+
   m_impl->m_inHeader = false;
   m_impl->m_currentHeaderOrFooter->addCloseHeader();
   m_impl->m_currentHeaderOrFooter.reset();
@@ -249,6 +504,9 @@ void EPUBTextGenerator::closeHeader()
 
 void EPUBTextGenerator::openFooter(const librevenge::RVNGPropertyList &propList)
 {
+  if (!m_impl->startCall(&EPUBTextElements::addOpenFooter, propList))
+    return;
+
   m_impl->m_inFooter = true;
   m_impl->m_currentFooter.reset(new EPUBTextElements());
   m_impl->m_currentHeaderOrFooter = m_impl->m_currentFooter;
@@ -259,6 +517,9 @@ void EPUBTextGenerator::openFooter(const librevenge::RVNGPropertyList &propList)
 
 void EPUBTextGenerator::closeFooter()
 {
+  if (!m_impl->startCall(&EPUBTextElements::addCloseFooter))
+    return;
+
   m_impl->m_inFooter = false;
   m_impl->m_currentHeaderOrFooter->addCloseFooter();
   m_impl->m_currentHeaderOrFooter.reset();
@@ -269,26 +530,39 @@ void EPUBTextGenerator::closeFooter()
 
 void EPUBTextGenerator::defineParagraphStyle(const librevenge::RVNGPropertyList &propList)
 {
+  if (!m_impl->startCall(&EPUBTextElements::addDefineParagraphStyle, propList))
+    return;
+
   m_impl->getHtml()->defineParagraphStyle(propList);
 }
 
 void EPUBTextGenerator::openParagraph(const librevenge::RVNGPropertyList &propList)
 {
+  if (!m_impl->startCall(&EPUBTextElements::addOpenParagraph, propList))
+    return;
+  if (m_impl->splitOnPlan())
+    m_impl->startNewHtmlFile(EPUB_SPLIT_REASON_PLAN);
+
   const RVNGProperty *const breakBefore = propList["fo:break-before"];
   if (isPageBreak(breakBefore) && m_impl->getSplitGuard().splitOnPageBreak())
   {
-    m_impl->startNewHtmlFile();
+    m_impl->startNewHtmlFile(EPUB_SPLIT_REASON_PAGE_BREAK);
   }
   const RVNGProperty *const breakAfter = propList["fo:break-after"];
   m_impl->m_breakAfterPara = isPageBreak(breakAfter);
   if (m_impl->getSplitGuard().splitOnSize())
-    m_impl->startNewHtmlFile();
+    m_impl->startNewHtmlFile(EPUB_SPLIT_REASON_SIZE);
 
   // Handle split by chapters.
   const RVNGProperty *const outlineLevel = propList["text:outline-level"];
   if (outlineLevel && m_impl->getSplitGuard().splitOnHeading(outlineLevel->getInt()))
-    m_impl->startNewHtmlFile();
+    m_impl->startNewHtmlFile(EPUB_SPLIT_REASON_HEADING, outlineLevel->getInt());
   m_impl->getSplitGuard().setCurrentHeadingLevel(outlineLevel ? outlineLevel->getInt() : 0);
+  // Headers and footers are repeated in every file, their headings are not in the outline.
+  const bool inHeaderOrFooter = m_impl->m_inHeader || m_impl->m_inFooter;
+  EPUBOutline &outline = m_impl->getHtmlManager().getOutline();
+  if (outline.openParagraph((outlineLevel && !inHeaderOrFooter) ? outlineLevel->getInt() : 0) && m_impl->hasOutlineToc())
+    m_impl->getHtml()->setParagraphId(outline.getAnchor(outline.getHeadings().size() - 1));
 
   if (const librevenge::RVNGPropertyListVector *chapterNames = m_impl->m_pageSpanProps.child("librevenge:chapter-names"))
   {
@@ -305,244 +579,333 @@ void EPUBTextGenerator::openParagraph(const librevenge::RVNGPropertyList &propLi
 
   m_impl->getSplitGuard().openLevel();
 
-  if (m_impl->m_inHeader || m_impl->m_inFooter)
-    m_impl->m_currentHeaderOrFooter->addOpenParagraph(propList);
+  m_impl->record(&EPUBTextElements::addOpenParagraph, propList);
 
   m_impl->getHtml()->openParagraph(propList);
 }
 
 void EPUBTextGenerator::closeParagraph()
 {
+  if (!m_impl->startCall(&EPUBTextElements::addCloseParagraph))
+    return;
+
   m_impl->getSplitGuard().closeLevel();
+  m_impl->getHtmlManager().getOutline().closeParagraph();
 
-  if (m_impl->m_inHeader || m_impl->m_inFooter)
-    m_impl->m_currentHeaderOrFooter->addCloseParagraph();
+  m_impl->record(&EPUBTextElements::addCloseParagraph);
 
   m_impl->getHtml()->closeParagraph();
 
   if (m_impl->m_breakAfterPara && m_impl->getSplitGuard().splitOnPageBreak())
-    m_impl->startNewHtmlFile();
+    m_impl->startNewHtmlFile(EPUB_SPLIT_REASON_PAGE_BREAK);
   m_impl->m_breakAfterPara = false;
 }
 
 void EPUBTextGenerator::defineCharacterStyle(const librevenge::RVNGPropertyList &propList)
 {
+  if (!m_impl->startCall(&EPUBTextElements::addDefineCharacterStyle, propList))
+    return;
+
   m_impl->getHtml()->defineCharacterStyle(propList);
 }
 
 void EPUBTextGenerator::openSpan(const librevenge::RVNGPropertyList &propList)
 {
-  if (m_impl->m_inHeader || m_impl->m_inFooter)
-    m_impl->m_currentHeaderOrFooter->addOpenSpan(propList);
+  if (!m_impl->startCall(&EPUBTextElements::addOpenSpan, propList))
+    return;
+
+  m_impl->record(&EPUBTextElements::addOpenSpan, propList);
 
   m_impl->getHtml()->openSpan(propList);
 }
 
 void EPUBTextGenerator::closeSpan()
 {
-  if (m_impl->m_inHeader || m_impl->m_inFooter)
-    m_impl->m_currentHeaderOrFooter->addCloseSpan();
+  if (!m_impl->startCall(&EPUBTextElements::addCloseSpan))
+    return;
+
+  m_impl->record(&EPUBTextElements::addCloseSpan);
 
   m_impl->getHtml()->closeSpan();
 }
 
 void EPUBTextGenerator::openLink(const librevenge::RVNGPropertyList &propList)
 {
-  if (m_impl->m_inHeader || m_impl->m_inFooter)
-    m_impl->m_currentHeaderOrFooter->addOpenLink(propList);
+  if (!m_impl->startCall(&EPUBTextElements::addOpenLink, propList))
+    return;
+
+  m_impl->record(&EPUBTextElements::addOpenLink, propList);
 
   m_impl->getHtml()->openLink(propList);
 }
 
 void EPUBTextGenerator::closeLink()
 {
-  if (m_impl->m_inHeader || m_impl->m_inFooter)
-    m_impl->m_currentHeaderOrFooter->addCloseLink();
+  if (!m_impl->startCall(&EPUBTextElements::addCloseLink))
+    return;
+
+  m_impl->record(&EPUBTextElements::addCloseLink);
 
   m_impl->getHtml()->closeLink();
 }
 
 void EPUBTextGenerator::defineSectionStyle(const librevenge::RVNGPropertyList &propList)
 {
+  if (!m_impl->startCall(&EPUBTextElements::addDefineSectionStyle, propList))
+    return;
+
   m_impl->getHtml()->defineSectionStyle(propList);
 }
 
 void EPUBTextGenerator::openSection(const librevenge::RVNGPropertyList &propList)
 {
+  if (!m_impl->startCall(&EPUBTextElements::addOpenSection, propList))
+    return;
+
   if (m_impl->getSplitGuard().splitOnSize())
-    m_impl->startNewHtmlFile();
+    m_impl->startNewHtmlFile(EPUB_SPLIT_REASON_SIZE);
 
   m_impl->getHtml()->openSection(propList);
 }
 
 void EPUBTextGenerator::closeSection()
 {
+  if (!m_impl->startCall(&EPUBTextElements::addCloseSection))
+    return;
+
   m_impl->getHtml()->closeSection();
 }
 
 void EPUBTextGenerator::insertTab()
 {
-  if (m_impl->m_inHeader || m_impl->m_inFooter)
-    m_impl->m_currentHeaderOrFooter->addInsertTab();
+  if (!m_impl->startCall(&EPUBTextElements::addInsertTab))
+    return;
 
-  m_impl->getSplitGuard().incrementSize(1);
+  m_impl->record(&EPUBTextElements::addInsertTab);
 
   m_impl->getHtml()->insertTab();
+  m_impl->updateSplitSize();
 }
 
 void EPUBTextGenerator::insertSpace()
 {
-  if (m_impl->m_inHeader || m_impl->m_inFooter)
-    m_impl->m_currentHeaderOrFooter->addInsertSpace();
+  if (!m_impl->startCall(&EPUBTextElements::addInsertSpace))
+    return;
 
-  m_impl->getSplitGuard().incrementSize(1);
+  m_impl->record(&EPUBTextElements::addInsertSpace);
 
   m_impl->getHtml()->insertSpace();
+  m_impl->updateSplitSize();
 }
 
 void EPUBTextGenerator::insertText(const librevenge::RVNGString &text)
 {
-  if (m_impl->m_inHeader || m_impl->m_inFooter)
-    m_impl->m_currentHeaderOrFooter->addInsertText(text);
+  if (!m_impl->startCall(&EPUBTextElements::addInsertText, text))
+    return;
 
-  if (m_impl->getSplitGuard().inHeading(!m_impl->getHtmlManager().hasHeadingText()))
-    m_impl->getHtmlManager().insertHeadingText(text.cstr());
+  m_impl->record(&EPUBTextElements::addInsertText, text);
 
-  m_impl->getSplitGuard().incrementSize(text.len());
+  m_impl->insertText(text.cstr(), text.size());
+}
+
+void EPUBTextGenerator::insertText(const char *const text, const std::size_t length)
+{
+  if (m_impl->isCancelled())
+    return;
 
-  m_impl->getHtml()->insertText(text);
+  // Like a RVNGString, the text ends at a null character.
+  const std::size_t textLength = std::size_t(std::find(text, text + length, '\0') - text);
+
+  // The recordings keep their own copy of the text.
+  if (m_impl->m_planRecording || m_impl->getRecorder())
+  {
+    RVNGString copy;
+    appendCharacters(copy, text, textLength);
+    insertText(copy);
+    return;
+  }
+
+  m_impl->insertText(text, textLength);
 }
 
 void EPUBTextGenerator::insertLineBreak()
 {
-  if (m_impl->m_inHeader || m_impl->m_inFooter)
-    m_impl->m_currentHeaderOrFooter->addInsertLineBreak();
+  if (!m_impl->startCall(&EPUBTextElements::addInsertLineBreak))
+    return;
 
-  m_impl->getSplitGuard().incrementSize(1);
+  m_impl->record(&EPUBTextElements::addInsertLineBreak);
 
   m_impl->getHtml()->insertLineBreak();
+  m_impl->updateSplitSize();
 }
 
 void EPUBTextGenerator::insertField(const librevenge::RVNGPropertyList &propList)
 {
-  if (m_impl->m_inHeader || m_impl->m_inFooter)
-    m_impl->m_currentHeaderOrFooter->addInsertField(propList);
+  if (!m_impl->startCall(&EPUBTextElements::addInsertField, propList))
+    return;
+
+  m_impl->record(&EPUBTextElements::addInsertField, propList);
 
   m_impl->getHtml()->insertField(propList);
 }
 
 void EPUBTextGenerator::openOrderedListLevel(const librevenge::RVNGPropertyList &propList)
 {
+  if (!m_impl->startCall(&EPUBTextElements::addOpenOrderedListLevel, propList))
+    return;
+  if (m_impl->splitOnPlan())
+    m_impl->startNewHtmlFile(EPUB_SPLIT_REASON_PLAN);
+
   if (m_impl->getSplitGuard().splitOnSize())
-    m_impl->startNewHtmlFile();
+    m_impl->startNewHtmlFile(EPUB_SPLIT_REASON_SIZE);
+  m_impl->openStructure(STRUCTURE_ORDERED_LIST, propList);
   m_impl->getSplitGuard().openLevel();
 
-  if (m_impl->m_inHeader || m_impl->m_inFooter)
-    m_impl->m_currentHeaderOrFooter->addOpenOrderedListLevel(propList);
+  m_impl->record(&EPUBTextElements::addOpenOrderedListLevel, propList);
 
   m_impl->getHtml()->openOrderedListLevel(propList);
 }
 
 void EPUBTextGenerator::openUnorderedListLevel(const librevenge::RVNGPropertyList &propList)
 {
+  if (!m_impl->startCall(&EPUBTextElements::addOpenUnorderedListLevel, propList))
+    return;
+  if (m_impl->splitOnPlan())
+    m_impl->startNewHtmlFile(EPUB_SPLIT_REASON_PLAN);
+
   if (m_impl->getSplitGuard().splitOnSize())
-    m_impl->startNewHtmlFile();
+    m_impl->startNewHtmlFile(EPUB_SPLIT_REASON_SIZE);
+  m_impl->openStructure(STRUCTURE_UNORDERED_LIST, propList);
   m_impl->getSplitGuard().openLevel();
 
-  if (m_impl->m_inHeader || m_impl->m_inFooter)
-    m_impl->m_currentHeaderOrFooter->addOpenUnorderedListLevel(propList);
+  m_impl->record(&EPUBTextElements::addOpenUnorderedListLevel, propList);
 
   m_impl->getHtml()->openUnorderedListLevel(propList);
 }
 
 void EPUBTextGenerator::closeOrderedListLevel()
 {
+  if (!m_impl->startCall(&EPUBTextElements::addCloseOrderedListLevel))
+    return;
+
   m_impl->getSplitGuard().closeLevel();
+  if (0 == m_impl->getSplitGuard().getNestingLevel())
+    m_impl->m_structureType = STRUCTURE_NONE;
 
-  if (m_impl->m_inHeader || m_impl->m_inFooter)
-    m_impl->m_currentHeaderOrFooter->addCloseOrderedListLevel();
+  m_impl->record(&EPUBTextElements::addCloseOrderedListLevel);
 
   m_impl->getHtml()->closeOrderedListLevel();
 }
 
 void EPUBTextGenerator::closeUnorderedListLevel()
 {
+  if (!m_impl->startCall(&EPUBTextElements::addCloseUnorderedListLevel))
+    return;
+
   m_impl->getSplitGuard().closeLevel();
+  if (0 == m_impl->getSplitGuard().getNestingLevel())
+    m_impl->m_structureType = STRUCTURE_NONE;
 
-  if (m_impl->m_inHeader || m_impl->m_inFooter)
-    m_impl->m_currentHeaderOrFooter->addCloseUnorderedListLevel();
+  m_impl->record(&EPUBTextElements::addCloseUnorderedListLevel);
 
   m_impl->getHtml()->closeUnorderedListLevel();
 }
 
 void EPUBTextGenerator::openListElement(const librevenge::RVNGPropertyList &propList)
 {
-  if (m_impl->m_inHeader || m_impl->m_inFooter)
-    m_impl->m_currentHeaderOrFooter->addOpenListElement(propList);
+  if (!m_impl->startCall(&EPUBTextElements::addOpenListElement, propList))
+    return;
+
+  if ((m_impl->m_structureType == STRUCTURE_ORDERED_LIST) || (m_impl->m_structureType == STRUCTURE_UNORDERED_LIST))
+  {
+    if (m_impl->getSplitGuard().splitInStructure())
+      m_impl->splitStructure();
+    if (1 == m_impl->getSplitGuard().getNestingLevel())
+      ++m_impl->m_structureElements;
+  }
+
+  m_impl->record(&EPUBTextElements::addOpenListElement, propList);
 
   m_impl->getHtml()->openListElement(propList);
 }
 
 void EPUBTextGenerator::closeListElement()
 {
-  if (m_impl->m_inHeader || m_impl->m_inFooter)
-    m_impl->m_currentHeaderOrFooter->addCloseListElement();
+  if (!m_impl->startCall(&EPUBTextElements::addCloseListElement))
+    return;
+
+  m_impl->record(&EPUBTextElements::addCloseListElement);
 
   m_impl->getHtml()->closeListElement();
 }
 
 void EPUBTextGenerator::openFootnote(const librevenge::RVNGPropertyList &propList)
 {
-  if (m_impl->m_inHeader || m_impl->m_inFooter)
-    m_impl->m_currentHeaderOrFooter->addOpenFootnote(propList);
+  if (!m_impl->startCall(&EPUBTextElements::addOpenFootnote, propList))
+    return;
+
+  m_impl->record(&EPUBTextElements::addOpenFootnote, propList);
 
   m_impl->getHtml()->openFootnote(propList);
 }
 
 void EPUBTextGenerator::closeFootnote()
 {
-  if (m_impl->m_inHeader || m_impl->m_inFooter)
-    m_impl->m_currentHeaderOrFooter->addCloseFootnote();
+  if (!m_impl->startCall(&EPUBTextElements::addCloseFootnote))
+    return;
+
+  m_impl->record(&EPUBTextElements::addCloseFootnote);
 
   m_impl->getHtml()->closeFootnote();
 }
 
 void EPUBTextGenerator::openEndnote(const librevenge::RVNGPropertyList &propList)
 {
-  if (m_impl->m_inHeader || m_impl->m_inFooter)
-    m_impl->m_currentHeaderOrFooter->addOpenEndnote(propList);
+  if (!m_impl->startCall(&EPUBTextElements::addOpenEndnote, propList))
+    return;
+
+  m_impl->record(&EPUBTextElements::addOpenEndnote, propList);
 
   m_impl->getHtml()->openEndnote(propList);
 }
 
 void EPUBTextGenerator::closeEndnote()
 {
-  if (m_impl->m_inHeader || m_impl->m_inFooter)
-    m_impl->m_currentHeaderOrFooter->addCloseEndnote();
+  if (!m_impl->startCall(&EPUBTextElements::addCloseEndnote))
+    return;
+
+  m_impl->record(&EPUBTextElements::addCloseEndnote);
 
   m_impl->getHtml()->closeEndnote();
 }
 
 void EPUBTextGenerator::openComment(const librevenge::RVNGPropertyList &propList)
 {
-  if (m_impl->m_inHeader || m_impl->m_inFooter)
-    m_impl->m_currentHeaderOrFooter->addOpenComment(propList);
+  if (!m_impl->startCall(&EPUBTextElements::addOpenComment, propList))
+    return;
+
+  m_impl->record(&EPUBTextElements::addOpenComment, propList);
 
   m_impl->getHtml()->openComment(propList);
 }
 
 void EPUBTextGenerator::closeComment()
 {
-  if (m_impl->m_inHeader || m_impl->m_inFooter)
-    m_impl->m_currentHeaderOrFooter->addCloseComment();
+  if (!m_impl->startCall(&EPUBTextElements::addCloseComment))
+    return;
+
+  m_impl->record(&EPUBTextElements::addCloseComment);
 
   m_impl->getHtml()->closeComment();
 }
 
 void EPUBTextGenerator::openTextBox(const librevenge::RVNGPropertyList &propList)
 {
+  if (!m_impl->startCall(&EPUBTextElements::addOpenTextBox, propList))
+    return;
+
   if (m_impl->getSplitGuard().splitOnSize())
-    m_impl->startNewHtmlFile();
+    m_impl->startNewHtmlFile(EPUB_SPLIT_REASON_SIZE);
   m_impl->getSplitGuard().openLevel();
 
   m_impl->getHtml()->openTextBox(propList);
@@ -550,6 +913,9 @@ void EPUBTextGenerator::openTextBox(const librevenge::RVNGPropertyList &propList
 
 void EPUBTextGenerator::closeTextBox()
 {
+  if (!m_impl->startCall(&EPUBTextElements::addCloseTextBox))
+    return;
+
   m_impl->getSplitGuard().closeLevel();
 
   m_impl->getHtml()->closeTextBox();
@@ -557,70 +923,110 @@ void EPUBTextGenerator::closeTextBox()
 
 void EPUBTextGenerator::openTable(const librevenge::RVNGPropertyList &propList)
 {
+  if (!m_impl->startCall(&EPUBTextElements::addOpenTable, propList))
+    return;
+  if (m_impl->splitOnPlan())
+    m_impl->startNewHtmlFile(EPUB_SPLIT_REASON_PLAN);
+
   if (m_impl->getSplitGuard().splitOnSize())
-    m_impl->startNewHtmlFile();
+    m_impl->startNewHtmlFile(EPUB_SPLIT_REASON_SIZE);
+  m_impl->openStructure(STRUCTURE_TABLE, propList);
   m_impl->getSplitGuard().openLevel();
 
-  if (m_impl->m_inHeader || m_impl->m_inFooter)
-    m_impl->m_currentHeaderOrFooter->addOpenTable(propList);
+  m_impl->record(&EPUBTextElements::addOpenTable, propList);
 
   m_impl->getHtml()->openTable(propList);
 }
 
 void EPUBTextGenerator::openTableRow(const librevenge::RVNGPropertyList &propList)
 {
-  if (m_impl->m_inHeader || m_impl->m_inFooter)
-    m_impl->m_currentHeaderOrFooter->addOpenTableRow(propList);
+  if (!m_impl->startCall(&EPUBTextElements::addOpenTableRow, propList))
+    return;
+
+  if ((m_impl->m_structureType == STRUCTURE_TABLE) && (1 == m_impl->getSplitGuard().getNestingLevel()))
+  {
+    // Header rows are repeated at the start of every part of the table.
+    const RVNGProperty *const headerRow = propList["librevenge:is-header-row"];
+    if (headerRow && headerRow->getInt())
+    {
+      if (!m_impl->m_headerRows)
+        m_impl->m_headerRows.reset(new EPUBTextElements());
+      m_impl->m_inHeaderRow = true;
+    }
+    else if (m_impl->getSplitGuard().splitInStructure())
+    {
+      m_impl->splitStructure();
+    }
+  }
+
+  m_impl->record(&EPUBTextElements::addOpenTableRow, propList);
 
   m_impl->getHtml()->openTableRow(propList);
 }
 
 void EPUBTextGenerator::closeTableRow()
 {
-  if (m_impl->m_inHeader || m_impl->m_inFooter)
-    m_impl->m_currentHeaderOrFooter->addCloseTableRow();
+  if (!m_impl->startCall(&EPUBTextElements::addCloseTableRow))
+    return;
+
+  m_impl->record(&EPUBTextElements::addCloseTableRow);
+  if (1 == m_impl->getSplitGuard().getNestingLevel())
+    m_impl->m_inHeaderRow = false;
 
   m_impl->getHtml()->closeTableRow();
 }
 
 void EPUBTextGenerator::openTableCell(const librevenge::RVNGPropertyList &propList)
 {
-  if (m_impl->m_inHeader || m_impl->m_inFooter)
-    m_impl->m_currentHeaderOrFooter->addOpenTableCell(propList);
+  if (!m_impl->startCall(&EPUBTextElements::addOpenTableCell, propList))
+    return;
+
+  m_impl->record(&EPUBTextElements::addOpenTableCell, propList);
 
   m_impl->getHtml()->openTableCell(propList);
 }
 
 void EPUBTextGenerator::closeTableCell()
 {
-  if (m_impl->m_inHeader || m_impl->m_inFooter)
-    m_impl->m_currentHeaderOrFooter->addCloseTableCell();
+  if (!m_impl->startCall(&EPUBTextElements::addCloseTableCell))
+    return;
+
+  m_impl->record(&EPUBTextElements::addCloseTableCell);
 
   m_impl->getHtml()->closeTableCell();
 }
 
 void EPUBTextGenerator::insertCoveredTableCell(const librevenge::RVNGPropertyList &propList)
 {
-  if (m_impl->m_inHeader || m_impl->m_inFooter)
-    m_impl->m_currentHeaderOrFooter->addInsertCoveredTableCell(propList);
+  if (!m_impl->startCall(&EPUBTextElements::addInsertCoveredTableCell, propList))
+    return;
+
+  m_impl->record(&EPUBTextElements::addInsertCoveredTableCell, propList);
 
   m_impl->getHtml()->insertCoveredTableCell(propList);
 }
 
 void EPUBTextGenerator::closeTable()
 {
+  if (!m_impl->startCall(&EPUBTextElements::addCloseTable))
+    return;
+
   m_impl->getSplitGuard().closeLevel();
+  if (0 == m_impl->getSplitGuard().getNestingLevel())
+    m_impl->m_structureType = STRUCTURE_NONE;
 
-  if (m_impl->m_inHeader || m_impl->m_inFooter)
-    m_impl->m_currentHeaderOrFooter->addCloseTable();
+  m_impl->record(&EPUBTextElements::addCloseTable);
 
   m_impl->getHtml()->closeTable();
 }
 
 void EPUBTextGenerator::openFrame(const librevenge::RVNGPropertyList &propList)
 {
+  if (!m_impl->startCall(&EPUBTextElements::addOpenFrame, propList))
+    return;
+
   if (m_impl->getSplitGuard().splitOnSize())
-    m_impl->startNewHtmlFile();
+    m_impl->startNewHtmlFile(EPUB_SPLIT_REASON_SIZE);
   m_impl->getSplitGuard().openLevel();
 
   m_impl->getHtml()->openFrame(propList);
@@ -628,6 +1034,9 @@ void EPUBTextGenerator::openFrame(const librevenge::RVNGPropertyList &propList)
 
 void EPUBTextGenerator::closeFrame()
 {
+  if (!m_impl->startCall(&EPUBTextElements::addCloseFrame))
+    return;
+
   m_impl->getSplitGuard().closeLevel();
 
   m_impl->getHtml()->closeFrame();
@@ -656,8 +1065,11 @@ static bool isValidMimeType(const RVNGString &mediaType)
 
 void EPUBTextGenerator::insertBinaryObject(const librevenge::RVNGPropertyList &propList)
 {
+  if (!m_impl->startCall(&EPUBTextElements::addInsertBinaryObject, propList))
+    return;
+
   if (m_impl->getSplitGuard().splitOnSize())
-    m_impl->startNewHtmlFile();
+    m_impl->startNewHtmlFile(EPUB_SPLIT_REASON_SIZE);
 
   RVNGPropertyList newPropList;
   shared_ptr<RVNGProperty> mimetype;
@@ -702,28 +1114,32 @@ void EPUBTextGenerator::insertBinaryObject(const librevenge::RVNGPropertyList &p
   newPropList.insert("librevenge:mime-type", mimetype->clone());
   newPropList.insert("office:binary-data", data->clone());
 
-  if (m_impl->m_inHeader || m_impl->m_inFooter)
-    m_impl->m_currentHeaderOrFooter->addInsertBinaryObject(newPropList);
+  m_impl->record(&EPUBTextElements::addInsertBinaryObject, newPropList);
 
-  m_impl->getSplitGuard().incrementSize(1);
   m_impl->getHtml()->insertBinaryObject(newPropList);
+  m_impl->updateSplitSize();
 }
 
 void EPUBTextGenerator::insertEquation(const librevenge::RVNGPropertyList &propList)
 {
+  if (!m_impl->startCall(&EPUBTextElements::addInsertEquation, propList))
+    return;
+
   if (m_impl->getSplitGuard().splitOnSize())
-    m_impl->startNewHtmlFile();
+    m_impl->startNewHtmlFile(EPUB_SPLIT_REASON_SIZE);
 
-  if (m_impl->m_inHeader || m_impl->m_inFooter)
-    m_impl->m_currentHeaderOrFooter->addInsertEquation(propList);
+  m_impl->record(&EPUBTextElements::addInsertEquation, propList);
 
   m_impl->getHtml()->insertEquation(propList);
 }
 
 void EPUBTextGenerator::openGroup(const librevenge::RVNGPropertyList &propList)
 {
+  if (!m_impl->startCall(&EPUBTextElements::addOpenGroup, propList))
+    return;
+
   if (m_impl->getSplitGuard().splitOnSize())
-    m_impl->startNewHtmlFile();
+    m_impl->startNewHtmlFile(EPUB_SPLIT_REASON_SIZE);
   m_impl->getSplitGuard().openLevel();
 
   m_impl->getHtml()->openGroup(propList);
@@ -731,6 +1147,9 @@ void EPUBTextGenerator::openGroup(const librevenge::RVNGPropertyList &propList)
 
 void EPUBTextGenerator::closeGroup()
 {
+  if (!m_impl->startCall(&EPUBTextElements::addCloseGroup))
+    return;
+
   m_impl->getSplitGuard().closeLevel();
 
   m_impl->getHtml()->closeGroup();
@@ -738,36 +1157,57 @@ void EPUBTextGenerator::closeGroup()
 
 void EPUBTextGenerator::defineGraphicStyle(const librevenge::RVNGPropertyList &propList)
 {
+  if (!m_impl->startCall(&EPUBTextElements::addDefineGraphicStyle, propList))
+    return;
+
   m_impl->getHtml()->defineGraphicStyle(propList);
 }
 
 void EPUBTextGenerator::drawRectangle(const librevenge::RVNGPropertyList &propList)
 {
+  if (!m_impl->startCall(&EPUBTextElements::addDrawRectangle, propList))
+    return;
+
   m_impl->getHtml()->drawRectangle(propList);
 }
 
 void EPUBTextGenerator::drawEllipse(const librevenge::RVNGPropertyList &propList)
 {
+  if (!m_impl->startCall(&EPUBTextElements::addDrawEllipse, propList))
+    return;
+
   m_impl->getHtml()->drawEllipse(propList);
 }
 
 void EPUBTextGenerator::drawPolygon(const librevenge::RVNGPropertyList &propList)
 {
+  if (!m_impl->startCall(&EPUBTextElements::addDrawPolygon, propList))
+    return;
+
   m_impl->getHtml()->drawPolygon(propList);
 }
 
 void EPUBTextGenerator::drawPolyline(const librevenge::RVNGPropertyList &propList)
 {
+  if (!m_impl->startCall(&EPUBTextElements::addDrawPolyline, propList))
+    return;
+
   m_impl->getHtml()->drawPolyline(propList);
 }
 
 void EPUBTextGenerator::drawPath(const librevenge::RVNGPropertyList &propList)
 {
+  if (!m_impl->startCall(&EPUBTextElements::addDrawPath, propList))
+    return;
+
   m_impl->getHtml()->drawPath(propList);
 }
 
 void EPUBTextGenerator::drawConnector(const librevenge::RVNGPropertyList &propList)
 {
+  if (!m_impl->startCall(&EPUBTextElements::addDrawConnector, propList))
+    return;
+
   m_impl->getHtml()->drawConnector(propList);
 }
 
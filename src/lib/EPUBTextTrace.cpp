@@ -0,0 +1,1196 @@
+/* -*- Mode: C++; tab-width: 2; indent-tabs-mode: nil; c-basic-offset: 2 -*- */
+/*
+ * This file is part of the libepubgen project.
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#include <libepubgen/EPUBTextTrace.h>
+
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <string>
+
+#include "EPUBTextElements.h"
+#include "libepubgen_utils.h"
+
+namespace libepubgen
+{
+
+using librevenge::RVNGPropertyList;
+using librevenge::RVNGPropertyListVector;
+using librevenge::RVNGString;
+
+namespace
+{
+
+/* The format of a trace is:
+ * - the magic bytes and the version
+ * - for each call, its TraceCall, followed by its property list or its
+ *   text, if it has one
+ * - TRACE_END, so a trace cut between two calls is not taken as complete.
+ *
+ * Numbers are written as variable-length unsigned integers, 7 bits per
+ * byte, the least significant first. A string is its length, followed by
+ * its bytes. A property list is the number of its properties, followed by
+ * the name, the TraceValue and the value of each property.
+ */
+
+const char TRACE_MAGIC[] = {'E', 'P', 'U', 'B', 'T', 'R', 'C'};
+const unsigned char TRACE_VERSION = 2;
+
+/// The maximal nesting of property list vectors.
+const unsigned MAX_DEPTH = 32;
+
+/// The calls of RVNGTextInterface. The values are part of the format.
+enum TraceCall
+{
+  TRACE_CLOSE_COMMENT = 0,
+  TRACE_CLOSE_ENDNOTE,
+  TRACE_CLOSE_FOOTER,
+  TRACE_CLOSE_FOOTNOTE,
+  TRACE_CLOSE_FRAME,
+  TRACE_CLOSE_GROUP,
+  TRACE_CLOSE_HEADER,
+  TRACE_CLOSE_LINK,
+  TRACE_CLOSE_LIST_ELEMENT,
+  TRACE_CLOSE_ORDERED_LIST_LEVEL,
+  TRACE_CLOSE_PAGE_SPAN,
+  TRACE_CLOSE_PARAGRAPH,
+  TRACE_CLOSE_SECTION,
+  TRACE_CLOSE_SPAN,
+  TRACE_CLOSE_TABLE,
+  TRACE_CLOSE_TABLE_CELL,
+  TRACE_CLOSE_TABLE_ROW,
+  TRACE_CLOSE_TEXT_BOX,
+  TRACE_CLOSE_UNORDERED_LIST_LEVEL,
+  TRACE_DEFINE_CHARACTER_STYLE,
+  TRACE_DEFINE_EMBEDDED_FONT,
+  TRACE_DEFINE_GRAPHIC_STYLE,
+  TRACE_DEFINE_PAGE_STYLE,
+  TRACE_DEFINE_PARAGRAPH_STYLE,
+  TRACE_DEFINE_SECTION_STYLE,
+  TRACE_DRAW_CONNECTOR,
+  TRACE_DRAW_ELLIPSE,
+  TRACE_DRAW_PATH,
+  TRACE_DRAW_POLYGON,
+  TRACE_DRAW_POLYLINE,
+  TRACE_DRAW_RECTANGLE,
+  TRACE_END_DOCUMENT,
+  TRACE_INSERT_BINARY_OBJECT,
+  TRACE_INSERT_COVERED_TABLE_CELL,
+  TRACE_INSERT_EQUATION,
+  TRACE_INSERT_FIELD,
+  TRACE_INSERT_LINE_BREAK,
+  TRACE_INSERT_SPACE,
+  TRACE_INSERT_TAB,
+  TRACE_INSERT_TEXT,
+  TRACE_OPEN_COMMENT,
+  TRACE_OPEN_ENDNOTE,
+  TRACE_OPEN_FOOTER,
+  TRACE_OPEN_FOOTNOTE,
+  TRACE_OPEN_FRAME,
+  TRACE_OPEN_GROUP,
+  TRACE_OPEN_HEADER,
+  TRACE_OPEN_LINK,
+  TRACE_OPEN_LIST_ELEMENT,
+  TRACE_OPEN_ORDERED_LIST_LEVEL,
+  TRACE_OPEN_PAGE_SPAN,
+  TRACE_OPEN_PARAGRAPH,
+  TRACE_OPEN_SECTION,
+  TRACE_OPEN_SPAN,
+  TRACE_OPEN_TABLE,
+  TRACE_OPEN_TABLE_CELL,
+  TRACE_OPEN_TABLE_ROW,
+  TRACE_OPEN_TEXT_BOX,
+  TRACE_OPEN_UNORDERED_LIST_LEVEL,
+  TRACE_SET_DOCUMENT_META_DATA,
+  TRACE_START_DOCUMENT,
+  /// Not a call: the end of the trace.
+  TRACE_END = 0xff
+};
+
+/// The kinds of properties. The values are part of the format.
+enum TraceValue
+{
+  /// A property written as its string value.
+  TRACE_VALUE_STRING = 0,
+  /// A double with a unit.
+  TRACE_VALUE_MEASURE,
+  /// A property list vector.
+  TRACE_VALUE_CHILDREN,
+  /// A boolean, as a byte.
+  TRACE_VALUE_BOOL,
+  /// An integer, as a zigzag-encoded number.
+  TRACE_VALUE_INT
+};
+
+void writeNumber(std::ostream &trace, unsigned long number)
+{
+  while (number >= 0x80)
+  {
+    trace.put(char((number & 0x7f) | 0x80));
+    number >>= 7;
+  }
+  trace.put(char(number));
+}
+
+void writeString(std::ostream &trace, const char *const str, const std::size_t length)
+{
+  writeNumber(trace, length);
+  trace.write(str, std::streamsize(length));
+}
+
+/// Writes a signed number, with the sign in the lowest bit.
+void writeInt(std::ostream &trace, const int value)
+{
+  const unsigned long magnitude = value < 0 ? ~static_cast<unsigned long>(long(value)) : static_cast<unsigned long>(value);
+  writeNumber(trace, (magnitude << 1) | (value < 0 ? 1 : 0));
+}
+
+void writeDouble(std::ostream &trace, const double value)
+{
+  std::uint64_t bits;
+  static_assert(sizeof(bits) == sizeof(value), "unexpected size of double");
+  std::memcpy(&bits, &value, sizeof(bits));
+  for (int i = 0; i < 8; ++i, bits >>= 8)
+    trace.put(char(bits & 0xff));
+}
+
+void writePropertyList(std::ostream &trace, const RVNGPropertyList &propList)
+{
+  RVNGPropertyList::Iter iter(propList);
+  unsigned long count = 0;
+  for (iter.rewind(); iter.next();)
+    ++count;
+  writeNumber(trace, count);
+
+  for (iter.rewind(); iter.next();)
+  {
+    writeString(trace, iter.key(), std::strlen(iter.key()));
+    if (const RVNGPropertyListVector *const children = iter.child())
+    {
+      trace.put(char(TRACE_VALUE_CHILDREN));
+      writeNumber(trace, children->count());
+      for (unsigned long i = 0; i < children->count(); ++i)
+        writePropertyList(trace, (*children)[i]);
+    }
+    else if (iter())
+    {
+      const librevenge::RVNGUnit unit = iter()->getUnit();
+      switch (unit)
+      {
+      case librevenge::RVNG_INCH:
+      case librevenge::RVNG_PERCENT:
+      case librevenge::RVNG_POINT:
+      case librevenge::RVNG_TWIP:
+        trace.put(char(TRACE_VALUE_MEASURE));
+        trace.put(char(unit));
+        writeDouble(trace, iter()->getDouble());
+        break;
+      default:
+      {
+        // The type of a property is not known, but a property which gives
+        // the same values as a boolean or an integer can be replayed as
+        // one. Other ones, e.g., binary data (as base64), keep their string
+        // value.
+        const RVNGString value = iter()->getStr();
+        const int intValue = iter()->getInt();
+        if ((value == "true" && 1 == intValue) || (value == "false" && 0 == intValue))
+        {
+          trace.put(char(TRACE_VALUE_BOOL));
+          trace.put(char(intValue));
+        }
+        else if (value == std::to_string(intValue).c_str())
+        {
+          trace.put(char(TRACE_VALUE_INT));
+          writeInt(trace, intValue);
+        }
+        else
+        {
+          trace.put(char(TRACE_VALUE_STRING));
+          writeString(trace, value.cstr(), value.size());
+        }
+        break;
+      }
+      }
+    }
+    else
+    {
+      trace.put(char(TRACE_VALUE_STRING));
+      writeString(trace, "", 0);
+    }
+  }
+}
+
+bool readByte(std::istream &trace, unsigned char &byte)
+{
+  const int c = trace.get();
+  if (std::istream::traits_type::eof() == c)
+    return false;
+  byte = static_cast<unsigned char>(c);
+  return true;
+}
+
+bool readNumber(std::istream &trace, unsigned long &number)
+{
+  number = 0;
+  for (unsigned shift = 0; shift < 8 * sizeof(number); shift += 7)
+  {
+    unsigned char byte = 0;
+    if (!readByte(trace, byte))
+      return false;
+    number |= static_cast<unsigned long>(byte & 0x7f) << shift;
+    if (!(byte & 0x80))
+      return true;
+  }
+  EPUBGEN_DEBUG_MSG(("readNumber: number too long\n"));
+  return false;
+}
+
+bool readString(std::istream &trace, std::string &str)
+{
+  unsigned long length = 0;
+  if (!readNumber(trace, length))
+    return false;
+  str.clear();
+  // Read in pieces, so a broken length does not allocate too much.
+  char buffer[4096];
+  while (length > 0)
+  {
+    const std::size_t size = length < sizeof(buffer) ? std::size_t(length) : sizeof(buffer);
+    if (!trace.read(buffer, std::streamsize(size)))
+      return false;
+    str.append(buffer, size);
+    length -= size;
+  }
+  return true;
+}
+
+bool readInt(std::istream &trace, int &value)
+{
+  unsigned long number = 0;
+  if (!readNumber(trace, number))
+    return false;
+  const unsigned long magnitude = number >> 1;
+  if (magnitude > static_cast<unsigned long>(std::numeric_limits<int>::max()))
+  {
+    EPUBGEN_DEBUG_MSG(("readInt: number out of range\n"));
+    return false;
+  }
+  value = (number & 1) ? -int(magnitude) - 1 : int(magnitude);
+  return true;
+}
+
+bool readDouble(std::istream &trace, double &value)
+{
+  std::uint64_t bits = 0;
+  for (int i = 0; i < 8; ++i)
+  {
+    unsigned char byte = 0;
+    if (!readByte(trace, byte))
+      return false;
+    bits |= std::uint64_t(byte) << (8 * i);
+  }
+  std::memcpy(&value, &bits, sizeof(value));
+  return true;
+}
+
+bool readPropertyList(std::istream &trace, RVNGPropertyList &propList, const unsigned depth)
+{
+  propList.clear();
+  if (depth > MAX_DEPTH)
+  {
+    EPUBGEN_DEBUG_MSG(("readPropertyList: nested too deep\n"));
+    return false;
+  }
+
+  unsigned long count = 0;
+  if (!readNumber(trace, count))
+    return false;
+  std::string name;
+  std::string value;
+  for (unsigned long i = 0; i < count; ++i)
+  {
+    unsigned char kind = 0;
+    if (!readString(trace, name) || !readByte(trace, kind))
+      return false;
+    switch (kind)
+    {
+    case TRACE_VALUE_STRING:
+      if (!readString(trace, value))
+        return false;
+      propList.insert(name.c_str(), value.c_str());
+      break;
+    case TRACE_VALUE_MEASURE:
+    {
+      unsigned char unit = 0;
+      double measure = 0;
+      if (!readByte(trace, unit) || !readDouble(trace, measure))
+        return false;
+      switch (unit)
+      {
+      case librevenge::RVNG_INCH:
+      case librevenge::RVNG_PERCENT:
+      case librevenge::RVNG_POINT:
+      case librevenge::RVNG_TWIP:
+        break;
+      default:
+        EPUBGEN_DEBUG_MSG(("readPropertyList: unknown unit %d\n", int(unit)));
+        return false;
+      }
+      propList.insert(name.c_str(), measure, librevenge::RVNGUnit(unit));
+      break;
+    }
+    case TRACE_VALUE_BOOL:
+    {
+      unsigned char flag = 0;
+      if (!readByte(trace, flag))
+        return false;
+      if (flag > 1)
+      {
+        EPUBGEN_DEBUG_MSG(("readPropertyList: invalid boolean %d\n", int(flag)));
+        return false;
+      }
+      propList.insert(name.c_str(), bool(flag));
+      break;
+    }
+    case TRACE_VALUE_INT:
+    {
+      int number = 0;
+      if (!readInt(trace, number))
+        return false;
+      propList.insert(name.c_str(), number);
+      break;
+    }
+    case TRACE_VALUE_CHILDREN:
+    {
+      unsigned long size = 0;
+      if (!readNumber(trace, size))
+        return false;
+      RVNGPropertyListVector children;
+      RVNGPropertyList child;
+      for (unsigned long j = 0; j < size; ++j)
+      {
+        if (!readPropertyList(trace, child, depth + 1))
+          return false;
+        children.append(child);
+      }
+      propList.insert(name.c_str(), children);
+      break;
+    }
+    default:
+      EPUBGEN_DEBUG_MSG(("readPropertyList: unknown kind of value %d\n", int(kind)));
+      return false;
+    }
+  }
+  return true;
+}
+
+/// Reads the next call into elements.
+bool readCall(std::istream &trace, const unsigned char call, EPUBTextElements &elements)
+{
+  RVNGPropertyList propList;
+  std::string text;
+  switch (call)
+  {
+  case TRACE_CLOSE_COMMENT:
+    elements.addCloseComment();
+    break;
+  case TRACE_CLOSE_ENDNOTE:
+    elements.addCloseEndnote();
+    break;
+  case TRACE_CLOSE_FOOTER:
+    elements.addCloseFooter();
+    break;
+  case TRACE_CLOSE_FOOTNOTE:
+    elements.addCloseFootnote();
+    break;
+  case TRACE_CLOSE_FRAME:
+    elements.addCloseFrame();
+    break;
+  case TRACE_CLOSE_GROUP:
+    elements.addCloseGroup();
+    break;
+  case TRACE_CLOSE_HEADER:
+    elements.addCloseHeader();
+    break;
+  case TRACE_CLOSE_LINK:
+    elements.addCloseLink();
+    break;
+  case TRACE_CLOSE_LIST_ELEMENT:
+    elements.addCloseListElement();
+    break;
+  case TRACE_CLOSE_ORDERED_LIST_LEVEL:
+    elements.addCloseOrderedListLevel();
+    break;
+  case TRACE_CLOSE_PAGE_SPAN:
+    elements.addClosePageSpan();
+    break;
+  case TRACE_CLOSE_PARAGRAPH:
+    elements.addCloseParagraph();
+    break;
+  case TRACE_CLOSE_SECTION:
+    elements.addCloseSection();
+    break;
+  case TRACE_CLOSE_SPAN:
+    elements.addCloseSpan();
+    break;
+  case TRACE_CLOSE_TABLE:
+    elements.addCloseTable();
+    break;
+  case TRACE_CLOSE_TABLE_CELL:
+    elements.addCloseTableCell();
+    break;
+  case TRACE_CLOSE_TABLE_ROW:
+    elements.addCloseTableRow();
+    break;
+  case TRACE_CLOSE_TEXT_BOX:
+    elements.addCloseTextBox();
+    break;
+  case TRACE_CLOSE_UNORDERED_LIST_LEVEL:
+    elements.addCloseUnorderedListLevel();
+    break;
+  case TRACE_DEFINE_CHARACTER_STYLE:
+    if (!readPropertyList(trace, propList, 0))
+      return false;
+    elements.addDefineCharacterStyle(propList);
+    break;
+  case TRACE_DEFINE_EMBEDDED_FONT:
+    if (!readPropertyList(trace, propList, 0))
+      return false;
+    elements.addDefineEmbeddedFont(propList);
+    break;
+  case TRACE_DEFINE_GRAPHIC_STYLE:
+    if (!readPropertyList(trace, propList, 0))
+      return false;
+    elements.addDefineGraphicStyle(propList);
+    break;
+  case TRACE_DEFINE_PAGE_STYLE:
+    if (!readPropertyList(trace, propList, 0))
+      return false;
+    elements.addDefinePageStyle(propList);
+    break;
+  case TRACE_DEFINE_PARAGRAPH_STYLE:
+    if (!readPropertyList(trace, propList, 0))
+      return false;
+    elements.addDefineParagraphStyle(propList);
+    break;
+  case TRACE_DEFINE_SECTION_STYLE:
+    if (!readPropertyList(trace, propList, 0))
+      return false;
+    elements.addDefineSectionStyle(propList);
+    break;
+  case TRACE_DRAW_CONNECTOR:
+    if (!readPropertyList(trace, propList, 0))
+      return false;
+    elements.addDrawConnector(propList);
+    break;
+  case TRACE_DRAW_ELLIPSE:
+    if (!readPropertyList(trace, propList, 0))
+      return false;
+    elements.addDrawEllipse(propList);
+    break;
+  case TRACE_DRAW_PATH:
+    if (!readPropertyList(trace, propList, 0))
+      return false;
+    elements.addDrawPath(propList);
+    break;
+  case TRACE_DRAW_POLYGON:
+    if (!readPropertyList(trace, propList, 0))
+      return false;
+    elements.addDrawPolygon(propList);
+    break;
+  case TRACE_DRAW_POLYLINE:
+    if (!readPropertyList(trace, propList, 0))
+      return false;
+    elements.addDrawPolyline(propList);
+    break;
+  case TRACE_DRAW_RECTANGLE:
+    if (!readPropertyList(trace, propList, 0))
+      return false;
+    elements.addDrawRectangle(propList);
+    break;
+  case TRACE_END_DOCUMENT:
+    elements.addEndDocument();
+    break;
+  case TRACE_INSERT_BINARY_OBJECT:
+    if (!readPropertyList(trace, propList, 0))
+      return false;
+    elements.addInsertBinaryObject(propList);
+    break;
+  case TRACE_INSERT_COVERED_TABLE_CELL:
+    if (!readPropertyList(trace, propList, 0))
+      return false;
+    elements.addInsertCoveredTableCell(propList);
+    break;
+  case TRACE_INSERT_EQUATION:
+    if (!readPropertyList(trace, propList, 0))
+      return false;
+    elements.addInsertEquation(propList);
+    break;
+  case TRACE_INSERT_FIELD:
+    if (!readPropertyList(trace, propList, 0))
+      return false;
+    elements.addInsertField(propList);
+    break;
+  case TRACE_INSERT_LINE_BREAK:
+    elements.addInsertLineBreak();
+    break;
+  case TRACE_INSERT_SPACE:
+    elements.addInsertSpace();
+    break;
+  case TRACE_INSERT_TAB:
+    elements.addInsertTab();
+    break;
+  case TRACE_INSERT_TEXT:
+    if (!readString(trace, text))
+      return false;
+    elements.addInsertText(text.c_str());
+    break;
+  case TRACE_OPEN_COMMENT:
+    if (!readPropertyList(trace, propList, 0))
+      return false;
+    elements.addOpenComment(propList);
+    break;
+  case TRACE_OPEN_ENDNOTE:
+    if (!readPropertyList(trace, propList, 0))
+      return false;
+    elements.addOpenEndnote(propList);
+    break;
+  case TRACE_OPEN_FOOTER:
+    if (!readPropertyList(trace, propList, 0))
+      return false;
+    elements.addOpenFooter(propList);
+    break;
+  case TRACE_OPEN_FOOTNOTE:
+    if (!readPropertyList(trace, propList, 0))
+      return false;
+    elements.addOpenFootnote(propList);
+    break;
+  case TRACE_OPEN_FRAME:
+    if (!readPropertyList(trace, propList, 0))
+      return false;
+    elements.addOpenFrame(propList);
+    break;
+  case TRACE_OPEN_GROUP:
+    if (!readPropertyList(trace, propList, 0))
+      return false;
+    elements.addOpenGroup(propList);
+    break;
+  case TRACE_OPEN_HEADER:
+    if (!readPropertyList(trace, propList, 0))
+      return false;
+    elements.addOpenHeader(propList);
+    break;
+  case TRACE_OPEN_LINK:
+    if (!readPropertyList(trace, propList, 0))
+      return false;
+    elements.addOpenLink(propList);
+    break;
+  case TRACE_OPEN_LIST_ELEMENT:
+    if (!readPropertyList(trace, propList, 0))
+      return false;
+    elements.addOpenListElement(propList);
+    break;
+  case TRACE_OPEN_ORDERED_LIST_LEVEL:
+    if (!readPropertyList(trace, propList, 0))
+      return false;
+    elements.addOpenOrderedListLevel(propList);
+    break;
+  case TRACE_OPEN_PAGE_SPAN:
+    if (!readPropertyList(trace, propList, 0))
+      return false;
+    elements.addOpenPageSpan(propList);
+    break;
+  case TRACE_OPEN_PARAGRAPH:
+    if (!readPropertyList(trace, propList, 0))
+      return false;
+    elements.addOpenParagraph(propList);
+    break;
+  case TRACE_OPEN_SECTION:
+    if (!readPropertyList(trace, propList, 0))
+      return false;
+    elements.addOpenSection(propList);
+    break;
+  case TRACE_OPEN_SPAN:
+    if (!readPropertyList(trace, propList, 0))
+      return false;
+    elements.addOpenSpan(propList);
+    break;
+  case TRACE_OPEN_TABLE:
+    if (!readPropertyList(trace, propList, 0))
+      return false;
+    elements.addOpenTable(propList);
+    break;
+  case TRACE_OPEN_TABLE_CELL:
+    if (!readPropertyList(trace, propList, 0))
+      return false;
+    elements.addOpenTableCell(propList);
+    break;
+  case TRACE_OPEN_TABLE_ROW:
+    if (!readPropertyList(trace, propList, 0))
+      return false;
+    elements.addOpenTableRow(propList);
+    break;
+  case TRACE_OPEN_TEXT_BOX:
+    if (!readPropertyList(trace, propList, 0))
+      return false;
+    elements.addOpenTextBox(propList);
+    break;
+  case TRACE_OPEN_UNORDERED_LIST_LEVEL:
+    if (!readPropertyList(trace, propList, 0))
+      return false;
+    elements.addOpenUnorderedListLevel(propList);
+    break;
+  case TRACE_SET_DOCUMENT_META_DATA:
+    if (!readPropertyList(trace, propList, 0))
+      return false;
+    elements.addSetDocumentMetaData(propList);
+    break;
+  case TRACE_START_DOCUMENT:
+    if (!readPropertyList(trace, propList, 0))
+      return false;
+    elements.addStartDocument(propList);
+    break;
+  default:
+    EPUBGEN_DEBUG_MSG(("readCall: unknown call %d\n", int(call)));
+    return false;
+  }
+  return true;
+}
+
+}
+
+struct EPUBTextTraceRecorder::Impl
+{
+  Impl(std::ostream &trace, librevenge::RVNGTextInterface *next);
+
+  void record(TraceCall call);
+  void record(TraceCall call, const RVNGPropertyList &propList);
+  void record(TraceCall call, const RVNGString &text);
+
+  std::ostream &m_trace;
+  librevenge::RVNGTextInterface *const m_next;
+
+private:
+  // disable copying
+  Impl(const Impl &);
+  Impl &operator=(const Impl &);
+};
+
+EPUBTextTraceRecorder::Impl::Impl(std::ostream &trace, librevenge::RVNGTextInterface *const next)
+  : m_trace(trace)
+  , m_next(next)
+{
+  m_trace.write(TRACE_MAGIC, sizeof(TRACE_MAGIC));
+  m_trace.put(char(TRACE_VERSION));
+}
+
+void EPUBTextTraceRecorder::Impl::record(const TraceCall call)
+{
+  m_trace.put(char(call));
+}
+
+void EPUBTextTraceRecorder::Impl::record(const TraceCall call, const RVNGPropertyList &propList)
+{
+  m_trace.put(char(call));
+  writePropertyList(m_trace, propList);
+}
+
+void EPUBTextTraceRecorder::Impl::record(const TraceCall call, const RVNGString &text)
+{
+  m_trace.put(char(call));
+  writeString(m_trace, text.cstr(), text.size());
+}
+
+EPUBTextTraceRecorder::EPUBTextTraceRecorder(std::ostream &trace, librevenge::RVNGTextInterface *const next)
+  : m_impl(new Impl(trace, next))
+{
+}
+
+EPUBTextTraceRecorder::~EPUBTextTraceRecorder()
+{
+  m_impl->record(TRACE_END);
+  m_impl->m_trace.flush();
+  delete m_impl;
+}
+
+void EPUBTextTraceRecorder::closeComment()
+{
+  m_impl->record(TRACE_CLOSE_COMMENT);
+  if (m_impl->m_next)
+    m_impl->m_next->closeComment();
+}
+
+void EPUBTextTraceRecorder::closeEndnote()
+{
+  m_impl->record(TRACE_CLOSE_ENDNOTE);
+  if (m_impl->m_next)
+    m_impl->m_next->closeEndnote();
+}
+
+void EPUBTextTraceRecorder::closeFooter()
+{
+  m_impl->record(TRACE_CLOSE_FOOTER);
+  if (m_impl->m_next)
+    m_impl->m_next->closeFooter();
+}
+
+void EPUBTextTraceRecorder::closeFootnote()
+{
+  m_impl->record(TRACE_CLOSE_FOOTNOTE);
+  if (m_impl->m_next)
+    m_impl->m_next->closeFootnote();
+}
+
+void EPUBTextTraceRecorder::closeFrame()
+{
+  m_impl->record(TRACE_CLOSE_FRAME);
+  if (m_impl->m_next)
+    m_impl->m_next->closeFrame();
+}
+
+void EPUBTextTraceRecorder::closeGroup()
+{
+  m_impl->record(TRACE_CLOSE_GROUP);
+  if (m_impl->m_next)
+    m_impl->m_next->closeGroup();
+}
+
+void EPUBTextTraceRecorder::closeHeader()
+{
+  m_impl->record(TRACE_CLOSE_HEADER);
+  if (m_impl->m_next)
+    m_impl->m_next->closeHeader();
+}
+
+void EPUBTextTraceRecorder::closeLink()
+{
+  m_impl->record(TRACE_CLOSE_LINK);
+  if (m_impl->m_next)
+    m_impl->m_next->closeLink();
+}
+
+void EPUBTextTraceRecorder::closeListElement()
+{
+  m_impl->record(TRACE_CLOSE_LIST_ELEMENT);
+  if (m_impl->m_next)
+    m_impl->m_next->closeListElement();
+}
+
+void EPUBTextTraceRecorder::closeOrderedListLevel()
+{
+  m_impl->record(TRACE_CLOSE_ORDERED_LIST_LEVEL);
+  if (m_impl->m_next)
+    m_impl->m_next->closeOrderedListLevel();
+}
+
+void EPUBTextTraceRecorder::closePageSpan()
+{
+  m_impl->record(TRACE_CLOSE_PAGE_SPAN);
+  if (m_impl->m_next)
+    m_impl->m_next->closePageSpan();
+}
+
+void EPUBTextTraceRecorder::closeParagraph()
+{
+  m_impl->record(TRACE_CLOSE_PARAGRAPH);
+  if (m_impl->m_next)
+    m_impl->m_next->closeParagraph();
+}
+
+void EPUBTextTraceRecorder::closeSection()
+{
+  m_impl->record(TRACE_CLOSE_SECTION);
+  if (m_impl->m_next)
+    m_impl->m_next->closeSection();
+}
+
+void EPUBTextTraceRecorder::closeSpan()
+{
+  m_impl->record(TRACE_CLOSE_SPAN);
+  if (m_impl->m_next)
+    m_impl->m_next->closeSpan();
+}
+
+void EPUBTextTraceRecorder::closeTable()
+{
+  m_impl->record(TRACE_CLOSE_TABLE);
+  if (m_impl->m_next)
+    m_impl->m_next->closeTable();
+}
+
+void EPUBTextTraceRecorder::closeTableCell()
+{
+  m_impl->record(TRACE_CLOSE_TABLE_CELL);
+  if (m_impl->m_next)
+    m_impl->m_next->closeTableCell();
+}
+
+void EPUBTextTraceRecorder::closeTableRow()
+{
+  m_impl->record(TRACE_CLOSE_TABLE_ROW);
+  if (m_impl->m_next)
+    m_impl->m_next->closeTableRow();
+}
+
+void EPUBTextTraceRecorder::closeTextBox()
+{
+  m_impl->record(TRACE_CLOSE_TEXT_BOX);
+  if (m_impl->m_next)
+    m_impl->m_next->closeTextBox();
+}
+
+void EPUBTextTraceRecorder::closeUnorderedListLevel()
+{
+  m_impl->record(TRACE_CLOSE_UNORDERED_LIST_LEVEL);
+  if (m_impl->m_next)
+    m_impl->m_next->closeUnorderedListLevel();
+}
+
+void EPUBTextTraceRecorder::defineCharacterStyle(const librevenge::RVNGPropertyList &propList)
+{
+  m_impl->record(TRACE_DEFINE_CHARACTER_STYLE, propList);
+  if (m_impl->m_next)
+    m_impl->m_next->defineCharacterStyle(propList);
+}
+
+void EPUBTextTraceRecorder::defineEmbeddedFont(const librevenge::RVNGPropertyList &propList)
+{
+  m_impl->record(TRACE_DEFINE_EMBEDDED_FONT, propList);
+  if (m_impl->m_next)
+    m_impl->m_next->defineEmbeddedFont(propList);
+}
+
+void EPUBTextTraceRecorder::defineGraphicStyle(const librevenge::RVNGPropertyList &propList)
+{
+  m_impl->record(TRACE_DEFINE_GRAPHIC_STYLE, propList);
+  if (m_impl->m_next)
+    m_impl->m_next->defineGraphicStyle(propList);
+}
+
+void EPUBTextTraceRecorder::definePageStyle(const librevenge::RVNGPropertyList &propList)
+{
+  m_impl->record(TRACE_DEFINE_PAGE_STYLE, propList);
+  if (m_impl->m_next)
+    m_impl->m_next->definePageStyle(propList);
+}
+
+void EPUBTextTraceRecorder::defineParagraphStyle(const librevenge::RVNGPropertyList &propList)
+{
+  m_impl->record(TRACE_DEFINE_PARAGRAPH_STYLE, propList);
+  if (m_impl->m_next)
+    m_impl->m_next->defineParagraphStyle(propList);
+}
+
+void EPUBTextTraceRecorder::defineSectionStyle(const librevenge::RVNGPropertyList &propList)
+{
+  m_impl->record(TRACE_DEFINE_SECTION_STYLE, propList);
+  if (m_impl->m_next)
+    m_impl->m_next->defineSectionStyle(propList);
+}
+
+void EPUBTextTraceRecorder::drawConnector(const librevenge::RVNGPropertyList &propList)
+{
+  m_impl->record(TRACE_DRAW_CONNECTOR, propList);
+  if (m_impl->m_next)
+    m_impl->m_next->drawConnector(propList);
+}
+
+void EPUBTextTraceRecorder::drawEllipse(const librevenge::RVNGPropertyList &propList)
+{
+  m_impl->record(TRACE_DRAW_ELLIPSE, propList);
+  if (m_impl->m_next)
+    m_impl->m_next->drawEllipse(propList);
+}
+
+void EPUBTextTraceRecorder::drawPath(const librevenge::RVNGPropertyList &propList)
+{
+  m_impl->record(TRACE_DRAW_PATH, propList);
+  if (m_impl->m_next)
+    m_impl->m_next->drawPath(propList);
+}
+
+void EPUBTextTraceRecorder::drawPolygon(const librevenge::RVNGPropertyList &propList)
+{
+  m_impl->record(TRACE_DRAW_POLYGON, propList);
+  if (m_impl->m_next)
+    m_impl->m_next->drawPolygon(propList);
+}
+
+void EPUBTextTraceRecorder::drawPolyline(const librevenge::RVNGPropertyList &propList)
+{
+  m_impl->record(TRACE_DRAW_POLYLINE, propList);
+  if (m_impl->m_next)
+    m_impl->m_next->drawPolyline(propList);
+}
+
+void EPUBTextTraceRecorder::drawRectangle(const librevenge::RVNGPropertyList &propList)
+{
+  m_impl->record(TRACE_DRAW_RECTANGLE, propList);
+  if (m_impl->m_next)
+    m_impl->m_next->drawRectangle(propList);
+}
+
+void EPUBTextTraceRecorder::endDocument()
+{
+  m_impl->record(TRACE_END_DOCUMENT);
+  if (m_impl->m_next)
+    m_impl->m_next->endDocument();
+}
+
+void EPUBTextTraceRecorder::insertBinaryObject(const librevenge::RVNGPropertyList &propList)
+{
+  m_impl->record(TRACE_INSERT_BINARY_OBJECT, propList);
+  if (m_impl->m_next)
+    m_impl->m_next->insertBinaryObject(propList);
+}
+
+void EPUBTextTraceRecorder::insertCoveredTableCell(const librevenge::RVNGPropertyList &propList)
+{
+  m_impl->record(TRACE_INSERT_COVERED_TABLE_CELL, propList);
+  if (m_impl->m_next)
+    m_impl->m_next->insertCoveredTableCell(propList);
+}
+
+void EPUBTextTraceRecorder::insertEquation(const librevenge::RVNGPropertyList &propList)
+{
+  m_impl->record(TRACE_INSERT_EQUATION, propList);
+  if (m_impl->m_next)
+    m_impl->m_next->insertEquation(propList);
+}
+
+void EPUBTextTraceRecorder::insertField(const librevenge::RVNGPropertyList &propList)
+{
+  m_impl->record(TRACE_INSERT_FIELD, propList);
+  if (m_impl->m_next)
+    m_impl->m_next->insertField(propList);
+}
+
+void EPUBTextTraceRecorder::insertLineBreak()
+{
+  m_impl->record(TRACE_INSERT_LINE_BREAK);
+  if (m_impl->m_next)
+    m_impl->m_next->insertLineBreak();
+}
+
+void EPUBTextTraceRecorder::insertSpace()
+{
+  m_impl->record(TRACE_INSERT_SPACE);
+  if (m_impl->m_next)
+    m_impl->m_next->insertSpace();
+}
+
+void EPUBTextTraceRecorder::insertTab()
+{
+  m_impl->record(TRACE_INSERT_TAB);
+  if (m_impl->m_next)
+    m_impl->m_next->insertTab();
+}
+
+void EPUBTextTraceRecorder::insertText(const librevenge::RVNGString &text)
+{
+  m_impl->record(TRACE_INSERT_TEXT, text);
+  if (m_impl->m_next)
+    m_impl->m_next->insertText(text);
+}
+
+void EPUBTextTraceRecorder::openComment(const librevenge::RVNGPropertyList &propList)
+{
+  m_impl->record(TRACE_OPEN_COMMENT, propList);
+  if (m_impl->m_next)
+    m_impl->m_next->openComment(propList);
+}
+
+void EPUBTextTraceRecorder::openEndnote(const librevenge::RVNGPropertyList &propList)
+{
+  m_impl->record(TRACE_OPEN_ENDNOTE, propList);
+  if (m_impl->m_next)
+    m_impl->m_next->openEndnote(propList);
+}
+
+void EPUBTextTraceRecorder::openFooter(const librevenge::RVNGPropertyList &propList)
+{
+  m_impl->record(TRACE_OPEN_FOOTER, propList);
+  if (m_impl->m_next)
+    m_impl->m_next->openFooter(propList);
+}
+
+void EPUBTextTraceRecorder::openFootnote(const librevenge::RVNGPropertyList &propList)
+{
+  m_impl->record(TRACE_OPEN_FOOTNOTE, propList);
+  if (m_impl->m_next)
+    m_impl->m_next->openFootnote(propList);
+}
+
+void EPUBTextTraceRecorder::openFrame(const librevenge::RVNGPropertyList &propList)
+{
+  m_impl->record(TRACE_OPEN_FRAME, propList);
+  if (m_impl->m_next)
+    m_impl->m_next->openFrame(propList);
+}
+
+void EPUBTextTraceRecorder::openGroup(const librevenge::RVNGPropertyList &propList)
+{
+  m_impl->record(TRACE_OPEN_GROUP, propList);
+  if (m_impl->m_next)
+    m_impl->m_next->openGroup(propList);
+}
+
+void EPUBTextTraceRecorder::openHeader(const librevenge::RVNGPropertyList &propList)
+{
+  m_impl->record(TRACE_OPEN_HEADER, propList);
+  if (m_impl->m_next)
+    m_impl->m_next->openHeader(propList);
+}
+
+void EPUBTextTraceRecorder::openLink(const librevenge::RVNGPropertyList &propList)
+{
+  m_impl->record(TRACE_OPEN_LINK, propList);
+  if (m_impl->m_next)
+    m_impl->m_next->openLink(propList);
+}
+
+void EPUBTextTraceRecorder::openListElement(const librevenge::RVNGPropertyList &propList)
+{
+  m_impl->record(TRACE_OPEN_LIST_ELEMENT, propList);
+  if (m_impl->m_next)
+    m_impl->m_next->openListElement(propList);
+}
+
+void EPUBTextTraceRecorder::openOrderedListLevel(const librevenge::RVNGPropertyList &propList)
+{
+  m_impl->record(TRACE_OPEN_ORDERED_LIST_LEVEL, propList);
+  if (m_impl->m_next)
+    m_impl->m_next->openOrderedListLevel(propList);
+}
+
+void EPUBTextTraceRecorder::openPageSpan(const librevenge::RVNGPropertyList &propList)
+{
+  m_impl->record(TRACE_OPEN_PAGE_SPAN, propList);
+  if (m_impl->m_next)
+    m_impl->m_next->openPageSpan(propList);
+}
+
+void EPUBTextTraceRecorder::openParagraph(const librevenge::RVNGPropertyList &propList)
+{
+  m_impl->record(TRACE_OPEN_PARAGRAPH, propList);
+  if (m_impl->m_next)
+    m_impl->m_next->openParagraph(propList);
+}
+
+void EPUBTextTraceRecorder::openSection(const librevenge::RVNGPropertyList &propList)
+{
+  m_impl->record(TRACE_OPEN_SECTION, propList);
+  if (m_impl->m_next)
+    m_impl->m_next->openSection(propList);
+}
+
+void EPUBTextTraceRecorder::openSpan(const librevenge::RVNGPropertyList &propList)
+{
+  m_impl->record(TRACE_OPEN_SPAN, propList);
+  if (m_impl->m_next)
+    m_impl->m_next->openSpan(propList);
+}
+
+void EPUBTextTraceRecorder::openTable(const librevenge::RVNGPropertyList &propList)
+{
+  m_impl->record(TRACE_OPEN_TABLE, propList);
+  if (m_impl->m_next)
+    m_impl->m_next->openTable(propList);
+}
+
+void EPUBTextTraceRecorder::openTableCell(const librevenge::RVNGPropertyList &propList)
+{
+  m_impl->record(TRACE_OPEN_TABLE_CELL, propList);
+  if (m_impl->m_next)
+    m_impl->m_next->openTableCell(propList);
+}
+
+void EPUBTextTraceRecorder::openTableRow(const librevenge::RVNGPropertyList &propList)
+{
+  m_impl->record(TRACE_OPEN_TABLE_ROW, propList);
+  if (m_impl->m_next)
+    m_impl->m_next->openTableRow(propList);
+}
+
+void EPUBTextTraceRecorder::openTextBox(const librevenge::RVNGPropertyList &propList)
+{
+  m_impl->record(TRACE_OPEN_TEXT_BOX, propList);
+  if (m_impl->m_next)
+    m_impl->m_next->openTextBox(propList);
+}
+
+void EPUBTextTraceRecorder::openUnorderedListLevel(const librevenge::RVNGPropertyList &propList)
+{
+  m_impl->record(TRACE_OPEN_UNORDERED_LIST_LEVEL, propList);
+  if (m_impl->m_next)
+    m_impl->m_next->openUnorderedListLevel(propList);
+}
+
+void EPUBTextTraceRecorder::setDocumentMetaData(const librevenge::RVNGPropertyList &propList)
+{
+  m_impl->record(TRACE_SET_DOCUMENT_META_DATA, propList);
+  if (m_impl->m_next)
+    m_impl->m_next->setDocumentMetaData(propList);
+}
+
+void EPUBTextTraceRecorder::startDocument(const librevenge::RVNGPropertyList &propList)
+{
+  m_impl->record(TRACE_START_DOCUMENT, propList);
+  if (m_impl->m_next)
+    m_impl->m_next->startDocument(propList);
+}
+
+EPUBTextTraceReplayer::EPUBTextTraceReplayer()
+  : m_elements(new EPUBTextElements())
+{
+}
+
+EPUBTextTraceReplayer::~EPUBTextTraceReplayer()
+{
+  delete m_elements;
+}
+
+bool EPUBTextTraceReplayer::load(std::istream &trace)
+{
+  char magic[sizeof(TRACE_MAGIC)];
+  unsigned char version = 0;
+  if (!trace.read(magic, sizeof(magic)) || (0 != std::memcmp(magic, TRACE_MAGIC, sizeof(magic))) || !readByte(trace, version))
+  {
+    EPUBGEN_DEBUG_MSG(("EPUBTextTraceReplayer::load: not a trace\n"));
+    return false;
+  }
+  if (TRACE_VERSION != version)
+  {
+    EPUBGEN_DEBUG_MSG(("EPUBTextTraceReplayer::load: unsupported version %d\n", int(version)));
+    return false;
+  }
+
+  unsigned char call = 0;
+  while (readByte(trace, call))
+  {
+    if (TRACE_END == call)
+      return true;
+    if (!readCall(trace, call, *m_elements))
+    {
+      EPUBGEN_DEBUG_MSG(("EPUBTextTraceReplayer::load: broken trace\n"));
+      return false;
+    }
+  }
+  EPUBGEN_DEBUG_MSG(("EPUBTextTraceReplayer::load: truncated trace\n"));
+  return false;
+}
+
+void EPUBTextTraceReplayer::replay(librevenge::RVNGTextInterface *const iface) const
+{
+  m_elements->write(iface);
+}
+
+}
+
+/* vim:set shiftwidth=2 softtabstop=2 expandtab: */
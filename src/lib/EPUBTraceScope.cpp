@@ -0,0 +1,119 @@
+/* -*- Mode: C++; tab-width: 2; indent-tabs-mode: nil; c-basic-offset: 2 -*- */
+/*
+ * This file is part of the libepubgen project.
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#include "EPUBTraceScope.h"
+
+#include <libepubgen/EPUBTraceEvents.h>
+
+#ifdef ENABLE_TRACE
+
+#include <atomic>
+#include <mutex>
+
+#endif
+
+namespace libepubgen
+{
+
+#ifdef ENABLE_TRACE
+
+namespace
+{
+
+/// Where the events go. The stream is only changed with the mutex locked.
+struct TraceSink
+{
+  TraceSink() : m_mutex(), m_stream(nullptr), m_start(), m_empty(true), m_active(false), m_threads(0) {}
+
+  std::mutex m_mutex;
+  std::ostream *m_stream;
+  EPUBTraceScope::Clock::time_point m_start;
+  /// No event was written to the stream yet.
+  bool m_empty;
+  /// Is there a stream? Checked without locking, so scopes are cheap without one.
+  std::atomic<bool> m_active;
+  std::atomic<unsigned> m_threads;
+};
+
+TraceSink &getSink()
+{
+  static TraceSink sink;
+  return sink;
+}
+
+/// Gets a small number identifying the current thread.
+unsigned getThreadId()
+{
+  static thread_local const unsigned id = ++getSink().m_threads;
+  return id;
+}
+
+long long getMicroseconds(const EPUBTraceScope::Clock::duration &duration)
+{
+  return std::chrono::duration_cast<std::chrono::microseconds>(duration).count();
+}
+
+}
+
+EPUBTraceScope::EPUBTraceScope(const char *const name)
+  : m_name(name)
+  , m_active(getSink().m_active.load(std::memory_order_relaxed))
+  , m_start(m_active ? Clock::now() : Clock::time_point())
+{
+}
+
+EPUBTraceScope::~EPUBTraceScope()
+{
+  if (!m_active)
+    return;
+
+  const Clock::time_point end = Clock::now();
+  TraceSink &sink = getSink();
+  const std::lock_guard<std::mutex> lock(sink.m_mutex);
+  // The stream could have been changed while the scope existed.
+  if (!sink.m_stream || (m_start < sink.m_start))
+    return;
+
+  std::ostream &stream = *sink.m_stream;
+  stream << (sink.m_empty ? "[\n" : ",\n")
+         << "{\"name\":\"" << m_name << "\",\"cat\":\"libepubgen\",\"ph\":\"X\""
+         << ",\"ts\":" << getMicroseconds(m_start - sink.m_start)
+         << ",\"dur\":" << getMicroseconds(end - m_start)
+         << ",\"pid\":1,\"tid\":" << getThreadId() << "}";
+  sink.m_empty = false;
+}
+
+bool setTraceEventStream(std::ostream *const stream)
+{
+  TraceSink &sink = getSink();
+  const std::lock_guard<std::mutex> lock(sink.m_mutex);
+  if (sink.m_stream)
+  {
+    *sink.m_stream << (sink.m_empty ? "[" : "\n") << "]\n";
+    sink.m_stream->flush();
+  }
+  sink.m_stream = stream;
+  sink.m_start = EPUBTraceScope::Clock::now();
+  sink.m_empty = true;
+  sink.m_active = bool(stream);
+  return true;
+}
+
+#else
+
+bool setTraceEventStream(std::ostream *)
+{
+  return false;
+}
+
+#endif
+
+}
+
+/* vim:set shiftwidth=2 softtabstop=2 expandtab: */
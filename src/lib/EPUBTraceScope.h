@@ -0,0 +1,59 @@
+/* -*- Mode: C++; tab-width: 2; indent-tabs-mode: nil; c-basic-offset: 2 -*- */
+/*
+ * This file is part of the libepubgen project.
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#ifndef INCLUDED_EPUBTRACESCOPE_H
+#define INCLUDED_EPUBTRACESCOPE_H
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+// record trace events only if configured with --enable-trace
+#ifdef ENABLE_TRACE
+
+#include <chrono>
+
+namespace libepubgen
+{
+
+/// Writes a trace event for the time it exists, if a trace event stream is set.
+class EPUBTraceScope
+{
+  // disable copying
+  EPUBTraceScope(const EPUBTraceScope &);
+  EPUBTraceScope &operator=(const EPUBTraceScope &);
+
+public:
+  typedef std::chrono::steady_clock Clock;
+
+  /// @param[in] name the name of the event; it must be a literal
+  explicit EPUBTraceScope(const char *name);
+  ~EPUBTraceScope();
+
+private:
+  const char *const m_name;
+  const bool m_active;
+  const Clock::time_point m_start;
+};
+
+}
+
+#define EPUBGEN_TRACE_CONCAT2(a, b) a ## b
+#define EPUBGEN_TRACE_CONCAT(a, b) EPUBGEN_TRACE_CONCAT2(a, b)
+#define EPUBGEN_TRACE_SCOPE(name) const libepubgen::EPUBTraceScope EPUBGEN_TRACE_CONCAT(traceScope, __LINE__)(name)
+
+#else
+
+#define EPUBGEN_TRACE_SCOPE(name)
+
+#endif
+
+#endif // INCLUDED_EPUBTRACESCOPE_H
+
+/* vim:set shiftwidth=2 softtabstop=2 expandtab: */
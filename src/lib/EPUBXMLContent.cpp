@@ -9,10 +9,15 @@
 
 #include "EPUBXMLContent.h"
 
+#include <algorithm>
+#include <cstring>
 #include <string>
 
 #include <libepubgen/EPUBPackage.h>
 
+#include "EPUBMemoryUsage.h"
+#include "EPUBStatistics.h"
+
 namespace libepubgen
 {
 
@@ -105,18 +110,26 @@ class InsertCharacters : public EPUBXMLElement
   InsertCharacters &operator=(const InsertCharacters &);
 
 public:
-  explicit InsertCharacters(const RVNGString &characters);
+  InsertCharacters();
+
+  /// Gets the text, so following runs can be appended to it.
+  RVNGString &getCharacters();
 
 private:
   void writeTo(EPUBPackage &package) const override;
 
 private:
-  const RVNGString m_characters;
+  RVNGString m_characters;
 };
 
-InsertCharacters::InsertCharacters(const RVNGString &characters)
-  : m_characters(characters)
+InsertCharacters::InsertCharacters()
+  : m_characters()
+{
+}
+
+RVNGString &InsertCharacters::getCharacters()
 {
+  return m_characters;
 }
 
 void InsertCharacters::writeTo(EPUBPackage &package) const
@@ -126,19 +139,57 @@ void InsertCharacters::writeTo(EPUBPackage &package) const
 
 }
 
+void appendCharacters(RVNGString &text, const char *str, std::size_t length)
+{
+  char chunk[256];
+  while (length > 0)
+  {
+    const std::size_t chunkLength = std::min(length, sizeof(chunk) - 1);
+    std::copy(str, str + chunkLength, chunk);
+    chunk[chunkLength] = '\0';
+    text.append(chunk);
+    str += chunkLength;
+    length -= chunkLength;
+  }
+}
+
+namespace
+{
+
+/// Estimated memory of an element of type T: the object with its reference count and its slot.
+template<class T>
+std::size_t elementMemory()
+{
+  return sizeof(T) + 2 * sizeof(long) + sizeof(std::shared_ptr<EPUBXMLElement>);
+}
+
+}
+
 EPUBXMLContent::EPUBXMLContent()
   : m_elements()
+  , m_size(0)
+  , m_memory(0)
+  , m_lastCharacters(nullptr)
 {
 }
 
 void EPUBXMLContent::openElement(const char *const name, const librevenge::RVNGPropertyList &attributes)
 {
   m_elements.push_back(std::make_shared<OpenElement>(name, attributes));
+  m_lastCharacters = nullptr;
+
+  // <name key="value">
+  m_size += std::strlen(name) + 2 + getSerializedAttributesSize(attributes);
+
+  m_memory += elementMemory<OpenElement>() + estimateMemory(std::strlen(name)) + estimateMemory(attributes);
 }
 
 void EPUBXMLContent::closeElement(const char *const name)
 {
   m_elements.push_back(std::make_shared<CloseElement>(name));
+  m_lastCharacters = nullptr;
+  m_size += std::strlen(name) + 3;
+  m_memory += elementMemory<CloseElement>() + estimateMemory(std::strlen(name));
 }
 
 void EPUBXMLContent::insertEmptyElement(const char *const name, const librevenge::RVNGPropertyList &attributes)
@@ -149,12 +200,45 @@ void EPUBXMLContent::insertEmptyElement(const char *const name, const librevenge
 
 void EPUBXMLContent::insertCharacters(const librevenge::RVNGString &characters)
 {
-  m_elements.push_back(std::make_shared<InsertCharacters>(characters));
+  getLastCharacters(characters.size()).append(characters);
+  m_size += getEscapedSize(characters.cstr(), characters.size(), false);
+}
+
+void EPUBXMLContent::insertCharacters(const char *const characters)
+{
+  insertCharacters(characters, std::strlen(characters));
+}
+
+void EPUBXMLContent::insertCharacters(const char *const characters, const std::size_t length)
+{
+  appendCharacters(getLastCharacters(length), characters, length);
+  m_size += getEscapedSize(characters, length, false);
+}
+
+librevenge::RVNGString &EPUBXMLContent::getLastCharacters(const std::size_t length)
+{
+  // A copy of this content shares the element, so it must not be changed then.
+  if (m_lastCharacters && (1 == m_elements.back().use_count()))
+  {
+    m_memory += length;
+  }
+  else
+  {
+    const std::shared_ptr<InsertCharacters> element = std::make_shared<InsertCharacters>();
+    m_elements.push_back(element);
+    m_lastCharacters = &element->getCharacters();
+    m_memory += elementMemory<InsertCharacters>() + sizeof(std::string) + estimateMemory(length);
+  }
+  return *m_lastCharacters;
 }
 
 void EPUBXMLContent::append(const EPUBXMLContent &other)
 {
   m_elements.insert(m_elements.end(), other.m_elements.begin(), other.m_elements.end());
+  m_lastCharacters = nullptr;
+  m_size += other.m_size;
+  // The elements are shared, but other is usually dropped afterwards.
+  m_memory += other.m_memory;
 }
 
 bool EPUBXMLContent::empty() const
@@ -162,6 +246,21 @@ bool EPUBXMLContent::empty() const
   return m_elements.empty();
 }
 
+std::size_t EPUBXMLContent::getEventCount() const
+{
+  return m_elements.size();
+}
+
+std::size_t EPUBXMLContent::size() const
+{
+  return m_size;
+}
+
+std::size_t EPUBXMLContent::getMemory() const
+{
+  return m_memory;
+}
+
 void EPUBXMLContent::writeTo(EPUBPackage &package, const char *const name)
 {
   package.openXMLFile(name);
@@ -170,6 +269,51 @@ void EPUBXMLContent::writeTo(EPUBPackage &package, const char *const name)
   package.closeXMLFile();
 }
 
+void EPUBXMLContent::writeTo(EPUBStatisticsPackage &package, const char *const name)
+{
+  package.addXMLBytes(m_size);
+  writeTo(static_cast<EPUBPackage &>(package), name);
+}
+
+std::size_t getEscapedSize(const char *str, const std::size_t length, const bool attribute)
+{
+  std::size_t size = 0;
+  for (const char *const end = str + length; end != str; ++str)
+  {
+    switch (*str)
+    {
+    case '&':
+      size += 5;
+      break;
+    case '<':
+    case '>':
+      size += 4;
+      break;
+    case '"':
+      size += attribute ? 6 : 1;
+      break;
+    default:
+      ++size;
+    }
+  }
+  return size;
+}
+
+std::size_t getSerializedAttributesSize(const librevenge::RVNGPropertyList &attributes)
+{
+  std::size_t size = 0;
+  librevenge::RVNGPropertyList::Iter i(attributes);
+  for (i.rewind(); i.next();)
+  {
+    if (i())
+    {
+      const RVNGString value = i()->getStr();
+      size += std::strlen(i.key()) + getEscapedSize(value.cstr(), value.size(), true) + 4;
+    }
+  }
+  return size;
+}
+
 }
 
 /* vim:set shiftwidth=2 softtabstop=2 expandtab: */
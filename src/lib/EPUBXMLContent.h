@@ -10,6 +10,7 @@
 #ifndef INCLUDED_EPUBXMLCONTENT_H
 #define INCLUDED_EPUBXMLCONTENT_H
 
+#include <cstddef>
 #include <deque>
 #include <memory>
 
@@ -19,6 +20,7 @@ namespace libepubgen
 {
 
 class EPUBPackage;
+class EPUBStatisticsPackage;
 class EPUBXMLElement;
 
 class EPUBXMLContent
@@ -32,17 +34,61 @@ public:
   void insertEmptyElement(const char *name, const librevenge::RVNGPropertyList &attributes = librevenge::RVNGPropertyList());
 
   void insertCharacters(const librevenge::RVNGString &characters);
+  void insertCharacters(const char *characters);
+  /** Inserts a run of characters.
+    *
+    * A run following another one is appended to it, so the text of a
+    * paragraph usually ends up in a single element.
+    *
+    * @param[in] characters the UTF-8 text; it does not need to be null-terminated
+    * @param[in] length the length of characters, in bytes; there is no null character before it
+    */
+  void insertCharacters(const char *characters, std::size_t length);
 
   void append(const EPUBXMLContent &other);
 
   void writeTo(EPUBPackage &package, const char *name);
+  /// Writes to a package which counts it, with the estimated size of the file.
+  void writeTo(EPUBStatisticsPackage &package, const char *name);
 
   bool empty() const;
 
+  /// Estimated size of the serialized content, in bytes.
+  std::size_t size() const;
+
+  /// The number of XML events: start and end tags and character runs.
+  std::size_t getEventCount() const;
+
+  /// Estimated heap memory used by the events, in bytes.
+  std::size_t getMemory() const;
+
+private:
+  /// Gets the run of characters to append length bytes to, adding one if needed.
+  librevenge::RVNGString &getLastCharacters(std::size_t length);
+
 private:
   std::deque<std::shared_ptr<EPUBXMLElement>> m_elements;
+  std::size_t m_size;
+  std::size_t m_memory;
+  /// The text of the last element, if it is a run of characters.
+  librevenge::RVNGString *m_lastCharacters;
 };
 
+/** Appends the first length bytes of str to text, without a temporary string.
+  *
+  * There must be no null character among them, as text cannot hold one.
+  */
+void appendCharacters(librevenge::RVNGString &text, const char *str, std::size_t length);
+
+/// Size of the first length bytes of str after XML escaping.
+std::size_t getEscapedSize(const char *str, std::size_t length, bool attribute);
+
+/** Estimated size of attributes in XML.
+  *
+  * Each attribute counts as ` key="value"`, with the value escaped.
+  */
+std::size_t getSerializedAttributesSize(const librevenge::RVNGPropertyList &attributes);
+
 }
 
 #endif // INCLUDED_EPUBXMLCONTENT_H
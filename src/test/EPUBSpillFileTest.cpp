@@ -0,0 +1,147 @@
+/* -*- Mode: C++; tab-width: 2; indent-tabs-mode: nil; c-basic-offset: 2 -*- */
+/*
+ * This file is part of the libepubgen project.
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#include <cstddef>
+#include <cstdio>
+
+#include <cppunit/TestFixture.h>
+#include <cppunit/extensions/HelperMacros.h>
+
+#include <libepubgen/EPUBNullPackage.h>
+
+#include "EPUBSpillFile.h"
+#include "EPUBStatistics.h"
+#include "EPUBXMLContent.h"
+
+namespace test
+{
+
+using libepubgen::EPUBNullPackage;
+using libepubgen::EPUBSpillFile;
+using libepubgen::EPUBStatistics;
+using libepubgen::EPUBStatisticsPackage;
+using libepubgen::EPUBXMLContent;
+
+class EPUBSpillFileTest : public CPPUNIT_NS::TestFixture
+{
+public:
+  virtual void setUp();
+  virtual void tearDown();
+
+private:
+  CPPUNIT_TEST_SUITE(EPUBSpillFileTest);
+  CPPUNIT_TEST(testReplay);
+  CPPUNIT_TEST(testDamaged);
+  CPPUNIT_TEST_SUITE_END();
+
+private:
+  void testReplay();
+  void testDamaged();
+};
+
+namespace
+{
+
+void fill(EPUBXMLContent &content, const char *const text)
+{
+  content.openElement("html");
+  content.openElement("p");
+  content.insertCharacters(text);
+  content.closeElement("p");
+  content.closeElement("html");
+}
+
+}
+
+void EPUBSpillFileTest::setUp()
+{
+}
+
+void EPUBSpillFileTest::tearDown()
+{
+}
+
+void EPUBSpillFileTest::testReplay()
+{
+  EPUBSpillFile spillFile;
+  EPUBXMLContent first;
+  fill(first, "Hello");
+  EPUBXMLContent second;
+  fill(second, "World");
+  std::size_t firstRecord = 0;
+  std::size_t secondRecord = 0;
+  CPPUNIT_ASSERT(spillFile.spill(first, "first.xhtml", firstRecord));
+  CPPUNIT_ASSERT(spillFile.spill(second, "second.xhtml", secondRecord));
+  CPPUNIT_ASSERT(firstRecord != secondRecord);
+
+  // The records are read back in any order.
+  EPUBNullPackage nullPackage;
+  EPUBStatistics statistics;
+  EPUBStatisticsPackage package(&nullPackage, statistics);
+  CPPUNIT_ASSERT(spillFile.replay(secondRecord, package));
+  CPPUNIT_ASSERT(spillFile.replay(firstRecord, package));
+  CPPUNIT_ASSERT_EQUAL(2UL, statistics.m_files);
+  CPPUNIT_ASSERT_EQUAL(4UL, statistics.m_elements);
+  CPPUNIT_ASSERT_EQUAL(static_cast<unsigned long>(first.size() + second.size()), statistics.m_xmlBytes);
+
+  // There is no such record.
+  CPPUNIT_ASSERT(!spillFile.replay(secondRecord + 1, package));
+  CPPUNIT_ASSERT_EQUAL(2UL, statistics.m_files);
+}
+
+void EPUBSpillFileTest::testDamaged()
+{
+  std::FILE *const file = std::tmpfile();
+  CPPUNIT_ASSERT(file);
+  EPUBSpillFile spillFile(file);
+  EPUBXMLContent first;
+  fill(first, "Hello");
+  EPUBXMLContent second;
+  fill(second, "World");
+  EPUBXMLContent third;
+  fill(third, "Again");
+  std::size_t firstRecord = 0;
+  std::size_t secondRecord = 0;
+  std::size_t thirdRecord = 0;
+  CPPUNIT_ASSERT(spillFile.spill(first, "first.xhtml", firstRecord));
+  CPPUNIT_ASSERT(spillFile.spill(second, "second.xhtml", secondRecord));
+  CPPUNIT_ASSERT(spillFile.spill(third, "third.xhtml", thirdRecord));
+
+  // Replace the length of the name of the first record by a huge one.
+  // The record starts the file, with its size in one byte and the call in another.
+  CPPUNIT_ASSERT(first.size() < 0x80);
+  CPPUNIT_ASSERT_EQUAL(0, std::fseek(file, 2, SEEK_SET));
+  for (int i = 0; i < 9; ++i)
+    CPPUNIT_ASSERT(EOF != std::fputc(0xff, file));
+  CPPUNIT_ASSERT(EOF != std::fputc(0x01, file));
+  // Replace the end of the third record by an unknown call.
+  CPPUNIT_ASSERT_EQUAL(0, std::fseek(file, -1, SEEK_END));
+  CPPUNIT_ASSERT(EOF != std::fputc(0x7f, file));
+  CPPUNIT_ASSERT_EQUAL(0, std::fflush(file));
+
+  EPUBNullPackage nullPackage;
+  EPUBStatistics statistics;
+  EPUBStatisticsPackage package(&nullPackage, statistics);
+  // Nothing is written for the damaged records, not even a part of them.
+  CPPUNIT_ASSERT(!spillFile.replay(firstRecord, package));
+  CPPUNIT_ASSERT(!spillFile.replay(thirdRecord, package));
+  CPPUNIT_ASSERT_EQUAL(0UL, statistics.m_files);
+  CPPUNIT_ASSERT_EQUAL(0UL, statistics.m_elements);
+  CPPUNIT_ASSERT_EQUAL(0UL, statistics.m_xmlBytes);
+
+  // The other record is intact.
+  CPPUNIT_ASSERT(spillFile.replay(secondRecord, package));
+  CPPUNIT_ASSERT_EQUAL(1UL, statistics.m_files);
+}
+
+CPPUNIT_TEST_SUITE_REGISTRATION(EPUBSpillFileTest);
+
+}
+
+/* vim:set shiftwidth=2 softtabstop=2 expandtab: */
@@ -8,9 +8,11 @@
  */
 
 #include <algorithm>
+#include <functional>
 #include <map>
 #include <memory>
 #include <set>
+#include <sstream>
 #include <string>
 #include <vector>
 
@@ -22,8 +24,12 @@
 #include <libxml/xpath.h>
 #include <libxml/xpathInternals.h>
 
+#include <libepubgen/EPUBDrawingGenerator.h>
+#include <libepubgen/EPUBNullPackage.h>
 #include <libepubgen/EPUBPackage.h>
 #include <libepubgen/EPUBTextGenerator.h>
+#include <libepubgen/EPUBTextTrace.h>
+#include <libepubgen/EPUBTraceEvents.h>
 
 namespace test
 {
@@ -250,6 +256,32 @@ private:
   CPPUNIT_TEST(testSplitOnSizeInPageSpan);
   CPPUNIT_TEST(testManyWritingModes);
   CPPUNIT_TEST(testRubyElements);
+  CPPUNIT_TEST(testStylesheetPerSection);
+  CPPUNIT_TEST(testSpanStylesDelta);
+  CPPUNIT_TEST(testClassNamesContent);
+  CPPUNIT_TEST(testTableRepeatedRows);
+  CPPUNIT_TEST(testUnusedStyles);
+  CPPUNIT_TEST(testSplitOnSizeWithImage);
+  CPPUNIT_TEST(testSplitDetect);
+  CPPUNIT_TEST(testSplitInStructure);
+  CPPUNIT_TEST(testSplitPlanBalanced);
+  CPPUNIT_TEST(testMaxSectionSize);
+  CPPUNIT_TEST(testSectionReport);
+  CPPUNIT_TEST(testPagedSplitSize);
+  CPPUNIT_TEST(testPagedMaxSectionSize);
+  CPPUNIT_TEST(testNotesSeparate);
+  CPPUNIT_TEST(testHeadingTitleRuns);
+  CPPUNIT_TEST(testTocOutline);
+  CPPUNIT_TEST(testTextTrace);
+  CPPUNIT_TEST(testStatistics);
+  CPPUNIT_TEST(testTraceEvents);
+  CPPUNIT_TEST(testMemoryUsage);
+  CPPUNIT_TEST(testMemoryBudget);
+  CPPUNIT_TEST(testMeasureOutput);
+  CPPUNIT_TEST(testProgress);
+  CPPUNIT_TEST(testInsertTextBuffer);
+  CPPUNIT_TEST(testInsertTextNull);
+  CPPUNIT_TEST(testTextTraceHeaderRow);
   CPPUNIT_TEST_SUITE_END();
 
 private:
@@ -298,6 +330,32 @@ private:
   void testSplitOnSizeInPageSpan();
   void testManyWritingModes();
   void testRubyElements();
+  void testStylesheetPerSection();
+  void testSpanStylesDelta();
+  void testClassNamesContent();
+  void testTableRepeatedRows();
+  void testUnusedStyles();
+  void testSplitOnSizeWithImage();
+  void testSplitDetect();
+  void testSplitInStructure();
+  void testSplitPlanBalanced();
+  void testMaxSectionSize();
+  void testSectionReport();
+  void testPagedSplitSize();
+  void testPagedMaxSectionSize();
+  void testNotesSeparate();
+  void testHeadingTitleRuns();
+  void testTocOutline();
+  void testTextTrace();
+  void testStatistics();
+  void testTraceEvents();
+  void testMemoryUsage();
+  void testMemoryBudget();
+  void testMeasureOutput();
+  void testProgress();
+  void testInsertTextBuffer();
+  void testInsertTextNull();
+  void testTextTraceHeaderRow();
 
   /// Asserts that exactly one xpath exists in buffer, and its content equals content.
   void assertXPathContent(xmlBufferPtr buffer, const std::string &xpath, const std::string &content, const CppUnit::SourceLine &rSourceLine);
@@ -336,6 +394,103 @@ void registerNamespaces(xmlXPathContextPtr xpathContext)
   xmlXPathRegisterNs(xpathContext, BAD_CAST("dc"), BAD_CAST("http://purl.org/dc/elements/1.1/"));
   xmlXPathRegisterNs(xpathContext, BAD_CAST("opf"), BAD_CAST("http://www.idpf.org/2007/opf"));
   xmlXPathRegisterNs(xpathContext, BAD_CAST("xhtml"), BAD_CAST("http://www.w3.org/1999/xhtml"));
+  xmlXPathRegisterNs(xpathContext, BAD_CAST("ncx"), BAD_CAST("http://www.daisy.org/z3986/2005/ncx/"));
+}
+
+/// Writes paragraphs of 100 characters.
+void writeParagraphs(libepubgen::EPUBTextGenerator &generator, const int count, const librevenge::RVNGPropertyList &paraProps = librevenge::RVNGPropertyList())
+{
+  const std::string text(100, 'x');
+  for (int i = 0; i < count; ++i)
+  {
+    generator.openParagraph(paraProps);
+    generator.insertText(text.c_str());
+    generator.closeParagraph();
+  }
+}
+
+/// Writes pages of a paragraph of 500 characters.
+void writePages(libepubgen::EPUBDrawingGenerator &generator, const int count)
+{
+  const std::string text(500, 'x');
+  for (int i = 0; i < count; ++i)
+  {
+    generator.startPage(librevenge::RVNGPropertyList());
+    generator.startTextObject(librevenge::RVNGPropertyList());
+    generator.openParagraph(librevenge::RVNGPropertyList());
+    generator.insertText(text.c_str());
+    generator.closeParagraph();
+    generator.endTextObject();
+    generator.endPage();
+  }
+}
+
+/// Writes a document of three sections, split on page breaks, with a footnote in each.
+void writeSections(libepubgen::EPUBTextGenerator &generator)
+{
+  generator.startDocument(librevenge::RVNGPropertyList());
+  for (int i = 0; i < 3; ++i)
+  {
+    librevenge::RVNGPropertyList paraProps;
+    if (i > 0)
+      paraProps.insert("fo:break-before", "page");
+    generator.openParagraph(paraProps);
+    generator.insertText("Hello & <world>");
+    generator.openFootnote(librevenge::RVNGPropertyList());
+    generator.openParagraph(librevenge::RVNGPropertyList());
+    generator.insertText("Note");
+    generator.closeParagraph();
+    generator.closeFootnote();
+    generator.closeParagraph();
+  }
+  generator.endDocument();
+}
+
+/// Writes a heading, which is in the outline, then a table with a header row, which is recorded.
+void writeHeadingAndHeaderRow(libepubgen::EPUBTextGenerator &generator, const char *const heading, const std::size_t headingLength, const char *const header, const std::size_t headerLength)
+{
+  generator.startDocument(librevenge::RVNGPropertyList());
+  librevenge::RVNGPropertyList headingProps;
+  headingProps.insert("text:outline-level", "1");
+  generator.openParagraph(headingProps);
+  generator.insertText(heading, headingLength);
+  generator.closeParagraph();
+  generator.openTable(librevenge::RVNGPropertyList());
+  librevenge::RVNGPropertyList headerRow;
+  headerRow.insert("librevenge:is-header-row", true);
+  generator.openTableRow(headerRow);
+  generator.openTableCell(librevenge::RVNGPropertyList());
+  generator.openParagraph(librevenge::RVNGPropertyList());
+  generator.insertText(header, headerLength);
+  generator.closeParagraph();
+  generator.closeTableCell();
+  generator.closeTableRow();
+  generator.closeTable();
+  generator.endDocument();
+}
+
+/// A step of generateText(), applied to its generator.
+typedef std::function<void(libepubgen::EPUBTextGenerator &)> TextStep_t;
+
+/** Writes a document to package with a new text generator.
+  *
+  * @param[in] setUp sets the options of the generator
+  * @param[in] write writes the document
+  * @param[out] statistics if not null, gets the statistics of the generation
+  * @param[out] usage if not null, gets the memory usage at the end
+  * @return whether the generation was cancelled
+  */
+bool generateText(libepubgen::EPUBPackage &package, const TextStep_t &setUp, const TextStep_t &write,
+                  librevenge::RVNGPropertyList *const statistics = nullptr, librevenge::RVNGPropertyList *const usage = nullptr)
+{
+  libepubgen::EPUBTextGenerator generator(&package);
+  setUp(generator);
+  write(generator);
+  if (statistics)
+    generator.getStatistics(*statistics);
+  if (usage)
+    generator.getMemoryUsage(*usage);
+  return generator.isCancelled();
 }
 }
 
@@ -1670,6 +1825,1016 @@ void EPUBTextGeneratorTest::testRubyElements()
   CPPUNIT_ASSERT_XPATH_CONTENT(package.m_streams["OEBPS/sections/section0001.xhtml"], "//xhtml:ruby/xhtml:span", "base text");
 }
 
+void EPUBTextGeneratorTest::testStylesheetPerSection()
+{
+  StringEPUBPackage package;
+  libepubgen::EPUBTextGenerator generator(&package);
+  generator.setOption(libepubgen::EPUB_GENERATOR_OPTION_STYLESHEET, libepubgen::EPUB_STYLESHEET_METHOD_PER_SECTION);
+  generator.startDocument(librevenge::RVNGPropertyList());
+  generator.openParagraph(librevenge::RVNGPropertyList());
+  librevenge::RVNGPropertyList bold;
+  bold.insert("fo:font-weight", "bold");
+  generator.openSpan(bold);
+  generator.insertText("Section 1");
+  generator.closeSpan();
+  generator.closeParagraph();
+  librevenge::RVNGPropertyList pageBreak;
+  pageBreak.insert("fo:break-before", "page");
+  generator.openParagraph(pageBreak);
+  librevenge::RVNGPropertyList italic;
+  italic.insert("fo:font-style", "italic");
+  generator.openSpan(italic);
+  generator.insertText("Section 2");
+  generator.closeSpan();
+  generator.closeParagraph();
+  generator.endDocument();
+
+  // Each section links both the shared and its own stylesheet.
+  CPPUNIT_ASSERT_XPATH(package.m_streams["OEBPS/sections/section0001.xhtml"], "//xhtml:link", 2);
+  CPPUNIT_ASSERT_XPATH_ATTRIBUTE(package.m_streams["OEBPS/sections/section0001.xhtml"], "//xhtml:link[2]", "href", "../styles/section0001.css");
+  CPPUNIT_ASSERT_XPATH_ATTRIBUTE(package.m_streams["OEBPS/content.opf"], "/opf:package/opf:manifest/opf:item[@href='styles/section0002.css']", "media-type", "text/css");
+
+  // Section stylesheets only contain the classes used by that section.
+  CPPUNIT_ASSERT_CSS(package.m_cssStreams["OEBPS/styles/section0001.css"], ".span0", "font-weight: bold", true);
+  CPPUNIT_ASSERT(package.m_cssStreams["OEBPS/styles/section0001.css"].count(".span1") == 0);
+  CPPUNIT_ASSERT_CSS(package.m_cssStreams["OEBPS/styles/section0002.css"], ".span1", "font-style: italic", true);
+  CPPUNIT_ASSERT(package.m_cssStreams["OEBPS/styles/section0002.css"].count(".span0") == 0);
+  // The shared stylesheet has no class rules.
+  CPPUNIT_ASSERT(package.m_cssStreams["OEBPS/styles/stylesheet.css"].count(".span0") == 0);
+}
+
+void EPUBTextGeneratorTest::testSpanStylesDelta()
+{
+  StringEPUBPackage package;
+  libepubgen::EPUBTextGenerator generator(&package);
+  generator.setOption(libepubgen::EPUB_GENERATOR_OPTION_SPAN_STYLES, libepubgen::EPUB_SPAN_STYLES_METHOD_DELTA);
+  generator.startDocument(librevenge::RVNGPropertyList());
+  librevenge::RVNGPropertyList paragraph;
+  paragraph.insert("fo:font-weight", "bold");
+  generator.openParagraph(paragraph);
+  librevenge::RVNGPropertyList bold;
+  bold.insert("fo:font-weight", "bold");
+  generator.openSpan(bold);
+  generator.insertText("same");
+  generator.closeSpan();
+  librevenge::RVNGPropertyList boldItalic;
+  boldItalic.insert("fo:font-weight", "bold");
+  boldItalic.insert("fo:font-style", "italic");
+  generator.openSpan(boldItalic);
+  generator.insertText("different");
+  generator.closeSpan();
+  generator.closeParagraph();
+  generator.endDocument();
+
+  // The paragraph provides the common text properties.
+  CPPUNIT_ASSERT_CSS(package.m_cssStreams["OEBPS/styles/stylesheet.css"], ".para0", "font-weight: bold", true);
+  // The span repeating the paragraph is omitted, the other only has the difference.
+  CPPUNIT_ASSERT_XPATH(package.m_streams["OEBPS/sections/section0001.xhtml"], "//xhtml:p/xhtml:span", 1);
+  CPPUNIT_ASSERT_XPATH_CONTENT(package.m_streams["OEBPS/sections/section0001.xhtml"], "//xhtml:p/xhtml:span", "different");
+  CPPUNIT_ASSERT_CSS(package.m_cssStreams["OEBPS/styles/stylesheet.css"], ".span0", "font-style: italic", true);
+  CPPUNIT_ASSERT_CSS(package.m_cssStreams["OEBPS/styles/stylesheet.css"], ".span0", "font-weight: bold", false);
+}
+
+void EPUBTextGeneratorTest::testClassNamesContent()
+{
+  librevenge::RVNGPropertyList bold;
+  bold.insert("fo:font-weight", "bold");
+  librevenge::RVNGPropertyList italic;
+  italic.insert("fo:font-style", "italic");
+
+  // The same spans, used in a different order.
+  StringEPUBPackage package1;
+  StringEPUBPackage package2;
+  StringEPUBPackage *const packages[] = { &package1, &package2 };
+  for (int i = 0; i < 2; ++i)
+  {
+    libepubgen::EPUBTextGenerator generator(packages[i]);
+    generator.setOption(libepubgen::EPUB_GENERATOR_OPTION_CLASS_NAMES, libepubgen::EPUB_CLASS_NAMES_METHOD_CONTENT);
+    generator.startDocument(librevenge::RVNGPropertyList());
+    generator.openParagraph(librevenge::RVNGPropertyList());
+    generator.openSpan(i == 0 ? bold : italic);
+    generator.insertText("first");
+    generator.closeSpan();
+    generator.openSpan(i == 0 ? italic : bold);
+    generator.insertText("second");
+    generator.closeSpan();
+    generator.closeParagraph();
+    generator.endDocument();
+  }
+
+  // The class names don't depend on the order the styles were first used.
+  const std::map< std::string, std::vector<std::string> > &css1 = package1.m_cssStreams["OEBPS/styles/stylesheet.css"];
+  const std::map< std::string, std::vector<std::string> > &css2 = package2.m_cssStreams["OEBPS/styles/stylesheet.css"];
+  CPPUNIT_ASSERT(css1 == css2);
+  CPPUNIT_ASSERT(css1.find(".span0") == css1.end());
+  int spanClasses = 0;
+  for (const auto &rule : css1)
+  {
+    if (rule.first.compare(0, 5, ".span") == 0)
+      ++spanClasses;
+  }
+  CPPUNIT_ASSERT_EQUAL(2, spanClasses);
+}
+
+void EPUBTextGeneratorTest::testTableRepeatedRows()
+{
+  StringEPUBPackage package;
+  libepubgen::EPUBTextGenerator generator(&package);
+  generator.startDocument(librevenge::RVNGPropertyList());
+
+  librevenge::RVNGPropertyList column;
+  column.insert("style:column-width", "1in");
+  librevenge::RVNGPropertyList column2;
+  column2.insert("style:column-width", "3in");
+  librevenge::RVNGPropertyListVector columns;
+  columns.append(column);
+  columns.append(column2);
+  librevenge::RVNGPropertyList table;
+  table.insert("librevenge:table-columns", columns);
+
+  librevenge::RVNGPropertyList innerColumn;
+  innerColumn.insert("style:column-width", "2in");
+  librevenge::RVNGPropertyListVector innerColumns;
+  innerColumns.append(innerColumn);
+  librevenge::RVNGPropertyList innerTable;
+  innerTable.insert("librevenge:table-columns", innerColumns);
+
+  librevenge::RVNGPropertyList cell;
+  cell.insert("librevenge:column", 0);
+  librevenge::RVNGPropertyList cell2;
+  cell2.insert("librevenge:column", 1);
+
+  generator.openTable(table);
+  for (int row = 0; row < 2; ++row)
+  {
+    generator.openTableRow(librevenge::RVNGPropertyList());
+    generator.openTableCell(cell);
+    if (row == 1)
+    {
+      // Same cell properties, but different column widths.
+      generator.openTable(innerTable);
+      generator.openTableRow(librevenge::RVNGPropertyList());
+      generator.openTableCell(cell);
+      generator.closeTableCell();
+      generator.closeTableRow();
+      generator.closeTable();
+    }
+    generator.closeTableCell();
+    generator.openTableCell(cell2);
+    generator.closeTableCell();
+    generator.closeTableRow();
+  }
+  generator.closeTable();
+  generator.endDocument();
+
+  // The repeated row reuses the classes of the first one.
+  CPPUNIT_ASSERT_XPATH(package.m_streams["OEBPS/sections/section0001.xhtml"], "//xhtml:td[@class='cellTable0']", 2);
+  CPPUNIT_ASSERT_XPATH(package.m_streams["OEBPS/sections/section0001.xhtml"], "//xhtml:td[@class='cellTable1']", 2);
+  CPPUNIT_ASSERT_CSS(package.m_cssStreams["OEBPS/styles/stylesheet.css"], ".cellTable0", "width: 1in", true);
+  CPPUNIT_ASSERT_CSS(package.m_cssStreams["OEBPS/styles/stylesheet.css"], ".cellTable1", "width: 3in", true);
+  // The nested table didn't reuse the cell of the outer one.
+  CPPUNIT_ASSERT_XPATH(package.m_streams["OEBPS/sections/section0001.xhtml"], "//xhtml:td//xhtml:td[@class='cellTable2']", 1);
+  CPPUNIT_ASSERT_CSS(package.m_cssStreams["OEBPS/styles/stylesheet.css"], ".cellTable2", "width: 2in", true);
+}
+
+void EPUBTextGeneratorTest::testUnusedStyles()
+{
+  StringEPUBPackage package;
+  libepubgen::EPUBTextGenerator generator(&package);
+  generator.startDocument(librevenge::RVNGPropertyList());
+  librevenge::RVNGPropertyList used;
+  used.insert("librevenge:paragraph-id", 1);
+  used.insert("fo:text-align", "center");
+  generator.defineParagraphStyle(used);
+  librevenge::RVNGPropertyList unused;
+  unused.insert("librevenge:paragraph-id", 2);
+  unused.insert("fo:text-align", "right");
+  generator.defineParagraphStyle(unused);
+  for (int i = 0; i < 2; ++i)
+  {
+    librevenge::RVNGPropertyList paragraph;
+    paragraph.insert("librevenge:paragraph-id", 1);
+    generator.openParagraph(paragraph);
+    generator.insertText("x");
+    generator.closeParagraph();
+  }
+  generator.endDocument();
+
+  // Only the used style has a rule.
+  const std::map< std::string, std::vector<std::string> > &css = package.m_cssStreams["OEBPS/styles/stylesheet.css"];
+  CPPUNIT_ASSERT(css.find(".para0") != css.end());
+  CPPUNIT_ASSERT(css.find(".para1") == css.end());
+
+  librevenge::RVNGPropertyList usage;
+  generator.getStyleUsage(usage);
+  CPPUNIT_ASSERT(usage["para0"]);
+  CPPUNIT_ASSERT_EQUAL(2, usage["para0"]->getInt());
+  CPPUNIT_ASSERT(usage["para1"]);
+  CPPUNIT_ASSERT_EQUAL(0, usage["para1"]->getInt());
+}
+
+void EPUBTextGeneratorTest::testSplitOnSizeWithImage()
+{
+  StringEPUBPackage package;
+  libepubgen::EPUBTextGenerator generator(&package);
+  generator.setOption(libepubgen::EPUB_GENERATOR_OPTION_SPLIT, libepubgen::EPUB_SPLIT_METHOD_SIZE);
+  generator.setSplitSize(1000);
+  generator.startDocument(librevenge::RVNGPropertyList());
+
+  generator.openParagraph(librevenge::RVNGPropertyList());
+  generator.openFrame(librevenge::RVNGPropertyList());
+  const std::vector<unsigned char> image(2000, 'x');
+  librevenge::RVNGPropertyList propertyList;
+  propertyList.insert("librevenge:mime-type", "image/png");
+  propertyList.insert("office:binary-data", librevenge::RVNGBinaryData(image.data(), image.size()));
+  generator.insertBinaryObject(propertyList);
+  generator.closeFrame();
+  generator.closeParagraph();
+  generator.openParagraph(librevenge::RVNGPropertyList());
+  generator.insertText("After");
+  generator.closeParagraph();
+  generator.endDocument();
+
+  // The image bytes count: the paragraph after it starts a new file.
+  CPPUNIT_ASSERT_XPATH(package.m_streams["OEBPS/sections/section0001.xhtml"], "//xhtml:img", 1);
+  CPPUNIT_ASSERT_XPATH_CONTENT(package.m_streams["OEBPS/sections/section0002.xhtml"], "//xhtml:p", "After");
+}
+
+void EPUBTextGeneratorTest::testSplitDetect()
+{
+  librevenge::RVNGPropertyList pageBreak;
+  pageBreak.insert("fo:break-before", "page");
+  librevenge::RVNGPropertyList heading;
+  heading.insert("text:outline-level", 1);
+
+  {
+    // Without headings, page breaks are used, but not for tiny sections.
+    StringEPUBPackage package;
+    libepubgen::EPUBTextGenerator generator(&package);
+    generator.setOption(libepubgen::EPUB_GENERATOR_OPTION_SPLIT, libepubgen::EPUB_SPLIT_METHOD_DETECT);
+    generator.setSplitSize(1000);
+    generator.startDocument(librevenge::RVNGPropertyList());
+    writeParagraphs(generator, 6, pageBreak);
+    generator.endDocument();
+
+    CPPUNIT_ASSERT_XPATH(package.m_streams["OEBPS/sections/section0001.xhtml"], "//xhtml:p", 3);
+    CPPUNIT_ASSERT_XPATH(package.m_streams["OEBPS/sections/section0002.xhtml"], "//xhtml:p", 3);
+    CPPUNIT_ASSERT(package.m_streams.find("OEBPS/sections/section0003.xhtml") == package.m_streams.end());
+  }
+
+  {
+    // Headings are preferred; too large sections are split on size.
+    StringEPUBPackage package;
+    libepubgen::EPUBTextGenerator generator(&package);
+    generator.setOption(libepubgen::EPUB_GENERATOR_OPTION_SPLIT, libepubgen::EPUB_SPLIT_METHOD_DETECT);
+    generator.setSplitSize(1000);
+    generator.startDocument(librevenge::RVNGPropertyList());
+    generator.openParagraph(heading);
+    generator.insertText("Chapter 1");
+    generator.closeParagraph();
+    writeParagraphs(generator, 3, pageBreak);
+    generator.openParagraph(heading);
+    generator.insertText("Chapter 2");
+    generator.closeParagraph();
+    writeParagraphs(generator, 12);
+    generator.endDocument();
+
+    CPPUNIT_ASSERT_XPATH(package.m_streams["OEBPS/sections/section0001.xhtml"], "//xhtml:p", 4);
+    CPPUNIT_ASSERT_XPATH_CONTENT(package.m_streams["OEBPS/sections/section0002.xhtml"], "//xhtml:p[1]", "Chapter 2");
+    CPPUNIT_ASSERT(package.m_streams.find("OEBPS/sections/section0003.xhtml") != package.m_streams.end());
+  }
+
+  {
+    // A tiny section is not split on a heading either; page breaks are
+    // used again after a section with headings.
+    StringEPUBPackage package;
+    libepubgen::EPUBTextGenerator generator(&package);
+    generator.setOption(libepubgen::EPUB_GENERATOR_OPTION_SPLIT, libepubgen::EPUB_SPLIT_METHOD_DETECT);
+    generator.setSplitSize(1000);
+    generator.startDocument(librevenge::RVNGPropertyList());
+    generator.openParagraph(heading);
+    generator.insertText("Title");
+    generator.closeParagraph();
+    generator.openParagraph(heading);
+    generator.insertText("Chapter 1");
+    generator.closeParagraph();
+    writeParagraphs(generator, 12);
+    writeParagraphs(generator, 6, pageBreak);
+    generator.endDocument();
+
+    CPPUNIT_ASSERT_XPATH_CONTENT(package.m_streams["OEBPS/sections/section0001.xhtml"], "//xhtml:p[2]", "Chapter 1");
+    // Split on size, then on the page breaks.
+    CPPUNIT_ASSERT_XPATH(package.m_streams["OEBPS/sections/section0002.xhtml"], "//xhtml:p", 4);
+    CPPUNIT_ASSERT_XPATH(package.m_streams["OEBPS/sections/section0003.xhtml"], "//xhtml:p", 3);
+    CPPUNIT_ASSERT_XPATH(package.m_streams["OEBPS/sections/section0004.xhtml"], "//xhtml:p", 3);
+    CPPUNIT_ASSERT(package.m_streams.find("OEBPS/sections/section0005.xhtml") == package.m_streams.end());
+  }
+}
+
+void EPUBTextGeneratorTest::testSplitInStructure()
+{
+  const std::string text(50, 'x');
+  StringEPUBPackage package;
+  libepubgen::EPUBTextGenerator generator(&package);
+  generator.setOption(libepubgen::EPUB_GENERATOR_OPTION_SPLIT, libepubgen::EPUB_SPLIT_METHOD_SIZE);
+  generator.setSplitSize(1000);
+  generator.startDocument(librevenge::RVNGPropertyList());
+
+  generator.openTable(librevenge::RVNGPropertyList());
+  librevenge::RVNGPropertyList headerRow;
+  headerRow.insert("librevenge:is-header-row", true);
+  generator.openTableRow(headerRow);
+  generator.openTableCell(librevenge::RVNGPropertyList());
+  generator.openParagraph(librevenge::RVNGPropertyList());
+  generator.insertText("Header");
+  generator.closeParagraph();
+  generator.closeTableCell();
+  generator.closeTableRow();
+  for (int i = 0; i < 20; ++i)
+  {
+    generator.openTableRow(librevenge::RVNGPropertyList());
+    generator.openTableCell(librevenge::RVNGPropertyList());
+    generator.openParagraph(librevenge::RVNGPropertyList());
+    generator.insertText(text.c_str());
+    generator.closeParagraph();
+    generator.closeTableCell();
+    generator.closeTableRow();
+  }
+  generator.closeTable();
+
+  generator.openOrderedListLevel(librevenge::RVNGPropertyList());
+  for (int i = 0; i < 20; ++i)
+  {
+    generator.openListElement(librevenge::RVNGPropertyList());
+    generator.insertText(text.c_str());
+    generator.closeListElement();
+  }
+  generator.closeOrderedListLevel();
+  generator.endDocument();
+
+  // The table is split, and every part starts with the header row.
+  CPPUNIT_ASSERT(package.m_streams.find("OEBPS/sections/section0002.xhtml") != package.m_streams.end());
+  CPPUNIT_ASSERT_XPATH_CONTENT(package.m_streams["OEBPS/sections/section0001.xhtml"], "//xhtml:tr[1]/xhtml:td/xhtml:p", "Header");
+  CPPUNIT_ASSERT_XPATH_CONTENT(package.m_streams["OEBPS/sections/section0002.xhtml"], "//xhtml:tr[1]/xhtml:td/xhtml:p", "Header");
+  CPPUNIT_ASSERT_XPATH(package.m_streams["OEBPS/sections/section0002.xhtml"], "//xhtml:table", 1);
+
+  // The list is split too, with continued numbering.
+  CPPUNIT_ASSERT(package.m_streams.find("OEBPS/sections/section0005.xhtml") != package.m_streams.end());
+  CPPUNIT_ASSERT_XPATH(package.m_streams["OEBPS/sections/section0005.xhtml"], "//xhtml:ol", 1);
+  CPPUNIT_ASSERT_XPATH(package.m_streams["OEBPS/sections/section0005.xhtml"], "//xhtml:ol[@start]", 1);
+}
+
+void EPUBTextGeneratorTest::testSplitPlanBalanced()
+{
+  StringEPUBPackage package;
+  libepubgen::EPUBTextGenerator generator(&package);
+  generator.setOption(libepubgen::EPUB_GENERATOR_OPTION_SPLIT, libepubgen::EPUB_SPLIT_METHOD_SIZE);
+  generator.setOption(libepubgen::EPUB_GENERATOR_OPTION_SPLIT_PLAN, libepubgen::EPUB_SPLIT_PLAN_METHOD_BALANCED);
+  generator.setSplitSize(1000);
+  generator.startDocument(librevenge::RVNGPropertyList());
+  writeParagraphs(generator, 12);
+  generator.endDocument();
+
+  // Two even sections, instead of a full one and a small trailing one.
+  CPPUNIT_ASSERT_XPATH(package.m_streams["OEBPS/sections/section0001.xhtml"], "//xhtml:p", 6);
+  CPPUNIT_ASSERT_XPATH(package.m_streams["OEBPS/sections/section0002.xhtml"], "//xhtml:p", 6);
+  CPPUNIT_ASSERT(package.m_streams.find("OEBPS/sections/section0003.xhtml") == package.m_streams.end());
+}
+
+namespace
+{
+unsigned sectionSizeCapCount = 0;
+
+void countSectionSizeCap(libepubgen::EPUBDiagnostic diagnostic, const librevenge::RVNGPropertyList &details)
+{
+  if (diagnostic == libepubgen::EPUB_DIAGNOSTIC_SECTION_SIZE_CAP && details["libepubgen:size"]->getInt() >= details["libepubgen:max-size"]->getInt())
+    ++sectionSizeCapCount;
+}
+}
+
+void EPUBTextGeneratorTest::testMaxSectionSize()
+{
+  StringEPUBPackage package;
+  libepubgen::EPUBTextGenerator generator(&package);
+  // No headings: without the maximum size, this would be a single section.
+  generator.setOption(libepubgen::EPUB_GENERATOR_OPTION_SPLIT, libepubgen::EPUB_SPLIT_METHOD_HEADING);
+  generator.setMaxSectionSize(1000);
+  sectionSizeCapCount = 0;
+  generator.registerDiagnosticHandler(countSectionSizeCap);
+  generator.startDocument(librevenge::RVNGPropertyList());
+  writeParagraphs(generator, 12);
+  generator.endDocument();
+
+  librevenge::RVNGPropertyListVector report;
+  generator.getSectionReport(report);
+  CPPUNIT_ASSERT_EQUAL(2UL, report.count());
+  CPPUNIT_ASSERT_EQUAL(std::string("max-size"), std::string(report[1]["libepubgen:split-reason"]->getStr().cstr()));
+  // Only the first section reached the cap, and only by its last paragraph of 100 characters.
+  CPPUNIT_ASSERT_EQUAL(1U, sectionSizeCapCount);
+  for (unsigned long i = 0; i < report.count(); ++i)
+    CPPUNIT_ASSERT(report[i]["libepubgen:size"]->getInt() < 1200);
+  CPPUNIT_ASSERT(report[1]["libepubgen:size"]->getInt() < 1000);
+}
+
+void EPUBTextGeneratorTest::testSectionReport()
+{
+  StringEPUBPackage package;
+  libepubgen::EPUBTextGenerator generator(&package);
+  generator.setOption(libepubgen::EPUB_GENERATOR_OPTION_SPLIT, libepubgen::EPUB_SPLIT_METHOD_HEADING);
+  generator.startDocument(librevenge::RVNGPropertyList());
+  generator.openParagraph(librevenge::RVNGPropertyList());
+  generator.insertText("Intro");
+  generator.closeParagraph();
+  librevenge::RVNGPropertyList heading;
+  heading.insert("text:outline-level", 1);
+  generator.openParagraph(heading);
+  generator.insertText("Chapter");
+  generator.closeParagraph();
+  generator.endDocument();
+
+  librevenge::RVNGPropertyListVector report;
+  generator.getSectionReport(report);
+  CPPUNIT_ASSERT_EQUAL(2UL, report.count());
+  CPPUNIT_ASSERT_EQUAL(std::string("OEBPS/sections/section0001.xhtml"), std::string(report[0]["libepubgen:path"]->getStr().cstr()));
+  CPPUNIT_ASSERT_EQUAL(std::string("start"), std::string(report[0]["libepubgen:split-reason"]->getStr().cstr()));
+  CPPUNIT_ASSERT_EQUAL(5, report[0]["libepubgen:text-length"]->getInt());
+  CPPUNIT_ASSERT_EQUAL(std::string("heading"), std::string(report[1]["libepubgen:split-reason"]->getStr().cstr()));
+  CPPUNIT_ASSERT_EQUAL(1, report[1]["libepubgen:heading-level"]->getInt());
+  CPPUNIT_ASSERT_EQUAL(7, report[1]["libepubgen:text-length"]->getInt());
+  CPPUNIT_ASSERT(report[1]["libepubgen:size"]->getInt() > 0);
+  CPPUNIT_ASSERT(report[1]["libepubgen:events"]->getInt() > 0);
+}
+
+void EPUBTextGeneratorTest::testPagedSplitSize()
+{
+  StringEPUBPackage package;
+  libepubgen::EPUBDrawingGenerator generator(&package);
+  generator.setOption(libepubgen::EPUB_GENERATOR_OPTION_SPLIT, libepubgen::EPUB_SPLIT_METHOD_SIZE);
+  generator.setSplitSize(2000);
+  generator.startDocument(librevenge::RVNGPropertyList());
+  writePages(generator, 8);
+  generator.endDocument();
+
+  // This was one file per page: the pages are grouped up to the split size.
+  CPPUNIT_ASSERT(package.m_streams.find("OEBPS/sections/section0002.xhtml") != package.m_streams.end());
+  CPPUNIT_ASSERT(package.m_streams.find("OEBPS/sections/section0005.xhtml") == package.m_streams.end());
+}
+
+void EPUBTextGeneratorTest::testPagedMaxSectionSize()
+{
+  StringEPUBPackage package;
+  libepubgen::EPUBDrawingGenerator generator(&package);
+  // Without the maximum size, this would be a single section.
+  generator.setOption(libepubgen::EPUB_GENERATOR_OPTION_SPLIT, libepubgen::EPUB_SPLIT_METHOD_NONE);
+  generator.setMaxSectionSize(2000);
+  sectionSizeCapCount = 0;
+  generator.registerDiagnosticHandler(countSectionSizeCap);
+  generator.startDocument(librevenge::RVNGPropertyList());
+  writePages(generator, 8);
+  generator.endDocument();
+
+  // A page is never split: both sections end with the page which reached the cap.
+  CPPUNIT_ASSERT(package.m_streams.find("OEBPS/sections/section0002.xhtml") != package.m_streams.end());
+  CPPUNIT_ASSERT(package.m_streams.find("OEBPS/sections/section0003.xhtml") == package.m_streams.end());
+  CPPUNIT_ASSERT_EQUAL(2U, sectionSizeCapCount);
+}
+
+void EPUBTextGeneratorTest::testNotesSeparate()
+{
+  StringEPUBPackage package;
+  libepubgen::EPUBTextGenerator generator(&package);
+  generator.setOption(libepubgen::EPUB_GENERATOR_OPTION_NOTES, libepubgen::EPUB_NOTES_METHOD_SEPARATE);
+  generator.startDocument(librevenge::RVNGPropertyList());
+  generator.openParagraph(librevenge::RVNGPropertyList());
+  generator.insertText("before");
+  generator.openFootnote(librevenge::RVNGPropertyList());
+  generator.openParagraph(librevenge::RVNGPropertyList());
+  generator.insertText("footnote content");
+  generator.closeParagraph();
+  generator.closeFootnote();
+  generator.insertText("after");
+  generator.closeParagraph();
+  generator.endDocument();
+
+  // The note call refers to the notes file, which refers back to the section.
+  CPPUNIT_ASSERT_XPATH_ATTRIBUTE(package.m_streams["OEBPS/sections/section0001.xhtml"], "//xhtml:p/xhtml:sup/xhtml:a", "href", "notes-0001.xhtml#dataF1");
+  CPPUNIT_ASSERT_XPATH(package.m_streams["OEBPS/sections/section0001.xhtml"], "//xhtml:aside", 0);
+  CPPUNIT_ASSERT_XPATH(package.m_streams["OEBPS/sections/notes-0001.xhtml"], "//xhtml:aside[@id='dataF1']", 1);
+  CPPUNIT_ASSERT_XPATH_ATTRIBUTE(package.m_streams["OEBPS/sections/notes-0001.xhtml"], "//xhtml:aside/xhtml:p/xhtml:sup/xhtml:a", "href", "section0001.xhtml#calledF1");
+  // The notes file is in the manifest, but out of the reading order.
+  CPPUNIT_ASSERT_XPATH_ATTRIBUTE(package.m_streams["OEBPS/content.opf"], "/opf:package/opf:manifest/opf:item[@id='notes-0001']", "href", "sections/notes-0001.xhtml");
+  CPPUNIT_ASSERT_XPATH_ATTRIBUTE(package.m_streams["OEBPS/content.opf"], "/opf:package/opf:spine/opf:itemref[2]", "idref", "notes-0001");
+  CPPUNIT_ASSERT_XPATH_ATTRIBUTE(package.m_streams["OEBPS/content.opf"], "/opf:package/opf:spine/opf:itemref[2]", "linear", "no");
+}
+
+void EPUBTextGeneratorTest::testHeadingTitleRuns()
+{
+  StringEPUBPackage package;
+  libepubgen::EPUBTextGenerator generator(&package);
+  generator.setOption(libepubgen::EPUB_GENERATOR_OPTION_SPLIT, libepubgen::EPUB_SPLIT_METHOD_HEADING);
+  generator.startDocument(librevenge::RVNGPropertyList());
+  {
+    librevenge::RVNGPropertyList propertyList;
+    propertyList.insert("text:outline-level", "2");
+    generator.openParagraph(propertyList);
+    generator.insertText("Copy");
+    generator.insertText("right");
+    generator.closeParagraph();
+  }
+  {
+    librevenge::RVNGPropertyList propertyList;
+    propertyList.insert("text:outline-level", "1");
+    generator.openParagraph(propertyList);
+    generator.insertText("Chapter ");
+    generator.insertText("1");
+    generator.closeParagraph();
+  }
+  generator.endDocument();
+
+  // This was "Copy": only the first run of a heading below the split level was in the title.
+  CPPUNIT_ASSERT_XPATH_CONTENT(package.m_streams["OEBPS/toc.xhtml"], "//xhtml:li[1]/xhtml:a", "Copyright");
+  CPPUNIT_ASSERT_XPATH_CONTENT(package.m_streams["OEBPS/toc.xhtml"], "//xhtml:li[2]/xhtml:a", "Chapter 1");
+}
+
+void EPUBTextGeneratorTest::testTocOutline()
+{
+  StringEPUBPackage package;
+  libepubgen::EPUBTextGenerator generator(&package);
+  generator.setOption(libepubgen::EPUB_GENERATOR_OPTION_SPLIT, libepubgen::EPUB_SPLIT_METHOD_HEADING);
+  generator.setOption(libepubgen::EPUB_GENERATOR_OPTION_TOC, libepubgen::EPUB_TOC_METHOD_OUTLINE);
+  generator.startDocument(librevenge::RVNGPropertyList());
+  const char *const titles[] = {"Chapter 1", "Chapter 1.1", "Chapter 1.2", "Chapter 2"};
+  const char *const levels[] = {"1", "2", "2", "1"};
+  for (int i = 0; i < 4; ++i)
+  {
+    librevenge::RVNGPropertyList propertyList;
+    propertyList.insert("text:outline-level", levels[i]);
+    generator.openParagraph(propertyList);
+    generator.insertText(titles[i]);
+    generator.closeParagraph();
+  }
+  generator.endDocument();
+
+  // Headings below the split level have their own entries, nested in their chapter.
+  const std::string nav = "/xhtml:html/xhtml:body/xhtml:nav/xhtml:ol";
+  CPPUNIT_ASSERT_XPATH(package.m_streams["OEBPS/toc.xhtml"], nav + "/xhtml:li", 2);
+  CPPUNIT_ASSERT_XPATH_CONTENT(package.m_streams["OEBPS/toc.xhtml"], nav + "/xhtml:li[2]/xhtml:a", "Chapter 2");
+  CPPUNIT_ASSERT_XPATH_ATTRIBUTE(package.m_streams["OEBPS/toc.xhtml"], nav + "/xhtml:li[1]/xhtml:ol/xhtml:li[2]/xhtml:a", "href", "sections/section0001.xhtml#heading3");
+  CPPUNIT_ASSERT_XPATH_CONTENT(package.m_streams["OEBPS/sections/section0001.xhtml"], "//xhtml:p[@id='heading3']", "Chapter 1.2");
+  CPPUNIT_ASSERT_XPATH(package.m_streams["OEBPS/toc.ncx"], "//ncx:navMap/ncx:navPoint", 2);
+  CPPUNIT_ASSERT_XPATH_ATTRIBUTE(package.m_streams["OEBPS/toc.ncx"], "//ncx:navMap/ncx:navPoint[1]/ncx:navPoint[2]/ncx:content", "src", "sections/section0001.xhtml#heading3");
+}
+
+void EPUBTextGeneratorTest::testTextTrace()
+{
+  std::stringstream trace;
+  StringEPUBPackage package;
+  libepubgen::EPUBTextGenerator generator(&package);
+  {
+    libepubgen::EPUBTextTraceRecorder recorder(trace, &generator);
+    recorder.startDocument(librevenge::RVNGPropertyList());
+    librevenge::RVNGPropertyList tableProps;
+    librevenge::RVNGPropertyListVector columns;
+    librevenge::RVNGPropertyList column;
+    column.insert("style:column-width", 1.5, librevenge::RVNG_INCH);
+    columns.append(column);
+    tableProps.insert("librevenge:table-columns", columns);
+    recorder.openTable(tableProps);
+    recorder.openTableRow(librevenge::RVNGPropertyList());
+    recorder.openTableCell(librevenge::RVNGPropertyList());
+    recorder.openParagraph(librevenge::RVNGPropertyList());
+    librevenge::RVNGPropertyList spanProps;
+    spanProps.insert("fo:font-size", 12.0, librevenge::RVNG_POINT);
+    spanProps.insert("fo:font-weight", "bold");
+    recorder.openSpan(spanProps);
+    recorder.insertText("Hello");
+    recorder.insertTab();
+    recorder.closeSpan();
+    recorder.closeParagraph();
+    recorder.closeTableCell();
+    recorder.closeTableRow();
+    recorder.closeTable();
+    recorder.endDocument();
+  }
+
+  libepubgen::EPUBTextTraceReplayer replayer;
+  CPPUNIT_ASSERT(replayer.load(trace));
+  StringEPUBPackage replayed;
+  libepubgen::EPUBTextGenerator replayedGenerator(&replayed);
+  replayer.replay(&replayedGenerator);
+
+  // The replayed calls give the same document.
+  const std::string section = "OEBPS/sections/section0001.xhtml";
+  CPPUNIT_ASSERT(replayed.m_streams[section]);
+  CPPUNIT_ASSERT_EQUAL(std::string(reinterpret_cast<const char *>(xmlBufferContent(package.m_streams[section]))),
+                       std::string(reinterpret_cast<const char *>(xmlBufferContent(replayed.m_streams[section]))));
+  CPPUNIT_ASSERT(package.m_cssStreams["OEBPS/styles/stylesheet.css"] == replayed.m_cssStreams["OEBPS/styles/stylesheet.css"]);
+
+  // A truncated trace is rejected, even if it is cut between two calls.
+  const std::string data = trace.str();
+  std::stringstream truncated(data.substr(0, data.size() / 2));
+  libepubgen::EPUBTextTraceReplayer broken;
+  CPPUNIT_ASSERT(!broken.load(truncated));
+  std::stringstream unfinished(data.substr(0, data.size() - 1));
+  libepubgen::EPUBTextTraceReplayer brokenAtCall;
+  CPPUNIT_ASSERT(!brokenAtCall.load(unfinished));
+}
+
+void EPUBTextGeneratorTest::testStatistics()
+{
+  StringEPUBPackage package;
+  libepubgen::EPUBTextGenerator generator(&package);
+  generator.startDocument(librevenge::RVNGPropertyList());
+  librevenge::RVNGPropertyList spanProps;
+  spanProps.insert("fo:font-weight", "bold");
+  librevenge::RVNGPropertyList imageProps;
+  imageProps.insert("librevenge:mime-type", "image/png");
+  imageProps.insert("office:binary-data", librevenge::RVNGBinaryData("aGVsbG8="));
+  for (int i = 0; i < 2; ++i)
+  {
+    librevenge::RVNGPropertyList paraProps;
+    if (i > 0)
+      paraProps.insert("fo:break-before", "page");
+    generator.openParagraph(paraProps);
+    generator.openSpan(spanProps);
+    generator.insertText("Hello");
+    generator.openFrame(librevenge::RVNGPropertyList());
+    generator.insertBinaryObject(imageProps);
+    generator.closeFrame();
+    generator.closeSpan();
+    generator.closeParagraph();
+  }
+  generator.endDocument();
+
+  librevenge::RVNGPropertyList statistics;
+  generator.getStatistics(statistics);
+  CPPUNIT_ASSERT_EQUAL(2, statistics["libepubgen:sections"]->getInt());
+  // The second image is the same as the first one.
+  CPPUNIT_ASSERT_EQUAL(2, statistics["libepubgen:images"]->getInt());
+  CPPUNIT_ASSERT_EQUAL(1, statistics["libepubgen:images-deduplicated"]->getInt());
+  CPPUNIT_ASSERT_EQUAL(5.0, statistics["libepubgen:binary-bytes"]->getDouble());
+  // The second span reuses the class of the first one.
+  CPPUNIT_ASSERT(statistics["libepubgen:style-cache-hits"]->getInt() > 0);
+  CPPUNIT_ASSERT(statistics["libepubgen:style-cache-misses"]->getInt() > 0);
+  CPPUNIT_ASSERT_EQUAL(2, statistics["libepubgen:spans"]->getInt());
+  CPPUNIT_ASSERT(statistics["libepubgen:elements"]->getInt() > 2);
+  CPPUNIT_ASSERT(statistics["libepubgen:text-bytes"]->getDouble() >= 10);
+  CPPUNIT_ASSERT(statistics["libepubgen:css-bytes"]->getDouble() > 0);
+  CPPUNIT_ASSERT(statistics["libepubgen:generation-time"]->getDouble() >= 0);
+  CPPUNIT_ASSERT(statistics["libepubgen:write-sections-time"]);
+}
+
+void EPUBTextGeneratorTest::testTraceEvents()
+{
+  std::ostringstream events;
+  if (!libepubgen::setTraceEventStream(&events))
+    return; // not configured with --enable-trace
+
+  {
+    StringEPUBPackage package;
+    libepubgen::EPUBTextGenerator generator(&package);
+    generator.startDocument(librevenge::RVNGPropertyList());
+    generator.openParagraph(librevenge::RVNGPropertyList());
+    generator.insertText("Hello");
+    generator.closeParagraph();
+    generator.endDocument();
+  }
+  libepubgen::setTraceEventStream(nullptr);
+
+  const std::string json = events.str();
+  CPPUNIT_ASSERT_EQUAL(std::string("["), json.substr(0, 1));
+  CPPUNIT_ASSERT_EQUAL(std::string("]\n"), json.substr(json.size() - 2));
+  CPPUNIT_ASSERT(json.find("\"name\":\"EPUBGenerator::writeRoot\"") != std::string::npos);
+  CPPUNIT_ASSERT(json.find("\"name\":\"EPUBHTMLGenerator::insertText\"") != std::string::npos);
+}
+
+void EPUBTextGeneratorTest::testMemoryUsage()
+{
+  StringEPUBPackage package;
+  libepubgen::EPUBTextGenerator generator(&package);
+  generator.startDocument(librevenge::RVNGPropertyList());
+  generator.openPageSpan(librevenge::RVNGPropertyList());
+  generator.openHeader(librevenge::RVNGPropertyList());
+  generator.openParagraph(librevenge::RVNGPropertyList());
+  generator.insertText("Header");
+  generator.closeParagraph();
+  generator.closeHeader();
+  librevenge::RVNGPropertyList spanProps;
+  spanProps.insert("fo:font-weight", "bold");
+  for (int i = 0; i < 2; ++i)
+  {
+    librevenge::RVNGPropertyList paraProps;
+    if (i > 0)
+      paraProps.insert("fo:break-before", "page");
+    generator.openParagraph(paraProps);
+    generator.openSpan(spanProps);
+    generator.insertText("Hello");
+    generator.closeSpan();
+    generator.closeParagraph();
+  }
+
+  librevenge::RVNGPropertyList usage;
+  generator.getMemoryUsage(usage);
+  CPPUNIT_ASSERT(usage["libepubgen:zones-bytes"]->getDouble() > 0);
+  CPPUNIT_ASSERT(usage["libepubgen:styles-bytes"]->getDouble() > 0);
+  CPPUNIT_ASSERT(usage["libepubgen:recorded-bytes"]->getDouble() > 0);
+  // The first section is finished.
+  CPPUNIT_ASSERT(usage["libepubgen:xhtml-bytes"]->getDouble() > 0);
+
+  generator.closePageSpan();
+  generator.endDocument();
+
+  usage.clear();
+  generator.getMemoryUsage(usage);
+  // All the content is in the finished sections now.
+  CPPUNIT_ASSERT_EQUAL(0.0, usage["libepubgen:zones-bytes"]->getDouble());
+  CPPUNIT_ASSERT(usage["libepubgen:zones-peak-bytes"]->getDouble() > 0);
+  const double xhtml = usage["libepubgen:xhtml-bytes"]->getDouble();
+  CPPUNIT_ASSERT(xhtml > 0);
+  CPPUNIT_ASSERT_EQUAL(xhtml, usage["libepubgen:xhtml-peak-bytes"]->getDouble());
+  CPPUNIT_ASSERT_EQUAL(0.0, usage["libepubgen:images-bytes"]->getDouble());
+  CPPUNIT_ASSERT(usage["libepubgen:total-bytes"]->getDouble() >= xhtml);
+  CPPUNIT_ASSERT(usage["libepubgen:total-peak-bytes"]->getDouble() >= usage["libepubgen:total-bytes"]->getDouble());
+}
+
+void EPUBTextGeneratorTest::testMemoryBudget()
+{
+  const auto withBudget = [](const unsigned long budget)
+  {
+    return [budget](libepubgen::EPUBTextGenerator &generator)
+    {
+      generator.setOption(libepubgen::EPUB_GENERATOR_OPTION_NOTES, libepubgen::EPUB_NOTES_METHOD_SEPARATE);
+      generator.setMemoryBudget(budget);
+    };
+  };
+
+  StringEPUBPackage package;
+  librevenge::RVNGPropertyList usage;
+  librevenge::RVNGPropertyList statistics;
+  generateText(package, withBudget(0), writeSections, &statistics, &usage);
+  StringEPUBPackage spilled;
+  librevenge::RVNGPropertyList spilledUsage;
+  librevenge::RVNGPropertyList spilledStatistics;
+  generateText(spilled, withBudget(1), writeSections, &spilledStatistics, &spilledUsage);
+
+  // The spilled sections are read back unchanged.
+  CPPUNIT_ASSERT_EQUAL(package.m_streams.size(), spilled.m_streams.size());
+  for (const auto &stream : package.m_streams)
+  {
+    if (stream.first.find("OEBPS/sections/") != 0)
+      continue; // the package has a random identifier
+    CPPUNIT_ASSERT(spilled.m_streams[stream.first]);
+    CPPUNIT_ASSERT_EQUAL(std::string(reinterpret_cast<const char *>(xmlBufferContent(stream.second))),
+                         std::string(reinterpret_cast<const char *>(xmlBufferContent(spilled.m_streams[stream.first]))));
+  }
+  CPPUNIT_ASSERT(spilled.m_streams["OEBPS/sections/notes-0001.xhtml"]);
+  // The estimated sizes of the spilled files are kept.
+  CPPUNIT_ASSERT_EQUAL(statistics["libepubgen:xml-bytes"]->getDouble(), spilledStatistics["libepubgen:xml-bytes"]->getDouble());
+
+  // Only the last section is still in memory.
+  CPPUNIT_ASSERT(spilledUsage["libepubgen:xhtml-bytes"]->getDouble() > 0);
+  CPPUNIT_ASSERT(spilledUsage["libepubgen:xhtml-bytes"]->getDouble() < usage["libepubgen:xhtml-bytes"]->getDouble());
+  // The sections are alike.
+  CPPUNIT_ASSERT_EQUAL(usage["libepubgen:xhtml-bytes"]->getDouble(), 3 * spilledUsage["libepubgen:xhtml-bytes"]->getDouble());
+}
+
+void EPUBTextGeneratorTest::testMeasureOutput()
+{
+  const auto withOutput = [](const libepubgen::EPUBOutputMethod output)
+  {
+    return [output](libepubgen::EPUBTextGenerator &generator)
+    {
+      generator.setOption(libepubgen::EPUB_GENERATOR_OPTION_NOTES, libepubgen::EPUB_NOTES_METHOD_SEPARATE);
+      generator.setOption(libepubgen::EPUB_GENERATOR_OPTION_OUTPUT, output);
+    };
+  };
+
+  StringEPUBPackage package;
+  librevenge::RVNGPropertyList statistics;
+  generateText(package, withOutput(libepubgen::EPUB_OUTPUT_METHOD_PACKAGE), writeSections, &statistics);
+  StringEPUBPackage measured;
+  librevenge::RVNGPropertyList measuredStatistics;
+  generateText(measured, withOutput(libepubgen::EPUB_OUTPUT_METHOD_MEASURE), writeSections, &measuredStatistics);
+
+  // The sections are counted, but not written.
+  CPPUNIT_ASSERT(package.m_streams["OEBPS/sections/section0001.xhtml"]);
+  CPPUNIT_ASSERT(!measured.m_streams["OEBPS/sections/section0001.xhtml"]);
+  CPPUNIT_ASSERT(!measured.m_streams["OEBPS/sections/section0003.xhtml"]);
+  CPPUNIT_ASSERT(!measured.m_streams["OEBPS/sections/notes-0001.xhtml"]);
+  CPPUNIT_ASSERT(measured.m_streams["OEBPS/content.opf"]);
+  CPPUNIT_ASSERT_EQUAL(statistics["libepubgen:files"]->getInt(), measuredStatistics["libepubgen:files"]->getInt());
+  CPPUNIT_ASSERT_EQUAL(statistics["libepubgen:elements"]->getInt(), measuredStatistics["libepubgen:elements"]->getInt());
+  CPPUNIT_ASSERT_EQUAL(statistics["libepubgen:text-bytes"]->getDouble(), measuredStatistics["libepubgen:text-bytes"]->getDouble());
+
+  // The null package counts the bytes like the statistics.
+  libepubgen::EPUBNullPackage nullPackage;
+  librevenge::RVNGPropertyList nullStatistics;
+  generateText(nullPackage, withOutput(libepubgen::EPUB_OUTPUT_METHOD_PACKAGE), writeSections, &nullStatistics);
+  CPPUNIT_ASSERT_EQUAL(static_cast<unsigned long>(nullStatistics["libepubgen:files"]->getInt()), nullPackage.getFiles());
+  CPPUNIT_ASSERT_EQUAL(nullStatistics["libepubgen:xml-bytes"]->getDouble() + nullStatistics["libepubgen:css-bytes"]->getDouble()
+                       + nullStatistics["libepubgen:binary-bytes"]->getDouble() + nullStatistics["libepubgen:text-file-bytes"]->getDouble(),
+                       double(nullPackage.getBytes()));
+}
+
+namespace
+{
+std::vector<std::string> progressPhases;
+int progressSections = 0;
+std::vector<double> progressBytes;
+/// The number of reports after which the generation is cancelled; 0 for never.
+unsigned cancelAfter = 0;
+
+bool recordProgress(const librevenge::RVNGPropertyList &progress)
+{
+  progressPhases.push_back(progress["libepubgen:phase"]->getStr().cstr());
+  // Both only grow.
+  CPPUNIT_ASSERT(progress["libepubgen:sections"]->getInt() >= progressSections);
+  CPPUNIT_ASSERT(progressBytes.empty() || (progress["libepubgen:bytes"]->getDouble() >= progressBytes.back()));
+  progressSections = progress["libepubgen:sections"]->getInt();
+  progressBytes.push_back(progress["libepubgen:bytes"]->getDouble());
+  return progressPhases.size() != cancelAfter;
+}
+
+/// Writes the sections, recording the progress from scratch; returns whether it was cancelled.
+bool generateWithProgress(StringEPUBPackage &package)
+{
+  progressPhases.clear();
+  progressBytes.clear();
+  progressSections = 0;
+  const auto setUp = [](libepubgen::EPUBTextGenerator &generator)
+  {
+    generator.registerProgressHandler(recordProgress);
+  };
+  return generateText(package, setUp, writeSections);
+}
+}
+
+void EPUBTextGeneratorTest::testProgress()
+{
+  cancelAfter = 0;
+  StringEPUBPackage package;
+  CPPUNIT_ASSERT(!generateWithProgress(package));
+  std::string phases;
+  for (const auto &phase : progressPhases)
+    phases += phase + " ";
+  CPPUNIT_ASSERT_EQUAL(std::string("generation generation generation container root navigation stylesheet sections images fonts "), phases);
+  CPPUNIT_ASSERT_EQUAL(3, progressSections);
+  // Each finished section counts, before anything is written.
+  CPPUNIT_ASSERT(progressBytes[0] > 0);
+  CPPUNIT_ASSERT(progressBytes[1] > progressBytes[0]);
+  CPPUNIT_ASSERT(progressBytes[2] > progressBytes[1]);
+  CPPUNIT_ASSERT_EQUAL(progressBytes[2], progressBytes.back());
+
+  // Cancelled after the first section: nothing is written.
+  cancelAfter = 1;
+  StringEPUBPackage cancelled;
+  CPPUNIT_ASSERT(generateWithProgress(cancelled));
+  CPPUNIT_ASSERT_EQUAL(size_t(1), progressPhases.size());
+  CPPUNIT_ASSERT(cancelled.m_streams.empty());
+
+  // Cancelled while writing the package: it stops there.
+  cancelAfter = 5;
+  StringEPUBPackage incomplete;
+  CPPUNIT_ASSERT(generateWithProgress(incomplete));
+  CPPUNIT_ASSERT_EQUAL(std::string("root"), progressPhases.back());
+  CPPUNIT_ASSERT(incomplete.m_streams.find("OEBPS/content.opf") != incomplete.m_streams.end());
+  CPPUNIT_ASSERT(incomplete.m_streams.find("OEBPS/sections/section0001.xhtml") == incomplete.m_streams.end());
+  cancelAfter = 0;
+}
+
+void EPUBTextGeneratorTest::testInsertTextBuffer()
+{
+  StringEPUBPackage package;
+  libepubgen::EPUBTextGenerator generator(&package);
+  generator.setOption(libepubgen::EPUB_GENERATOR_OPTION_TOC, libepubgen::EPUB_TOC_METHOD_OUTLINE);
+  generator.startDocument(librevenge::RVNGPropertyList());
+  const char buffer[] = "Chapter 1Header, world";
+  librevenge::RVNGPropertyList headingProps;
+  headingProps.insert("text:outline-level", "1");
+  generator.openParagraph(headingProps);
+  generator.insertText(buffer, 9);
+  generator.closeParagraph();
+  // The runs of text are merged.
+  generator.openParagraph(librevenge::RVNGPropertyList());
+  generator.insertText(buffer + 9, 6);
+  generator.insertText(buffer + 15, 1);
+  generator.insertSpace();
+  generator.insertText(librevenge::RVNGString("world"));
+  generator.insertText(buffer, 0);
+  generator.closeParagraph();
+  // A header row is recorded, so its text is copied.
+  generator.openTable(librevenge::RVNGPropertyList());
+  librevenge::RVNGPropertyList headerRow;
+  headerRow.insert("librevenge:is-header-row", true);
+  generator.openTableRow(headerRow);
+  generator.openTableCell(librevenge::RVNGPropertyList());
+  generator.openParagraph(librevenge::RVNGPropertyList());
+  generator.insertText(buffer + 9, 6);
+  generator.closeParagraph();
+  generator.closeTableCell();
+  generator.closeTableRow();
+  generator.closeTable();
+  generator.endDocument();
+
+  xmlBufferPtr const section = package.m_streams["OEBPS/sections/section0001.xhtml"];
+  CPPUNIT_ASSERT_XPATH_CONTENT(section, "//xhtml:p[@id='heading1']", "Chapter 1");
+  CPPUNIT_ASSERT_XPATH_CONTENT(section, "/xhtml:html/xhtml:body/xhtml:p[2]", "Header,\xc2\xa0world");
+  CPPUNIT_ASSERT_XPATH_CONTENT(section, "//xhtml:tr[1]/xhtml:td/xhtml:p", "Header");
+  CPPUNIT_ASSERT_XPATH_CONTENT(package.m_streams["OEBPS/toc.xhtml"], "/xhtml:html/xhtml:body/xhtml:nav/xhtml:ol/xhtml:li[1]/xhtml:a", "Chapter 1");
+}
+
+void EPUBTextGeneratorTest::testInsertTextNull()
+{
+  const auto setUp = [](libepubgen::EPUBTextGenerator &generator)
+  {
+    generator.setOption(libepubgen::EPUB_GENERATOR_OPTION_TOC, libepubgen::EPUB_TOC_METHOD_OUTLINE);
+  };
+
+  StringEPUBPackage package;
+  librevenge::RVNGPropertyList statistics;
+  const auto write = [](libepubgen::EPUBTextGenerator &generator)
+  {
+    writeHeadingAndHeaderRow(generator, "Chapter 1", 9, "Header", 6);
+  };
+  generateText(package, setUp, write, &statistics);
+  StringEPUBPackage truncated;
+  librevenge::RVNGPropertyList truncatedStatistics;
+  const auto writeTruncated = [](libepubgen::EPUBTextGenerator &generator)
+  {
+    const char heading[] = "Chapter 1\0<ignored>";
+    const char header[] = "Header\0&ignored";
+    writeHeadingAndHeaderRow(generator, heading, sizeof(heading) - 1, header, sizeof(header) - 1);
+  };
+  generateText(truncated, setUp, writeTruncated, &truncatedStatistics);
+
+  // The text ends at the null character, in the section, the outline and the estimated size.
+  xmlBufferPtr const section = truncated.m_streams["OEBPS/sections/section0001.xhtml"];
+  CPPUNIT_ASSERT_XPATH_CONTENT(section, "//xhtml:p[@id='heading1']", "Chapter 1");
+  CPPUNIT_ASSERT_XPATH_CONTENT(section, "//xhtml:tr[1]/xhtml:td/xhtml:p", "Header");
+  CPPUNIT_ASSERT_XPATH_CONTENT(truncated.m_streams["OEBPS/toc.xhtml"], "/xhtml:html/xhtml:body/xhtml:nav/xhtml:ol/xhtml:li[1]/xhtml:a", "Chapter 1");
+  CPPUNIT_ASSERT_EQUAL(std::string(reinterpret_cast<const char *>(xmlBufferContent(package.m_streams["OEBPS/sections/section0001.xhtml"]))),
+                       std::string(reinterpret_cast<const char *>(xmlBufferContent(section))));
+  CPPUNIT_ASSERT_EQUAL(statistics["libepubgen:xml-bytes"]->getDouble(), truncatedStatistics["libepubgen:xml-bytes"]->getDouble());
+  CPPUNIT_ASSERT_EQUAL(statistics["libepubgen:text-bytes"]->getDouble(), truncatedStatistics["libepubgen:text-bytes"]->getDouble());
+}
+
+void EPUBTextGeneratorTest::testTextTraceHeaderRow()
+{
+  const std::string text(50, 'x');
+  std::stringstream trace;
+  StringEPUBPackage package;
+  libepubgen::EPUBTextGenerator generator(&package);
+  generator.setOption(libepubgen::EPUB_GENERATOR_OPTION_SPLIT, libepubgen::EPUB_SPLIT_METHOD_SIZE);
+  generator.setSplitSize(1000);
+  {
+    libepubgen::EPUBTextTraceRecorder recorder(trace, &generator);
+    recorder.startDocument(librevenge::RVNGPropertyList());
+    recorder.openTable(librevenge::RVNGPropertyList());
+    librevenge::RVNGPropertyList headerRow;
+    headerRow.insert("librevenge:is-header-row", true);
+    headerRow.insert("style:min-row-height", 2);
+    recorder.openTableRow(headerRow);
+    recorder.openTableCell(librevenge::RVNGPropertyList());
+    recorder.openParagraph(librevenge::RVNGPropertyList());
+    recorder.insertText("Header");
+    recorder.closeParagraph();
+    recorder.closeTableCell();
+    recorder.closeTableRow();
+    for (int i = 0; i < 20; ++i)
+    {
+      recorder.openTableRow(librevenge::RVNGPropertyList());
+      recorder.openTableCell(librevenge::RVNGPropertyList());
+      recorder.openParagraph(librevenge::RVNGPropertyList());
+      recorder.insertText(text.c_str());
+      recorder.closeParagraph();
+      recorder.closeTableCell();
+      recorder.closeTableRow();
+    }
+    recorder.closeTable();
+    recorder.endDocument();
+  }
+
+  libepubgen::EPUBTextTraceReplayer replayer;
+  CPPUNIT_ASSERT(replayer.load(trace));
+  StringEPUBPackage replayed;
+  libepubgen::EPUBTextGenerator replayedGenerator(&replayed);
+  replayedGenerator.setOption(libepubgen::EPUB_GENERATOR_OPTION_SPLIT, libepubgen::EPUB_SPLIT_METHOD_SIZE);
+  replayedGenerator.setSplitSize(1000);
+  replayer.replay(&replayedGenerator);
+
+  // The header row is still a header row, so every part of the table repeats it.
+  CPPUNIT_ASSERT_XPATH_CONTENT(replayed.m_streams["OEBPS/sections/section0002.xhtml"], "//xhtml:tr[1]/xhtml:td/xhtml:p", "Header");
+  CPPUNIT_ASSERT_EQUAL(package.m_streams.size(), replayed.m_streams.size());
+  for (const auto &stream : package.m_streams)
+  {
+    // The package file has a random identifier.
+    if (0 != stream.first.find("OEBPS/sections/"))
+      continue;
+    CPPUNIT_ASSERT(replayed.m_streams[stream.first]);
+    CPPUNIT_ASSERT_EQUAL(std::string(reinterpret_cast<const char *>(xmlBufferContent(stream.second))),
+                         std::string(reinterpret_cast<const char *>(xmlBufferContent(replayed.m_streams[stream.first]))));
+  }
+}
 
 CPPUNIT_TEST_SUITE_REGISTRATION(EPUBTextGeneratorTest);
 
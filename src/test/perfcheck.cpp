@@ -0,0 +1,566 @@
+/* -*- Mode: C++; tab-width: 2; indent-tabs-mode: nil; c-basic-offset: 2 -*- */
+/*
+ * This file is part of the libepubgen project.
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+/* Checks that the generators do not get more expensive.
+ *
+ * Fixed documents are generated while the allocations and the calls of
+ * the package are counted. Unlike times, these counts are the same on
+ * every run, so they can be compared with baselines recorded before: a
+ * count which grows by more than TOLERANCE fails the check.
+ *
+ * Usage: perfcheck [--record] [--lenient] [BASELINES]
+ *
+ * The package calls do not depend on the platform. The allocations and
+ * the buffered bytes depend on the word size and the C++ library, so
+ * their baselines are kept for each platform, named by getPlatform().
+ * A metric without a baseline for the current platform fails the check;
+ * --record adds or replaces the baselines of the current platform, and
+ * keeps those of the other ones. With --lenient, or if PERFCHECK_LENIENT
+ * is set in the environment, a missing baseline is only reported, e.g.,
+ * for a local check on another platform.
+ */
+
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <new>
+#include <sstream>
+#include <string>
+
+#include <librevenge/librevenge.h>
+
+#include <libepubgen/libepubgen.h>
+
+#ifndef PERF_BASELINES
+#define PERF_BASELINES "perf-baselines.txt"
+#endif
+
+namespace
+{
+
+std::size_t allocationCount = 0;
+
+void *allocate(std::size_t size)
+{
+  ++allocationCount;
+  if (void *const ptr = std::malloc(size ? size : 1))
+    return ptr;
+  throw std::bad_alloc();
+}
+
+}
+
+void *operator new(std::size_t size)
+{
+  return allocate(size);
+}
+
+void *operator new[](std::size_t size)
+{
+  return allocate(size);
+}
+
+void operator delete(void *ptr) noexcept
+{
+  std::free(ptr);
+}
+
+void operator delete[](void *ptr) noexcept
+{
+  std::free(ptr);
+}
+
+// The sized forms are used since C++14; they must match the ones above.
+void operator delete(void *ptr, std::size_t) noexcept
+{
+  std::free(ptr);
+}
+
+void operator delete[](void *ptr, std::size_t) noexcept
+{
+  std::free(ptr);
+}
+
+namespace
+{
+
+using librevenge::RVNGPropertyList;
+using librevenge::RVNGString;
+
+/// How much a count may grow before the check fails.
+const double TOLERANCE = 0.02;
+
+const char *const TEXT = "Lorem ipsum dolor sit amet, consectetur adipiscing elit.";
+
+/// A package which only counts its calls.
+class CountingPackage : public libepubgen::EPUBPackage
+{
+public:
+  CountingPackage();
+
+  void openXMLFile(const char *) override
+  {
+    ++m_calls;
+  }
+  void openElement(const char *, const RVNGPropertyList &) override
+  {
+    ++m_calls;
+  }
+  void closeElement(const char *) override
+  {
+    ++m_calls;
+  }
+  void insertCharacters(const RVNGString &) override
+  {
+    ++m_calls;
+  }
+  void closeXMLFile() override
+  {
+    ++m_calls;
+  }
+
+  void openCSSFile(const char *) override
+  {
+    ++m_calls;
+  }
+  void insertRule(const RVNGString &, const RVNGPropertyList &) override
+  {
+    ++m_calls;
+  }
+  void closeCSSFile() override
+  {
+    ++m_calls;
+  }
+
+  void openBinaryFile(const char *) override
+  {
+    ++m_calls;
+  }
+  void insertBinaryData(const librevenge::RVNGBinaryData &) override
+  {
+    ++m_calls;
+  }
+  void closeBinaryFile() override
+  {
+    ++m_calls;
+  }
+
+  void openTextFile(const char *) override
+  {
+    ++m_calls;
+  }
+  void insertText(const RVNGString &) override
+  {
+    ++m_calls;
+  }
+  void insertLineBreak() override
+  {
+    ++m_calls;
+  }
+  void closeTextFile() override
+  {
+    ++m_calls;
+  }
+
+  unsigned long m_calls;
+};
+
+CountingPackage::CountingPackage()
+  : m_calls(0)
+{
+}
+
+/// The counts of one workload, keyed by metric.
+typedef std::map<std::string, double> Metrics_t;
+
+RVNGPropertyList makeSpanProps(const unsigned index)
+{
+  RVNGPropertyList props;
+  if (index % 3 == 1)
+    props.insert("fo:font-weight", "bold");
+  if (index % 5 == 2)
+    props.insert("fo:font-style", "italic");
+  return props;
+}
+
+template<class Interface>
+void writeParagraph(Interface &generator, const unsigned index, const RVNGPropertyList &paraProps = RVNGPropertyList())
+{
+  generator.openParagraph(paraProps);
+  for (unsigned span = 0; span < 3; ++span)
+  {
+    generator.openSpan(makeSpanProps(index + span));
+    generator.insertText(TEXT);
+    generator.closeSpan();
+  }
+  generator.closeParagraph();
+}
+
+/// Paragraphs of styled spans, with a heading starting each section.
+unsigned writeParagraphs(libepubgen::EPUBTextGenerator &generator)
+{
+  const unsigned paragraphs = 400;
+  generator.startDocument(RVNGPropertyList());
+  generator.openPageSpan(RVNGPropertyList());
+  for (unsigned i = 0; i < paragraphs; ++i)
+  {
+    RVNGPropertyList paraProps;
+    if (0 == i % 40)
+    {
+      paraProps.insert("text:outline-level", 1);
+      if (0 != i)
+        paraProps.insert("fo:break-before", "page");
+    }
+    writeParagraph(generator, i, paraProps);
+  }
+  generator.closePageSpan();
+  generator.endDocument();
+  return paragraphs;
+}
+
+/// Paragraphs of text written in pieces: words, spaces and tabs.
+unsigned writePieces(libepubgen::EPUBTextGenerator &generator)
+{
+  const unsigned paragraphs = 400;
+  const std::string text(TEXT);
+  generator.startDocument(RVNGPropertyList());
+  generator.openPageSpan(RVNGPropertyList());
+  for (unsigned i = 0; i < paragraphs; ++i)
+  {
+    RVNGPropertyList paraProps;
+    if ((0 != i) && (0 == i % 40))
+      paraProps.insert("fo:break-before", "page");
+    generator.openParagraph(paraProps);
+    generator.insertTab();
+    for (unsigned repeat = 0; repeat < 3; ++repeat)
+    {
+      std::string::size_type start = 0;
+      for (std::string::size_type end = text.find(' '); std::string::npos != end; end = text.find(' ', start))
+      {
+        // The buffer overload, as a filter with its own buffer would call it.
+        generator.insertText(text.data() + start, end - start);
+        generator.insertSpace();
+        start = end + 1;
+      }
+      generator.insertText(RVNGString(text.substr(start).c_str()));
+      generator.insertSpace();
+    }
+    generator.closeParagraph();
+  }
+  generator.closePageSpan();
+  generator.endDocument();
+  return paragraphs;
+}
+
+/// Tables with a paragraph in each cell.
+unsigned writeTables(libepubgen::EPUBTextGenerator &generator)
+{
+  const unsigned tables = 20;
+  const unsigned rows = 10;
+  const unsigned columns = 4;
+  generator.startDocument(RVNGPropertyList());
+  generator.openPageSpan(RVNGPropertyList());
+  for (unsigned table = 0; table < tables; ++table)
+  {
+    writeParagraph(generator, table);
+    generator.openTable(RVNGPropertyList());
+    for (unsigned row = 0; row < rows; ++row)
+    {
+      generator.openTableRow(RVNGPropertyList());
+      for (unsigned column = 0; column < columns; ++column)
+      {
+        generator.openTableCell(RVNGPropertyList());
+        writeParagraph(generator, row + column);
+        generator.closeTableCell();
+      }
+      generator.closeTableRow();
+    }
+    generator.closeTable();
+  }
+  generator.closePageSpan();
+  generator.endDocument();
+  return tables * (rows * columns + 1);
+}
+
+/// Paragraphs with a footnote each, in separate notes files.
+unsigned writeNotes(libepubgen::EPUBTextGenerator &generator)
+{
+  const unsigned paragraphs = 200;
+  generator.setOption(libepubgen::EPUB_GENERATOR_OPTION_NOTES, libepubgen::EPUB_NOTES_METHOD_SEPARATE);
+  generator.startDocument(RVNGPropertyList());
+  generator.openPageSpan(RVNGPropertyList());
+  for (unsigned i = 0; i < paragraphs; ++i)
+  {
+    RVNGPropertyList paraProps;
+    if ((0 != i) && (0 == i % 50))
+      paraProps.insert("fo:break-before", "page");
+    generator.openParagraph(paraProps);
+    generator.insertText(TEXT);
+    generator.openFootnote(RVNGPropertyList());
+    writeParagraph(generator, i);
+    generator.closeFootnote();
+    generator.closeParagraph();
+  }
+  generator.closePageSpan();
+  generator.endDocument();
+  return paragraphs;
+}
+
+/// Slides with a text box of paragraphs.
+unsigned writeSlides(libepubgen::EPUBPresentationGenerator &generator)
+{
+  const unsigned slides = 20;
+  const unsigned paragraphs = 10;
+  generator.startDocument(RVNGPropertyList());
+  for (unsigned slide = 0; slide < slides; ++slide)
+  {
+    generator.startSlide(RVNGPropertyList());
+    generator.startTextObject(RVNGPropertyList());
+    for (unsigned i = 0; i < paragraphs; ++i)
+      writeParagraph(generator, slide + i);
+    generator.endTextObject();
+    generator.endSlide();
+  }
+  generator.endDocument();
+  return slides * paragraphs;
+}
+
+template<class Generator>
+void getMetrics(const Generator &generator, const CountingPackage &package, const std::size_t allocations, const unsigned paragraphs, Metrics_t &metrics)
+{
+  RVNGPropertyList statistics;
+  generator.getStatistics(statistics);
+  RVNGPropertyList usage;
+  generator.getMemoryUsage(usage);
+  const int sections = statistics["libepubgen:sections"]->getInt();
+
+  metrics["allocations-per-paragraph"] = double(allocations) / paragraphs;
+  metrics["package-calls-per-section"] = double(package.m_calls) / (sections ? sections : 1);
+  metrics["peak-buffered-bytes-per-paragraph"] = usage["libepubgen:total-peak-bytes"]->getDouble() / paragraphs;
+}
+
+template<class Generator>
+void runText(unsigned(*write)(Generator &), Metrics_t &metrics)
+{
+  CountingPackage package;
+  allocationCount = 0;
+  Generator generator(&package);
+  const unsigned paragraphs = write(generator);
+  const std::size_t allocations = allocationCount;
+  getMetrics(generator, package, allocations, paragraphs, metrics);
+}
+
+void runAll(std::map<std::string, Metrics_t> &results)
+{
+  runText<libepubgen::EPUBTextGenerator>(writeParagraphs, results["text-paragraphs"]);
+  runText<libepubgen::EPUBTextGenerator>(writePieces, results["text-pieces"]);
+  runText<libepubgen::EPUBTextGenerator>(writeTables, results["text-tables"]);
+  runText<libepubgen::EPUBTextGenerator>(writeNotes, results["text-notes"]);
+  runText<libepubgen::EPUBPresentationGenerator>(writeSlides, results["presentation"]);
+}
+
+/** The platform of the baselines which depend on it.
+  *
+  * It is the word size and the C++ library, e.g., 64-bit-libstdc++.
+  */
+std::string getPlatform()
+{
+  std::ostringstream platform;
+  platform << 8 * sizeof(void *) << "-bit-";
+#if defined(_LIBCPP_VERSION)
+  platform << "libc++";
+#elif defined(__GLIBCXX__)
+  platform << "libstdc++";
+#elif defined(_MSC_VER)
+  platform << "msvc";
+#else
+  platform << "unknown";
+#endif
+  return platform.str();
+}
+
+/// The platform of the baselines which are the same everywhere.
+const char *const ALL_PLATFORMS = "all";
+
+/// Gets the platform of the baselines of metric.
+std::string getMetricPlatform(const std::string &metric)
+{
+  return ("package-calls-per-section" == metric) ? ALL_PLATFORMS : getPlatform();
+}
+
+/// Baselines of each workload, for each platform.
+typedef std::map<std::string, std::map<std::string, Metrics_t>> Baselines_t;
+
+/** Reads lines of "workload metric value"; lines starting with # are comments.
+  *
+  * The baselines are for all platforms, up to a line of "platform name",
+  * which starts the ones for that platform.
+  */
+bool readBaselines(const std::string &path, Baselines_t &baselines)
+{
+  std::ifstream input(path.c_str());
+  if (!input)
+    return false;
+  std::string platform(ALL_PLATFORMS);
+  std::string line;
+  while (std::getline(input, line))
+  {
+    if (line.empty() || ('#' == line[0]))
+      continue;
+    std::istringstream fields(line);
+    std::string workload;
+    std::string metric;
+    double value = 0;
+    if (fields >> workload >> metric)
+    {
+      if ("platform" == workload)
+      {
+        platform = metric;
+        continue;
+      }
+      if (fields >> value)
+      {
+        baselines[platform][workload][metric] = value;
+        continue;
+      }
+    }
+    std::cerr << path << ": ignoring \"" << line << "\"\n";
+  }
+  return true;
+}
+
+bool writeBaselines(const std::string &path, const Baselines_t &baselines)
+{
+  std::ofstream output(path.c_str());
+  output << "# Baselines of perfcheck, recorded by \"make perf-baselines\".\n"
+         "# The allocations and the buffered bytes depend on the word size and\n"
+         "# the C++ library, so they follow the line of their platform. Recording\n"
+         "# replaces the baselines of the current platform only.\n";
+  const auto writePlatform = [&output](const std::map<std::string, Metrics_t> &platform)
+  {
+    for (const auto &workload : platform)
+    {
+      for (const auto &metric : workload.second)
+        output << workload.first << ' ' << metric.first << ' ' << std::fixed << std::setprecision(2) << metric.second << '\n';
+    }
+  };
+
+  // The baselines for all platforms come first, as they precede any platform line.
+  const auto all = baselines.find(ALL_PLATFORMS);
+  if (baselines.end() != all)
+    writePlatform(all->second);
+  for (const auto &platform : baselines)
+  {
+    if (ALL_PLATFORMS == platform.first)
+      continue;
+    output << "platform " << platform.first << '\n';
+    writePlatform(platform.second);
+  }
+  return bool(output);
+}
+
+}
+
+int main(int argc, char *argv[])
+{
+  bool record = false;
+  bool lenient = bool(std::getenv("PERFCHECK_LENIENT"));
+  std::string path(PERF_BASELINES);
+  for (int i = 1; i < argc; ++i)
+  {
+    const std::string arg(argv[i]);
+    if (arg == "--record")
+      record = true;
+    else if (arg == "--lenient")
+      lenient = true;
+    else
+      path = arg;
+  }
+
+  std::map<std::string, Metrics_t> results;
+  runAll(results);
+
+  Baselines_t baselines;
+  const bool haveBaselines = readBaselines(path, baselines);
+  const std::string platform(getPlatform());
+
+  if (record)
+  {
+    // The baselines of the other platforms are kept.
+    baselines[ALL_PLATFORMS].clear();
+    baselines[platform].clear();
+    for (const auto &workload : results)
+    {
+      for (const auto &metric : workload.second)
+        baselines[getMetricPlatform(metric.first)][workload.first][metric.first] = metric.second;
+    }
+    if (!writeBaselines(path, baselines))
+    {
+      std::cerr << "cannot write " << path << '\n';
+      return 1;
+    }
+    std::cout << "recorded " << path << " for " << platform << '\n';
+    return 0;
+  }
+
+  bool ok = true;
+  if (!haveBaselines)
+  {
+    std::cerr << "cannot read " << path << '\n';
+    ok = lenient;
+  }
+
+  std::cout << "platform " << platform << '\n';
+  for (const auto &workload : results)
+  {
+    for (const auto &metric : workload.second)
+    {
+      std::cout << std::left << std::setw(16) << workload.first << std::setw(36) << metric.first
+                << std::right << std::fixed << std::setprecision(2) << std::setw(12) << metric.second;
+      Metrics_t &platformBaselines = baselines[getMetricPlatform(metric.first)][workload.first];
+      const auto baseline = platformBaselines.find(metric.first);
+      if (platformBaselines.end() == baseline)
+      {
+        if (lenient)
+        {
+          std::cout << "  not checked: no baseline\n";
+        }
+        else
+        {
+          std::cout << "  FAIL: no baseline\n";
+          ok = false;
+        }
+        continue;
+      }
+      std::cout << std::setw(12) << baseline->second;
+      if (metric.second > baseline->second * (1 + TOLERANCE) + 0.005)
+      {
+        std::cout << "  FAIL: grew by " << std::setprecision(1) << 100 * (metric.second / baseline->second - 1) << "%\n";
+        ok = false;
+      }
+      else if (metric.second < baseline->second * (1 - TOLERANCE))
+      {
+        std::cout << "  improved, record new baselines\n";
+      }
+      else
+      {
+        std::cout << "  ok\n";
+      }
+    }
+  }
+
+  if (!ok)
+    std::cerr << "Some counts grew or have no baseline for " << platform << ". If it is intended, record new baselines with \"make perf-baselines\";\n"
+              "to only check the counts which have baselines, set PERFCHECK_LENIENT.\n";
+  return ok ? 0 : 1;
+}
+
+/* vim:set shiftwidth=2 softtabstop=2 expandtab: */